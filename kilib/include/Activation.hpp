@@ -53,7 +53,7 @@ namespace kilib {
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CActivationNull : public CLayer::IActivation
+class CActivationNull final : public CLayer::IActivation
 {
 public:
     CActivationNull() = default;
@@ -80,6 +80,12 @@ public:
      * @return the Output of this Activation function according the documentation above.
      */
     virtual float activation(float inLearningRate, float inIntegratedValue, float inThisValue) const override;
+
+    virtual float derivative(float inIntegratedValue, float inThisValue) const override;
+
+    virtual const char* name() const override {return "null";}
+
+    virtual bool isIdentity() const override {return true;}
 }; // class CActivationNull;
 
 /*!
@@ -87,7 +93,7 @@ public:
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CActivationReLU : public CLayer::IActivation
+class CActivationReLU final : public CLayer::IActivation
 {
 public:
     CActivationReLU() = default;
@@ -115,6 +121,10 @@ public:
      * @return the Output of this Activation function according the documentation above.
      */
     virtual float activation(float inLearningRate, float inIntegratedValue, float inThisValue) const override;
+
+    virtual float derivative(float inIntegratedValue, float inThisValue) const override;
+
+    virtual const char* name() const override {return "reLU";}
 }; // class CActivationReLU;
 
 /*!
@@ -122,7 +132,7 @@ public:
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CActivationLeakyReLU : public CLayer::IActivation
+class CActivationLeakyReLU final : public CLayer::IActivation
 {
 public:
     CActivationLeakyReLU() = default;
@@ -150,6 +160,10 @@ public:
      * @return the Output of this Activation function according the documentation above.
      */
     virtual float activation(float inLearningRate, float inIntegratedValue, float inThisValue) const override;
+
+    virtual float derivative(float inIntegratedValue, float inThisValue) const override;
+
+    virtual const char* name() const override {return "leakyReLU";}
 }; // class CActivationLeakyReLU;
 
 /*!
@@ -157,7 +171,7 @@ public:
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CActivationSigmoid : public CLayer::IActivation
+class CActivationSigmoid final : public CLayer::IActivation
 {
 public:
     CActivationSigmoid() = default;
@@ -183,6 +197,10 @@ public:
      * @return the Output of this Activation function according the documentation above.
      */
     virtual float activation(float inLearningRate, float inIntegratedValue, float inThisValue) const override;
+
+    virtual float derivative(float inIntegratedValue, float inThisValue) const override;
+
+    virtual const char* name() const override {return "sigmoid";}
 }; // class CActivationSigmoid;
 
 /*!
@@ -190,7 +208,7 @@ public:
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CActivationTanh : public CLayer::IActivation
+class CActivationTanh final : public CLayer::IActivation
 {
 public:
     CActivationTanh() = default;
@@ -217,6 +235,10 @@ public:
      * @return the Output of this Activation function according the documentation above.
      */
     virtual float activation(float inLearningRate, float inIntegratedValue, float inThisValue) const override;
+
+    virtual float derivative(float inIntegratedValue, float inThisValue) const override;
+
+    virtual const char* name() const override {return "tanh";}
 }; // class CActivationTanh;
 
 /*!
@@ -224,7 +246,7 @@ public:
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CActivationSoftmax : public CLayer::IActivation
+class CActivationSoftmax final : public CLayer::IActivation
 {
 public:
     CActivationSoftmax() = default;
@@ -250,6 +272,18 @@ public:
      * @return the Output of this Activation function according the documentation above.
      */
     virtual float activation(float inLearningRate, float inIntegratedValue, float inThisValue) const override;
+
+    virtual float derivative(float inIntegratedValue, float inThisValue) const override;
+
+    virtual const char* name() const override {return "softmax";}
 }; // class CActivationSoftmax;
 
+/*!
+ * @brief Returns a shared instance of a built in activation by its name.
+ * @param inName The name as returned by CLayer::IActivation::name()
+ * @return The activation or nullptr if there is no built in activation of
+ *     this name.
+ */
+const CLayer::IActivation* activationForName(const char* inName);
+
 } // namespace kilib
@@ -0,0 +1,139 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: kilib/include/CBatchLoader.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/DataSources.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// kilib/include/CBatchLoader.hpp
+namespace kilib {
+
+/*!
+ * @brief Reads the samples of an IDataSource by batches. A background
+ * thread prefetches the next batch while the caller processes the actual
+ * one.
+ *
+ * @code
+ * kilib::CBatchLoader loader(source, 64);
+ * kilib::CBatchLoader::Batch batch;
+ * while (loader.nextBatch(batch))
+ * {
+ *     trainer.trainBatch(batch.inputs, batch.targets, batch.nrOfSamples);
+ * }
+ * loader.rewind(); // Next epoch
+ * @endcode
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CBatchLoader
+{
+public:
+    /// @brief The alignment of the batch buffers in bytes (a cache line).
+    static constexpr size_t kAlignment = 64;
+
+    struct Batch
+    {
+        const float* inputs = nullptr;  ///< nrOfSamples rows of IDataSource::nrOfInputs() values
+        const float* targets = nullptr; ///< nrOfSamples rows of IDataSource::nrOfTargets() values
+        unsigned int nrOfSamples = 0;
+    };
+
+    /*!
+     * @brief Starts prefetching the first batch.
+     * @param inSource The source to read. It must not be used otherwise
+     *     while this loader exists.
+     * @param inBatchSize The number of samples per batch.
+     */
+    CBatchLoader(IDataSource& inSource, unsigned int inBatchSize);
+    ~CBatchLoader();
+
+    // This class is not ought to be copied or assigned!
+    CBatchLoader(const CBatchLoader&) = delete;
+    CBatchLoader& operator= (const CBatchLoader&) = delete;
+
+    /*!
+     * @brief Hands over the next batch. The batch stays valid until the
+     * next call of nextBatch() or rewind().
+     * @param outBatch Receives the batch. Only the last batch of the data
+     *     may have less than the batch size samples.
+     * @return false at the end of the data.
+     */
+    bool nextBatch(Batch& outBatch);
+
+    /*!
+     * @brief Restarts at the first sample of the source.
+     */
+    void rewind();
+
+private: // Private Types
+    struct Slot
+    {
+        std::vector<float> storage;
+        float* inputs = nullptr;
+        float* targets = nullptr;
+        unsigned int nrOfSamples = 0;
+        bool isFull = false;
+    };
+
+private: // Private Methods
+    void _startPrefetching();
+    void _stopPrefetching();
+    void _prefetch();
+
+private:
+    IDataSource& m_Source;
+    const unsigned int m_BatchSize;
+
+    /// @brief The caller uses one slot while the other is filled.
+    Slot m_Slots[2];
+    unsigned int m_ConsumerSlot = 0;
+    bool m_IsConsumerSlotInUse = false;
+
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_SlotChanged;
+    bool m_Quit = false;
+}; // class CBatchLoader
+} // namespace kilib
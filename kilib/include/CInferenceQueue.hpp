@@ -0,0 +1,193 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: kilib/include/CInferenceQueue.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/CNeuronalNet.hpp"
+#include "utils/include/CMPSCQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// kilib/include/CInferenceQueue.hpp
+namespace kilib {
+
+/*!
+ * @brief Serves inference requests of many threads by one worker thread that
+ * coalesces the pending requests into micro batches.
+ *
+ * The requests are passed by a lock free queue (utils::CMPSCQueue). The
+ * worker collects requests until either CInferenceQueue::Config::maxBatchSize
+ * requests are pending or the oldest one waited for
+ * CInferenceQueue::Config::maxLatency. Then it propagates the whole batch by
+ * CNeuronalNet::forwardPropagationBatch() and completes every request.
+ *
+ * While the queue is started the network must not be used otherwise.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CInferenceQueue
+{
+public:
+    struct Config
+    {
+        /// @brief The maximum number of requests to propagate at once.
+        unsigned int maxBatchSize = 32;
+
+        /// @brief The maximum time a request waits for further requests to join its batch.
+        std::chrono::microseconds maxLatency = std::chrono::microseconds(500);
+    };
+
+    struct Statistics
+    {
+        /// @brief The number of completed requests.
+        unsigned long long nrOfRequests = 0;
+
+        /// @brief The number of propagated batches.
+        unsigned long long nrOfBatches = 0;
+    };
+
+    /*!
+     * @brief Gets the output values of a request. It is called by the worker
+     * thread.
+     * @param inOutputs The output values of the network
+     *     (CNeuronalNet::neuronsInLayer() of the output layer values) or
+     *     nullptr if the request could not be propagated.
+     */
+    using Completion = std::function<void(const float* inOutputs)>;
+
+    /*!
+     * @param inNet The inited network to serve. It has to outlive this queue.
+     * @param inConfig The batching parameters.
+     */
+    CInferenceQueue(CNeuronalNet& inNet, const Config& inConfig);
+
+    /*!
+     * @brief Like CInferenceQueue(CNeuronalNet&, const Config&) using the
+     * default Config.
+     */
+    explicit CInferenceQueue(CNeuronalNet& inNet);
+    ~CInferenceQueue();
+
+    // This class is not ought to be copied or assigned!
+    CInferenceQueue(const CInferenceQueue&) = delete;
+    CInferenceQueue& operator= (const CInferenceQueue&) = delete;
+
+    /*!
+     * @brief Starts the worker thread.
+     * @return false if the network is not inited or the queue is started already.
+     */
+    bool start();
+
+    /*!
+     * @brief Completes all pending requests and stops the worker thread.
+     */
+    void stop();
+
+    bool isStarted() const;
+
+    /*!
+     * @brief Queues an inference request. This may be called by any thread.
+     *
+     * @param inInputs The input values (CNeuronalNet::neuronsInLayer(0)
+     *     values). They are copied, so the caller may reuse them right after
+     *     this call.
+     * @param inCompletion Gets the output values once the request has been
+     *     propagated.
+     * @return false if the queue is not started or out of memory.
+     */
+    bool submit(const float* inInputs, Completion inCompletion);
+
+    /*!
+     * @brief Like submit(const float*, Completion) but hands over the output
+     * values by a future.
+     * @return The future of the output values. It is empty if the request
+     *     could not be queued. Its vector is empty if the request could not
+     *     be propagated.
+     */
+    std::future<std::vector<float>> submit(const float* inInputs);
+
+    /*!
+     * @brief Asks for the numbers of requests and batches processed so far.
+     * A ratio of requests per batch near 1 indicates that batching does not
+     * pay off for the actual load.
+     */
+    Statistics statistics() const;
+
+private: // Private Methods
+    struct Request;
+    void _run();
+    void _waitForRequests();
+    void _waitForRequests(const std::chrono::steady_clock::time_point& inDeadline);
+    void _processBatch(std::vector<Request*>& ioBatch);
+
+private:
+    CNeuronalNet& m_Net;
+    const Config m_Config;
+    const unsigned int m_NrOfInputs;
+    const unsigned int m_NrOfOutputs;
+
+    utils::CMPSCQueue<Request> m_Requests;
+
+    std::thread m_Worker;
+    std::atomic<bool> m_Running{false};      ///< Accepts new requests
+    std::atomic<bool> m_StopWorker{false};   ///< The worker exits once the queue is empty
+    std::atomic<unsigned int> m_NrOfSubmitting{0}; ///< Threads within submit()
+
+    // Wakes up the idle worker. The producers only take the lock if the
+    // worker announced to wait by m_Waiting.
+    std::mutex m_WakeUpMutex;
+    std::condition_variable m_WakeUp;
+    std::atomic<bool> m_Waiting{false};
+
+    std::atomic<unsigned long long> m_NrOfRequests{0};
+    std::atomic<unsigned long long> m_NrOfBatches{0};
+
+    // Used by the worker thread only.
+    std::vector<float> m_BatchInputs;
+    std::vector<float> m_BatchOutputs;
+}; // class CInferenceQueue
+} // namespace kilib
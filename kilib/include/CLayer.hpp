@@ -43,9 +43,11 @@
  * ========================================================================== */
 #include <functional>
 #include "utils/include/CVector.hpp"
+#include "kilib/include/Profiling.hpp"
+#include <utility>
 #include <vector>
 
-namespace utils {class CMath;} // Forward decl.
+namespace utils {class CMath; class CClassicMathDriver; class CRandom;} // Forward decl.
 
 namespace kilib {
 #if 0
@@ -176,8 +178,78 @@ public:
 
         virtual bool needsIntegralPart() const = 0;
         virtual float activation(float inLearningRate, float inIntegtedValue, float inThisValue) const = 0;
+
+        /*!
+         * @brief The derivative of activation() in respect of \p inThisValue
+         * (with a learning rate of 0 as the forward propagation uses it).
+         * This is needed for training only (see CTrainer).
+         *
+         * An activation that needs the integral part is supposed to divide
+         * by it. Only the diagonal part of its derivative is returned here:
+         * The coupling of the neurons by the integral is applied by the
+         * trainer.
+         *
+         * The integral part and the value are passed as to activation().
+         *
+         * @return The derivative. The default is 1 (a linear activation).
+         */
+        virtual float derivative(float /*inIntegratedValue*/, float /*inThisValue*/) const {return 1.f;}
+
+        /*!
+         * @brief The unique name of this activation. This is used to store
+         * and restore a network (see CNeuronalNet::save()).
+         * @return The name or nullptr (default) if this activation can not
+         *     be persisted.
+         * @see activationForName()
+         */
+        virtual const char* name() const {return nullptr;}
+
+        /*!
+         * @brief Tells if activation() returns its value unchanged. The layers
+         * of such an activation are linear and may be merged with their
+         * successor (see CNeuronalNet::optimize()).
+         * @return false (default).
+         */
+        virtual bool isIdentity() const {return false;}
     }; // class IActivation
 
+    /*!
+     * @brief The counters that are collected for every phase of this layers
+     * forward propagation.
+     * @see profile() const
+     */
+    struct Profile
+    {
+        PhaseCounters dotProduct; ///< Weightning of the parents output.
+        PhaseCounters activation; ///< Application of the activation function.
+    };
+
+    /*!
+     * @brief The storage formats of the weightnings (and biases) of a layer.
+     * @see setWeightFormat()
+     */
+    enum struct WeightFormat
+    {
+        dense,      ///< One vector per neuron (default).
+        csr,        ///< Compressed sparse rows: The non zero values and their indices.
+        blockSparse,///< The non zero blocks of #kWeightBlockSize values and their indices.
+        panels      ///< Dense, but packed into panels for the blocked matrix kernels (see utils::kernels::kPanelSize).
+    };
+
+    /*!
+     * @brief The distributions of the initial weightnings.
+     * @see randomizeWeightnings()
+     */
+    enum struct WeightInit
+    {
+        uniform,    ///< Uniform in [0 ... 1) (default).
+        xavier,     ///< Uniform in [-a ... a] with \f$a = \sqrt{6 / (fanIn + fanOut)}\f$ (Glorot). Suits tanh and sigmoid.
+        he          ///< Normal with mean 0 and deviation \f$\sqrt{2 / fanIn}\f$ (He). Suits reLU.
+    };
+
+    /// @brief The number of consecutive weightnings of a block (see WeightFormat::blockSparse)
+    static constexpr unsigned int kWeightBlockSize = 4;
+
     CLayer() = default;
     ~CLayer();
 
@@ -214,6 +286,13 @@ public:
      *     the calculation.
      * @param inParentLayer The Parent layer. That is the Layer that feeds in this
      *     Layer by its output. For the Input Layer this is a \p nullptr.
+     * @param inRandomizeWeightnings true to randomize the weightnings by
+     *     WeightInit::uniform. A layer draws from the stream of its index
+     *     within the chain of its parents and utils::CRandom::kDefaultSeed. So
+     *     its weightnings equal those of a CNeuronalNet of the default weight
+     *     init (see CNeuronalNet::setWeightInit()). Call randomizeWeightnings()
+     *     for any other seed. If false the weightnings are undefined until
+     *     they are set by the caller.
      *
      * @return true for success, false upon \p inNrOfNeurons is 0 which is an error.
      */
@@ -221,7 +300,42 @@ public:
         unsigned int inNrOfNeurons,
         const IActivation& inActivation,
         utils::CMath& inMath,
-        CLayer* inParentLayer = nullptr);
+        CLayer* inParentLayer = nullptr,
+        bool inRandomizeWeightnings = true);
+
+    /*!
+     * @brief Sets the weightnings of all neurons to random numbers and the
+     * biases to 0. The layer is converted to WeightFormat::dense.
+     *
+     * Weightning i of neuron n is the number at position
+     * \f$n \cdot (P + 1) + i\f$ of the stream of \p inRandom (P being the
+     * number of parent neurons). So the result only depends on the seed and
+     * the stream.
+     *
+     * @param inWeightInit The distribution of the weightnings.
+     * @param inRandom The generator to draw from.
+     * @return false if this layer is not inited or it is the input layer.
+     */
+    bool randomizeWeightnings(WeightInit inWeightInit, const utils::CRandom& inRandom);
+
+    /*!
+     * @brief Like randomizeWeightnings(WeightInit, const utils::CRandom&), but
+     * for the neurons \p inFirstNeuron ... \p inFirstNeuron + \p inNrOfNeurons - 1
+     * only.
+     *
+     * Several threads may randomize distinct ranges of the same layer at once.
+     * Unlike the method above this neither converts the layer nor calls
+     * invalidate(). This is up to the caller.
+     *
+     * @param inWeightInit The distribution of the weightnings.
+     * @param inRandom The generator to draw from.
+     * @param inFirstNeuron The index of the first neuron to randomize.
+     * @param inNrOfNeurons The number of neurons to randomize.
+     * @return false if this layer is not inited, it is the input layer, it
+     *     is not dense or the range exceeds the neurons.
+     */
+    bool randomizeWeightnings(WeightInit inWeightInit, const utils::CRandom& inRandom,
+                              unsigned int inFirstNeuron, unsigned int inNrOfNeurons);
 
     /*!
      * @brief The number of Neurons of this layer.
@@ -249,6 +363,69 @@ public:
      */
     const utils::CVectorF32* forwardPropagation(bool recalcParentLayers = true);
 
+    /*!
+     * @brief Performs the forward propagation of **this layer only** by
+     * using the actual output values of its parent layer.
+     *
+     * Unlike forwardPropagation() this does neither walk up the parent layers
+     * nor does it check whether this layer has been inited. It is supposed to
+     * be called by an execution plan (see CNeuronalNet) that already ensured
+     * that the layer is inited and its parent layers are up to date.
+     *
+     * @return A Vector that contains the output values after the propagation.
+     */
+    const utils::CVectorF32* propagate();
+
+    /*!
+     * @brief Performs the forward propagation of this layer for a batch of
+     * samples. The output vector of this layer is not touched.
+     *
+     * Every sample is a row of #nrOfWeightnings() input values **plus one**
+     * trailing 1.0 (just like the parents output vector). The results are
+     * written likewise: #nrOfNeurons() values plus one trailing 1.0 per
+     * sample. So the output of a layer can be fed into the next one directly.
+     *
+     * @param inInputs The input rows of all samples.
+     * @param inBatchSize The number of samples.
+     * @param outOutputs Receives the output rows of all samples.
+     * @return false if this layer is not inited or is an input layer.
+     */
+    bool propagateBatch(const float* inInputs, unsigned int inBatchSize, float* outOutputs);
+
+    /*!
+     * @brief Performs the forward propagation of some neurons of this layer
+     * only by using the actual output values of its parent layer. The output
+     * vector of this layer is not touched.
+     *
+     * An activation that needs the integral part (see
+     * IActivation::needsIntegralPart()) depends on every neuron. Then the
+     * whole layer is propagated and the requested values are picked.
+     *
+     * @param inNeuronIndices The indices of the neurons to propagate.
+     * @param inNrOfNeurons The number of indices.
+     * @param outValues Receives the output value of each requested neuron.
+     * @return false if this layer is not inited, is an input layer or an
+     *     index exceeds #nrOfNeurons().
+     */
+    bool propagateNeurons(const unsigned int* inNeuronIndices, unsigned int inNrOfNeurons, float* outValues);
+
+    /*!
+     * @brief Performs the forward propagation of this layer and determines
+     * the \p inK neurons with the greatest output values, without storing
+     * the values of all neurons. The output vector of this layer is not
+     * touched (unless the activation needs the integral part, see
+     * propagateNeurons()).
+     *
+     * @param inK The number of neurons to determine (1 for the argmax).
+     * @param outNeuronIndices Receives the indices of the \p inK neurons,
+     *     ordered by descending output values. Equal values are ordered by
+     *     their indices.
+     * @param outValues Receives the \p inK output values (may be nullptr).
+     * @return false if this layer is not inited, is an input layer or
+     *     \p inK is 0 or exceeds #nrOfNeurons().
+     */
+    bool propagateTopK(unsigned int inK, unsigned int* outNeuronIndices, float* outValues);
+
     /*!
      * @brief Returns an Pointer to an immutable Vector that represents the
      * Output of all neurons that belong to this layer.
@@ -446,8 +623,159 @@ public:
      */
     bool isInited() const;
 
+    /*!
+     * @brief Returns the profiling counters collected by #forwardPropagation()
+     * since the last call of #resetProfile() (or since construction).
+     *
+     * @note The counters will only be updated if the library has been built
+     * with \p KILIB_ENABLE_PROFILING (see #kProfilingEnabled). Otherwise all
+     * counters stay 0.
+     *
+     * @return The profiling counters of this layer.
+     * @see resetProfile()
+     */
+    const Profile& profile() const;
+
+    /*!
+     * @brief Resets all profiling counters of this layer to 0.
+     * @see profile() const
+     */
+    void resetProfile();
+
+    /*!
+     * @brief Lets this layer write its output values into an external
+     * storage instead of its own output vector.
+     *
+     * This allows several layers to share the same buffer as long as their
+     * outputs are not needed at the same time (see CNeuronalNet::MemoryMode).
+     * The content of the previous output vector is lost.
+     *
+     * @param inExternalStorage The storage of at least #nrOfNeurons() + 1
+     *     floats. This needs to outlive the binding. Pass nullptr in order to
+     *     let this layer allocate its own output vector again.
+     * @return false if this layer has not been inited or the own output
+     *     vector could not be allocated.
+     * @see neuronOutputVector()
+     */
+    bool setOutputStorage(float* inExternalStorage);
+
+    /*!
+     * @brief Sets the weightnings with the smallest magnitudes to 0 (magnitude
+     * pruning). The biases are not subject of pruning.
+     *
+     * @param inSparsity The fraction [0 ... 1] of the weightnings to prune.
+     * @return The number of weightnings that are 0 after pruning.
+     */
+    unsigned int pruneWeightnings(float inSparsity);
+
+    /*!
+     * @brief Asks for the fraction of the weightnings (without biases) that are 0.
+     * @return The sparsity [0 ... 1] of the weightnings.
+     */
+    float weightningSparsity() const;
+
+    /*!
+     * @brief Converts the weightnings into another storage format.
+     *
+     * The sparse formats store (and multiply) the non zero weightnings only.
+     * So the memory and the number of operations scale with the number of
+     * non zero weightnings.
+     *
+     * WeightFormat::panels keeps all weightnings but packs them once, so that
+     * the cache blocked kernels of utils::CMath multiply a whole panel of
+     * neurons at once. This is the fastest format for dense inference,
+     * especially for propagateBatch().
+     *
+     * @note In a non dense format the const accessors to the weightnings and
+     * biases return nullptr since there are no dense vectors. Use
+     * weightningsOfNeuron() instead. The non const accessors convert the
+     * layer back to WeightFormat::dense. The incremental propagation is
+     * suspended for sparse formats.
+     *
+     * @param inWeightFormat The desired format.
+     * @return false if this layer is not inited or the memory for the format
+     *     could not be allocated. WeightFormat::blockSparse additionally needs
+     *     at least #kWeightBlockSize weightnings per neuron.
+     */
+    bool setWeightFormat(WeightFormat inWeightFormat);
+
+    /*!
+     * @brief Asks for the actual storage format of the weightnings.
+     * @see setWeightFormat()
+     */
+    WeightFormat weightFormat() const;
+
+    /*!
+     * @brief Asks for the memory occupied by the weightnings and biases.
+     * @return The number of bytes of the weightnings storage.
+     */
+    size_t weightningMemorySize() const;
+
+    /*!
+     * @brief Copies the weightnings and the bias of a neuron regardless of
+     * the storage format.
+     *
+     * @param inNeuronIndex The index of the neuron [0... #nrOfNeurons-1]
+     * @param outWeightnings Receives #nrOfWeightnings() weightnings followed
+     *     by the bias.
+     * @return false if \p inNeuronIndex is out of range or this is the input
+     *     layer.
+     */
+    bool weightningsOfNeuron(unsigned int inNeuronIndex, float* outWeightnings) const;
+
+    /*!
+     * @brief Enables or disables the incremental propagation of this layer.
+     *
+     * If enabled the layer keeps a copy of the input values (its parents
+     * output) and of its pre-activation values of the last propagation.
+     * A following propagation then
+     * - does nothing at all if no input value has changed.
+     * - updates the pre-activation values by
+     *   \f$pre_n \mathrel{+}= w_{n,j} \cdot (in_j - in^{last}_j)\f$ for every
+     *   changed input \f$j\f$ if only a few inputs have changed.
+     * - recomputes the layer as usual otherwise.
+     *
+     * Since the incremental update rounds differently than a full calculation
+     * a full calculation is forced after a certain number of incremental
+     * updates in order to bound the deviation.
+     *
+     * @note Every non const access to the weightnings or biases invalidates
+     * the kept state. If a pointer to a weightning is kept and modified later,
+     * call invalidate() explicitly.
+     *
+     * @param inEnable true to enable the incremental propagation.
+     */
+    void setIncrementalPropagation(bool inEnable);
+
+    /*!
+     * @brief Asks if the incremental propagation is enabled.
+     * @see setIncrementalPropagation()
+     */
+    bool isIncrementalPropagation() const;
+
+    /*!
+     * @brief Forces the next propagation to recalculate this layer
+     * completely.
+     * @see setIncrementalPropagation()
+     */
+    void invalidate();
+
 private:
     void _cleanup();
+    bool _prepareIncrementalState();
+    void _calcPreActivations(utils::CVectorF32& outPreActivations);
+    void _calcPreActivations(const utils::CVectorF32& inInputValues, utils::CVectorF32& outPreActivations);
+    template <typename TMath>
+    void _calcPreActivations(const TMath& inMath, const utils::CVectorF32& inInputValues, utils::CVectorF32& outPreActivations);
+    void _calcPreActivationsOfNeurons(unsigned int inFirstNeuronIndex, unsigned int inNrOfNeurons, float* outPreActivations);
+    template <typename TMath>
+    void _calcPreActivationsOfNeurons(const TMath& inMath, unsigned int inFirstNeuronIndex, unsigned int inNrOfNeurons, float* outPreActivations);
+    bool _updatePreActivations();
+    void _applyActivation(const utils::CVectorF32& inPreActivations);
+    void _activateInPlace(utils::CVectorF32& ioValues);
+    bool _makeDense();
+    bool _packPanels();
+    void _releaseSparseWeightnings();
 
     utils::CVectorF32* _neuronWeightningVector(unsigned int forNeuronIndex);
     const utils::CVectorF32* _parentNeuronOutputVector() const;
@@ -455,6 +783,10 @@ private:
 
 private:
     utils::CMath* m_Math = nullptr;
+
+    // The driver of m_Math if it is the classic one. The propagation then
+    // calls it directly (see utils::CBasicMath), so the kernels get inlined.
+    const utils::CClassicMathDriver* m_InlineDriver = nullptr;
     CLayer* m_ParentLayer = nullptr;
 
     utils::CVectorF32*              m_OutputVector = nullptr;
@@ -462,6 +794,29 @@ private:
 
 //    ActivationFunction m_ActivationFunction = nullptr;
     const IActivation* m_Activation = nullptr;
+
+    Profile m_Profile;
+
+    // Sparse weightnings (see setWeightFormat()). Row n of the values and
+    // indices starts at m_SparseRowOffsets[n] (in entries or blocks).
+    WeightFormat m_WeightFormat = WeightFormat::dense;
+    std::vector<float> m_SparseValues;
+    std::vector<unsigned int> m_SparseIndices;
+    std::vector<unsigned int> m_SparseRowOffsets;
+
+    // The weightnings of WeightFormat::panels (see utils::kernels::packPanelsF32())
+    std::vector<float> m_PanelValues;
+
+    // State of the incremental propagation (see setIncrementalPropagation())
+    bool m_IncrementalPropagation = false;
+    bool m_IncrementalStateValid = false;
+    unsigned int m_NrOfIncrementalUpdates = 0;
+    utils::CVectorF32* m_PreActivationVector = nullptr;
+    utils::CVectorF32* m_LastInputVector = nullptr;
+    std::vector<unsigned int> m_ChangedInputIndices;
+
+    // The candidates of propagateTopK(), a heap with the smallest value on top.
+    std::vector<std::pair<float, unsigned int>> m_TopKHeap;
 }; // class CLayer
 
 } // namespace kilib
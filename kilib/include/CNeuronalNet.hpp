@@ -43,8 +43,11 @@
  * ========================================================================== */
 
 #include "kilib/include/CLayer.hpp"
+#include "utils/include/CRandom.hpp"
+#include <cstdint>
 #include <vector>
 #include <functional>
+#include <cstdio>
 
 // kilib/include/CNeuronalNet.hpp
 namespace kilib {
@@ -54,7 +57,46 @@ class CNeuronalNet
 public:
     enum struct Error
     {
-        ok, notInited, param, tooLessLayers, zeroNeuronsInLayer, outOfMemory
+        ok, notInited, param, tooLessLayers, zeroNeuronsInLayer, outOfMemory,
+        io, format, unknownActivation
+    };
+
+    /*!
+     * @brief Determines how the output buffers of the layers are managed.
+     * @see setMemoryMode()
+     */
+    enum struct MemoryMode
+    {
+        /*!
+         * Every layer owns its output vector. So the outputs of all layers
+         * stay available for inspection after a propagation (default).
+         */
+        perLayerBuffers,
+
+        /*!
+         * Inference only: The hidden and output layers write into a few
+         * shared buffers that are assigned by the lifetime of each layers
+         * output. Only the input and the output layers values are valid
+         * after a propagation.
+         */
+        sharedBuffers
+    };
+
+    /*!
+     * @brief The sparsity from which on a layer is stored sparse by default.
+     * Below of it the indices of the sparse formats outweigh the saved zeros.
+     * @see selectWeightFormats()
+     */
+    static constexpr float kDefaultSparsityThreshold = 0.5f;
+
+    /*!
+     * @brief What optimize() has changed.
+     */
+    struct OptimizeStats
+    {
+        unsigned int collapsedLayers = 0;       ///< The layers merged into their successor.
+        unsigned int droppedNeurons = 0;        ///< The hidden neurons removed.
+        bool foldedInputNormalization = false;  ///< true if a normalization has been folded.
     };
 
     CNeuronalNet() = default;
@@ -81,16 +123,338 @@ public:
         utils::CMath& inMath
         );
 
+    /*!
+     * @brief Selects how init() randomizes the weightnings. This setting is
+     * kept across init().
+     *
+     * init() randomizes the layers of a large net by several threads (unless
+     * built without \p KILIB_ENABLE_THREADS). Layer
+     * l draws from the stream l of \p inSeed (see utils::CRandom), so the
+     * weightnings only depend on the seed and not on the number of threads.
+     *
+     * @param inWeightInit The distribution of the weightnings.
+     * @param inSeed The seed.
+     */
+    void setWeightInit(CLayer::WeightInit inWeightInit, std::uint64_t inSeed = utils::CRandom::kDefaultSeed);
+
+    /*!
+     * @brief Asks for the distribution of the weightnings.
+     * @see setWeightInit()
+     */
+    CLayer::WeightInit weightInit() const;
+
+    /*!
+     * @brief Asks for the seed of the weightnings.
+     * @see setWeightInit()
+     */
+    std::uint64_t weightInitSeed() const;
+
+    /*!
+     * @brief Stores the topology, the names of the activations and all
+     * weightnings and biases of this network into a file.
+     *
+     * The file is a binary file in the hosts native byte order:
+     * - "TMLN" magic, uint32 version
+     * - uint32 number of layers, followed by uint32 neurons per layer
+     * - 32 characters name of the hidden and the output activation each
+     * - For every layer but the input layer and every neuron of it:
+     *   the weightnings followed by the bias as float32
+     *
+     * @param inPath The path of the file to write.
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::unknownActivation if an activation has no name()
+     * - Error::io if the file could not be written
+     */
+    Error save(const char* inPath) const;
+
+    /*!
+     * @brief Initializes this network from a file written by save().
+     * The activations are looked up by kilib::activationForName().
+     *
+     * @param inPath The path of the file to read.
+     * @param inMath The Math object for the network (see init()).
+     * @return
+     * - Error::ok
+     * - Error::io if the file could not be read
+     * - Error::format if the file is not a valid network file, e.g. if it
+     *   is truncated or its size does not match the topology
+     * - Error::unknownActivation if an activation is not a built in one
+     * - or any Error of init()
+     */
+    Error load(const char* inPath, utils::CMath& inMath);
+
     CLayer* layer(unsigned int inIndex);
+    const CLayer* layer(unsigned int inIndex) const;
     CLayer* inputLayer();
     CLayer* outputLayer();
 
     const CLayer* outputLayer() const;
 
     using ValueVisitor = std::function<void(unsigned int index, float value)>;
-    void forwardPropagation(const ValueVisitor&);
+
+    /*!
+     * @brief Propagates the actual input values through all layers of this
+     * network and hands over every output value to \p inValueVisitor.
+     *
+     * The layers are evaluated by the execution plan that has been built by
+     * init(): An ordered list of steps, one per layer from the input towards
+     * the output layer.
+     */
+    void forwardPropagation(const ValueVisitor& inValueVisitor);
+
+    /*!
+     * @brief Like forwardPropagation(const ValueVisitor&) but re-evaluates
+     * only the layers starting with \p inFirstLayerIndex. The layers in front
+     * of it keep their actual output values.
+     *
+     * Use this if only the output values of the layer in front of
+     * \p inFirstLayerIndex (e.g. its weightnings) have been changed since the
+     * last propagation.
+     *
+     * @param inFirstLayerIndex The index of the first layer to re-evaluate.
+     * @param inValueVisitor Gets every value of the output layer.
+     */
+    void forwardPropagationFromLayer(unsigned int inFirstLayerIndex, const ValueVisitor& inValueVisitor);
+
+    /*!
+     * @brief Like forwardPropagation(const ValueVisitor&) but writes the
+     * output values into \p outValues at once.
+     *
+     * @param outValues Receives the neuronsInLayer(nrOfLayers()-1) output
+     *     values.
+     * @param inNrOfValues The number of floats \p outValues is able to take.
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::param if \p outValues is nullptr or \p inNrOfValues is less
+     *   than the number of output values
+     */
+    Error forwardPropagationInto(float* outValues, size_t inNrOfValues);
+
+    /*!
+     * @brief Lets the input layer use a storage of the caller as its output
+     * vector. The input values written to \p ioInputs are propagated without
+     * copying them.
+     *
+     * The layers rely on a trailing 1.0 behind the output values of every
+     * layer which drives the biases. So the storage needs one more float
+     * than there are input neurons. This network writes the 1.0 into the
+     * last float when binding.
+     *
+     * The binding gets lost by init(), load() and optimize().
+     *
+     * @param ioInputs The storage of neuronsInLayer(0) + 1 floats. This needs
+     *     to outlive the binding. Pass nullptr in order to let the input layer
+     *     use its own output vector again.
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::outOfMemory if the own output vector could not be allocated
+     * @see CLayer::setOutputStorage()
+     */
+    Error bindInputs(float* ioInputs);
+
+    /*!
+     * @brief Propagates the actual input values through all layers of this
+     * network but evaluates only the requested neurons of the output layer
+     * (see CLayer::propagateNeurons()).
+     *
+     * The output vector of the output layer is not updated by this.
+     *
+     * @param inOutputIndices The indices of the output neurons to evaluate.
+     * @param inNrOfIndices The number of indices.
+     * @param outOutputs Receives the output value of each requested neuron.
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::param if a pointer is nullptr or an index exceeds the output layer
+     */
+    Error forwardPropagationSelected(const unsigned int* inOutputIndices, unsigned int inNrOfIndices, float* outOutputs);
+
+    /*!
+     * @brief Propagates the actual input values through all layers of this
+     * network and determines the \p inK output neurons with the greatest
+     * values without storing all output values (see CLayer::propagateTopK()).
+     *
+     * The output vector of the output layer is not updated by this.
+     *
+     * @param inK The number of output neurons to determine (1 for the argmax).
+     * @param outIndices Receives the indices of the \p inK output neurons,
+     *     ordered by descending values.
+     * @param outOutputs Receives the \p inK output values (may be nullptr).
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::param if \p outIndices is nullptr or \p inK is 0 or exceeds
+     *   the output layer
+     */
+    Error forwardPropagationTopK(unsigned int inK, unsigned int* outIndices, float* outOutputs);
+
+    /*!
+     * @brief Propagates a batch of samples through all layers of this network.
+     *
+     * Every layer processes all samples at once while its weightnings are
+     * hot in the cache. The results are identical to propagating the samples
+     * one by one. The output vectors of the layers are not touched, so this
+     * does not interfere with forwardPropagation().
+     *
+     * @param inInputs The input values of all samples: \p inBatchSize rows
+     *     of neuronsInLayer(0) values each.
+     * @param inBatchSize The number of samples.
+     * @param outOutputs Receives the output values of all samples:
+     *     \p inBatchSize rows of neuronsInLayer(nrOfLayers()-1) values each.
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::param if a pointer is nullptr or \p inBatchSize is 0
+     */
+    Error forwardPropagationBatch(const float* inInputs, unsigned int inBatchSize, float* outOutputs);
+
+    /*!
+     * @brief Enables or disables the incremental propagation of all layers
+     * (see CLayer::setIncrementalPropagation()). This setting is kept across
+     * init() and load().
+     *
+     * This pays off if only a few input values change between consecutive
+     * propagations: The first hidden layer is updated by the changed inputs
+     * only and every layer whose inputs did not change is skipped.
+     *
+     * @param inEnable true to enable the incremental propagation.
+     */
+    void setIncrementalPropagation(bool inEnable);
+
+    /*!
+     * @brief Asks if the incremental propagation is enabled.
+     * @see setIncrementalPropagation()
+     */
+    bool isIncrementalPropagation() const;
+
+    /*!
+     * @brief Selects how the output buffers of the layers are managed. This
+     * setting is kept across init() and load().
+     *
+     * In MemoryMode::sharedBuffers the incremental propagation is suspended
+     * and forwardPropagationFromLayer() always propagates the whole network
+     * since the outputs of the intermediate layers are not retained.
+     *
+     * @param inMemoryMode The mode to use.
+     * @return
+     * - Error::ok
+     * - Error::outOfMemory if the buffers could not be allocated. The
+     *   network keeps MemoryMode::perLayerBuffers then.
+     */
+    Error setMemoryMode(MemoryMode inMemoryMode);
+
+    /*!
+     * @brief Asks for the actual memory mode.
+     * @see setMemoryMode()
+     */
+    MemoryMode memoryMode() const;
+
+    /*!
+     * @brief Asks for the memory occupied by the output values of all layers.
+     * @return The number of bytes of all output buffers.
+     */
+    size_t activationMemorySize() const;
+
+    /*!
+     * @brief Prunes the weightnings with the smallest magnitudes of every
+     * layer (see CLayer::pruneWeightnings()).
+     *
+     * @param inSparsity The fraction [0 ... 1] of the weightnings of each
+     *     layer to set to 0.
+     * @return The number of weightnings of all layers that are 0 afterwards.
+     * @see selectWeightFormats()
+     */
+    unsigned int pruneByMagnitude(float inSparsity);
+
+    /*!
+     * @brief Chooses the storage format of the weightnings for every layer:
+     * A layer whose sparsity reaches \p inSparsityThreshold is stored sparse
+     * (block sparse or CSR, whatever needs less memory). Any other layer is
+     * stored dense.
+     *
+     * @param inSparsityThreshold The minimum sparsity [0 ... 1] of a layer in
+     *     order to store it sparse.
+     * @see CLayer::setWeightFormat()
+     */
+    void selectWeightFormats(float inSparsityThreshold = kDefaultSparsityThreshold);
+
+    /*!
+     * @brief Packs the weightnings of every dense layer into panels for the
+     * blocked kernels (see CLayer::WeightFormat::panels). Sparse layers are
+     * kept as they are.
+     *
+     * This is meant for inference only: Call it once after init() or load().
+     * Any mutable access to the weightnings of a layer converts it back to
+     * dense.
+     */
+    void packWeightnings();
+
+    /*!
+     * @brief Rewrites this network into an equivalent one that needs less
+     * work for the inference:
+     *
+     * - A constant normalization of the inputs (\f$x' = x \cdot scale + shift\f$)
+     *   is folded into the weightnings and biases of the first hidden layer.
+     *   So the raw inputs are fed in afterwards.
+     * - A hidden layer of a linear activation (see CLayer::IActivation::isIdentity())
+     *   is merged with its successor into a single product matrix if that
+     *   needs less multiplications.
+     * - Hidden neurons whose outgoing weightnings are all 0 are removed (unless
+     *   the hidden activation needs the integral part, since the neurons
+     *   contribute to it).
+     *
+     * A network of just the input layer is left unchanged.
+     *
+     * The network is rebuilt by init(). Thus pointers to its layers become
+     * invalid and all layers are stored WeightFormat::dense afterwards. The
+     * memory mode and the incremental propagation are kept.
+     *
+     * @param inInputScale The scale of every input or nullptr (1).
+     * @param inInputShift The shift of every input or nullptr (0).
+     * @param outStats Receives what has been changed. May be nullptr.
+     * @return
+     * - Error::ok
+     * - Error::notInited if this network has not been inited
+     * - Error::outOfMemory if the network could not be rebuilt. It is
+     *   not usable then.
+     */
+    Error optimize(const float* inInputScale = nullptr, const float* inInputShift = nullptr,
+                   OptimizeStats* outStats = nullptr);
+
+    /*!
+     * @brief Asks for the memory occupied by the weightnings and biases of all
+     * layers.
+     * @return The number of bytes.
+     */
+    size_t weightningMemorySize() const;
+
+    /*!
+     * @brief The number of steps of the execution plan.
+     * @return The number of steps. This is 0 if this network has not been
+     *     inited.
+     */
+    unsigned int nrOfExecutionSteps() const;
+
+    /*!
+     * @brief Executes a single step of the execution plan.
+     *
+     * This allows a caller to drive the propagation step by step, e.g. in
+     * order to interleave the steps of several networks that process
+     * consecutive samples in a pipeline.
+     *
+     * @param inStepIndex The step to execute [0 ... nrOfExecutionSteps()-1].
+     * @return false if \p inStepIndex is out of range.
+     */
+    bool executeStep(unsigned int inStepIndex);
 
     // Information
+    const CLayer::IActivation* hiddenLayerActivation() const;
+    const CLayer::IActivation* outputActivation() const;
+    const utils::CMath* math() const;
     unsigned int nrOfLayers() const;
     unsigned int neuronsInLayer(unsigned int inLayerIndex) const;
 
@@ -101,15 +465,73 @@ public:
     float* biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex);
     const float* biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex) const;
 
+    // Profiling
+    /*!
+     * @brief Sums up the profiling counters of all layers of this network.
+     * @return The accumulated counters of every layers forward propagation.
+     * @see CLayer::profile() const
+     */
+    CLayer::Profile totalProfile() const;
+
+    /*!
+     * @brief Resets the profiling counters of all layers of this network.
+     * @see CLayer::resetProfile()
+     */
+    void resetProfile();
+
+    /*!
+     * @brief Writes the profiling counters of every layer as a table.
+     * @param inFile The file to write the table to (\p stdout if omitted).
+     * @note The counters are only collected if the library has been built
+     * with \p KILIB_ENABLE_PROFILING.
+     */
+    void dumpProfile(std::FILE* inFile = stdout) const;
+
 private: // Private Methods
+    Error _init(const std::vector<unsigned int>& inNeuronLayers,
+                const CLayer::IActivation& inHiddenLayerActivation,
+                const CLayer::IActivation& inOutputActivation,
+                utils::CMath& inMath,
+                bool inRandomizeWeightnings);
+    void _randomizeWeightnings();
     void _cleanup();
     void _connect(CLayer* inInputLayer, CLayer* inOutputLayer);
+    void _buildExecutionPlan();
+    void _executePlan(unsigned int inFirstStepIndex, unsigned int inEndStepIndex);
+    void _visitOutputValues(const ValueVisitor& inValueVisitor) const;
+    bool _planSharedBuffers();
+    void _releaseSharedBuffers();
+    void _applyLayerSettings();
 
 private:
     std::vector<CLayer*> m_Layers;
 
+    /*!
+     * @brief The layers in the order they have to be propagated. Every layer
+     * of it has been inited successfully.
+     */
+    std::vector<CLayer*> m_ExecutionPlan;
+
+    bool m_IncrementalPropagation = false;
+
+    MemoryMode m_MemoryMode = MemoryMode::perLayerBuffers;
+
+    CLayer::WeightInit m_WeightInit = CLayer::WeightInit::uniform;
+    std::uint64_t m_WeightInitSeed = utils::CRandom::kDefaultSeed;
+
+    /*!
+     * @brief The buffers shared by the layers in MemoryMode::sharedBuffers.
+     */
+    std::vector<utils::CVectorF32*> m_SharedBuffers;
+
+    /*!
+     * @brief The scratch buffers of forwardPropagationBatch(). The layers
+     * read from one and write into the other alternately.
+     */
+    std::vector<float> m_BatchBuffers[2];
+
     const CLayer::IActivation* m_HiddenLayerActivation = nullptr;
     const CLayer::IActivation* m_OutputActivation = nullptr;
-    const utils::CMath* m_Math = nullptr;
+    utils::CMath* m_Math = nullptr;
 };
 } // namespace kilib
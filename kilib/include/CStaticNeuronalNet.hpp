@@ -0,0 +1,332 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: kilib/include/CStaticNeuronalNet.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/CNeuronalNet.hpp"
+#include "utils/include/CMath.hpp"
+#include "utils/include/MathKernels.hpp"
+
+namespace kilib {
+/*!
+ * @brief A type erased view onto a single layer of a CStaticNeuronalNet.
+ * The weightnings are stored row by row (one row per neuron). Every row
+ * holds #nrOfWeightnings weightnings **plus one** trailing bias value which
+ * is the same layout CLayer uses.
+ */
+struct StaticLayerView
+{
+    float* weightnings = nullptr;  ///< nullptr for the input layer
+    float* output = nullptr;       ///< #nrOfNeurons output values plus one neutral 1.0
+    unsigned int nrOfNeurons = 0;
+    unsigned int nrOfWeightnings = 0;
+};
+
+/*!
+ * @brief The storage and the forward propagation of a single layer of a
+ * CStaticNeuronalNet whose dimensions are known at compile time.
+ *
+ * @tparam NR_OF_INPUTS The number of neurons of the feeding layer.
+ * @tparam NR_OF_NEURONS The number of neurons of this layer.
+ */
+template <unsigned int NR_OF_INPUTS, unsigned int NR_OF_NEURONS>
+struct CStaticLayer
+{
+    static_assert(NR_OF_INPUTS > 0, "A layer needs at least one input");
+    static_assert(NR_OF_NEURONS > 0, "A layer needs at least one neuron");
+
+    CStaticLayer()
+    {
+        output[NR_OF_NEURONS] = 1.f; // Neutral Part for weightning offset calculation!
+    }
+
+    /*!
+     * @brief Calculates the output of this layer.
+     * @param inInput The output of the feeding layer. This must hold
+     *     NR_OF_INPUTS values **plus one** trailing 1.0 for the bias.
+     * @param inActivation The activation to apply.
+     */
+    template <typename ACTIVATION>
+    void forwardPropagation(const float* inInput, const ACTIVATION& inActivation)
+    {
+        for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < NR_OF_NEURONS; ++thisNeuronIndex)
+        {
+            output[thisNeuronIndex] = utils::kernels::calcDotF32<NR_OF_INPUTS + 1>(
+                weightnings[thisNeuronIndex], inInput, 0.f);
+        }
+
+        float integralPart = 1.f;
+        if (inActivation.needsIntegralPart())
+        {
+            integralPart = utils::kernels::sumUpF32<NR_OF_NEURONS>(output);
+        }
+
+        for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < NR_OF_NEURONS; ++thisNeuronIndex)
+        {
+            output[thisNeuronIndex] = inActivation.activation(0.f, integralPart, output[thisNeuronIndex]);
+        }
+    }
+
+    StaticLayerView view()
+    {
+        StaticLayerView ret;
+        ret.weightnings = &weightnings[0][0];
+        ret.output = output;
+        ret.nrOfNeurons = NR_OF_NEURONS;
+        ret.nrOfWeightnings = NR_OF_INPUTS;
+        return ret;
+    }
+
+    float weightnings[NR_OF_NEURONS][NR_OF_INPUTS + 1] = {};
+    float output[NR_OF_NEURONS + 1] = {};
+}; // struct CStaticLayer
+
+/*!
+ * @brief The chain of layers that follow the input layer of a CStaticNeuronalNet.
+ * Every element of the chain owns one layer and the remainder of the chain.
+ * The last one applies the output activation, all others the hidden one.
+ */
+template <typename HIDDEN_ACTIVATION, typename OUTPUT_ACTIVATION, unsigned int NR_OF_INPUTS, unsigned int... LAYER_SIZES>
+class CStaticLayerChain;
+
+template <typename HIDDEN_ACTIVATION, typename OUTPUT_ACTIVATION, unsigned int NR_OF_INPUTS, unsigned int NR_OF_NEURONS>
+class CStaticLayerChain<HIDDEN_ACTIVATION, OUTPUT_ACTIVATION, NR_OF_INPUTS, NR_OF_NEURONS>
+{
+public:
+    static constexpr unsigned int kNrOfOutputs = NR_OF_NEURONS;
+
+    const float* forwardPropagation(const float* inInput, const HIDDEN_ACTIVATION&, const OUTPUT_ACTIVATION& inOutputActivation)
+    {
+        m_Layer.forwardPropagation(inInput, inOutputActivation);
+        return m_Layer.output;
+    }
+
+    StaticLayerView view(unsigned int inIndex)
+    {
+        return (0 == inIndex) ? m_Layer.view() : StaticLayerView();
+    }
+
+private:
+    CStaticLayer<NR_OF_INPUTS, NR_OF_NEURONS> m_Layer;
+};
+
+template <typename HIDDEN_ACTIVATION, typename OUTPUT_ACTIVATION, unsigned int NR_OF_INPUTS, unsigned int NR_OF_NEURONS, unsigned int... REMAINING_LAYER_SIZES>
+class CStaticLayerChain<HIDDEN_ACTIVATION, OUTPUT_ACTIVATION, NR_OF_INPUTS, NR_OF_NEURONS, REMAINING_LAYER_SIZES...>
+{
+    using NextChain = CStaticLayerChain<HIDDEN_ACTIVATION, OUTPUT_ACTIVATION, NR_OF_NEURONS, REMAINING_LAYER_SIZES...>;
+public:
+    static constexpr unsigned int kNrOfOutputs = NextChain::kNrOfOutputs;
+
+    const float* forwardPropagation(const float* inInput, const HIDDEN_ACTIVATION& inHiddenActivation, const OUTPUT_ACTIVATION& inOutputActivation)
+    {
+        m_Layer.forwardPropagation(inInput, inHiddenActivation);
+        return m_NextChain.forwardPropagation(m_Layer.output, inHiddenActivation, inOutputActivation);
+    }
+
+    StaticLayerView view(unsigned int inIndex)
+    {
+        return (0 == inIndex) ? m_Layer.view() : m_NextChain.view(inIndex - 1);
+    }
+
+private:
+    CStaticLayer<NR_OF_INPUTS, NR_OF_NEURONS> m_Layer;
+    NextChain m_NextChain;
+};
+
+/*!
+ * @brief A neuronal network whose topology and activations are fixed at
+ * compile time.
+ *
+ * Compared with CNeuronalNet every loop bound is a constant, all activation
+ * buffers and weightnings are members of this object (so there is no heap
+ * allocation at all and the net may live on the stack or in static memory)
+ * and there is no virtual dispatch. The dot products use the same kernels as
+ * CClassicMathDriver (see utils::kernels). Hence for the same weightnings the
+ * result is identical to the one of a CNeuronalNet that uses the default CMath.
+ *
+ * This is intended for small networks. Since every neuron is a member of
+ * this object large networks would exhaust the stack.
+ *
+ * @code
+ * kilib::CStaticNeuronalNet<kilib::CActivationReLU, kilib::CActivationSigmoid, 3, 10, 16, 8> net;
+ * net.inputVector()[0] = 1.f; ...
+ * const float* result = net.forwardPropagation();
+ * @endcode
+ *
+ * @tparam HIDDEN_ACTIVATION The (final) activation class of the hidden layers.
+ * @tparam OUTPUT_ACTIVATION The (final) activation class of the output layer.
+ * @tparam LAYER_SIZES The number of neurons of every layer starting with the
+ *     input layer. At least two layers are needed.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+template <typename HIDDEN_ACTIVATION, typename OUTPUT_ACTIVATION, unsigned int NR_OF_INPUTS, unsigned int... LAYER_SIZES>
+class CStaticNeuronalNet
+{
+    static_assert(NR_OF_INPUTS > 0, "The input layer needs at least one neuron");
+    static_assert(sizeof...(LAYER_SIZES) > 0, "A static net needs at least an input and an output layer");
+
+    using Chain = CStaticLayerChain<HIDDEN_ACTIVATION, OUTPUT_ACTIVATION, NR_OF_INPUTS, LAYER_SIZES...>;
+public:
+    static constexpr unsigned int kNrOfLayers = 1 + sizeof...(LAYER_SIZES);
+    static constexpr unsigned int kNrOfInputs = NR_OF_INPUTS;
+    static constexpr unsigned int kNrOfOutputs = Chain::kNrOfOutputs;
+
+    /*!
+     * @brief Creates the net. All weightnings and biases are 0.
+     * @see randomize()
+     * @see assign()
+     */
+    CStaticNeuronalNet()
+    {
+        m_Input[NR_OF_INPUTS] = 1.f; // Neutral Part for weightning offset calculation!
+    }
+
+    /*!
+     * @brief Randomizes all weightnings in the range [0...1[ and sets all
+     * biases to 0 as CLayer::init() does.
+     */
+    void randomize()
+    {
+        for (unsigned int layerIndex = 1; layerIndex < kNrOfLayers; ++layerIndex)
+        {
+            const StaticLayerView thisLayer = layerView(layerIndex);
+            for (unsigned int neuronIndex = 0; neuronIndex < thisLayer.nrOfNeurons; ++neuronIndex)
+            {
+                float* row = thisLayer.weightnings + neuronIndex * (thisLayer.nrOfWeightnings + 1);
+                for (unsigned int i = 0; i < thisLayer.nrOfWeightnings; ++i)
+                {
+                    row[i] = utils::CMath::randF32(0.f, 1.f);
+                }
+                row[thisLayer.nrOfWeightnings] = 0.f;
+            }
+        }
+    }
+
+    /*!
+     * @brief Copies the weightnings and biases of a dynamic net.
+     * @param inNet The net to copy from.
+     * @return true upon success. false if the topology of \p inNet does not
+     *     match this one. This net remains unchanged then.
+     */
+    bool assign(const CNeuronalNet& inNet)
+    {
+        bool success = (kNrOfLayers == inNet.nrOfLayers());
+        for (unsigned int layerIndex = 0; success && (layerIndex < kNrOfLayers); ++layerIndex)
+        {
+            success = (layerView(layerIndex).nrOfNeurons == inNet.neuronsInLayer(layerIndex));
+        }
+
+        for (unsigned int layerIndex = 1; success && (layerIndex < kNrOfLayers); ++layerIndex)
+        {
+            const StaticLayerView thisLayer = layerView(layerIndex);
+            for (unsigned int neuronIndex = 0; neuronIndex < thisLayer.nrOfNeurons; ++neuronIndex)
+            {
+                // The row holds the weightnings followed by the bias as CLayer does.
+                float* row = thisLayer.weightnings + neuronIndex * (thisLayer.nrOfWeightnings + 1);
+                inNet.layer(layerIndex)->weightningsOfNeuron(neuronIndex, row);
+            }
+        }
+        return success;
+    }
+
+    /*!
+     * @brief The input of this net. Assign kNrOfInputs values before calling
+     * forwardPropagation(). Don't touch the element at index kNrOfInputs!
+     */
+    float* inputVector()
+    {
+        return m_Input;
+    }
+
+    /*!
+     * @brief Performs the forward propagation of all layers.
+     * @return A pointer to the kNrOfOutputs output values.
+     */
+    const float* forwardPropagation()
+    {
+        return m_Chain.forwardPropagation(m_Input, m_HiddenActivation, m_OutputActivation);
+    }
+
+    /*!
+     * @brief Gives runtime access to the weightnings and outputs of a layer.
+     * @param inLayerIndex The index of the layer [0 ... kNrOfLayers-1]
+     * @return The view onto this layer. This is empty if the index is out of range.
+     */
+    StaticLayerView layerView(unsigned int inLayerIndex)
+    {
+        StaticLayerView ret;
+        if (0 == inLayerIndex)
+        {
+            ret.output = m_Input;
+            ret.nrOfNeurons = NR_OF_INPUTS;
+        }
+        else
+        {
+            ret = m_Chain.view(inLayerIndex - 1);
+        }
+        return ret;
+    }
+
+    float* weightningForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex, unsigned int inWeightningIndex)
+    {
+        const StaticLayerView thisLayer = layerView(inLayerIndex);
+        return (thisLayer.weightnings && (inNeuronIndex < thisLayer.nrOfNeurons) && (inWeightningIndex < thisLayer.nrOfWeightnings))
+            ? thisLayer.weightnings + inNeuronIndex * (thisLayer.nrOfWeightnings + 1) + inWeightningIndex
+            : nullptr;
+    }
+
+    float* biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex)
+    {
+        const StaticLayerView thisLayer = layerView(inLayerIndex);
+        return (thisLayer.weightnings && (inNeuronIndex < thisLayer.nrOfNeurons))
+            ? thisLayer.weightnings + inNeuronIndex * (thisLayer.nrOfWeightnings + 1) + thisLayer.nrOfWeightnings
+            : nullptr;
+    }
+
+private:
+    float m_Input[NR_OF_INPUTS + 1] = {};
+    Chain m_Chain;
+
+    HIDDEN_ACTIVATION m_HiddenActivation;
+    OUTPUT_ACTIVATION m_OutputActivation;
+}; // class CStaticNeuronalNet
+} // namespace kilib
@@ -0,0 +1,308 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: kilib/include/CTrainer.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/CNeuronalNet.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// kilib/include/CTrainer.hpp
+namespace kilib {
+
+/*!
+ * @brief Trains a CNeuronalNet by mini-batch gradient descent on all cores.
+ *
+ * The loss is the squared error \f$\frac{1}{2}\sum(y - t)^2\f$ of the output
+ * values \f$y\f$ towards the target values \f$t\f$.
+ *
+ * Every mini-batch is split into contiguous shards, one per worker thread.
+ * Each worker propagates its samples forward and backward by its own
+ * activation and gradient buffers, while all of them read the weightnings of
+ * the layers in place. Afterwards the gradients are reduced row by row: Every
+ * worker sums up a disjoint range of weightning rows over all workers in a
+ * fixed order and applies the update step to these rows. So the results are
+ * bit identical for the same seed and the same number of threads.
+ *
+ * The update step is done by the Config::optimizer. The state of Momentum and
+ * Adam is kept in buffers parallel to the gradients, so every weightning row
+ * is updated by a single pass over contiguous arrays. This state is allocated
+ * once (see optimizerStateSize()) and kept as long as the number of
+ * parameters of the network does not change.
+ *
+ * The calling thread serves as the first worker. The other workers are kept
+ * alive between the batches.
+ *
+ * Training reads and updates the weightnings in place, so it needs the
+ * layers in CLayer::WeightFormat::dense. They are converted once when
+ * training begins, i.e. a network that has been optimized or packed for
+ * scoring (see CNeuronalNet::optimize(), CNeuronalNet::packWeightnings())
+ * gets unpacked then. A layer that is converted to another format later on
+ * is refused by Error::weightFormat.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CTrainer
+{
+public:
+    enum struct Error
+    {
+        ok, notInited, param,
+        weightFormat ///< A layer is not dense anymore since training began
+    };
+
+    enum struct Optimizer
+    {
+        sgd,      ///< Plain (mini-batch) gradient descent
+        momentum, ///< Gradient descent with momentum
+        adam      ///< Adam (adaptive moment estimation)
+    };
+
+    struct Config
+    {
+        /// @brief The number of worker threads (0: One per hardware thread).
+        unsigned int nrOfThreads = 0;
+
+        /// @brief The number of samples per update step (see trainEpoch()).
+        unsigned int batchSize = 32;
+
+        /// @brief The step size of the gradient descent.
+        float learningRate = 0.05f;
+
+        Optimizer optimizer = Optimizer::sgd;
+
+        /// @brief The decay of the velocities of Optimizer::momentum [0, 1).
+        float momentum = 0.9f;
+
+        /// @brief The decays of the moments of Optimizer::adam [0, 1).
+        float beta1 = 0.9f;
+        float beta2 = 0.999f;
+
+        /// @brief Prevents a division by 0 for Optimizer::adam.
+        float epsilon = 1e-8f;
+
+        /// @brief The seed of the shuffling of the samples by trainEpoch().
+        std::uint32_t seed = 1;
+    };
+
+    /*!
+     * @param inNet The inited network to train. It has to outlive this
+     *     trainer. Its layers are converted to the dense weightning format
+     *     once training begins.
+     * @param inConfig The training parameters.
+     */
+    CTrainer(CNeuronalNet& inNet, const Config& inConfig);
+
+    /*!
+     * @brief Like CTrainer(CNeuronalNet&, const Config&) using the default
+     * Config.
+     */
+    explicit CTrainer(CNeuronalNet& inNet);
+    ~CTrainer();
+
+    // This class is not ought to be copied or assigned!
+    CTrainer(const CTrainer&) = delete;
+    CTrainer& operator= (const CTrainer&) = delete;
+
+    /*!
+     * @brief Performs a single update step for a mini-batch.
+     *
+     * @param inInputs \p inBatchSize rows of CNeuronalNet::neuronsInLayer(0) input values.
+     * @param inTargets \p inBatchSize rows of target values (one per output neuron).
+     * @param inBatchSize The number of samples.
+     * @param outLoss Receives the mean loss of the samples before the update
+     *     (may be nullptr).
+     * @return
+     * - Error::ok
+     * - Error::notInited if the network is not inited
+     * - Error::param if a pointer is nullptr, \p inBatchSize is 0 or the
+     *   parameters of the Config::optimizer are out of range
+     * - Error::weightFormat if a layer has been converted from the dense
+     *   format since training began
+     */
+    Error trainBatch(const float* inInputs, const float* inTargets, unsigned int inBatchSize, float* outLoss = nullptr);
+
+    /*!
+     * @brief Trains one epoch: The samples are shuffled and processed by
+     * mini-batches of Config::batchSize samples.
+     *
+     * @param inInputs \p inNrOfSamples rows of input values.
+     * @param inTargets \p inNrOfSamples rows of target values.
+     * @param inNrOfSamples The number of samples.
+     * @param outLoss Receives the mean loss of all samples (may be nullptr).
+     * @return See trainBatch().
+     */
+    Error trainEpoch(const float* inInputs, const float* inTargets, unsigned int inNrOfSamples, float* outLoss = nullptr);
+
+    /*!
+     * @brief The gradients of the loss (summed up over the samples) of the
+     * last update step.
+     *
+     * The layout follows the layers 1 ... n, their neurons and the
+     * weightnings of each neuron followed by its bias.
+     *
+     * @return The gradients or nullptr if nothing has been trained yet.
+     */
+    const float* gradients() const;
+
+    /*!
+     * @brief The number of weightnings and biases of all layers, which is
+     * the number of gradients().
+     */
+    size_t nrOfParameters() const;
+
+    unsigned int nrOfThreads() const;
+
+    /*!
+     * @brief The number of bytes of the state of the optimizer (e.g. the
+     * moments of Adam). This is 0 until training begins and for
+     * Optimizer::sgd.
+     */
+    size_t optimizerStateSize() const;
+
+    /*!
+     * @brief Clears the state of the optimizer, e.g. after the network has
+     * been re-inited.
+     */
+    void resetOptimizer();
+
+private: // Private Types
+    struct Worker;
+
+    /*!
+     * @brief A job of the thread pool: Refers to a callable that is called
+     * by the worker index. Unlike std::function it neither copies the
+     * callable nor allocates, so the callable must outlive the job.
+     */
+    class JobRef
+    {
+    public:
+        template<typename Callable>
+        explicit JobRef(const Callable& inCallable)
+        : m_Function([](const void* inCallable, unsigned int inWorkerIndex){
+              (*static_cast<const Callable*>(inCallable))(inWorkerIndex);
+          })
+        , m_Callable(&inCallable)
+        {
+        }
+
+        void operator()(unsigned int inWorkerIndex) const {m_Function(m_Callable, inWorkerIndex);}
+
+    private:
+        void (*m_Function)(const void* inCallable, unsigned int inWorkerIndex);
+        const void* m_Callable;
+    };
+
+    /// @brief The weightnings (followed by the bias) of a neuron.
+    struct Row
+    {
+        float* weightnings;
+        size_t nrOfElements;
+        size_t gradientOffset; ///< The index of the rows first gradient
+    };
+
+private: // Private Methods
+
+    bool _isValidConfig() const;
+    Error _prepare();
+    Error _trainSamples(const float* inInputs, const float* inTargets, const unsigned int* inSampleIndices,
+                        unsigned int inNrOfSamples, float& outLossSum);
+    void _processShard(Worker& ioWorker, const float* inInputs, const float* inTargets,
+                       const unsigned int* inSampleIndices, unsigned int inNrOfSamples);
+    void _processSample(Worker& ioWorker, const float* inInput, const float* inTarget);
+    void _reduceAndUpdate(unsigned int inWorkerIndex, float inScale);
+
+    void _runOnAllWorkers(const char* inJobName, const JobRef& inJob);
+    void _workerThread(unsigned int inWorkerIndex);
+
+private:
+    CNeuronalNet& m_Net;
+    const Config m_Config;
+    std::mt19937 m_Random;
+
+    std::vector<Worker*> m_Workers;
+
+    /// @brief All weightning rows of the network (layer by layer, neuron by neuron).
+    std::vector<Row> m_Rows;
+
+    /// @brief The first row of the rows every worker reduces and updates [nrOfThreads + 1].
+    std::vector<size_t> m_RowRangeOfWorker;
+
+    /// @brief The index of the first row of every layer within m_Rows.
+    std::vector<size_t> m_FirstRowOfLayer;
+
+    /// @brief The offset of each layers values within the per worker activation buffers.
+    std::vector<size_t> m_LayerOffsets;
+
+    size_t m_NrOfParameters = 0;
+    bool m_HasGradients = false;
+
+    /// @brief The layers have been converted to the dense format (see _prepare()).
+    bool m_HasBegun = false;
+
+    /*!
+     * @brief The state of the optimizer parallel to the gradients: The
+     * velocities of Optimizer::momentum, or the first moments followed by
+     * the second moments of Optimizer::adam.
+     */
+    std::vector<float> m_OptimizerState;
+
+    /// @brief The number of update steps since the optimizer has been reset.
+    unsigned long long m_NrOfSteps = 0;
+
+    std::vector<unsigned int> m_SampleIndices;
+
+    // The thread pool
+    std::vector<std::thread> m_Threads;
+    std::mutex m_PoolMutex;
+    std::condition_variable m_StartJob;
+    std::condition_variable m_JobDone;
+    const JobRef* m_Job = nullptr;
+    const char* m_JobName = nullptr; ///< The name of m_Job's trace events (utils::CTrace::kTask)
+    unsigned long long m_JobGeneration = 0;
+    unsigned int m_NrOfPendingWorkers = 0;
+    bool m_Quit = false;
+}; // class CTrainer
+} // namespace kilib
@@ -0,0 +1,288 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: kilib/include/DataSources.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "utils/include/CMappedFile.hpp"
+#include <cstdint>
+
+// kilib/include/DataSources.hpp
+namespace kilib {
+
+/*!
+ * @brief A stream of samples (input values and target values) e.g. for
+ * training. A source is read sequentially, so it never needs to hold the
+ * whole data set in memory.
+ *
+ * @see CBatchLoader
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class IDataSource
+{
+public:
+    IDataSource() = default;
+    virtual ~IDataSource() = default;
+
+    virtual unsigned int nrOfInputs() const = 0;
+    virtual unsigned int nrOfTargets() const = 0;
+
+    /*!
+     * @brief Reads the next samples.
+     * @param outInputs Receives up to \p inMaxNrOfSamples rows of nrOfInputs() values.
+     * @param outTargets Receives up to \p inMaxNrOfSamples rows of nrOfTargets() values.
+     * @param inMaxNrOfSamples The maximum number of samples to read.
+     * @return The number of samples read. This is 0 at the end of the data.
+     */
+    virtual unsigned int read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples) = 0;
+
+    /*!
+     * @brief Restarts at the first sample.
+     */
+    virtual void rewind() = 0;
+}; // class IDataSource
+
+/*!
+ * @brief The common settings of the data sources.
+ */
+struct DataSourceConfig
+{
+    /*!
+     * @brief If not 0 the target is a single class label that is expanded
+     * into this number of one hot encoded target values. Otherwise the
+     * target values are taken as they are.
+     */
+    unsigned int nrOfClasses = 0;
+
+    /// @brief The input values are normalized to value * inputScale + inputOffset.
+    float inputScale = 1.f;
+    float inputOffset = 0.f;
+};
+
+/*!
+ * @brief Reads samples from a text file of comma separated values.
+ *
+ * Every line is a sample of nrOfInputs values followed by the target
+ * values (or the class label, see DataSourceConfig::nrOfClasses). Lines
+ * that do not match are skipped. The file is mapped into the memory and
+ * the pages already parsed are released again.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CCSVDataSource final : public IDataSource
+{
+public:
+    enum struct Error
+    {
+        ok, io, param
+    };
+
+    struct Config : DataSourceConfig
+    {
+        unsigned int nrOfInputs = 0;
+
+        /*!
+         * @brief The number of target columns (ignored if nrOfClasses is set).
+         * 0 for data without targets, e.g. to be scored by a trained network.
+         */
+        unsigned int nrOfTargets = 1;
+
+        char separator = ',';
+
+        /// @brief Skip the first line.
+        bool hasHeader = false;
+
+        /// @brief The target columns precede the input columns.
+        bool targetsFirst = false;
+    };
+
+    CCSVDataSource() = default;
+
+    /*!
+     * @brief Opens a CSV file.
+     * @return
+     * - Error::ok
+     * - Error::param if Config::nrOfInputs is 0
+     * - Error::io if the file could not be opened
+     */
+    Error open(const char* inPath, const Config& inConfig);
+
+    virtual unsigned int nrOfInputs() const override;
+    virtual unsigned int nrOfTargets() const override;
+    virtual unsigned int read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples) override;
+    virtual void rewind() override;
+
+    /*!
+     * @brief The number of lines that have been skipped since they do not
+     * match the configuration.
+     */
+    unsigned long long nrOfSkippedLines() const;
+
+private:
+    bool _parseLine(const char*& ioPosition, const char* inEnd, float* outInputs, float* outTargets) const;
+    void _skipHeader();
+
+private:
+    utils::CMappedFile m_File;
+    Config m_Config;
+    size_t m_Offset = 0;
+    unsigned long long m_NrOfSkippedLines = 0;
+}; // class CCSVDataSource
+
+/*!
+ * @brief Reads samples from a pair of IDX files (the format of the MNIST
+ * data set): One of the inputs (e.g. the images) and one of the targets
+ * (e.g. the labels).
+ *
+ * Every value type of the format (unsigned/signed byte, short, int, float,
+ * double) is supported. The first dimension is the sample, the product of
+ * the others is the number of values per sample. Both files are mapped into
+ * the memory.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CIDXDataSource final : public IDataSource
+{
+public:
+    enum struct Error
+    {
+        ok, io, format, param
+    };
+
+    using Config = DataSourceConfig;
+
+    CIDXDataSource() = default;
+
+    /*!
+     * @brief Opens the files of the inputs and of the targets.
+     * @return
+     * - Error::ok
+     * - Error::io if a file could not be opened
+     * - Error::format if a file is no IDX file, is truncated, or the number
+     *   of samples of both files differ
+     * - Error::param if Config::nrOfClasses is set but the targets are not
+     *   a single label per sample
+     */
+    Error open(const char* inInputsPath, const char* inTargetsPath, const Config& inConfig);
+
+    virtual unsigned int nrOfInputs() const override;
+    virtual unsigned int nrOfTargets() const override;
+    virtual unsigned int read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples) override;
+    virtual void rewind() override;
+
+    /// @brief The total number of samples.
+    unsigned int nrOfSamples() const;
+
+private:
+    /// @brief The layout of the values of an IDX file.
+    struct Values
+    {
+        const char* data = nullptr;
+        std::uint8_t type = 0;
+        unsigned int nrOfSamples = 0;
+        unsigned int valuesPerSample = 0;
+        unsigned int bytesPerValue = 0;
+    };
+    static bool _parseHeader(const utils::CMappedFile& inFile, Values& outValues);
+
+private:
+    utils::CMappedFile m_InputsFile;
+    utils::CMappedFile m_TargetsFile;
+    Values m_Inputs;
+    Values m_Targets;
+    Config m_Config;
+    unsigned int m_NextSample = 0;
+}; // class CIDXDataSource
+
+/*!
+ * @brief Reads samples from a file of raw float32 values in the byte order
+ * of this machine: Every sample is nrOfInputs values followed by the target
+ * values (or the class label, see DataSourceConfig::nrOfClasses). There is
+ * no header, so this is the cheapest format to read. The file is mapped
+ * into the memory and the pages already read are released again.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CRawDataSource final : public IDataSource
+{
+public:
+    enum struct Error
+    {
+        ok, io, format, param
+    };
+
+    struct Config : DataSourceConfig
+    {
+        unsigned int nrOfInputs = 0;
+
+        /// @brief The number of target values (ignored if nrOfClasses is set).
+        unsigned int nrOfTargets = 0;
+    };
+
+    CRawDataSource() = default;
+
+    /*!
+     * @brief Opens a file of raw float32 values.
+     * @return
+     * - Error::ok
+     * - Error::param if Config::nrOfInputs is 0
+     * - Error::io if the file could not be opened
+     * - Error::format if the file size is not a multiple of the sample size
+     */
+    Error open(const char* inPath, const Config& inConfig);
+
+    virtual unsigned int nrOfInputs() const override;
+    virtual unsigned int nrOfTargets() const override;
+    virtual unsigned int read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples) override;
+    virtual void rewind() override;
+
+    /// @brief The total number of samples.
+    unsigned long long nrOfSamples() const;
+
+private:
+    unsigned int _valuesPerSample() const;
+
+private:
+    utils::CMappedFile m_File;
+    Config m_Config;
+    unsigned long long m_NextSample = 0;
+}; // class CRawDataSource
+
+} // namespace kilib
@@ -0,0 +1,131 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: kilib/include/Profiling.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include <chrono>
+#include <cstdint>
+
+namespace kilib {
+#if defined(KILIB_ENABLE_PROFILING)
+constexpr bool kProfilingEnabled = true;
+#else
+constexpr bool kProfilingEnabled = false;
+#endif
+
+/*!
+ * @brief Counters that are collected for a certain phase (e.g. the dot product
+ * or the activation) of a layers forward propagation.
+ *
+ * @note The counters are only updated if the library has been build with
+ * \p KILIB_ENABLE_PROFILING. Otherwise they will remain 0.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+struct PhaseCounters
+{
+    std::uint64_t calls = 0;       ///< How often has this phase been run?
+    std::uint64_t flops = 0;       ///< Number of floating point operations.
+    std::uint64_t bytes = 0;       ///< Number of bytes read and written.
+    std::uint64_t nanoSeconds = 0; ///< Cumulated wall clock time in [ns].
+
+    PhaseCounters& operator+=(const PhaseCounters& inRHS)
+    {
+        calls += inRHS.calls;
+        flops += inRHS.flops;
+        bytes += inRHS.bytes;
+        nanoSeconds += inRHS.nanoSeconds;
+        return *this;
+    }
+}; // struct PhaseCounters
+
+/*!
+ * @brief Helper that measures the time of its own scope and adds this
+ * together with a given amount of FLOPs and bytes to a PhaseCounters object
+ * upon its destruction.
+ *
+ * Please don't use this directly but by means of the macro #KILIB_PROFILE_PHASE
+ * which vanishes if profiling has not been enabled.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CPhaseScope
+{
+public:
+    CPhaseScope(PhaseCounters& inCounters, std::uint64_t inFlops, std::uint64_t inBytes)
+    : m_Counters(inCounters)
+    , m_Flops(inFlops)
+    , m_Bytes(inBytes)
+    , m_Start(std::chrono::steady_clock::now())
+    {}
+
+    ~CPhaseScope()
+    {
+        const auto duration = std::chrono::steady_clock::now() - m_Start;
+        ++m_Counters.calls;
+        m_Counters.flops += m_Flops;
+        m_Counters.bytes += m_Bytes;
+        m_Counters.nanoSeconds += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    CPhaseScope(const CPhaseScope&) = delete;
+    CPhaseScope& operator= (const CPhaseScope&) = delete;
+
+private:
+    PhaseCounters& m_Counters;
+    const std::uint64_t m_Flops;
+    const std::uint64_t m_Bytes;
+    const std::chrono::steady_clock::time_point m_Start;
+}; // class CPhaseScope
+} // namespace kilib
+
+/*!
+ * @brief Account the remainder of the enclosing scope to \p counters.
+ * This expands to nothing unless \p KILIB_ENABLE_PROFILING is defined. So the
+ * arguments must not have any side effects!
+ */
+#if defined(KILIB_ENABLE_PROFILING)
+    #define KILIB_PROFILE_PHASE(name, counters, flops, bytes) \
+        kilib::CPhaseScope name((counters), (flops), (bytes))
+#else
+    #define KILIB_PROFILE_PHASE(name, counters, flops, bytes) do{}while(0)
+#endif
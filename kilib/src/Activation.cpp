@@ -41,7 +41,9 @@
  *
  * ========================================================================== */
 #include "kilib/include/Activation.hpp"
+#include <cassert>
 #include <cmath>
+#include <cstring>
 
 /*!
  * @brief The *sigmoid* Activation Function.
@@ -69,6 +71,11 @@ float CActivationNull::activation(float inLearningRate, float inIntegratedValue,
     return inThisValue;
 }
 
+float CActivationNull::derivative(float inIntegratedValue, float inThisValue) const
+{
+    return 1.f;
+}
+
 // ==========================================================================
 // class CActivationReLU : public CLayer::IActivation
 // ==========================================================================
@@ -77,6 +84,11 @@ float CActivationReLU::activation(float inLearningRate, float inIntegratedValue,
     return std::fmaxf(0.f, inThisValue);
 }
 
+float CActivationReLU::derivative(float inIntegratedValue, float inThisValue) const
+{
+    return (inThisValue > 0.f) ? 1.f : 0.f;
+}
+
 // ==========================================================================
 // class CActivationLeakyReLU : public CLayer::IActivation
 // ==========================================================================
@@ -85,6 +97,12 @@ float CActivationLeakyReLU::activation(float inLearningRate, float inIntegratedV
     return (inThisValue >= 0) ? inThisValue : inThisValue * inLearningRate;
 }
 
+float CActivationLeakyReLU::derivative(float inIntegratedValue, float inThisValue) const
+{
+    // The forward propagation uses a learning rate of 0.
+    return (inThisValue >= 0.f) ? 1.f : 0.f;
+}
+
 // ==========================================================================
 // class CActivationSigmoid : public CLayer::IActivation
 // ==========================================================================
@@ -93,6 +111,12 @@ float CActivationSigmoid::activation(float inLearningRate, float inIntegratedVal
     return _activationFunctionSigmoid(inThisValue) - 1.f;
 }
 
+float CActivationSigmoid::derivative(float inIntegratedValue, float inThisValue) const
+{
+    const float sigmoid = _activationFunctionSigmoid(inThisValue);
+    return sigmoid * (1.f - sigmoid);
+}
+
 // ==========================================================================
 // class CActivationTanh : public CLayer::IActivation
 // ==========================================================================
@@ -101,6 +125,12 @@ float CActivationTanh::activation(float inLearningRate, float inIntegratedValue,
     return 2.f * _activationFunctionSigmoid(2.f * inThisValue) - 1.f;
 }
 
+float CActivationTanh::derivative(float inIntegratedValue, float inThisValue) const
+{
+    const float sigmoid = _activationFunctionSigmoid(2.f * inThisValue);
+    return 4.f * sigmoid * (1.f - sigmoid);
+}
+
 // ==========================================================================
 // class CActivationSoftmax : public CLayer::IActivation
 // ==========================================================================
@@ -114,4 +144,41 @@ float CActivationSoftmax::activation(float inLearningRate, float inIntegratedVal
     return 0;
 }
 
+float CActivationSoftmax::derivative(float inIntegratedValue, float inThisValue) const
+{
+    return (0.f != inIntegratedValue) ? 1.f / inIntegratedValue : 0.f;
+}
+
+// ==========================================================================
+// Functions
+// ==========================================================================
+const CLayer::IActivation* activationForName(const char* inName)
+{
+    static const CActivationNull nullActivation;
+    static const CActivationReLU reLUActivation;
+    static const CActivationLeakyReLU leakyReLUActivation;
+    static const CActivationSigmoid sigmoidActivation;
+    static const CActivationTanh tanhActivation;
+    static const CActivationSoftmax softmaxActivation;
+
+    static const CLayer::IActivation* const kActivations[] = {
+        &nullActivation, &reLUActivation, &leakyReLUActivation,
+        &sigmoidActivation, &tanhActivation, &softmaxActivation
+    };
+
+    const CLayer::IActivation* ret = nullptr;
+    if (inName)
+    {
+        for (const CLayer::IActivation* thisActivation : kActivations)
+        {
+            if (0 == strcmp(thisActivation->name(), inName))
+            {
+                ret = thisActivation;
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
 } // namespace kilib
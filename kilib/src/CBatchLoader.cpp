@@ -0,0 +1,181 @@
+/* ==========================================================================
+ * @(#)File: kilib/src/CBatchLoader.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/CBatchLoader.hpp"
+#include <cstdint>
+
+/*!
+ * @brief Returns the first element of a buffer that is aligned to
+ * kilib::CBatchLoader::kAlignment.
+ */
+static float* _aligned(std::vector<float>& inBuffer)
+{
+    const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(inBuffer.data());
+    const std::uintptr_t alignedAddress = (address + kilib::CBatchLoader::kAlignment - 1) & ~std::uintptr_t(kilib::CBatchLoader::kAlignment - 1);
+    return reinterpret_cast<float*>(alignedAddress);
+}
+
+namespace kilib {
+// ==========================================================================
+// class CBatchLoader - public
+// ==========================================================================
+CBatchLoader::CBatchLoader(IDataSource& inSource, unsigned int inBatchSize)
+: m_Source(inSource)
+, m_BatchSize(inBatchSize)
+{
+    const size_t nrOfInputValues = size_t(inBatchSize) * inSource.nrOfInputs();
+    const size_t nrOfTargetValues = size_t(inBatchSize) * inSource.nrOfTargets();
+    constexpr size_t kPadding = kAlignment / sizeof(float);
+
+    // The inputs and the targets start at a cache line each.
+    const size_t alignedNrOfInputValues = (nrOfInputValues + kPadding - 1) / kPadding * kPadding;
+    for (Slot& thisSlot : m_Slots)
+    {
+        thisSlot.storage.resize(kPadding + alignedNrOfInputValues + nrOfTargetValues);
+        thisSlot.inputs = _aligned(thisSlot.storage);
+        thisSlot.targets = thisSlot.inputs + alignedNrOfInputValues;
+    }
+    _startPrefetching();
+}
+
+CBatchLoader::~CBatchLoader()
+{
+    _stopPrefetching();
+}
+
+bool CBatchLoader::nextBatch(Batch& outBatch)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    if (m_IsConsumerSlotInUse)
+    {
+        // Hand back the slot of the previous batch.
+        m_Slots[m_ConsumerSlot].isFull = false;
+        m_ConsumerSlot ^= 1;
+        m_IsConsumerSlotInUse = false;
+        m_SlotChanged.notify_all();
+    }
+
+    Slot& slot = m_Slots[m_ConsumerSlot];
+    m_SlotChanged.wait(lock, [&slot](){return slot.isFull;});
+    if (0 == slot.nrOfSamples)
+    {
+        outBatch = Batch();
+        return false; // End of data. The slot is kept, so further calls return false too.
+    }
+
+    m_IsConsumerSlotInUse = true;
+    outBatch.inputs = slot.inputs;
+    outBatch.targets = slot.targets;
+    outBatch.nrOfSamples = slot.nrOfSamples;
+    return true;
+}
+
+void CBatchLoader::rewind()
+{
+    _stopPrefetching();
+    m_Source.rewind();
+    _startPrefetching();
+}
+
+// ==========================================================================
+// class CBatchLoader - private
+// ==========================================================================
+void CBatchLoader::_startPrefetching()
+{
+    for (Slot& thisSlot : m_Slots)
+    {
+        thisSlot.isFull = false;
+        thisSlot.nrOfSamples = 0;
+    }
+    m_ConsumerSlot = 0;
+    m_IsConsumerSlotInUse = false;
+    m_Quit = false;
+    m_Thread = std::thread(&CBatchLoader::_prefetch, this);
+}
+
+void CBatchLoader::_stopPrefetching()
+{
+    if (m_Thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Quit = true;
+        }
+        m_SlotChanged.notify_all();
+        m_Thread.join();
+    }
+}
+
+void CBatchLoader::_prefetch()
+{
+    unsigned int producerSlot = 0;
+    for (;;)
+    {
+        Slot& slot = m_Slots[producerSlot];
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_SlotChanged.wait(lock, [this, &slot](){return m_Quit || !slot.isFull;});
+            if (m_Quit)
+            {
+                return;
+            }
+        }
+
+        // The slot is not full, so the caller does not access it.
+        const unsigned int nrOfSamples = (0 != m_BatchSize) ? m_Source.read(slot.inputs, slot.targets, m_BatchSize) : 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            slot.nrOfSamples = nrOfSamples;
+            slot.isFull = true;
+        }
+        m_SlotChanged.notify_all();
+
+        if (0 == nrOfSamples)
+        {
+            return; // End of data
+        }
+        producerSlot ^= 1;
+    }
+}
+
+} // namespace kilib
@@ -0,0 +1,277 @@
+/* ==========================================================================
+ * @(#)File: kilib/src/CInferenceQueue.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/CInferenceQueue.hpp"
+#include "utils/include/CTrace.hpp"
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace kilib {
+// ==========================================================================
+// struct CInferenceQueue::Request
+// ==========================================================================
+struct CInferenceQueue::Request : utils::CMPSCQueue<Request>::Node
+{
+    std::vector<float> m_Inputs;
+    Completion m_Completion;
+};
+
+// ==========================================================================
+// class CInferenceQueue - public
+// ==========================================================================
+CInferenceQueue::CInferenceQueue(CNeuronalNet& inNet, const Config& inConfig)
+: m_Net(inNet)
+, m_Config(inConfig)
+, m_NrOfInputs(inNet.neuronsInLayer(0))
+, m_NrOfOutputs(inNet.nrOfLayers() ? inNet.neuronsInLayer(inNet.nrOfLayers() - 1) : 0)
+{
+}
+
+CInferenceQueue::CInferenceQueue(CNeuronalNet& inNet)
+: CInferenceQueue(inNet, Config())
+{
+}
+
+CInferenceQueue::~CInferenceQueue()
+{
+    stop();
+}
+
+bool CInferenceQueue::start()
+{
+    if (m_Worker.joinable() || (0 == m_NrOfInputs) || (0 == m_NrOfOutputs)
+     || (0 == m_Net.nrOfExecutionSteps()) || (0 == m_Config.maxBatchSize))
+    {
+        return false;
+    }
+
+    m_StopWorker = false;
+    m_Running = true;
+    m_Worker = std::thread(&CInferenceQueue::_run, this);
+    return true;
+}
+
+void CInferenceQueue::stop()
+{
+    if (m_Worker.joinable())
+    {
+        // Refuse new requests and let the submitting threads finish their
+        // push. Then the worker completes the remaining requests and exits.
+        m_Running = false;
+        while (0 != m_NrOfSubmitting)
+        {
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_WakeUpMutex);
+            m_StopWorker = true;
+        }
+        m_WakeUp.notify_one();
+        m_Worker.join();
+    }
+}
+
+bool CInferenceQueue::isStarted() const
+{
+    return m_Running;
+}
+
+bool CInferenceQueue::submit(const float* inInputs, Completion inCompletion)
+{
+    if (nullptr == inInputs)
+    {
+        return false;
+    }
+
+    bool success = false;
+    ++m_NrOfSubmitting;
+    if (m_Running)
+    {
+        Request* request = new(std::nothrow) Request;
+        assert(request);
+        if (request)
+        {
+            request->m_Inputs.assign(inInputs, inInputs + m_NrOfInputs);
+            request->m_Completion = std::move(inCompletion);
+            m_Requests.push(request);
+
+            if (m_Waiting)
+            {
+                std::lock_guard<std::mutex> lock(m_WakeUpMutex);
+                m_WakeUp.notify_one();
+            }
+            success = true;
+        }
+    }
+    --m_NrOfSubmitting;
+    return success;
+}
+
+std::future<std::vector<float>> CInferenceQueue::submit(const float* inInputs)
+{
+    std::shared_ptr<std::promise<std::vector<float>>> promise = std::make_shared<std::promise<std::vector<float>>>();
+    std::future<std::vector<float>> future = promise->get_future();
+
+    const unsigned int nrOfOutputs = m_NrOfOutputs;
+    if (!submit(inInputs, [promise, nrOfOutputs](const float* inOutputs){
+            promise->set_value(inOutputs ? std::vector<float>(inOutputs, inOutputs + nrOfOutputs) : std::vector<float>());
+        }))
+    {
+        return std::future<std::vector<float>>();
+    }
+    return future;
+}
+
+auto CInferenceQueue::statistics() const -> Statistics
+{
+    Statistics statistics;
+    statistics.nrOfRequests = m_NrOfRequests;
+    statistics.nrOfBatches = m_NrOfBatches;
+    return statistics;
+}
+
+// ==========================================================================
+// class CInferenceQueue - private
+// ==========================================================================
+void CInferenceQueue::_run()
+{
+    std::vector<Request*> batch;
+    batch.reserve(m_Config.maxBatchSize);
+
+    for (;;)
+    {
+        Request* request = m_Requests.pop();
+        if (nullptr == request)
+        {
+            if (m_StopWorker && m_Requests.isEmpty())
+            {
+                break;
+            }
+            _waitForRequests();
+            continue;
+        }
+
+        // The first request opens the batch. Let further requests join it
+        // until it is full or the first one waited long enough.
+        batch.push_back(request);
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + m_Config.maxLatency;
+        while (batch.size() < m_Config.maxBatchSize)
+        {
+            request = m_Requests.pop();
+            if (request)
+            {
+                batch.push_back(request);
+            }
+            else if (m_StopWorker || (std::chrono::steady_clock::now() >= deadline))
+            {
+                break;
+            }
+            else
+            {
+                _waitForRequests(deadline);
+            }
+        }
+
+        _processBatch(batch);
+        batch.clear();
+    }
+}
+
+void CInferenceQueue::_waitForRequests()
+{
+    // Announce the wait before looking at the queue for the last time. So
+    // a producer either sees m_Waiting and notifies or its request is seen
+    // here.
+    m_Waiting = true;
+    {
+        std::unique_lock<std::mutex> lock(m_WakeUpMutex);
+        m_WakeUp.wait(lock, [this](){return !m_Requests.isEmpty() || m_StopWorker;});
+    }
+    m_Waiting = false;
+}
+
+void CInferenceQueue::_waitForRequests(const std::chrono::steady_clock::time_point& inDeadline)
+{
+    // Like _waitForRequests() but gives up at the deadline.
+    m_Waiting = true;
+    {
+        std::unique_lock<std::mutex> lock(m_WakeUpMutex);
+        m_WakeUp.wait_until(lock, inDeadline, [this](){return !m_Requests.isEmpty() || m_StopWorker;});
+    }
+    m_Waiting = false;
+}
+
+void CInferenceQueue::_processBatch(std::vector<Request*>& ioBatch)
+{
+    const unsigned int batchSize = static_cast<unsigned int>(ioBatch.size());
+    UTILS_TRACE_SCOPE(traceScope, "CInferenceQueue::processBatch", utils::CTrace::kNet, batchSize);
+
+    m_BatchInputs.resize(batchSize * m_NrOfInputs);
+    m_BatchOutputs.resize(batchSize * m_NrOfOutputs);
+    for (unsigned int requestIndex = 0; requestIndex < batchSize; ++requestIndex)
+    {
+        memcpy(m_BatchInputs.data() + requestIndex * m_NrOfInputs,
+               ioBatch[requestIndex]->m_Inputs.data(), m_NrOfInputs * sizeof(float));
+    }
+
+    // A failed batch is completed without outputs.
+    const bool success = (CNeuronalNet::Error::ok == m_Net.forwardPropagationBatch(m_BatchInputs.data(), batchSize, m_BatchOutputs.data()));
+
+    // Count first, so the statistics include a batch once its requests are completed.
+    m_NrOfRequests += batchSize;
+    ++m_NrOfBatches;
+
+    for (unsigned int requestIndex = 0; requestIndex < batchSize; ++requestIndex)
+    {
+        Request* request = ioBatch[requestIndex];
+        if (request->m_Completion)
+        {
+            request->m_Completion(success ? m_BatchOutputs.data() + requestIndex * m_NrOfOutputs : nullptr);
+        }
+        delete request;
+    }
+}
+
+} // namespace kilib
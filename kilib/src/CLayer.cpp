@@ -43,7 +43,14 @@
 #include "kilib/include/CLayer.hpp"
 #include "kilib/include/Activation.hpp"
 #include "utils/include/CMath.hpp"
+#include "utils/include/CClassicMathDriver.hpp"
+#include "utils/include/CRandom.hpp"
+#include "utils/include/CTrace.hpp"
+#include "utils/include/MathKernels.hpp"
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <new>
 
 static kilib::CActivationNull nullActivation;
@@ -59,6 +66,17 @@ static utils::CVectorF32* _allocateOutputValueVector(unsigned int inNrOfNeurons)
     return ret;
 }
 
+static utils::CVectorF32* _bindOutputValueVector(float* inStorage, unsigned int inNrOfNeurons)
+{
+    utils::CVectorF32* ret = new(std::nothrow) utils::CVectorF32(inStorage, inNrOfNeurons + 1);
+    assert(ret);
+    if (ret)
+    {
+        (*ret)[inNrOfNeurons] = 1.f; // Neutral Part for weightning offset calculation!
+    }
+    return ret;
+}
+
 static bool _allocateWeightningsVector(
     const kilib::CLayer* inParentLayer,
     unsigned int inNrOfNeurons,
@@ -82,12 +100,6 @@ static bool _allocateWeightningsVector(
             }
 
             outVector.push_back(thisVector);
-
-            // Randomize the Weightnings!
-            thisVector->for_each([](float& vectorValue)->void{
-                vectorValue = utils::CMath::randF32(0.f, 1.f);
-            });
-            (*thisVector)[thisVector->size()-1] = 0.f;
         }
     }
 
@@ -107,7 +119,8 @@ bool CLayer::init(
         unsigned int inNrOfNeurons,
         const IActivation& inActivation,
         utils::CMath& inMath,
-        CLayer* inParentLayer)
+        CLayer* inParentLayer,
+        bool inRandomizeWeightnings)
 {
     bool success = false;
     if (inNrOfNeurons > 0)
@@ -117,6 +130,7 @@ bool CLayer::init(
         m_Activation = &inActivation;
         m_ParentLayer = inParentLayer;
         m_Math = &inMath;
+        m_InlineDriver = dynamic_cast<const utils::CClassicMathDriver*>(&inMath.driver());
 
         m_OutputVector = _allocateOutputValueVector(inNrOfNeurons);
         assert(m_OutputVector);
@@ -125,6 +139,16 @@ bool CLayer::init(
             if (true == _allocateWeightningsVector(inParentLayer, inNrOfNeurons, m_WeightningVectors))
             {
                 success = true;
+                if (inRandomizeWeightnings && inParentLayer)
+                {
+                    // Draw from the stream of the layer index, as CNeuronalNet does.
+                    unsigned int layerIndex = 0;
+                    for (const CLayer* thisLayer = inParentLayer; thisLayer; thisLayer = thisLayer->m_ParentLayer)
+                    {
+                        ++layerIndex;
+                    }
+                    randomizeWeightnings(WeightInit::uniform, utils::CRandom(utils::CRandom::kDefaultSeed, layerIndex));
+                }
             }
             else // Failed to allocate the Weightning Buffer
             {
@@ -137,47 +161,71 @@ bool CLayer::init(
 
 const utils::CVectorF32* CLayer::forwardPropagation(bool recalcParentLayers)
 {
-    if (recalcParentLayers && m_ParentLayer)
+    if (!isInited())
     {
-        m_ParentLayer->forwardPropagation(recalcParentLayers);
+        return nullptr;
     }
 
-    utils::CVectorF32* ret = nullptr;
-    assert(m_OutputVector);
-    assert(m_Math);
-
-    if (isInited())
+    if (recalcParentLayers)
     {
-        if (m_ParentLayer)
+        // Propagate from the topmost parent layer downwards. This walks up
+        // the chain of parents instead of recursing into it.
+        unsigned int nrOfParentLayers = 0;
+        for (const CLayer* thisLayer = m_ParentLayer; thisLayer; thisLayer = thisLayer->m_ParentLayer)
         {
-            for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons(); ++thisNeuronIndex)
-            {
-                const utils::CVectorF32* weightningValues = _neuronWeightningVector(thisNeuronIndex);
-                assert(weightningValues);
-
-                const utils::CVectorF32* parentOutputValues = _parentNeuronOutputVector();
-                assert(parentOutputValues);
-
-                assert(parentOutputValues->size() == weightningValues->size());
-
-                (*m_OutputVector)[thisNeuronIndex] = m_Math->calcDotF32(*weightningValues, *parentOutputValues);
-            }
+            ++nrOfParentLayers;
+        }
 
-        } // if (m_ParentLayer)
-        if (m_Activation)
+        for (unsigned int depth = nrOfParentLayers; depth > 0; --depth)
         {
-            float integralPart = 1.f;
-            if (m_Activation->needsIntegralPart())
+            CLayer* thisLayer = this;
+            for (unsigned int i = 0; i < depth; ++i)
+            {
+                thisLayer = thisLayer->m_ParentLayer;
+            }
+            if (thisLayer->isInited())
             {
-                integralPart = m_Math->sumUpVector(*m_OutputVector, 0, m_OutputVector->size() - 1);
+                thisLayer->propagate();
             }
+        }
+    }
+    return propagate();
+}
+
+const utils::CVectorF32* CLayer::propagate()
+{
+    UTILS_TRACE_SCOPE(traceScope, "CLayer::forwardPropagation", utils::CTrace::kLayer, nrOfNeurons());
 
-            for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons(); ++thisNeuronIndex)
+    assert(m_OutputVector);
+    assert(m_Math);
+
+    if (m_IncrementalPropagation && m_ParentLayer && (WeightFormat::dense == m_WeightFormat) && _prepareIncrementalState())
+    {
+        if (m_IncrementalStateValid)
+        {
+            if (!_updatePreActivations())
             {
-                (*m_OutputVector)[thisNeuronIndex] = m_Activation->activation(0.f, integralPart, (*m_OutputVector)[thisNeuronIndex]);
+                // None of the inputs has changed. So the output is still valid.
+                return m_OutputVector;
             }
         }
-    } // if (isInited())
+        else
+        {
+            _calcPreActivations(*m_PreActivationVector);
+            *m_LastInputVector = *_parentNeuronOutputVector();
+            m_IncrementalStateValid = true;
+            m_NrOfIncrementalUpdates = 0;
+        }
+        _applyActivation(*m_PreActivationVector);
+    }
+    else
+    {
+        if (m_ParentLayer)
+        {
+            _calcPreActivations(*m_OutputVector);
+        }
+        _applyActivation(*m_OutputVector);
+    }
     return m_OutputVector;
 }
 
@@ -198,9 +246,16 @@ unsigned int CLayer::nrOfNeurons() const
 
 float* CLayer::weightningAtIndexForNeuron(unsigned int inNeuronIndex, unsigned int inWeightningIndex)
 {
-    float* weightningPtr = nullptr;
+    invalidate();
+    _makeDense();
+    return const_cast<float*>(const_cast<const CLayer*>(this)->weightningAtIndexForNeuron(inNeuronIndex, inWeightningIndex));
+}
 
-    utils::CVectorF32* weightningVectorPtr = CLayer::weightningVectorForNeuronAtIndex(inNeuronIndex);
+const float* CLayer::weightningAtIndexForNeuron(unsigned int inNeuronIndex, unsigned int inWeightningIndex) const
+{
+    const float* weightningPtr = nullptr;
+
+    const utils::CVectorF32* weightningVectorPtr = CLayer::weightningVectorForNeuronAtIndex(inNeuronIndex);
     if (weightningVectorPtr && (weightningVectorPtr->size() > 0) && (inWeightningIndex < weightningVectorPtr->size() - 1))
     {
         weightningPtr = &((*weightningVectorPtr)[inWeightningIndex]);
@@ -209,16 +264,18 @@ float* CLayer::weightningAtIndexForNeuron(unsigned int inNeuronIndex, unsigned i
     return weightningPtr;
 }
 
-const float* CLayer::weightningAtIndexForNeuron(unsigned int inNeuronIndex, unsigned int inWeightningIndex) const
+float* CLayer::biasForNeuron(unsigned int inNeuronIndex)
 {
-    return const_cast<const float*>(const_cast<CLayer*>(this)->weightningAtIndexForNeuron(inNeuronIndex, inWeightningIndex));
+    invalidate();
+    _makeDense();
+    return const_cast<float*>(const_cast<const CLayer*>(this)->biasForNeuron(inNeuronIndex));
 }
 
-float* CLayer::biasForNeuron(unsigned int inNeuronIndex)
+const float* CLayer::biasForNeuron(unsigned int inNeuronIndex) const
 {
-    float* biasPtr = nullptr;
+    const float* biasPtr = nullptr;
 
-    utils::CVectorF32* weightningVectorPtr = CLayer::weightningVectorForNeuronAtIndex(inNeuronIndex);
+    const utils::CVectorF32* weightningVectorPtr = CLayer::weightningVectorForNeuronAtIndex(inNeuronIndex);
     if (weightningVectorPtr && (weightningVectorPtr->size() > 0))
     {
         biasPtr = &((*weightningVectorPtr)[weightningVectorPtr->size() - 1]);
@@ -226,11 +283,6 @@ float* CLayer::biasForNeuron(unsigned int inNeuronIndex)
     return biasPtr;
 }
 
-const float* CLayer::biasForNeuron(unsigned int inNeuronIndex) const
-{
-    return const_cast<const float*>(const_cast<CLayer*>(this)->biasForNeuron(inNeuronIndex));
-}
-
 bool CLayer::isInputLayer() const
 {
     return nullptr == m_ParentLayer;
@@ -243,17 +295,19 @@ bool CLayer::isInited() const
 
 utils::CVectorF32* CLayer::weightningVectorForNeuronAtIndex(unsigned int inNeuronIndex)
 {
-    utils::CVectorF32* weightningVector = nullptr;
-    if (isInited() && m_ParentLayer)
-    {
-        weightningVector = _neuronWeightningVector(inNeuronIndex);
-    }
-    return weightningVector;
+    invalidate();
+    _makeDense();
+    return const_cast<utils::CVectorF32*>(const_cast<const CLayer*>(this)->weightningVectorForNeuronAtIndex(inNeuronIndex));
 }
 
 const utils::CVectorF32* CLayer::weightningVectorForNeuronAtIndex(unsigned int inNeuronIndex) const
 {
-    return const_cast<utils::CVectorF32*>(const_cast<CLayer*>(this)->weightningVectorForNeuronAtIndex(inNeuronIndex));
+    const utils::CVectorF32* weightningVector = nullptr;
+    if (isInited() && m_ParentLayer && (inNeuronIndex < m_WeightningVectors.size()))
+    {
+        weightningVector = m_WeightningVectors[inNeuronIndex];
+    }
+    return weightningVector;
 }
 
 unsigned int CLayer::nrOfWeightnings() const
@@ -261,6 +315,514 @@ unsigned int CLayer::nrOfWeightnings() const
     return _nrOfParentNeurons();
 }
 
+const CLayer::Profile& CLayer::profile() const
+{
+    return m_Profile;
+}
+
+void CLayer::resetProfile()
+{
+    m_Profile = Profile();
+}
+
+unsigned int CLayer::pruneWeightnings(float inSparsity)
+{
+    const WeightFormat weightFormat = m_WeightFormat;
+    if (!isInited() || !m_ParentLayer || !_makeDense())
+    {
+        return 0;
+    }
+
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    const unsigned int nrOfWeightnings = _nrOfParentNeurons();
+    const unsigned int nrOfAllWeightnings = nrOfNeurons * nrOfWeightnings;
+    const unsigned int nrToPrune = static_cast<unsigned int>(std::min(std::max(inSparsity, 0.f), 1.f) * nrOfAllWeightnings);
+
+    if (nrToPrune > 0)
+    {
+        std::vector<float> magnitudes;
+        magnitudes.reserve(nrOfAllWeightnings);
+        for (const utils::CVectorF32* thisVector : m_WeightningVectors)
+        {
+            for (unsigned int i = 0; i < nrOfWeightnings; ++i)
+            {
+                magnitudes.push_back(std::fabs((*thisVector)[i]));
+            }
+        }
+        std::nth_element(magnitudes.begin(), magnitudes.begin() + (nrToPrune - 1), magnitudes.end());
+        const float threshold = magnitudes[nrToPrune - 1];
+
+        // Prune everything below the threshold first. Then prune as many of
+        // the weightnings that equal the threshold as needed.
+        unsigned int nrOfPruned = 0;
+        for (const bool pruneEqual : {false, true})
+        {
+            for (utils::CVectorF32* thisVector : m_WeightningVectors)
+            {
+                for (unsigned int i = 0; (i < nrOfWeightnings) && (nrOfPruned < nrToPrune); ++i)
+                {
+                    const float magnitude = std::fabs((*thisVector)[i]);
+                    const bool prune = pruneEqual
+                        ? ((magnitude == threshold) && (0.f != (*thisVector)[i]))
+                        : (magnitude < threshold);
+                    if (prune)
+                    {
+                        (*thisVector)[i] = 0.f;
+                        ++nrOfPruned;
+                    }
+                }
+            }
+        }
+    }
+
+    invalidate();
+    setWeightFormat(weightFormat);
+    return static_cast<unsigned int>(std::lround(weightningSparsity() * nrOfAllWeightnings));
+}
+
+float CLayer::weightningSparsity() const
+{
+    const unsigned int nrOfWeightnings = _nrOfParentNeurons();
+    const unsigned int nrOfAllWeightnings = nrOfNeurons() * nrOfWeightnings;
+    if (!isInited() || (0 == nrOfAllWeightnings))
+    {
+        return 0.f;
+    }
+
+    unsigned int nrOfNonZeros = 0;
+    if (WeightFormat::dense == m_WeightFormat)
+    {
+        for (const utils::CVectorF32* thisVector : m_WeightningVectors)
+        {
+            for (unsigned int i = 0; i < nrOfWeightnings; ++i)
+            {
+                nrOfNonZeros += (0.f != (*thisVector)[i]);
+            }
+        }
+    }
+    else if (WeightFormat::panels == m_WeightFormat)
+    {
+        std::vector<float> weightnings(nrOfWeightnings + 1);
+        for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons(); ++thisNeuronIndex)
+        {
+            weightningsOfNeuron(thisNeuronIndex, weightnings.data());
+            for (unsigned int i = 0; i < nrOfWeightnings; ++i)
+            {
+                nrOfNonZeros += (0.f != weightnings[i]);
+            }
+        }
+    }
+    else
+    {
+        const unsigned int blockSize = (WeightFormat::csr == m_WeightFormat) ? 1 : kWeightBlockSize;
+        for (unsigned int k = 0; k < m_SparseValues.size(); ++k)
+        {
+            const unsigned int index = m_SparseIndices[k / blockSize] + (k % blockSize);
+            nrOfNonZeros += (index < nrOfWeightnings) && (0.f != m_SparseValues[k]);
+        }
+    }
+    return 1.f - float(nrOfNonZeros) / nrOfAllWeightnings;
+}
+
+bool CLayer::setWeightFormat(WeightFormat inWeightFormat)
+{
+    if (!isInited())
+    {
+        return false;
+    }
+    if (!m_ParentLayer)
+    {
+        // The input layer does not have any weightnings
+        return WeightFormat::dense == inWeightFormat;
+    }
+    if (inWeightFormat == m_WeightFormat)
+    {
+        return true;
+    }
+
+    const unsigned int rowSize = _nrOfParentNeurons() + 1;
+    if (((WeightFormat::blockSparse == inWeightFormat) && (rowSize < kWeightBlockSize)) || !_makeDense())
+    {
+        return false;
+    }
+    if (WeightFormat::dense == inWeightFormat)
+    {
+        return true;
+    }
+
+    if (WeightFormat::panels == inWeightFormat)
+    {
+        return _packPanels();
+    }
+
+    std::vector<float> values;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> rowOffsets;
+    rowOffsets.reserve(nrOfNeurons() + 1);
+
+    for (const utils::CVectorF32* thisVector : m_WeightningVectors)
+    {
+        const utils::CVectorF32& weightnings = *thisVector;
+        rowOffsets.push_back(static_cast<unsigned int>(indices.size()));
+
+        if (WeightFormat::csr == inWeightFormat)
+        {
+            for (unsigned int i = 0; i < rowSize; ++i)
+            {
+                if (0.f != weightnings[i])
+                {
+                    values.push_back(weightnings[i]);
+                    indices.push_back(i);
+                }
+            }
+        }
+        else
+        {
+            for (unsigned int start = 0; start < rowSize; start += kWeightBlockSize)
+            {
+                const unsigned int end = std::min(start + kWeightBlockSize, rowSize);
+                bool isZeroBlock = true;
+                for (unsigned int i = start; isZeroBlock && (i < end); ++i)
+                {
+                    isZeroBlock = (0.f == weightnings[i]);
+                }
+
+                if (!isZeroBlock)
+                {
+                    // The last block is shifted in front in order to fit into the
+                    // row. Its part that overlaps the previous block is zeroed.
+                    const unsigned int blockStart = std::min(start, rowSize - kWeightBlockSize);
+                    indices.push_back(blockStart);
+                    for (unsigned int i = blockStart; i < blockStart + kWeightBlockSize; ++i)
+                    {
+                        values.push_back((i >= start) ? weightnings[i] : 0.f);
+                    }
+                }
+            }
+        }
+    }
+    rowOffsets.push_back(static_cast<unsigned int>(indices.size()));
+
+    values.shrink_to_fit();
+    indices.shrink_to_fit();
+    m_SparseValues.swap(values);
+    m_SparseIndices.swap(indices);
+    m_SparseRowOffsets.swap(rowOffsets);
+
+    for (utils::CVectorF32* thisVector : m_WeightningVectors)
+    {
+        delete thisVector;
+    }
+    m_WeightningVectors.clear();
+
+    m_WeightFormat = inWeightFormat;
+    invalidate();
+    return true;
+}
+
+auto CLayer::weightFormat() const -> WeightFormat
+{
+    return m_WeightFormat;
+}
+
+size_t CLayer::weightningMemorySize() const
+{
+    size_t nrOfBytes = 0;
+    if (WeightFormat::dense == m_WeightFormat)
+    {
+        for (const utils::CVectorF32* thisVector : m_WeightningVectors)
+        {
+            nrOfBytes += thisVector->size() * sizeof(float);
+        }
+    }
+    else
+    {
+        nrOfBytes = (m_SparseValues.size() + m_PanelValues.size()) * sizeof(float)
+                  + (m_SparseIndices.size() + m_SparseRowOffsets.size()) * sizeof(unsigned int);
+    }
+    return nrOfBytes;
+}
+
+bool CLayer::weightningsOfNeuron(unsigned int inNeuronIndex, float* outWeightnings) const
+{
+    if (!isInited() || !m_ParentLayer || (inNeuronIndex >= nrOfNeurons()))
+    {
+        return false;
+    }
+
+    const unsigned int rowSize = _nrOfParentNeurons() + 1;
+    if (WeightFormat::dense == m_WeightFormat)
+    {
+        memcpy(outWeightnings, **m_WeightningVectors[inNeuronIndex], rowSize * sizeof(float));
+    }
+    else if (WeightFormat::panels == m_WeightFormat)
+    {
+        utils::kernels::unpackPanelRowF32(m_PanelValues.data(), rowSize, inNeuronIndex, outWeightnings);
+    }
+    else
+    {
+        const unsigned int blockSize = (WeightFormat::csr == m_WeightFormat) ? 1 : kWeightBlockSize;
+        std::fill(outWeightnings, outWeightnings + rowSize, 0.f);
+        for (unsigned int b = m_SparseRowOffsets[inNeuronIndex]; b < m_SparseRowOffsets[inNeuronIndex + 1]; ++b)
+        {
+            for (unsigned int i = 0; i < blockSize; ++i)
+            {
+                // Zeros may overlap the previous block (see setWeightFormat())
+                const float value = m_SparseValues[b * blockSize + i];
+                if (0.f != value)
+                {
+                    outWeightnings[m_SparseIndices[b] + i] = value;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CLayer::propagateBatch(const float* inInputs, unsigned int inBatchSize, float* outOutputs)
+{
+    if (!isInited() || !m_ParentLayer)
+    {
+        return false;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CLayer::propagateBatch", utils::CTrace::kLayer, inBatchSize);
+
+    const unsigned int inputRowSize = _nrOfParentNeurons() + 1;
+    const unsigned int outputRowSize = nrOfNeurons() + 1;
+    if (WeightFormat::panels == m_WeightFormat)
+    {
+        // All samples at once. Every panel of weightnings is loaded into the
+        // cache once per block of samples instead of once per sample.
+        KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+            2ull * inBatchSize * nrOfNeurons() * inputRowSize,
+            sizeof(float) * (m_PanelValues.size() + inBatchSize * (inputRowSize + nrOfNeurons())));
+
+        m_Math->calcPanelGemmF32(m_PanelValues.data(), nrOfNeurons(), inputRowSize,
+                                 inInputs, inBatchSize, inputRowSize, outOutputs, outputRowSize);
+    }
+
+    for (unsigned int sampleIndex = 0; sampleIndex < inBatchSize; ++sampleIndex)
+    {
+        // The vectors just refer to the rows of the batch (no copy).
+        const utils::CVectorF32 inputRow(const_cast<float*>(inInputs) + sampleIndex * inputRowSize, inputRowSize);
+        utils::CVectorF32 outputRow(outOutputs + sampleIndex * outputRowSize, outputRowSize);
+        assert(1.f == inputRow[inputRowSize - 1]);
+
+        if (WeightFormat::panels != m_WeightFormat)
+        {
+            _calcPreActivations(inputRow, outputRow);
+        }
+        outputRow[outputRowSize - 1] = 1.f;
+        _activateInPlace(outputRow);
+    }
+    return true;
+}
+
+bool CLayer::propagateNeurons(const unsigned int* inNeuronIndices, unsigned int inNrOfNeurons, float* outValues)
+{
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    if (!isInited() || !m_ParentLayer)
+    {
+        return false;
+    }
+    for (unsigned int i = 0; i < inNrOfNeurons; ++i)
+    {
+        if (inNeuronIndices[i] >= nrOfNeurons)
+        {
+            return false;
+        }
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CLayer::propagateNeurons", utils::CTrace::kLayer, inNrOfNeurons);
+
+    if (m_Activation && m_Activation->needsIntegralPart())
+    {
+        const utils::CVectorF32& outputValues = *propagate();
+        for (unsigned int i = 0; i < inNrOfNeurons; ++i)
+        {
+            outValues[i] = outputValues[inNeuronIndices[i]];
+        }
+        return true;
+    }
+
+    // A panel is calculated as a whole, so keep the last one for its neighbours.
+    const bool isPanels = (WeightFormat::panels == m_WeightFormat);
+    float preActivations[utils::kernels::kPanelSize];
+    unsigned int firstNeuronIndex = nrOfNeurons;
+    for (unsigned int i = 0; i < inNrOfNeurons; ++i)
+    {
+        const unsigned int neuronIndex = inNeuronIndices[i];
+        if (!isPanels)
+        {
+            firstNeuronIndex = neuronIndex;
+            _calcPreActivationsOfNeurons(neuronIndex, 1, preActivations);
+        }
+        else if ((neuronIndex < firstNeuronIndex) || (neuronIndex >= firstNeuronIndex + utils::kernels::kPanelSize))
+        {
+            firstNeuronIndex = neuronIndex - neuronIndex % utils::kernels::kPanelSize;
+            _calcPreActivationsOfNeurons(firstNeuronIndex,
+                std::min<unsigned int>(utils::kernels::kPanelSize, nrOfNeurons - firstNeuronIndex), preActivations);
+        }
+
+        const float preActivation = preActivations[neuronIndex - firstNeuronIndex];
+        outValues[i] = m_Activation ? m_Activation->activation(0.f, 1.f, preActivation) : preActivation;
+    }
+    return true;
+}
+
+bool CLayer::propagateTopK(unsigned int inK, unsigned int* outNeuronIndices, float* outValues)
+{
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    if (!isInited() || !m_ParentLayer || (0 == inK) || (inK > nrOfNeurons))
+    {
+        return false;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CLayer::propagateTopK", utils::CTrace::kLayer, inK);
+
+    // Greater values first, equal values by their indices.
+    const auto isBetter = [](const std::pair<float, unsigned int>& inA, const std::pair<float, unsigned int>& inB) {
+        return (inA.first > inB.first) || ((inA.first == inB.first) && (inA.second < inB.second));
+    };
+
+    m_TopKHeap.clear();
+    m_TopKHeap.reserve(inK);
+    const auto offer = [&](float inValue, unsigned int inNeuronIndex) {
+        const std::pair<float, unsigned int> candidate(inValue, inNeuronIndex);
+        if (m_TopKHeap.size() < inK)
+        {
+            m_TopKHeap.push_back(candidate);
+            std::push_heap(m_TopKHeap.begin(), m_TopKHeap.end(), isBetter);
+        }
+        else if (isBetter(candidate, m_TopKHeap.front()))
+        {
+            std::pop_heap(m_TopKHeap.begin(), m_TopKHeap.end(), isBetter);
+            m_TopKHeap.back() = candidate;
+            std::push_heap(m_TopKHeap.begin(), m_TopKHeap.end(), isBetter);
+        }
+    };
+
+    if (m_Activation && m_Activation->needsIntegralPart())
+    {
+        const utils::CVectorF32& outputValues = *propagate();
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+        {
+            offer(outputValues[neuronIndex], neuronIndex);
+        }
+    }
+    else
+    {
+        // Calculate a panel worth of neurons at once.
+        float preActivations[utils::kernels::kPanelSize];
+        for (unsigned int firstNeuronIndex = 0; firstNeuronIndex < nrOfNeurons; firstNeuronIndex += utils::kernels::kPanelSize)
+        {
+            const unsigned int nrOfValues = std::min<unsigned int>(utils::kernels::kPanelSize, nrOfNeurons - firstNeuronIndex);
+            _calcPreActivationsOfNeurons(firstNeuronIndex, nrOfValues, preActivations);
+            for (unsigned int i = 0; i < nrOfValues; ++i)
+            {
+                offer(m_Activation ? m_Activation->activation(0.f, 1.f, preActivations[i]) : preActivations[i],
+                      firstNeuronIndex + i);
+            }
+        }
+    }
+
+    std::sort_heap(m_TopKHeap.begin(), m_TopKHeap.end(), isBetter);
+    for (unsigned int i = 0; i < inK; ++i)
+    {
+        outNeuronIndices[i] = m_TopKHeap[i].second;
+        if (outValues)
+        {
+            outValues[i] = m_TopKHeap[i].first;
+        }
+    }
+    return true;
+}
+
+bool CLayer::setOutputStorage(float* inExternalStorage)
+{
+    bool success = false;
+    if (isInited())
+    {
+        const unsigned int nrOfNeurons = this->nrOfNeurons();
+        utils::CVectorF32* outputVector = inExternalStorage
+            ? _bindOutputValueVector(inExternalStorage, nrOfNeurons)
+            : _allocateOutputValueVector(nrOfNeurons);
+        if (outputVector)
+        {
+            delete m_OutputVector;
+            m_OutputVector = outputVector;
+            invalidate();
+            success = true;
+        }
+    }
+    return success;
+}
+
+void CLayer::setIncrementalPropagation(bool inEnable)
+{
+    m_IncrementalPropagation = inEnable;
+    invalidate();
+}
+
+bool CLayer::isIncrementalPropagation() const
+{
+    return m_IncrementalPropagation;
+}
+
+bool CLayer::randomizeWeightnings(WeightInit inWeightInit, const utils::CRandom& inRandom)
+{
+    if (!isInited() || !m_ParentLayer || !_makeDense())
+    {
+        return false;
+    }
+    randomizeWeightnings(inWeightInit, inRandom, 0, nrOfNeurons());
+    invalidate();
+    return true;
+}
+
+bool CLayer::randomizeWeightnings(WeightInit inWeightInit, const utils::CRandom& inRandom,
+                                  unsigned int inFirstNeuron, unsigned int inNrOfNeurons)
+{
+    if (!isInited() || !m_ParentLayer || (WeightFormat::dense != m_WeightFormat)
+        || (inFirstNeuron > nrOfNeurons()) || (inNrOfNeurons > nrOfNeurons() - inFirstNeuron))
+    {
+        return false;
+    }
+
+    const unsigned int nrOfInputs = _nrOfParentNeurons();
+    const unsigned int rowSize = nrOfInputs + 1;
+    for (unsigned int neuronIndex = inFirstNeuron; neuronIndex < inFirstNeuron + inNrOfNeurons; ++neuronIndex)
+    {
+        float* row = **m_WeightningVectors[neuronIndex];
+        const std::uint64_t position = std::uint64_t(neuronIndex) * rowSize;
+        switch (inWeightInit)
+        {
+            case WeightInit::uniform:
+                inRandom.fillUniformF32(position, row, nrOfInputs, 0.f, 1.f);
+                break;
+
+            case WeightInit::xavier:
+            {
+                const float limit = std::sqrt(6.f / (nrOfInputs + nrOfNeurons()));
+                inRandom.fillUniformF32(position, row, nrOfInputs, -limit, limit);
+                break;
+            }
+
+            case WeightInit::he:
+                inRandom.fillNormalF32(position, row, nrOfInputs, 0.f, std::sqrt(2.f / nrOfInputs));
+                break;
+        }
+        row[nrOfInputs] = 0.f; // The bias
+    }
+    return true;
+}
+
+void CLayer::invalidate()
+{
+    m_IncrementalStateValid = false;
+}
+
 // ==========================================================================
 // CLayer - private
 // ==========================================================================
@@ -269,6 +831,18 @@ void CLayer::_cleanup()
     delete m_OutputVector;
     m_OutputVector = nullptr;
 
+    delete m_PreActivationVector;
+    m_PreActivationVector = nullptr;
+
+    delete m_LastInputVector;
+    m_LastInputVector = nullptr;
+
+    m_ChangedInputIndices.clear();
+    m_IncrementalStateValid = false;
+
+    _releaseSparseWeightnings();
+    m_WeightFormat = WeightFormat::dense;
+
     // Delete every Vector
     for (utils::CVectorF32* thisVector : m_WeightningVectors)
     {
@@ -278,6 +852,333 @@ void CLayer::_cleanup()
     m_WeightningVectors.clear();
 }
 
+bool CLayer::_prepareIncrementalState()
+{
+    if (nullptr == m_PreActivationVector)
+    {
+        m_PreActivationVector = new(std::nothrow) utils::CVectorF32(nrOfNeurons() + 1);
+        m_LastInputVector = new(std::nothrow) utils::CVectorF32(_nrOfParentNeurons() + 1);
+        if (!m_PreActivationVector || !m_LastInputVector)
+        {
+            delete m_PreActivationVector;
+            m_PreActivationVector = nullptr;
+            delete m_LastInputVector;
+            m_LastInputVector = nullptr;
+            return false;
+        }
+        m_ChangedInputIndices.reserve(_nrOfParentNeurons());
+        m_IncrementalStateValid = false;
+    }
+    return true;
+}
+
+void CLayer::_calcPreActivations(utils::CVectorF32& outPreActivations)
+{
+    const utils::CVectorF32* parentOutputValues = _parentNeuronOutputVector();
+    assert(parentOutputValues);
+    _calcPreActivations(*parentOutputValues, outPreActivations);
+}
+
+void CLayer::_calcPreActivations(const utils::CVectorF32& inInputValues, utils::CVectorF32& outPreActivations)
+{
+    if (m_InlineDriver)
+    {
+        _calcPreActivations(utils::CBasicMath<utils::CClassicMathDriver>(*m_InlineDriver), inInputValues, outPreActivations);
+    }
+    else
+    {
+        _calcPreActivations(*m_Math, inInputValues, outPreActivations);
+    }
+}
+
+template <typename TMath>
+void CLayer::_calcPreActivations(const TMath& inMath, const utils::CVectorF32& inInputValues, utils::CVectorF32& outPreActivations)
+{
+    const utils::CVectorF32* parentOutputValues = &inInputValues;
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+
+    switch (m_WeightFormat)
+    {
+        case WeightFormat::dense:
+        {
+            // Every neuron weights its parents output (+ the bias) by a multiply and an add.
+            KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+                2ull * nrOfNeurons * (_nrOfParentNeurons() + 1),
+                sizeof(float) * ((nrOfNeurons + 1ull) * (_nrOfParentNeurons() + 1) + nrOfNeurons));
+
+            for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons; ++thisNeuronIndex)
+            {
+                const utils::CVectorF32* weightningValues = m_WeightningVectors[thisNeuronIndex];
+                assert(weightningValues);
+                assert(parentOutputValues->size() == weightningValues->size());
+
+                outPreActivations[thisNeuronIndex] = inMath.calcDotF32(*weightningValues, *parentOutputValues);
+            }
+            break;
+        }
+
+        case WeightFormat::csr:
+        {
+            // Every non zero weightning is a multiply, an add and a gather.
+            KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+                2ull * m_SparseValues.size(),
+                sizeof(float) * (3ull * m_SparseValues.size() + nrOfNeurons));
+
+            for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons; ++thisNeuronIndex)
+            {
+                const unsigned int first = m_SparseRowOffsets[thisNeuronIndex];
+                outPreActivations[thisNeuronIndex] = inMath.calcSparseDotF32(
+                    m_SparseValues.data() + first, m_SparseIndices.data() + first,
+                    m_SparseRowOffsets[thisNeuronIndex + 1] - first, *parentOutputValues);
+            }
+            break;
+        }
+
+        case WeightFormat::panels:
+        {
+            // The same work as the dense format, just ordered by panels.
+            KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+                2ull * nrOfNeurons * (_nrOfParentNeurons() + 1),
+                sizeof(float) * ((nrOfNeurons + 1ull) * (_nrOfParentNeurons() + 1) + nrOfNeurons));
+
+            inMath.calcPanelGemvF32(m_PanelValues.data(), nrOfNeurons, _nrOfParentNeurons() + 1,
+                                     *(*parentOutputValues), *outPreActivations);
+            break;
+        }
+
+        case WeightFormat::blockSparse:
+        {
+            KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+                2ull * m_SparseValues.size(),
+                sizeof(float) * (2ull * m_SparseValues.size() + m_SparseIndices.size() + nrOfNeurons));
+
+            for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons; ++thisNeuronIndex)
+            {
+                const unsigned int first = m_SparseRowOffsets[thisNeuronIndex];
+                outPreActivations[thisNeuronIndex] = inMath.calcBlockSparseDotF32(
+                    m_SparseValues.data() + first * kWeightBlockSize, m_SparseIndices.data() + first,
+                    m_SparseRowOffsets[thisNeuronIndex + 1] - first, kWeightBlockSize, *parentOutputValues);
+            }
+            break;
+        }
+    }
+}
+
+void CLayer::_calcPreActivationsOfNeurons(unsigned int inFirstNeuronIndex, unsigned int inNrOfNeurons, float* outPreActivations)
+{
+    if (m_InlineDriver)
+    {
+        _calcPreActivationsOfNeurons(utils::CBasicMath<utils::CClassicMathDriver>(*m_InlineDriver),
+                                     inFirstNeuronIndex, inNrOfNeurons, outPreActivations);
+    }
+    else
+    {
+        _calcPreActivationsOfNeurons(*m_Math, inFirstNeuronIndex, inNrOfNeurons, outPreActivations);
+    }
+}
+
+template <typename TMath>
+void CLayer::_calcPreActivationsOfNeurons(const TMath& inMath, unsigned int inFirstNeuronIndex, unsigned int inNrOfNeurons, float* outPreActivations)
+{
+    const utils::CVectorF32& parentOutputValues = *_parentNeuronOutputVector();
+    const unsigned int rowSize = _nrOfParentNeurons() + 1;
+    KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+        2ull * inNrOfNeurons * rowSize,
+        sizeof(float) * ((inNrOfNeurons + 1ull) * rowSize + inNrOfNeurons));
+
+    if (WeightFormat::panels == m_WeightFormat)
+    {
+        // The neurons need to be a single panel (or the last part of it).
+        assert(0 == inFirstNeuronIndex % utils::kernels::kPanelSize);
+        assert(inNrOfNeurons <= utils::kernels::kPanelSize);
+        inMath.calcPanelGemvF32(m_PanelValues.data() + size_t(inFirstNeuronIndex) * rowSize, inNrOfNeurons, rowSize,
+                                *parentOutputValues, outPreActivations);
+        return;
+    }
+
+    for (unsigned int i = 0; i < inNrOfNeurons; ++i)
+    {
+        const unsigned int thisNeuronIndex = inFirstNeuronIndex + i;
+        const unsigned int first = (WeightFormat::dense != m_WeightFormat) ? m_SparseRowOffsets[thisNeuronIndex] : 0;
+        switch (m_WeightFormat)
+        {
+            case WeightFormat::dense:
+                outPreActivations[i] = inMath.calcDotF32(*m_WeightningVectors[thisNeuronIndex], parentOutputValues);
+                break;
+
+            case WeightFormat::csr:
+                outPreActivations[i] = inMath.calcSparseDotF32(
+                    m_SparseValues.data() + first, m_SparseIndices.data() + first,
+                    m_SparseRowOffsets[thisNeuronIndex + 1] - first, parentOutputValues);
+                break;
+
+            case WeightFormat::blockSparse:
+                outPreActivations[i] = inMath.calcBlockSparseDotF32(
+                    m_SparseValues.data() + first * kWeightBlockSize, m_SparseIndices.data() + first,
+                    m_SparseRowOffsets[thisNeuronIndex + 1] - first, kWeightBlockSize, parentOutputValues);
+                break;
+
+            case WeightFormat::panels:
+                break;
+        }
+    }
+}
+
+bool CLayer::_updatePreActivations()
+{
+    // Beyond these limits a full calculation is cheaper or more accurate.
+    static constexpr unsigned int kMaxChangedInputsDivisor = 4;
+    static constexpr unsigned int kMaxNrOfIncrementalUpdates = 256;
+
+    const utils::CVectorF32& parentOutputValues = *_parentNeuronOutputVector();
+    utils::CVectorF32& lastInputValues = *m_LastInputVector;
+    const unsigned int nrOfInputs = _nrOfParentNeurons();
+
+    m_ChangedInputIndices.clear();
+    for (unsigned int inputIndex = 0; inputIndex < nrOfInputs; ++inputIndex)
+    {
+        if (parentOutputValues[inputIndex] != lastInputValues[inputIndex])
+        {
+            m_ChangedInputIndices.push_back(inputIndex);
+        }
+    }
+
+    const unsigned int nrOfChangedInputs = static_cast<unsigned int>(m_ChangedInputIndices.size());
+    if (0 == nrOfChangedInputs)
+    {
+        return false;
+    }
+
+    if ((nrOfChangedInputs * kMaxChangedInputsDivisor > nrOfInputs)
+        || (++m_NrOfIncrementalUpdates > kMaxNrOfIncrementalUpdates))
+    {
+        _calcPreActivations(*m_PreActivationVector);
+        lastInputValues = parentOutputValues;
+        m_NrOfIncrementalUpdates = 0;
+        return true;
+    }
+
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    KILIB_PROFILE_PHASE(dotProductScope, m_Profile.dotProduct,
+        2ull * nrOfNeurons * nrOfChangedInputs,
+        sizeof(float) * (2ull * nrOfNeurons * nrOfChangedInputs + nrOfNeurons));
+
+    utils::CVectorF32& preActivations = *m_PreActivationVector;
+    for (const unsigned int inputIndex : m_ChangedInputIndices)
+    {
+        const float delta = parentOutputValues[inputIndex] - lastInputValues[inputIndex];
+        lastInputValues[inputIndex] = parentOutputValues[inputIndex];
+
+        for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons; ++thisNeuronIndex)
+        {
+            preActivations[thisNeuronIndex] += (*m_WeightningVectors[thisNeuronIndex])[inputIndex] * delta;
+        }
+    }
+    return true;
+}
+
+void CLayer::_applyActivation(const utils::CVectorF32& inPreActivations)
+{
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    if (&inPreActivations != m_OutputVector)
+    {
+        memcpy(**m_OutputVector, *inPreActivations, nrOfNeurons * sizeof(float));
+    }
+    _activateInPlace(*m_OutputVector);
+}
+
+void CLayer::_activateInPlace(utils::CVectorF32& ioValues)
+{
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    if (m_Activation)
+    {
+        const bool needsIntegralPart = m_Activation->needsIntegralPart();
+        KILIB_PROFILE_PHASE(activationScope, m_Profile.activation,
+            (needsIntegralPart ? 2 : 1) * nrOfNeurons,
+            sizeof(float) * (needsIntegralPart ? 3 : 2) * nrOfNeurons);
+
+        float integralPart = 1.f;
+        if (needsIntegralPart)
+        {
+            integralPart = m_Math->sumUpVector(ioValues, 0, nrOfNeurons);
+        }
+
+        for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons; ++thisNeuronIndex)
+        {
+            ioValues[thisNeuronIndex] = m_Activation->activation(0.f, integralPart, ioValues[thisNeuronIndex]);
+        }
+    }
+}
+
+bool CLayer::_makeDense()
+{
+    if (WeightFormat::dense == m_WeightFormat)
+    {
+        return true;
+    }
+
+    const unsigned int nrOfNeurons = this->nrOfNeurons();
+    const unsigned int rowSize = _nrOfParentNeurons() + 1;
+
+    std::vector<utils::CVectorF32*> weightningVectors;
+    weightningVectors.reserve(nrOfNeurons);
+    for (unsigned int thisNeuronIndex = 0; thisNeuronIndex < nrOfNeurons; ++thisNeuronIndex)
+    {
+        utils::CVectorF32* thisVector = new(std::nothrow) utils::CVectorF32(rowSize);
+        assert(thisVector);
+        if (nullptr == thisVector)
+        {
+            for (utils::CVectorF32* allocatedVector : weightningVectors)
+            {
+                delete allocatedVector;
+            }
+            return false;
+        }
+        weightningsOfNeuron(thisNeuronIndex, **thisVector);
+        weightningVectors.push_back(thisVector);
+    }
+
+    m_WeightningVectors.swap(weightningVectors);
+    _releaseSparseWeightnings();
+    m_WeightFormat = WeightFormat::dense;
+    invalidate();
+    return true;
+}
+
+bool CLayer::_packPanels()
+{
+    const unsigned int rowSize = _nrOfParentNeurons() + 1;
+
+    std::vector<const float*> rows;
+    rows.reserve(m_WeightningVectors.size());
+    for (const utils::CVectorF32* thisVector : m_WeightningVectors)
+    {
+        rows.push_back(**thisVector);
+    }
+
+    std::vector<float> panelValues(utils::kernels::panelMatrixSize(rows.size(), rowSize));
+    utils::kernels::packPanelsF32(rows.data(), rows.size(), rowSize, panelValues.data());
+    m_PanelValues.swap(panelValues);
+
+    for (utils::CVectorF32* thisVector : m_WeightningVectors)
+    {
+        delete thisVector;
+    }
+    m_WeightningVectors.clear();
+
+    m_WeightFormat = WeightFormat::panels;
+    invalidate();
+    return true;
+}
+
+void CLayer::_releaseSparseWeightnings()
+{
+    std::vector<float>().swap(m_SparseValues);
+    std::vector<unsigned int>().swap(m_SparseIndices);
+    std::vector<unsigned int>().swap(m_SparseRowOffsets);
+    std::vector<float>().swap(m_PanelValues);
+}
+
 utils::CVectorF32* CLayer::_neuronWeightningVector(unsigned int forNeuronIndex)
 {
     utils::CVectorF32* weightningVectorPtr = nullptr;
@@ -43,9 +43,154 @@
 #include "kilib/include/CNeuronalNet.hpp"
 #include "kilib/include/CLayer.hpp"
 #include "kilib/include/Activation.hpp"
+#include "utils/include/CTrace.hpp"
 #include <cassert>
 #include <cstdio>
+#include <cstring>
+#include <cstdint>
 #include <algorithm>
+#include <atomic>
+#if defined(KILIB_ENABLE_THREADS)
+#include <thread>
+#endif
+
+static constexpr char kFileMagic[4] = {'T', 'M', 'L', 'N'};
+static constexpr std::uint32_t kFileVersion = 1;
+static constexpr unsigned int kActivationNameSize = 32;
+static constexpr std::uint32_t kMaxNrOfLayers = 0x10000;
+static constexpr std::uint32_t kMaxNrOfNeurons = 0x1000000;
+
+static bool _writeU32(std::FILE* inFile, std::uint32_t inValue)
+{
+    return 1 == fwrite(&inValue, sizeof(inValue), 1, inFile);
+}
+
+static bool _readU32(std::FILE* inFile, std::uint32_t& outValue)
+{
+    return 1 == fread(&outValue, sizeof(outValue), 1, inFile);
+}
+
+/*!
+ * @brief Determines the number of bytes from the current position to the end of a file.
+ * @return false if the file is not seekable.
+ */
+static bool _remainingFileSize(std::FILE* inFile, std::uint64_t& outSize)
+{
+    const long position = ftell(inFile);
+    if ((position < 0) || (0 != fseek(inFile, 0, SEEK_END)))
+    {
+        return false;
+    }
+    const long size = ftell(inFile);
+    outSize = (size >= position) ? static_cast<std::uint64_t>(size - position) : 0;
+    return (size >= 0) && (0 == fseek(inFile, position, SEEK_SET));
+}
+
+/*!
+ * @brief Determines whether the rest of a file holds exactly the weightnings
+ * and biases of a topology.
+ */
+static bool _hasPayloadOfTopology(std::FILE* inFile, const std::vector<unsigned int>& inTopology)
+{
+    std::uint64_t remainingSize = 0;
+    if (!_remainingFileSize(inFile, remainingSize))
+    {
+        return false;
+    }
+
+    // No overflow: Every layer needs less than 2^51 bytes and the sum is bounded by the file size.
+    std::uint64_t payloadSize = 0;
+    for (size_t layerIndex = 1; layerIndex < inTopology.size(); ++layerIndex)
+    {
+        const std::uint64_t layerSize = sizeof(float) * inTopology[layerIndex] * (inTopology[layerIndex - 1] + 1ull);
+        if (layerSize > remainingSize - payloadSize)
+        {
+            return false;
+        }
+        payloadSize += layerSize;
+    }
+    return remainingSize == payloadSize;
+}
+
+/*!
+ * @brief The weightnings of a layer as a dense matrix: One row per neuron of
+ * the weightnings followed by the bias.
+ */
+struct LayerMatrix
+{
+    unsigned int nrOfInputs = 0;
+    unsigned int nrOfNeurons = 0;
+    std::vector<float> values;
+
+    float* row(unsigned int inNeuronIndex) {return values.data() + inNeuronIndex * (nrOfInputs + 1);}
+    const float* row(unsigned int inNeuronIndex) const {return values.data() + inNeuronIndex * (nrOfInputs + 1);}
+
+    /// @brief The multiplications of a propagation.
+    unsigned long long cost() const {return 1ull * nrOfNeurons * (nrOfInputs + 1);}
+};
+
+/*!
+ * @brief Merges two consecutive layers, the first being linear.
+ * @param inFirst The matrix of the first (linear) layer.
+ * @param inSecond The matrix of the layer that is fed by \p inFirst.
+ * @return The matrix of a layer that maps the inputs of \p inFirst to the
+ *     pre-activations of \p inSecond.
+ */
+static LayerMatrix _mergeLayers(const LayerMatrix& inFirst, const LayerMatrix& inSecond)
+{
+    LayerMatrix merged;
+    merged.nrOfInputs = inFirst.nrOfInputs;
+    merged.nrOfNeurons = inSecond.nrOfNeurons;
+    merged.values.assign(merged.cost(), 0.f);
+
+    const unsigned int rowSize = inFirst.nrOfInputs + 1;
+    for (unsigned int neuronIndex = 0; neuronIndex < merged.nrOfNeurons; ++neuronIndex)
+    {
+        const float* secondRow = inSecond.row(neuronIndex);
+        float* mergedRow = merged.row(neuronIndex);
+        for (unsigned int j = 0; j < inFirst.nrOfNeurons; ++j)
+        {
+            // The biases of the first layer are weighted like its weightnings.
+            const float* firstRow = inFirst.row(j);
+            for (unsigned int k = 0; k < rowSize; ++k)
+            {
+                mergedRow[k] += secondRow[j] * firstRow[k];
+            }
+        }
+        mergedRow[rowSize - 1] += secondRow[inFirst.nrOfNeurons];
+    }
+    return merged;
+}
+
+/*!
+ * @brief Removes a neuron of a layer and its outgoing weightnings.
+ * @param ioLayer The matrix of the layer.
+ * @param ioSuccessor The matrix of the layer that is fed by \p ioLayer.
+ * @param inNeuronIndex The neuron to remove.
+ */
+static void _removeNeuron(LayerMatrix& ioLayer, LayerMatrix& ioSuccessor, unsigned int inNeuronIndex)
+{
+    ioLayer.values.erase(ioLayer.values.begin() + inNeuronIndex * (ioLayer.nrOfInputs + 1),
+                         ioLayer.values.begin() + (inNeuronIndex + 1) * (ioLayer.nrOfInputs + 1));
+    --ioLayer.nrOfNeurons;
+
+    // Compact the rows of the successor in place.
+    const unsigned int oldRowSize = ioSuccessor.nrOfInputs + 1;
+    float* destination = ioSuccessor.values.data();
+    for (unsigned int neuronIndex = 0; neuronIndex < ioSuccessor.nrOfNeurons; ++neuronIndex)
+    {
+        const float* source = ioSuccessor.values.data() + neuronIndex * oldRowSize;
+        for (unsigned int k = 0; k < oldRowSize; ++k)
+        {
+            if (k != inNeuronIndex)
+            {
+                *destination++ = source[k];
+            }
+        }
+    }
+    --ioSuccessor.nrOfInputs;
+    ioSuccessor.values.resize(ioSuccessor.cost());
+}
 
 namespace kilib {
 // ==========================================================================
@@ -62,6 +207,11 @@ CLayer* CNeuronalNet::layer(unsigned int inIndex)
     return inIndex < m_Layers.size() ? m_Layers[inIndex] : nullptr;
 }
 
+const CLayer* CNeuronalNet::layer(unsigned int inIndex) const
+{
+    return inIndex < m_Layers.size() ? m_Layers[inIndex] : nullptr;
+}
+
 CLayer* CNeuronalNet::outputLayer()
 {
     return m_Layers.empty() ? nullptr : m_Layers.back();
@@ -83,10 +233,680 @@ auto CNeuronalNet::init(
     const CLayer::IActivation& inOutputActivation,
     utils::CMath& inMath
     ) -> Error
+{
+    return _init(inNeuronLayers, inHiddenLayerActivation, inOutputActivation, inMath, true);
+}
+
+void CNeuronalNet::setWeightInit(CLayer::WeightInit inWeightInit, std::uint64_t inSeed)
+{
+    m_WeightInit = inWeightInit;
+    m_WeightInitSeed = inSeed;
+}
+
+CLayer::WeightInit CNeuronalNet::weightInit() const
+{
+    return m_WeightInit;
+}
+
+std::uint64_t CNeuronalNet::weightInitSeed() const
+{
+    return m_WeightInitSeed;
+}
+
+auto CNeuronalNet::save(const char* inPath) const -> Error
+{
+    if (m_Layers.empty() || !m_HiddenLayerActivation || !m_OutputActivation)
+    {
+        return Error::notInited;
+    }
+
+    const char* hiddenName = m_HiddenLayerActivation->name();
+    const char* outputName = m_OutputActivation->name();
+    if (!hiddenName || !outputName || (strlen(hiddenName) >= kActivationNameSize) || (strlen(outputName) >= kActivationNameSize))
+    {
+        return Error::unknownActivation;
+    }
+
+    std::FILE* file = fopen(inPath, "wb");
+    if (nullptr == file)
+    {
+        return Error::io;
+    }
+
+    bool success = (1 == fwrite(kFileMagic, sizeof(kFileMagic), 1, file))
+                && _writeU32(file, kFileVersion)
+                && _writeU32(file, nrOfLayers());
+    for (unsigned int layerIndex = 0; success && (layerIndex < nrOfLayers()); ++layerIndex)
+    {
+        success = _writeU32(file, neuronsInLayer(layerIndex));
+    }
+
+    char names[2][kActivationNameSize] = {};
+    strncpy(names[0], hiddenName, kActivationNameSize - 1);
+    strncpy(names[1], outputName, kActivationNameSize - 1);
+    success = success && (1 == fwrite(names, sizeof(names), 1, file));
+
+    for (unsigned int layerIndex = 1; success && (layerIndex < nrOfLayers()); ++layerIndex)
+    {
+        const CLayer* thisLayer = m_Layers[layerIndex];
+        std::vector<float> weightnings(thisLayer->nrOfWeightnings() + 1);
+        for (unsigned int neuronIndex = 0; success && (neuronIndex < thisLayer->nrOfNeurons()); ++neuronIndex)
+        {
+            // The weightnings are followed by the bias.
+            success = thisLayer->weightningsOfNeuron(neuronIndex, weightnings.data())
+                   && (weightnings.size() == fwrite(weightnings.data(), sizeof(float), weightnings.size(), file));
+        }
+    }
+
+    success = (0 == fclose(file)) && success;
+    return success ? Error::ok : Error::io;
+}
+
+auto CNeuronalNet::load(const char* inPath, utils::CMath& inMath) -> Error
+{
+    std::FILE* file = fopen(inPath, "rb");
+    if (nullptr == file)
+    {
+        return Error::io;
+    }
+
+    Error error = Error::ok;
+
+    char magic[sizeof(kFileMagic)];
+    std::uint32_t version = 0;
+    std::uint32_t nrOfLayers = 0;
+    if ((1 != fread(magic, sizeof(magic), 1, file))
+        || (0 != memcmp(magic, kFileMagic, sizeof(magic)))
+        || !_readU32(file, version) || (kFileVersion != version)
+        || !_readU32(file, nrOfLayers) || (0 == nrOfLayers) || (nrOfLayers > kMaxNrOfLayers))
+    {
+        error = Error::format;
+    }
+
+    std::vector<unsigned int> topology;
+    for (unsigned int layerIndex = 0; (Error::ok == error) && (layerIndex < nrOfLayers); ++layerIndex)
+    {
+        std::uint32_t nrOfNeurons = 0;
+        if (!_readU32(file, nrOfNeurons) || (nrOfNeurons > kMaxNrOfNeurons))
+        {
+            error = Error::format;
+        }
+        topology.push_back(nrOfNeurons);
+    }
+
+    const CLayer::IActivation* activations[2] = {nullptr, nullptr};
+    if (Error::ok == error)
+    {
+        char names[2][kActivationNameSize];
+        if (1 != fread(names, sizeof(names), 1, file))
+        {
+            error = Error::format;
+        }
+        else
+        {
+            names[0][kActivationNameSize - 1] = '\0';
+            names[1][kActivationNameSize - 1] = '\0';
+            activations[0] = activationForName(names[0]);
+            activations[1] = activationForName(names[1]);
+            if (!activations[0] || !activations[1])
+            {
+                error = Error::unknownActivation;
+            }
+        }
+    }
+
+    // Rejects a truncated file before allocating the layers of a corrupted topology.
+    if ((Error::ok == error) && !_hasPayloadOfTopology(file, topology))
+    {
+        error = Error::format;
+    }
+
+    if (Error::ok == error)
+    {
+        // The weightnings are read from the file. So there is no need to randomize them.
+        error = _init(topology, *activations[0], *activations[1], inMath, false);
+    }
+
+    for (unsigned int layerIndex = 1; (Error::ok == error) && (layerIndex < m_Layers.size()); ++layerIndex)
+    {
+        CLayer* thisLayer = m_Layers[layerIndex];
+        for (unsigned int neuronIndex = 0; (Error::ok == error) && (neuronIndex < thisLayer->nrOfNeurons()); ++neuronIndex)
+        {
+            utils::CVectorF32* weightnings = thisLayer->weightningVectorForNeuronAtIndex(neuronIndex);
+            if (!weightnings || (weightnings->size() != fread(**weightnings, sizeof(float), weightnings->size(), file)))
+            {
+                error = Error::format;
+            }
+        }
+    }
+
+    fclose(file);
+    if (Error::ok != error)
+    {
+        _cleanup();
+    }
+    return error;
+}
+
+void CNeuronalNet::visitLayers(const VisitorFunct& inVisitorFunct)
+{
+    std::for_each(m_Layers.begin(), m_Layers.end(), [this, &inVisitorFunct](CLayer* thisLayer){
+        assert(thisLayer);
+        if (thisLayer)
+        {
+            inVisitorFunct(*thisLayer);
+        }
+    });
+}
+
+void CNeuronalNet::forwardPropagation(const ValueVisitor& inValueVisitor)
+{
+    forwardPropagationFromLayer(0, inValueVisitor);
+}
+
+void CNeuronalNet::forwardPropagationFromLayer(unsigned int inFirstLayerIndex, const ValueVisitor& inValueVisitor)
+{
+    UTILS_TRACE_SCOPE(traceScope, "CNeuronalNet::forwardPropagation", utils::CTrace::kNet, nrOfLayers());
+    assert(!m_ExecutionPlan.empty());
+
+    // Shared buffers don't retain the outputs of the layers in front of
+    // inFirstLayerIndex. So start from scratch then.
+    _executePlan((MemoryMode::sharedBuffers == m_MemoryMode) ? 0 : inFirstLayerIndex,
+                 static_cast<unsigned int>(m_ExecutionPlan.size()));
+    _visitOutputValues(inValueVisitor);
+}
+
+auto CNeuronalNet::forwardPropagationInto(float* outValues, size_t inNrOfValues) -> Error
+{
+    if (m_ExecutionPlan.empty())
+    {
+        return Error::notInited;
+    }
+
+    if ((nullptr == outValues) || (inNrOfValues < m_ExecutionPlan.back()->nrOfNeurons()))
+    {
+        return Error::param;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CNeuronalNet::forwardPropagation", utils::CTrace::kNet, nrOfLayers());
+    _executePlan(0, static_cast<unsigned int>(m_ExecutionPlan.size()));
+
+    const CLayer* _outputLayer = m_ExecutionPlan.back();
+    memcpy(outValues, **_outputLayer->neuronOutputVector(), _outputLayer->nrOfNeurons() * sizeof(float));
+    return Error::ok;
+}
+
+auto CNeuronalNet::forwardPropagationSelected(const unsigned int* inOutputIndices, unsigned int inNrOfIndices, float* outOutputs) -> Error
+{
+    if (m_ExecutionPlan.empty())
+    {
+        return Error::notInited;
+    }
+
+    if ((nullptr == inOutputIndices) || (nullptr == outOutputs))
+    {
+        return Error::param;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CNeuronalNet::forwardPropagationSelected", utils::CTrace::kNet, inNrOfIndices);
+    const unsigned int lastStepIndex = static_cast<unsigned int>(m_ExecutionPlan.size()) - 1;
+    _executePlan(0, lastStepIndex);
+    return m_ExecutionPlan[lastStepIndex]->propagateNeurons(inOutputIndices, inNrOfIndices, outOutputs)
+        ? Error::ok : Error::param;
+}
+
+auto CNeuronalNet::forwardPropagationTopK(unsigned int inK, unsigned int* outIndices, float* outOutputs) -> Error
+{
+    if (m_ExecutionPlan.empty())
+    {
+        return Error::notInited;
+    }
+
+    if (nullptr == outIndices)
+    {
+        return Error::param;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CNeuronalNet::forwardPropagationTopK", utils::CTrace::kNet, inK);
+    const unsigned int lastStepIndex = static_cast<unsigned int>(m_ExecutionPlan.size()) - 1;
+    _executePlan(0, lastStepIndex);
+    return m_ExecutionPlan[lastStepIndex]->propagateTopK(inK, outIndices, outOutputs)
+        ? Error::ok : Error::param;
+}
+
+auto CNeuronalNet::bindInputs(float* ioInputs) -> Error
+{
+    if (m_ExecutionPlan.empty())
+    {
+        return Error::notInited;
+    }
+
+    CLayer* _inputLayer = m_ExecutionPlan.front();
+    return _inputLayer->setOutputStorage(ioInputs) ? Error::ok : Error::outOfMemory;
+}
+
+auto CNeuronalNet::forwardPropagationBatch(const float* inInputs, unsigned int inBatchSize, float* outOutputs) -> Error
+{
+    if (m_ExecutionPlan.empty())
+    {
+        return Error::notInited;
+    }
+
+    if ((nullptr == inInputs) || (nullptr == outOutputs) || (0 == inBatchSize))
+    {
+        return Error::param;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CNeuronalNet::forwardPropagationBatch", utils::CTrace::kNet, inBatchSize);
+
+    // Copy the inputs into rows that end with the 1.0 for the biases.
+    const unsigned int nrOfInputs = m_ExecutionPlan.front()->nrOfNeurons();
+    std::vector<float>* source = &m_BatchBuffers[0];
+    std::vector<float>* destination = &m_BatchBuffers[1];
+    source->resize(inBatchSize * (nrOfInputs + 1));
+    for (unsigned int sampleIndex = 0; sampleIndex < inBatchSize; ++sampleIndex)
+    {
+        float* row = source->data() + sampleIndex * (nrOfInputs + 1);
+        memcpy(row, inInputs + sampleIndex * nrOfInputs, nrOfInputs * sizeof(float));
+        row[nrOfInputs] = 1.f;
+    }
+
+    for (unsigned int stepIndex = 1; stepIndex < m_ExecutionPlan.size(); ++stepIndex)
+    {
+        CLayer* thisLayer = m_ExecutionPlan[stepIndex];
+        destination->resize(inBatchSize * (thisLayer->nrOfNeurons() + 1));
+        thisLayer->propagateBatch(source->data(), inBatchSize, destination->data());
+        std::swap(source, destination);
+    }
+
+    const unsigned int nrOfOutputs = m_ExecutionPlan.back()->nrOfNeurons();
+    for (unsigned int sampleIndex = 0; sampleIndex < inBatchSize; ++sampleIndex)
+    {
+        memcpy(outOutputs + sampleIndex * nrOfOutputs,
+               source->data() + sampleIndex * (nrOfOutputs + 1), nrOfOutputs * sizeof(float));
+    }
+    return Error::ok;
+}
+
+void CNeuronalNet::setIncrementalPropagation(bool inEnable)
+{
+    m_IncrementalPropagation = inEnable;
+    _applyLayerSettings();
+}
+
+bool CNeuronalNet::isIncrementalPropagation() const
+{
+    return m_IncrementalPropagation;
+}
+
+auto CNeuronalNet::setMemoryMode(MemoryMode inMemoryMode) -> Error
+{
+    Error error = Error::ok;
+
+    _releaseSharedBuffers();
+    m_MemoryMode = inMemoryMode;
+    if ((MemoryMode::sharedBuffers == m_MemoryMode) && !_planSharedBuffers())
+    {
+        _releaseSharedBuffers();
+        m_MemoryMode = MemoryMode::perLayerBuffers;
+        error = Error::outOfMemory;
+    }
+    _applyLayerSettings();
+    return error;
+}
+
+auto CNeuronalNet::memoryMode() const -> MemoryMode
+{
+    return m_MemoryMode;
+}
+
+size_t CNeuronalNet::activationMemorySize() const
+{
+    size_t nrOfElements = 0;
+    for (const CLayer* thisLayer : m_Layers)
+    {
+        const utils::CVectorF32* outputVector = thisLayer->neuronOutputVector();
+        if (outputVector && outputVector->ownsElements())
+        {
+            nrOfElements += outputVector->size();
+        }
+    }
+    for (const utils::CVectorF32* thisBuffer : m_SharedBuffers)
+    {
+        nrOfElements += thisBuffer->size();
+    }
+    return nrOfElements * sizeof(float);
+}
+
+unsigned int CNeuronalNet::pruneByMagnitude(float inSparsity)
+{
+    unsigned int nrOfZeros = 0;
+    for (CLayer* thisLayer : m_Layers)
+    {
+        nrOfZeros += thisLayer->pruneWeightnings(inSparsity);
+    }
+    return nrOfZeros;
+}
+
+void CNeuronalNet::selectWeightFormats(float inSparsityThreshold)
+{
+    for (CLayer* thisLayer : m_Layers)
+    {
+        if (thisLayer->isInputLayer())
+        {
+            continue;
+        }
+
+        CLayer::WeightFormat weightFormat = CLayer::WeightFormat::dense;
+        if (thisLayer->weightningSparsity() >= inSparsityThreshold)
+        {
+            // Prefer blocks if they are filled well. Otherwise the zeros within
+            // the blocks would cost more than the indices CSR needs.
+            weightFormat = CLayer::WeightFormat::csr;
+            if (thisLayer->setWeightFormat(CLayer::WeightFormat::blockSparse))
+            {
+                const size_t blockSparseSize = thisLayer->weightningMemorySize();
+                thisLayer->setWeightFormat(CLayer::WeightFormat::csr);
+                if (blockSparseSize < thisLayer->weightningMemorySize())
+                {
+                    weightFormat = CLayer::WeightFormat::blockSparse;
+                }
+            }
+        }
+        thisLayer->setWeightFormat(weightFormat);
+    }
+}
+
+void CNeuronalNet::packWeightnings()
+{
+    for (CLayer* thisLayer : m_Layers)
+    {
+        if (!thisLayer->isInputLayer() && (CLayer::WeightFormat::dense == thisLayer->weightFormat()))
+        {
+            thisLayer->setWeightFormat(CLayer::WeightFormat::panels);
+        }
+    }
+}
+
+auto CNeuronalNet::optimize(const float* inInputScale, const float* inInputShift, OptimizeStats* outStats) -> Error
+{
+    if (m_ExecutionPlan.empty())
+    {
+        return Error::notInited;
+    }
+
+    OptimizeStats stats;
+
+    // A net of just the input layer has no weightnings to optimize.
+    if (m_Layers.size() < 2)
+    {
+        if (outStats)
+        {
+            *outStats = stats;
+        }
+        return Error::ok;
+    }
+
+    // Step 1: Get the weightnings of all layers regardless of their format
+    std::vector<LayerMatrix> matrices(m_Layers.size() - 1);
+    for (unsigned int layerIndex = 1; layerIndex < m_Layers.size(); ++layerIndex)
+    {
+        LayerMatrix& matrix = matrices[layerIndex - 1];
+        matrix.nrOfInputs = m_Layers[layerIndex - 1]->nrOfNeurons();
+        matrix.nrOfNeurons = m_Layers[layerIndex]->nrOfNeurons();
+        matrix.values.resize(matrix.cost());
+        for (unsigned int neuronIndex = 0; neuronIndex < matrix.nrOfNeurons; ++neuronIndex)
+        {
+            m_Layers[layerIndex]->weightningsOfNeuron(neuronIndex, matrix.row(neuronIndex));
+        }
+    }
+
+    // Step 2: Fold the normalization of the inputs into the first hidden layer
+    if (inInputScale || inInputShift)
+    {
+        LayerMatrix& matrix = matrices.front();
+        for (unsigned int neuronIndex = 0; neuronIndex < matrix.nrOfNeurons; ++neuronIndex)
+        {
+            float* row = matrix.row(neuronIndex);
+            for (unsigned int k = 0; k < matrix.nrOfInputs; ++k)
+            {
+                if (inInputShift)
+                {
+                    row[matrix.nrOfInputs] += row[k] * inInputShift[k];
+                }
+                if (inInputScale)
+                {
+                    row[k] *= inInputScale[k];
+                }
+            }
+        }
+        stats.foldedInputNormalization = true;
+    }
+
+    // Step 3: Merge linear hidden layers with their successor if that is cheaper
+    if (m_HiddenLayerActivation->isIdentity())
+    {
+        for (size_t i = 0; i + 1 < matrices.size(); )
+        {
+            LayerMatrix merged = _mergeLayers(matrices[i], matrices[i + 1]);
+            if (merged.cost() < matrices[i].cost() + matrices[i + 1].cost())
+            {
+                matrices[i + 1] = std::move(merged);
+                matrices.erase(matrices.begin() + i);
+                ++stats.collapsedLayers;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    // Step 4: Remove hidden neurons that do not contribute to any successor.
+    // Removing a neuron drops its incoming weightnings, so walk backwards.
+    if (!m_HiddenLayerActivation->needsIntegralPart())
+    {
+        for (size_t i = matrices.size() - 1; i-- > 0; )
+        {
+            LayerMatrix& successor = matrices[i + 1];
+            for (unsigned int neuronIndex = matrices[i].nrOfNeurons; (neuronIndex-- > 0) && (matrices[i].nrOfNeurons > 1); )
+            {
+                bool isUnused = true;
+                for (unsigned int n = 0; isUnused && (n < successor.nrOfNeurons); ++n)
+                {
+                    isUnused = (0.f == successor.row(n)[neuronIndex]);
+                }
+                if (isUnused)
+                {
+                    _removeNeuron(matrices[i], successor, neuronIndex);
+                    ++stats.droppedNeurons;
+                }
+            }
+        }
+    }
+
+    // Step 5: Rebuild the network
+    std::vector<unsigned int> topology(1, m_Layers.front()->nrOfNeurons());
+    for (const LayerMatrix& matrix : matrices)
+    {
+        topology.push_back(matrix.nrOfNeurons);
+    }
+
+    const Error error = _init(topology, *m_HiddenLayerActivation, *m_OutputActivation, *m_Math, false);
+    if (Error::ok != error)
+    {
+        return error;
+    }
+    for (unsigned int layerIndex = 1; layerIndex < m_Layers.size(); ++layerIndex)
+    {
+        const LayerMatrix& matrix = matrices[layerIndex - 1];
+        for (unsigned int neuronIndex = 0; neuronIndex < matrix.nrOfNeurons; ++neuronIndex)
+        {
+            memcpy(**m_Layers[layerIndex]->weightningVectorForNeuronAtIndex(neuronIndex), matrix.row(neuronIndex),
+                   (matrix.nrOfInputs + 1) * sizeof(float));
+        }
+        m_Layers[layerIndex]->invalidate();
+    }
+
+    if (outStats)
+    {
+        *outStats = stats;
+    }
+    return Error::ok;
+}
+
+size_t CNeuronalNet::weightningMemorySize() const
+{
+    size_t nrOfBytes = 0;
+    for (const CLayer* thisLayer : m_Layers)
+    {
+        nrOfBytes += thisLayer->weightningMemorySize();
+    }
+    return nrOfBytes;
+}
+
+unsigned int CNeuronalNet::nrOfExecutionSteps() const
+{
+    return static_cast<unsigned int>(m_ExecutionPlan.size());
+}
+
+bool CNeuronalNet::executeStep(unsigned int inStepIndex)
+{
+    const bool success = inStepIndex < m_ExecutionPlan.size();
+    if (success)
+    {
+        m_ExecutionPlan[inStepIndex]->propagate();
+    }
+    return success;
+}
+
+const CLayer::IActivation* CNeuronalNet::hiddenLayerActivation() const
+{
+    return m_HiddenLayerActivation;
+}
+
+const CLayer::IActivation* CNeuronalNet::outputActivation() const
+{
+    return m_OutputActivation;
+}
+
+const utils::CMath* CNeuronalNet::math() const
+{
+    return m_Math;
+}
+
+unsigned int CNeuronalNet::nrOfLayers() const
+{
+    return static_cast<unsigned int>(m_Layers.size());
+}
+
+unsigned int CNeuronalNet::neuronsInLayer(unsigned int inLayerIndex) const
+{
+    return (inLayerIndex < m_Layers.size()) ? m_Layers[inLayerIndex]->nrOfNeurons() : 0;
+}
+
+float* CNeuronalNet::weightningForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex, unsigned int inWeightningIndex)
+{
+    float* weightningPtr = nullptr;
+
+    if (inLayerIndex < m_Layers.size())
+    {
+        CLayer* thisLayer = m_Layers[inLayerIndex];
+        weightningPtr = thisLayer->weightningAtIndexForNeuron(inNeuronIndex, inWeightningIndex);
+    }
+    return weightningPtr;
+}
+
+const float* CNeuronalNet::weightningForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex, unsigned int inWeightningIndex) const
+{
+    const CLayer* thisLayer = layer(inLayerIndex);
+    return thisLayer ? thisLayer->weightningAtIndexForNeuron(inNeuronIndex, inWeightningIndex) : nullptr;
+}
+
+float* CNeuronalNet::biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex)
+{
+    float* weightningPtr = nullptr;
+
+    if (inLayerIndex < m_Layers.size())
+    {
+        CLayer* thisLayer = m_Layers[inLayerIndex];
+        weightningPtr = thisLayer->biasForNeuron(inNeuronIndex);
+    }
+    return weightningPtr;
+}
+
+const float* CNeuronalNet::biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex) const
+{
+    const CLayer* thisLayer = layer(inLayerIndex);
+    return thisLayer ? thisLayer->biasForNeuron(inNeuronIndex) : nullptr;
+}
+
+CLayer::Profile CNeuronalNet::totalProfile() const
+{
+    CLayer::Profile total;
+    for (const CLayer* thisLayer : m_Layers)
+    {
+        total.dotProduct += thisLayer->profile().dotProduct;
+        total.activation += thisLayer->profile().activation;
+    }
+    return total;
+}
+
+void CNeuronalNet::resetProfile()
+{
+    visitLayers([](CLayer& thisLayer)->void{
+        thisLayer.resetProfile();
+    });
+}
+
+void CNeuronalNet::dumpProfile(std::FILE* inFile) const
+{
+    const auto dumpRow = [inFile](const char* inLayerName, unsigned int inNrOfNeurons,
+                                  const char* inPhaseName, const PhaseCounters& inCounters)->void{
+        const double mflops = inCounters.nanoSeconds ? (1e3 * inCounters.flops) / inCounters.nanoSeconds : 0.;
+        fprintf(inFile, "%6s | %7u | %-10s | %10llu | %14llu | %14llu | %12.3f | %10.1f\n",
+            inLayerName, inNrOfNeurons, inPhaseName,
+            static_cast<unsigned long long>(inCounters.calls),
+            static_cast<unsigned long long>(inCounters.flops),
+            static_cast<unsigned long long>(inCounters.bytes),
+            inCounters.nanoSeconds / 1e3, mflops);
+    };
+
+    fprintf(inFile, "%6s | %7s | %-10s | %10s | %14s | %14s | %12s | %10s\n",
+        "Layer", "Neurons", "Phase", "Calls", "FLOPs", "Bytes", "Time [us]", "MFLOP/s");
+    if (!kProfilingEnabled)
+    {
+        fprintf(inFile, "*** Profiling is disabled (build with KILIB_ENABLE_PROFILING)\n");
+    }
+
+    for (unsigned int i = 0; i < m_Layers.size(); ++i)
+    {
+        char layerName[16];
+        snprintf(layerName, sizeof(layerName), "%u", i);
+
+        const CLayer* thisLayer = m_Layers[i];
+        dumpRow(layerName, thisLayer->nrOfNeurons(), "dot", thisLayer->profile().dotProduct);
+        dumpRow(layerName, thisLayer->nrOfNeurons(), "activation", thisLayer->profile().activation);
+    }
+
+    const CLayer::Profile total = totalProfile();
+    dumpRow("total", 0, "dot", total.dotProduct);
+    dumpRow("total", 0, "activation", total.activation);
+}
+
+// ==========================================================================
+// class CNeuronalNet - private
+// ==========================================================================
+auto CNeuronalNet::_init(
+    const std::vector<unsigned int>& inNeuronLayers,
+    const CLayer::IActivation& inHiddenLayerActivation,
+    const CLayer::IActivation& inOutputActivation,
+    utils::CMath& inMath,
+    bool inRandomizeWeightnings
+    ) -> Error
 {
     Error error;
 
-    printf("*** inNeurons.size = %ld\n", inNeuronLayers.size());
     if (inNeuronLayers.empty())
     {
         error = Error::tooLessLayers;
@@ -96,6 +916,12 @@ auto CNeuronalNet::init(
         // Be optimistic
         error = Error::ok;
 
+        // Step 0: Get rid of a previous initialization
+        _cleanup();
+        m_HiddenLayerActivation = &inHiddenLayerActivation;
+        m_OutputActivation = &inOutputActivation;
+        m_Math = &inMath;
+
         // Step 1: Create the Layers
         m_Layers.reserve(inNeuronLayers.size());
 
@@ -135,7 +961,8 @@ auto CNeuronalNet::init(
                 thisLayer->init(nrOfNeuronsInThisLayer,
                                 *thisActivation,
                                 inMath,
-                                parentLayer);
+                                parentLayer,
+                                false);
 
                 m_Layers.push_back(thisLayer);
             }
@@ -147,98 +974,216 @@ auto CNeuronalNet::init(
             }
             parentLayer = thisLayer;
         }
+
+        // Step 2: Determine the order of evaluation once
+        if (Error::ok == error)
+        {
+            _buildExecutionPlan();
+            if (inRandomizeWeightnings)
+            {
+                _randomizeWeightnings();
+            }
+
+            // Step 3: Apply the memory mode and the layer settings
+            error = setMemoryMode(m_MemoryMode);
+        }
     }
     return error;
 }
 
-void CNeuronalNet::visitLayers(const VisitorFunct& inVisitorFunct)
+void CNeuronalNet::_randomizeWeightnings()
 {
-    std::for_each(m_Layers.begin(), m_Layers.end(), [this, &inVisitorFunct](CLayer* thisLayer){
-        assert(thisLayer);
-        if (thisLayer)
+    // The weightnings are randomized in chunks of whole neurons. Every chunk
+    // depends on the seed, the layer and its neurons only. So the threads may
+    // take them in any order.
+    static constexpr unsigned int kChunkSize = 64 * 1024;
+
+    struct Chunk
+    {
+        unsigned int layerIndex;
+        unsigned int firstNeuron;
+        unsigned int nrOfNeurons;
+    };
+
+    std::vector<Chunk> chunks;
+    unsigned long long nrOfWeightnings = 0;
+    for (unsigned int layerIndex = 1; layerIndex < m_Layers.size(); ++layerIndex)
+    {
+        const CLayer* thisLayer = m_Layers[layerIndex];
+        const unsigned int rowSize = m_Layers[layerIndex - 1]->nrOfNeurons() + 1;
+        nrOfWeightnings += 1ull * rowSize * thisLayer->nrOfNeurons();
+        const unsigned int neuronsPerChunk = std::max(1u, kChunkSize / rowSize);
+        for (unsigned int firstNeuron = 0; firstNeuron < thisLayer->nrOfNeurons(); firstNeuron += neuronsPerChunk)
         {
-            inVisitorFunct(*thisLayer);
+            chunks.push_back({layerIndex, firstNeuron, std::min(neuronsPerChunk, thisLayer->nrOfNeurons() - firstNeuron)});
         }
-    });
+    }
+
+    std::atomic<size_t> nextChunk(0);
+    const auto randomizeChunks = [this, &chunks, &nextChunk]()->void{
+        for (size_t chunkIndex = nextChunk++; chunkIndex < chunks.size(); chunkIndex = nextChunk++)
+        {
+            const Chunk& thisChunk = chunks[chunkIndex];
+            const utils::CRandom random(m_WeightInitSeed, thisChunk.layerIndex);
+            m_Layers[thisChunk.layerIndex]->randomizeWeightnings(m_WeightInit, random, thisChunk.firstNeuron, thisChunk.nrOfNeurons);
+        }
+    };
+
+#if defined(KILIB_ENABLE_THREADS)
+    // The calling thread takes part as well. A small net is randomized by it
+    // alone since starting a thread takes longer than randomizing a chunk.
+    const size_t nrOfThreads = (nrOfWeightnings < 2ull * kChunkSize) ? 1
+        : std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), chunks.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nrOfThreads; ++i)
+    {
+        threads.emplace_back(randomizeChunks);
+    }
+    randomizeChunks();
+    for (std::thread& thisThread : threads)
+    {
+        thisThread.join();
+    }
+#else
+    (void)nrOfWeightnings;
+    randomizeChunks();
+#endif
+
+    for (CLayer* thisLayer : m_Layers)
+    {
+        thisLayer->invalidate();
+    }
 }
 
-void CNeuronalNet::forwardPropagation(const ValueVisitor& inValueVisitor)
+void CNeuronalNet::_buildExecutionPlan()
 {
-    const CLayer* _outputLayer = outputLayer();
-    assert(_outputLayer);
-    if (_outputLayer)
+    // The layers are chained linearly. So the plan is simply the order from
+    // the input towards the output layer.
+    m_ExecutionPlan.clear();
+    m_ExecutionPlan.reserve(m_Layers.size());
+    for (CLayer* thisLayer : m_Layers)
     {
-        if (_outputLayer->nrOfNeurons() > 0)
+        if (!thisLayer->isInited())
         {
-            const utils::CVectorF32* res = _outputLayer->neuronOutputVector();
-            assert(res);
-            assert(res->size() == _outputLayer->nrOfNeurons() + 1);
-            if (res)
-            {
-#if 0
-                // Iterate through all Layers
-                visitLayers([](CLayer& thisLayer)->void{
-                    thisLayer.forwardPropagation();
-                });
-#else
-                const_cast<CLayer*>(_outputLayer)->forwardPropagation(true);
-#endif
-                for (unsigned int neronIndex = 0; neronIndex < _outputLayer->nrOfNeurons(); ++neronIndex)
-                {
-                    inValueVisitor(neronIndex, (*res)[neronIndex]);
-                }
-            }
+            m_ExecutionPlan.clear();
+            break;
         }
+        m_ExecutionPlan.push_back(thisLayer);
     }
 }
 
-unsigned int CNeuronalNet::nrOfLayers() const
+void CNeuronalNet::_executePlan(unsigned int inFirstStepIndex, unsigned int inEndStepIndex)
 {
-    return static_cast<unsigned int>(m_Layers.size());
+    for (unsigned int stepIndex = inFirstStepIndex; stepIndex < inEndStepIndex; ++stepIndex)
+    {
+        m_ExecutionPlan[stepIndex]->propagate();
+    }
 }
 
-unsigned int CNeuronalNet::neuronsInLayer(unsigned int inLayerIndex) const
+void CNeuronalNet::_visitOutputValues(const ValueVisitor& inValueVisitor) const
 {
-    return (inLayerIndex < m_Layers.size()) ? m_Layers[inLayerIndex]->nrOfNeurons() : 0;
+    if (!m_ExecutionPlan.empty())
+    {
+        const CLayer* _outputLayer = m_ExecutionPlan.back();
+        const utils::CVectorF32& res = *_outputLayer->neuronOutputVector();
+        for (unsigned int neuronIndex = 0; neuronIndex < _outputLayer->nrOfNeurons(); ++neuronIndex)
+        {
+            inValueVisitor(neuronIndex, res[neuronIndex]);
+        }
+    }
 }
 
-float* CNeuronalNet::weightningForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex, unsigned int inWeightningIndex)
+bool CNeuronalNet::_planSharedBuffers()
 {
-    float* weightningPtr = nullptr;
+    // The output of layer i is written by step i and read by step i+1 for
+    // the last time (the output layers output is read by the caller after
+    // the last step). So a buffer may be reused by the first layer that is
+    // written after the last read of its previous user. The input layer keeps
+    // its own buffer since its values are provided by the caller.
+    struct BufferUsage
+    {
+        unsigned int lastReadStep;
+        unsigned int nrOfElements;
+    };
+    std::vector<BufferUsage> bufferUsages;
+    std::vector<unsigned int> bufferOfLayer(m_ExecutionPlan.size(), 0);
 
-    if (inLayerIndex < m_Layers.size())
+    for (unsigned int stepIndex = 1; stepIndex < m_ExecutionPlan.size(); ++stepIndex)
     {
-        CLayer* thisLayer = m_Layers[inLayerIndex];
-        weightningPtr = thisLayer->weightningAtIndexForNeuron(inNeuronIndex, inWeightningIndex);
+        const unsigned int nrOfElements = m_ExecutionPlan[stepIndex]->nrOfNeurons() + 1;
+
+        unsigned int bufferIndex = 0;
+        while ((bufferIndex < bufferUsages.size()) && (bufferUsages[bufferIndex].lastReadStep >= stepIndex))
+        {
+            ++bufferIndex;
+        }
+        if (bufferIndex == bufferUsages.size())
+        {
+            bufferUsages.push_back(BufferUsage{0, 0});
+        }
+
+        BufferUsage& usage = bufferUsages[bufferIndex];
+        usage.lastReadStep = stepIndex + 1;
+        usage.nrOfElements = std::max(usage.nrOfElements, nrOfElements);
+        bufferOfLayer[stepIndex] = bufferIndex;
     }
-    return weightningPtr;
-}
 
-const float* CNeuronalNet::weightningForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex, unsigned int inWeightningIndex) const
-{
-    return const_cast<const float*>(const_cast<CNeuronalNet*>(this)->weightningForNeuronInLayer(inLayerIndex, inNeuronIndex, inWeightningIndex));
+    m_SharedBuffers.reserve(bufferUsages.size());
+    for (const BufferUsage& thisUsage : bufferUsages)
+    {
+        utils::CVectorF32* thisBuffer = new(std::nothrow) utils::CVectorF32(thisUsage.nrOfElements);
+        assert(thisBuffer);
+        if (nullptr == thisBuffer)
+        {
+            return false;
+        }
+        m_SharedBuffers.push_back(thisBuffer);
+    }
+
+    for (unsigned int stepIndex = 1; stepIndex < m_ExecutionPlan.size(); ++stepIndex)
+    {
+        if (!m_ExecutionPlan[stepIndex]->setOutputStorage(**m_SharedBuffers[bufferOfLayer[stepIndex]]))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-float* CNeuronalNet::biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex)
+void CNeuronalNet::_releaseSharedBuffers()
 {
-    float* weightningPtr = nullptr;
-
-    if (inLayerIndex < m_Layers.size())
+    if (!m_SharedBuffers.empty())
     {
-        CLayer* thisLayer = m_Layers[inLayerIndex];
-        weightningPtr = thisLayer->biasForNeuron(inNeuronIndex);
+        // The input layer never uses a shared buffer but may be bound to
+        // the inputs of the caller (see bindInputs()).
+        for (unsigned int stepIndex = 1; stepIndex < m_ExecutionPlan.size(); ++stepIndex)
+        {
+            CLayer* thisLayer = m_ExecutionPlan[stepIndex];
+            const utils::CVectorF32* outputVector = thisLayer->neuronOutputVector();
+            if (outputVector && !outputVector->ownsElements())
+            {
+                thisLayer->setOutputStorage(nullptr);
+            }
+        }
+
+        for (utils::CVectorF32* thisBuffer : m_SharedBuffers)
+        {
+            delete thisBuffer;
+        }
+        m_SharedBuffers.clear();
     }
-    return weightningPtr;
 }
 
-const float* CNeuronalNet::biasForNeuronInLayer(unsigned int inLayerIndex, unsigned int inNeuronIndex) const
+void CNeuronalNet::_applyLayerSettings()
 {
-    return const_cast<const float*>(const_cast<CNeuronalNet*>(this)->biasForNeuronInLayer(inLayerIndex, inNeuronIndex));
+    // The incremental propagation relies on retained layer outputs.
+    const bool incrementalPropagation = m_IncrementalPropagation && (MemoryMode::perLayerBuffers == m_MemoryMode);
+    for (CLayer* thisLayer : m_Layers)
+    {
+        thisLayer->setIncrementalPropagation(incrementalPropagation);
+    }
 }
 
-// ==========================================================================
-// class CNeuronalNet - private
-// ==========================================================================
 void CNeuronalNet::_cleanup()
 {
     for (auto thisLayer : m_Layers)
@@ -246,6 +1191,13 @@ void CNeuronalNet::_cleanup()
         delete thisLayer;
     }
     m_Layers.clear();
+    m_ExecutionPlan.clear();
+
+    for (utils::CVectorF32* thisBuffer : m_SharedBuffers)
+    {
+        delete thisBuffer;
+    }
+    m_SharedBuffers.clear();
 
     m_HiddenLayerActivation = nullptr;
     m_OutputActivation = nullptr;
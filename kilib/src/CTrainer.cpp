@@ -0,0 +1,619 @@
+/* ==========================================================================
+ * @(#)File: kilib/src/CTrainer.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/CTrainer.hpp"
+#include "utils/include/CMath.hpp"
+#include "utils/include/CTrace.hpp"
+#include "utils/include/MathKernels.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+/*!
+ * @brief Draws a number in [0 ... inBound) without the bias of a plain
+ * modulo (Lemire's multiply and reject). Unlike std::uniform_int_distribution
+ * this yields the same numbers on every platform.
+ */
+static std::uint32_t _boundedRandom(std::mt19937& ioRandom, std::uint32_t inBound)
+{
+    std::uint64_t product = static_cast<std::uint64_t>(ioRandom()) * inBound;
+    if (static_cast<std::uint32_t>(product) < inBound)
+    {
+        // Reject the numbers that would make up an incomplete last interval.
+        const std::uint32_t threshold = (0u - inBound) % inBound;
+        while (static_cast<std::uint32_t>(product) < threshold)
+        {
+            product = static_cast<std::uint64_t>(ioRandom()) * inBound;
+        }
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+}
+
+namespace kilib {
+// ==========================================================================
+// struct CTrainer::Worker
+// ==========================================================================
+/*!
+ * @brief The buffers of a single worker thread. Every layer l occupies
+ * neuronsInLayer(l) + 1 values beginning at m_LayerOffsets[l] within
+ * preActivations and activations.
+ */
+struct CTrainer::Worker
+{
+    std::vector<float> preActivations;
+    std::vector<float> activations;
+    std::vector<float> integrals;    ///< The integral part of each layer
+    std::vector<float> errors[2];    ///< The loss gradient of the actual and of the parent layers output
+    std::vector<float> gradients;    ///< The summed up gradients of the workers samples
+    float lossSum = 0.f;
+};
+
+// ==========================================================================
+// class CTrainer - public
+// ==========================================================================
+CTrainer::CTrainer(CNeuronalNet& inNet, const Config& inConfig)
+: m_Net(inNet)
+, m_Config(inConfig)
+, m_Random(inConfig.seed)
+{
+    unsigned int nrOfThreads = m_Config.nrOfThreads;
+    if (0 == nrOfThreads)
+    {
+        nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int workerIndex = 0; workerIndex < nrOfThreads; ++workerIndex)
+    {
+        Worker* worker = new(std::nothrow) Worker;
+        assert(worker);
+        if (nullptr == worker)
+        {
+            break;
+        }
+        m_Workers.push_back(worker);
+    }
+
+    // The calling thread serves as worker 0.
+    for (unsigned int workerIndex = 1; workerIndex < m_Workers.size(); ++workerIndex)
+    {
+        m_Threads.emplace_back(&CTrainer::_workerThread, this, workerIndex);
+    }
+}
+
+CTrainer::CTrainer(CNeuronalNet& inNet)
+: CTrainer(inNet, Config())
+{
+}
+
+CTrainer::~CTrainer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_PoolMutex);
+        m_Quit = true;
+    }
+    m_StartJob.notify_all();
+    for (std::thread& thisThread : m_Threads)
+    {
+        thisThread.join();
+    }
+
+    for (Worker* thisWorker : m_Workers)
+    {
+        delete thisWorker;
+    }
+}
+
+auto CTrainer::trainBatch(const float* inInputs, const float* inTargets, unsigned int inBatchSize, float* outLoss) -> Error
+{
+    if ((nullptr == inInputs) || (nullptr == inTargets) || (0 == inBatchSize) || !_isValidConfig())
+    {
+        return Error::param;
+    }
+
+    m_SampleIndices.resize(inBatchSize);
+    for (unsigned int sampleIndex = 0; sampleIndex < inBatchSize; ++sampleIndex)
+    {
+        m_SampleIndices[sampleIndex] = sampleIndex;
+    }
+
+    float lossSum = 0.f;
+    const Error error = _trainSamples(inInputs, inTargets, m_SampleIndices.data(), inBatchSize, lossSum);
+    if (outLoss && (Error::ok == error))
+    {
+        *outLoss = lossSum / static_cast<float>(inBatchSize);
+    }
+    return error;
+}
+
+auto CTrainer::trainEpoch(const float* inInputs, const float* inTargets, unsigned int inNrOfSamples, float* outLoss) -> Error
+{
+    if ((nullptr == inInputs) || (nullptr == inTargets) || (0 == inNrOfSamples) || (0 == m_Config.batchSize) || !_isValidConfig())
+    {
+        return Error::param;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CTrainer::trainEpoch", utils::CTrace::kNet, inNrOfSamples);
+
+    // Fisher-Yates shuffle. The engine is specified by the standard (unlike
+    // std::shuffle) so the order is the same on every platform.
+    m_SampleIndices.resize(inNrOfSamples);
+    for (unsigned int sampleIndex = 0; sampleIndex < inNrOfSamples; ++sampleIndex)
+    {
+        m_SampleIndices[sampleIndex] = sampleIndex;
+    }
+    for (unsigned int sampleIndex = inNrOfSamples - 1; sampleIndex > 0; --sampleIndex)
+    {
+        std::swap(m_SampleIndices[sampleIndex], m_SampleIndices[_boundedRandom(m_Random, sampleIndex + 1)]);
+    }
+
+    Error error = Error::ok;
+    float lossSum = 0.f;
+    for (unsigned int firstSample = 0; (Error::ok == error) && (firstSample < inNrOfSamples); firstSample += m_Config.batchSize)
+    {
+        const unsigned int batchSize = std::min(m_Config.batchSize, inNrOfSamples - firstSample);
+        float batchLossSum = 0.f;
+        error = _trainSamples(inInputs, inTargets, m_SampleIndices.data() + firstSample, batchSize, batchLossSum);
+        lossSum += batchLossSum;
+    }
+
+    if (outLoss && (Error::ok == error))
+    {
+        *outLoss = lossSum / static_cast<float>(inNrOfSamples);
+    }
+    return error;
+}
+
+const float* CTrainer::gradients() const
+{
+    return m_HasGradients ? m_Workers.front()->gradients.data() : nullptr;
+}
+
+size_t CTrainer::nrOfParameters() const
+{
+    return m_NrOfParameters;
+}
+
+unsigned int CTrainer::nrOfThreads() const
+{
+    return static_cast<unsigned int>(m_Workers.size());
+}
+
+size_t CTrainer::optimizerStateSize() const
+{
+    return m_OptimizerState.size() * sizeof(float);
+}
+
+void CTrainer::resetOptimizer()
+{
+    std::fill(m_OptimizerState.begin(), m_OptimizerState.end(), 0.f);
+    m_NrOfSteps = 0;
+}
+
+// ==========================================================================
+// class CTrainer - private
+// ==========================================================================
+bool CTrainer::_isValidConfig() const
+{
+    switch (m_Config.optimizer)
+    {
+        case Optimizer::sgd:
+            return true;
+        case Optimizer::momentum:
+            return (m_Config.momentum >= 0.f) && (m_Config.momentum < 1.f);
+        case Optimizer::adam:
+            return (m_Config.beta1 >= 0.f) && (m_Config.beta1 < 1.f)
+                && (m_Config.beta2 >= 0.f) && (m_Config.beta2 < 1.f) && (m_Config.epsilon > 0.f);
+    }
+    return false;
+}
+
+auto CTrainer::_prepare() -> Error
+{
+    const unsigned int nrOfLayers = m_Net.nrOfLayers();
+    if ((0 == m_Net.nrOfExecutionSteps()) || (nullptr == m_Net.math()) || m_Workers.empty())
+    {
+        return Error::notInited;
+    }
+
+    // Collect the weightning rows. The network may have been re-inited
+    // since the last batch.
+    m_Rows.clear();
+    m_FirstRowOfLayer.assign(nrOfLayers, 0);
+    m_LayerOffsets.assign(nrOfLayers + 1, 0);
+    size_t nrOfParameters = 0;
+    size_t maxNrOfNeurons = 0;
+    for (unsigned int layerIndex = 0; layerIndex < nrOfLayers; ++layerIndex)
+    {
+        CLayer* thisLayer = m_Net.layer(layerIndex);
+        const unsigned int nrOfNeurons = thisLayer->nrOfNeurons();
+        m_LayerOffsets[layerIndex + 1] = m_LayerOffsets[layerIndex] + nrOfNeurons + 1;
+        m_FirstRowOfLayer[layerIndex] = m_Rows.size();
+        maxNrOfNeurons = std::max<size_t>(maxNrOfNeurons, nrOfNeurons);
+
+        if (0 == layerIndex)
+        {
+            continue; // The input layer has no weightnings.
+        }
+
+        // Training reads and updates the weightnings in place. So the layers
+        // are converted to the dense format once, when training begins.
+        if (CLayer::WeightFormat::dense != thisLayer->weightFormat())
+        {
+            if (m_HasBegun)
+            {
+                return Error::weightFormat;
+            }
+            if (!thisLayer->setWeightFormat(CLayer::WeightFormat::dense))
+            {
+                return Error::notInited;
+            }
+        }
+
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+        {
+            utils::CVectorF32* weightnings = thisLayer->weightningVectorForNeuronAtIndex(neuronIndex);
+            assert(weightnings && (weightnings->size() == thisLayer->nrOfWeightnings() + 1));
+            m_Rows.push_back(Row{**weightnings, weightnings->size(), nrOfParameters});
+            nrOfParameters += weightnings->size();
+        }
+    }
+
+    if (nrOfParameters != m_NrOfParameters)
+    {
+        m_HasGradients = false;
+    }
+    m_NrOfParameters = nrOfParameters;
+
+    const size_t nrOfStateValues = nrOfParameters * ((Optimizer::momentum == m_Config.optimizer) ? 1
+                                                   : (Optimizer::adam == m_Config.optimizer) ? 2 : 0);
+    if (nrOfStateValues != m_OptimizerState.size())
+    {
+        m_OptimizerState.assign(nrOfStateValues, 0.f);
+        m_NrOfSteps = 0;
+    }
+
+    for (Worker* thisWorker : m_Workers)
+    {
+        thisWorker->preActivations.resize(m_LayerOffsets.back());
+        thisWorker->activations.resize(m_LayerOffsets.back());
+        thisWorker->integrals.resize(nrOfLayers);
+        thisWorker->errors[0].resize(maxNrOfNeurons);
+        thisWorker->errors[1].resize(maxNrOfNeurons);
+        thisWorker->gradients.resize(nrOfParameters);
+    }
+
+    // Balance the rows to reduce by their number of elements.
+    const size_t nrOfWorkers = m_Workers.size();
+    m_RowRangeOfWorker.assign(nrOfWorkers + 1, m_Rows.size());
+    m_RowRangeOfWorker[0] = 0;
+    unsigned int workerIndex = 1;
+    for (size_t rowIndex = 0; (rowIndex < m_Rows.size()) && (workerIndex < nrOfWorkers); ++rowIndex)
+    {
+        while ((workerIndex < nrOfWorkers) && (m_Rows[rowIndex].gradientOffset >= nrOfParameters * workerIndex / nrOfWorkers))
+        {
+            m_RowRangeOfWorker[workerIndex++] = rowIndex;
+        }
+    }
+
+    m_HasBegun = true;
+    return Error::ok;
+}
+
+auto CTrainer::_trainSamples(const float* inInputs, const float* inTargets, const unsigned int* inSampleIndices,
+                             unsigned int inNrOfSamples, float& outLossSum) -> Error
+{
+    const Error error = _prepare();
+    if (Error::ok != error)
+    {
+        return error;
+    }
+
+    UTILS_TRACE_SCOPE(traceScope, "CTrainer::trainBatch", utils::CTrace::kNet, inNrOfSamples);
+
+    // The jobs are passed by JobRef, so they do not allocate.
+    const unsigned int nrOfWorkers = nrOfThreads();
+    const auto processShards = [&](unsigned int inWorkerIndex){
+        const unsigned int firstSample = inNrOfSamples * inWorkerIndex / nrOfWorkers;
+        const unsigned int endSample = inNrOfSamples * (inWorkerIndex + 1) / nrOfWorkers;
+        _processShard(*m_Workers[inWorkerIndex], inInputs, inTargets,
+                      inSampleIndices + firstSample, endSample - firstSample);
+    };
+    _runOnAllWorkers("CTrainer::processShard", JobRef(processShards));
+
+    outLossSum = 0.f;
+    for (const Worker* thisWorker : m_Workers)
+    {
+        outLossSum += thisWorker->lossSum;
+    }
+
+    ++m_NrOfSteps;
+    const float scale = 1.f / static_cast<float>(inNrOfSamples);
+    const auto reduceAndUpdate = [this, scale](unsigned int inWorkerIndex){
+        _reduceAndUpdate(inWorkerIndex, scale);
+    };
+    _runOnAllWorkers("CTrainer::reduceAndUpdate", JobRef(reduceAndUpdate));
+
+    m_HasGradients = true;
+    return Error::ok;
+}
+
+void CTrainer::_processShard(Worker& ioWorker, const float* inInputs, const float* inTargets,
+                             const unsigned int* inSampleIndices, unsigned int inNrOfSamples)
+{
+    const unsigned int nrOfInputs = m_Net.neuronsInLayer(0);
+    const unsigned int nrOfOutputs = m_Net.neuronsInLayer(m_Net.nrOfLayers() - 1);
+
+    std::fill(ioWorker.gradients.begin(), ioWorker.gradients.end(), 0.f);
+    ioWorker.lossSum = 0.f;
+    for (unsigned int i = 0; i < inNrOfSamples; ++i)
+    {
+        const unsigned int sampleIndex = inSampleIndices[i];
+        _processSample(ioWorker, inInputs + sampleIndex * nrOfInputs, inTargets + sampleIndex * nrOfOutputs);
+    }
+}
+
+void CTrainer::_processSample(Worker& ioWorker, const float* inInput, const float* inTarget)
+{
+    const utils::CMath& math = *m_Net.math();
+    const unsigned int nrOfLayers = m_Net.nrOfLayers();
+    const unsigned int outputLayerIndex = nrOfLayers - 1;
+
+    // Forward: Keep the pre activations and the outputs of every layer.
+    const unsigned int nrOfInputs = m_Net.neuronsInLayer(0);
+    memcpy(ioWorker.activations.data(), inInput, nrOfInputs * sizeof(float));
+    ioWorker.activations[nrOfInputs] = 1.f;
+
+    for (unsigned int layerIndex = 1; layerIndex < nrOfLayers; ++layerIndex)
+    {
+        const CLayer::IActivation* activation = (outputLayerIndex == layerIndex) ? m_Net.outputActivation() : m_Net.hiddenLayerActivation();
+        const unsigned int nrOfNeurons = m_Net.neuronsInLayer(layerIndex);
+        const unsigned int nrOfParentNeurons = m_Net.neuronsInLayer(layerIndex - 1);
+
+        const utils::CVectorF32 inputValues(ioWorker.activations.data() + m_LayerOffsets[layerIndex - 1], nrOfParentNeurons + 1);
+        utils::CVectorF32 preActivations(ioWorker.preActivations.data() + m_LayerOffsets[layerIndex], nrOfNeurons + 1);
+        float* outputValues = ioWorker.activations.data() + m_LayerOffsets[layerIndex];
+
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+        {
+            const Row& row = m_Rows[m_FirstRowOfLayer[layerIndex] + neuronIndex];
+            const utils::CVectorF32 weightnings(row.weightnings, row.nrOfElements);
+            preActivations[neuronIndex] = math.calcDotF32(weightnings, inputValues);
+        }
+
+        float integralPart = 1.f;
+        if (activation->needsIntegralPart())
+        {
+            integralPart = math.sumUpVector(preActivations, 0, nrOfNeurons);
+        }
+        ioWorker.integrals[layerIndex] = integralPart;
+
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+        {
+            outputValues[neuronIndex] = activation->activation(0.f, integralPart, preActivations[neuronIndex]);
+        }
+        outputValues[nrOfNeurons] = 1.f;
+    }
+
+    // The loss and its gradient in respect of the outputs
+    float* errors = ioWorker.errors[0].data();
+    float* parentErrors = ioWorker.errors[1].data();
+    {
+        const unsigned int nrOfOutputs = m_Net.neuronsInLayer(outputLayerIndex);
+        const float* outputValues = ioWorker.activations.data() + m_LayerOffsets[outputLayerIndex];
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfOutputs; ++neuronIndex)
+        {
+            errors[neuronIndex] = outputValues[neuronIndex] - inTarget[neuronIndex];
+            ioWorker.lossSum += 0.5f * errors[neuronIndex] * errors[neuronIndex];
+        }
+    }
+
+    // Backward
+    for (unsigned int layerIndex = outputLayerIndex; layerIndex > 0; --layerIndex)
+    {
+        const CLayer::IActivation* activation = (outputLayerIndex == layerIndex) ? m_Net.outputActivation() : m_Net.hiddenLayerActivation();
+        const unsigned int nrOfNeurons = m_Net.neuronsInLayer(layerIndex);
+        const unsigned int nrOfParentNeurons = m_Net.neuronsInLayer(layerIndex - 1);
+        const float* preActivations = ioWorker.preActivations.data() + m_LayerOffsets[layerIndex];
+        const float* outputValues = ioWorker.activations.data() + m_LayerOffsets[layerIndex];
+        const float* inputValues = ioWorker.activations.data() + m_LayerOffsets[layerIndex - 1];
+        const float integralPart = ioWorker.integrals[layerIndex];
+
+        // An activation that divides by the integral part couples all
+        // neurons: d(y_i)/d(x_j) = (delta_ij - y_i) / integral
+        float coupling = 0.f;
+        if (activation->needsIntegralPart())
+        {
+            for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+            {
+                coupling += errors[neuronIndex] * outputValues[neuronIndex];
+            }
+        }
+
+        // errors becomes the loss gradient in respect of the pre activations.
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+        {
+            errors[neuronIndex] = activation->derivative(integralPart, preActivations[neuronIndex]) * (errors[neuronIndex] - coupling);
+        }
+
+        const bool hasParentErrors = layerIndex > 1;
+        if (hasParentErrors)
+        {
+            std::fill(parentErrors, parentErrors + nrOfParentNeurons, 0.f);
+        }
+
+        for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+        {
+            const Row& row = m_Rows[m_FirstRowOfLayer[layerIndex] + neuronIndex];
+            const float error = errors[neuronIndex];
+            float* gradients = ioWorker.gradients.data() + row.gradientOffset;
+            for (unsigned int i = 0; i <= nrOfParentNeurons; ++i)
+            {
+                gradients[i] += error * inputValues[i];
+            }
+
+            if (hasParentErrors)
+            {
+                for (unsigned int i = 0; i < nrOfParentNeurons; ++i)
+                {
+                    parentErrors[i] += error * row.weightnings[i];
+                }
+            }
+        }
+        std::swap(errors, parentErrors);
+    }
+}
+
+void CTrainer::_reduceAndUpdate(unsigned int inWorkerIndex, float inScale)
+{
+    // The rows of this worker are summed up into the gradients of worker 0
+    // in the order of the workers. So the sum does not depend on the timing.
+    float* sum = m_Workers.front()->gradients.data();
+
+    // Adam: The bias correction of both moments is folded into the step size.
+    float adamStepSize = 0.f;
+    if (Optimizer::adam == m_Config.optimizer)
+    {
+        const double step = static_cast<double>(m_NrOfSteps);
+        adamStepSize = static_cast<float>(m_Config.learningRate * std::sqrt(1. - std::pow(m_Config.beta2, step))
+                                                                / (1. - std::pow(m_Config.beta1, step)));
+    }
+
+    for (size_t rowIndex = m_RowRangeOfWorker[inWorkerIndex]; rowIndex < m_RowRangeOfWorker[inWorkerIndex + 1]; ++rowIndex)
+    {
+        const Row& row = m_Rows[rowIndex];
+        float* rowSum = sum + row.gradientOffset;
+        for (size_t workerIndex = 1; workerIndex < m_Workers.size(); ++workerIndex)
+        {
+            const float* rowGradients = m_Workers[workerIndex]->gradients.data() + row.gradientOffset;
+            for (size_t i = 0; i < row.nrOfElements; ++i)
+            {
+                rowSum[i] += rowGradients[i];
+            }
+        }
+
+        switch (m_Config.optimizer)
+        {
+            case Optimizer::sgd:
+                utils::kernels::stepSGDF32(row.weightnings, rowSum, row.nrOfElements, m_Config.learningRate * inScale);
+                break;
+
+            case Optimizer::momentum:
+                utils::kernels::stepMomentumF32(row.weightnings, m_OptimizerState.data() + row.gradientOffset, rowSum,
+                    row.nrOfElements, inScale, m_Config.learningRate, m_Config.momentum);
+                break;
+
+            case Optimizer::adam:
+                utils::kernels::stepAdamF32(row.weightnings, m_OptimizerState.data() + row.gradientOffset,
+                    m_OptimizerState.data() + m_NrOfParameters + row.gradientOffset, rowSum, row.nrOfElements,
+                    inScale, adamStepSize, m_Config.beta1, m_Config.beta2, m_Config.epsilon);
+                break;
+        }
+    }
+}
+
+void CTrainer::_runOnAllWorkers(const char* inJobName, const JobRef& inJob)
+{
+    m_JobName = inJobName;
+    if (!m_Threads.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_PoolMutex);
+            m_Job = &inJob;
+            m_NrOfPendingWorkers = static_cast<unsigned int>(m_Threads.size());
+            ++m_JobGeneration;
+        }
+        m_StartJob.notify_all();
+    }
+
+    {
+        UTILS_TRACE_SCOPE(traceScope, m_JobName, utils::CTrace::kTask, 0);
+        inJob(0);
+    }
+
+    if (!m_Threads.empty())
+    {
+        std::unique_lock<std::mutex> lock(m_PoolMutex);
+        m_JobDone.wait(lock, [this](){return 0 == m_NrOfPendingWorkers;});
+        m_Job = nullptr;
+    }
+}
+
+void CTrainer::_workerThread(unsigned int inWorkerIndex)
+{
+    unsigned long long lastJobGeneration = 0;
+    for (;;)
+    {
+        const JobRef* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_PoolMutex);
+            m_StartJob.wait(lock, [this, lastJobGeneration](){return m_Quit || (lastJobGeneration != m_JobGeneration);});
+            if (m_Quit)
+            {
+                return;
+            }
+            lastJobGeneration = m_JobGeneration;
+            job = m_Job;
+        }
+
+        {
+            // m_JobName is kept until all workers have finished the job.
+            UTILS_TRACE_SCOPE(traceScope, m_JobName, utils::CTrace::kTask, inWorkerIndex);
+            (*job)(inWorkerIndex);
+        }
+
+        bool isLastWorker = false;
+        {
+            std::lock_guard<std::mutex> lock(m_PoolMutex);
+            isLastWorker = (0 == --m_NrOfPendingWorkers);
+        }
+        if (isLastWorker)
+        {
+            m_JobDone.notify_one();
+        }
+    }
+}
+
+} // namespace kilib
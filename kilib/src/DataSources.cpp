@@ -0,0 +1,640 @@
+/* ==========================================================================
+ * @(#)File: kilib/src/DataSources.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "kilib/include/DataSources.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+static bool _isDigit(char inChar)
+{
+    return (inChar >= '0') && (inChar <= '9');
+}
+
+static const char* _skipBlanks(const char* inPosition, const char* inEnd)
+{
+    while ((inPosition < inEnd) && ((' ' == *inPosition) || ('\t' == *inPosition) || ('\r' == *inPosition)))
+    {
+        ++inPosition;
+    }
+    return inPosition;
+}
+
+/*!
+ * @brief Parses a decimal floating point number like "-12.5e-3".
+ *
+ * Unlike strtof() this neither depends on the locale nor needs a
+ * terminated string. Up to 19 significant digits are collected in an
+ * integer that is scaled by a power of 10 once.
+ *
+ * @param ioPosition The first character. Behind the number on success.
+ * @param inEnd The end of the characters.
+ * @param outValue Receives the number.
+ * @return false if there is no number at \p ioPosition.
+ */
+static bool _parseFloat(const char*& ioPosition, const char* inEnd, float& outValue)
+{
+    static const double kPowersOf10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    constexpr int kMaxPowerOf10 = 22;
+    constexpr unsigned int kMaxDigits = 19;
+
+    const char* position = _skipBlanks(ioPosition, inEnd);
+    bool isNegative = false;
+    if ((position < inEnd) && (('-' == *position) || ('+' == *position)))
+    {
+        isNegative = ('-' == *position);
+        ++position;
+    }
+
+    std::uint64_t mantissa = 0;
+    unsigned int nrOfDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; (position < inEnd) && _isDigit(*position); ++position)
+    {
+        hasDigits = true;
+        if (nrOfDigits < kMaxDigits)
+        {
+            mantissa = 10 * mantissa + static_cast<unsigned int>(*position - '0');
+            nrOfDigits += (0 != mantissa) ? 1 : 0;
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+
+    if ((position < inEnd) && ('.' == *position))
+    {
+        for (++position; (position < inEnd) && _isDigit(*position); ++position)
+        {
+            hasDigits = true;
+            if (nrOfDigits < kMaxDigits)
+            {
+                mantissa = 10 * mantissa + static_cast<unsigned int>(*position - '0');
+                nrOfDigits += (0 != mantissa) ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+
+    if (!hasDigits)
+    {
+        return false;
+    }
+
+    if ((position < inEnd) && (('e' == *position) || ('E' == *position)))
+    {
+        ++position;
+        bool isNegativeExponent = false;
+        if ((position < inEnd) && (('-' == *position) || ('+' == *position)))
+        {
+            isNegativeExponent = ('-' == *position);
+            ++position;
+        }
+
+        if ((position >= inEnd) || !_isDigit(*position))
+        {
+            return false;
+        }
+
+        int explicitExponent = 0;
+        for (; (position < inEnd) && _isDigit(*position); ++position)
+        {
+            if (explicitExponent < 10000)
+            {
+                explicitExponent = 10 * explicitExponent + (*position - '0');
+            }
+        }
+        exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    double value = static_cast<double>(mantissa);
+    for (; (0 != mantissa) && (exponent > kMaxPowerOf10) && (value < 1e300); exponent -= kMaxPowerOf10)
+    {
+        value *= kPowersOf10[kMaxPowerOf10];
+    }
+    for (; (0 != mantissa) && (exponent < -kMaxPowerOf10) && (value > 1e-300); exponent += kMaxPowerOf10)
+    {
+        value /= kPowersOf10[kMaxPowerOf10];
+    }
+
+    if ((exponent >= 0) && (exponent <= kMaxPowerOf10))
+    {
+        value *= kPowersOf10[exponent];
+    }
+    else if ((exponent < 0) && (exponent >= -kMaxPowerOf10))
+    {
+        value /= kPowersOf10[-exponent];
+    }
+
+    outValue = static_cast<float>(isNegative ? -value : value);
+    ioPosition = position;
+    return true;
+}
+
+/*!
+ * @brief Writes the one hot encoding of a class label.
+ * @return false if the label is not a class [0 ... inNrOfClasses-1].
+ */
+static bool _encodeClass(float inLabel, unsigned int inNrOfClasses, float* outTargets)
+{
+    if (!(inLabel >= 0.f) || (inLabel >= static_cast<float>(inNrOfClasses)) || (inLabel != static_cast<float>(static_cast<unsigned int>(inLabel))))
+    {
+        return false;
+    }
+
+    std::fill(outTargets, outTargets + inNrOfClasses, 0.f);
+    outTargets[static_cast<unsigned int>(inLabel)] = 1.f;
+    return true;
+}
+
+static float _idxValue(const unsigned char* inValue, std::uint8_t inType)
+{
+    switch (inType)
+    {
+        case 0x08: return static_cast<float>(inValue[0]);
+        case 0x09: return static_cast<float>(static_cast<std::int8_t>(inValue[0]));
+        case 0x0B: return static_cast<float>(static_cast<std::int16_t>((inValue[0] << 8) | inValue[1]));
+        case 0x0C: return static_cast<float>(static_cast<std::int32_t>(
+                        (std::uint32_t(inValue[0]) << 24) | (std::uint32_t(inValue[1]) << 16) | (std::uint32_t(inValue[2]) << 8) | inValue[3]));
+        case 0x0D:
+        {
+            const std::uint32_t bits = (std::uint32_t(inValue[0]) << 24) | (std::uint32_t(inValue[1]) << 16) | (std::uint32_t(inValue[2]) << 8) | inValue[3];
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        case 0x0E:
+        {
+            std::uint64_t bits = 0;
+            for (unsigned int i = 0; i < 8; ++i)
+            {
+                bits = (bits << 8) | inValue[i];
+            }
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return static_cast<float>(value);
+        }
+        default:
+            assert(false);
+            return 0.f;
+    }
+}
+
+static unsigned int _idxSizeOfType(std::uint8_t inType)
+{
+    switch (inType)
+    {
+        case 0x08: case 0x09: return 1;
+        case 0x0B: return 2;
+        case 0x0C: case 0x0D: return 4;
+        case 0x0E: return 8;
+        default: return 0;
+    }
+}
+
+namespace kilib {
+// ==========================================================================
+// class CCSVDataSource - public
+// ==========================================================================
+auto CCSVDataSource::open(const char* inPath, const Config& inConfig) -> Error
+{
+    if (0 == inConfig.nrOfInputs)
+    {
+        return Error::param;
+    }
+
+    if (!m_File.open(inPath))
+    {
+        return Error::io;
+    }
+
+    m_Config = inConfig;
+    rewind();
+    return Error::ok;
+}
+
+unsigned int CCSVDataSource::nrOfInputs() const
+{
+    return m_Config.nrOfInputs;
+}
+
+unsigned int CCSVDataSource::nrOfTargets() const
+{
+    return (0 != m_Config.nrOfClasses) ? m_Config.nrOfClasses : m_Config.nrOfTargets;
+}
+
+unsigned int CCSVDataSource::read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples)
+{
+    const char* const data = m_File.data();
+    const char* const end = data + m_File.size();
+    const unsigned int nrOfInputs = this->nrOfInputs();
+    const unsigned int nrOfTargets = this->nrOfTargets();
+
+    unsigned int nrOfSamples = 0;
+    while ((nrOfSamples < inMaxNrOfSamples) && (m_Offset < m_File.size()))
+    {
+        const char* position = data + m_Offset;
+        const char* lineEnd = static_cast<const char*>(memchr(position, '\n', static_cast<size_t>(end - position)));
+        if (nullptr == lineEnd)
+        {
+            lineEnd = end;
+        }
+
+        if (_skipBlanks(position, lineEnd) != lineEnd)
+        {
+            if (_parseLine(position, lineEnd, outInputs + nrOfSamples * nrOfInputs, outTargets + nrOfSamples * nrOfTargets))
+            {
+                ++nrOfSamples;
+            }
+            else
+            {
+                ++m_NrOfSkippedLines;
+            }
+        }
+        m_Offset = static_cast<size_t>(lineEnd - data) + 1;
+    }
+
+    // The lines read so far are not needed any more.
+    m_File.release(m_Offset);
+    return nrOfSamples;
+}
+
+void CCSVDataSource::rewind()
+{
+    m_Offset = 0;
+    m_NrOfSkippedLines = 0;
+    if (m_Config.hasHeader)
+    {
+        _skipHeader();
+    }
+}
+
+unsigned long long CCSVDataSource::nrOfSkippedLines() const
+{
+    return m_NrOfSkippedLines;
+}
+
+// ==========================================================================
+// class CCSVDataSource - private
+// ==========================================================================
+bool CCSVDataSource::_parseLine(const char*& ioPosition, const char* inEnd, float* outInputs, float* outTargets) const
+{
+    const unsigned int nrOfInputs = m_Config.nrOfInputs;
+    const unsigned int nrOfTargetColumns = (0 != m_Config.nrOfClasses) ? 1 : m_Config.nrOfTargets;
+    const unsigned int nrOfColumns = nrOfInputs + nrOfTargetColumns;
+    const unsigned int firstInputColumn = m_Config.targetsFirst ? nrOfTargetColumns : 0;
+    const unsigned int firstTargetColumn = m_Config.targetsFirst ? 0 : nrOfInputs;
+
+    for (unsigned int column = 0; column < nrOfColumns; ++column)
+    {
+        float value = 0.f;
+        if (!_parseFloat(ioPosition, inEnd, value))
+        {
+            return false;
+        }
+
+        if ((column >= firstInputColumn) && (column < firstInputColumn + nrOfInputs))
+        {
+            outInputs[column - firstInputColumn] = value * m_Config.inputScale + m_Config.inputOffset;
+        }
+        else if (0 != m_Config.nrOfClasses)
+        {
+            if (!_encodeClass(value, m_Config.nrOfClasses, outTargets))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            outTargets[column - firstTargetColumn] = value;
+        }
+
+        ioPosition = _skipBlanks(ioPosition, inEnd);
+        if (column + 1 < nrOfColumns)
+        {
+            if ((ioPosition >= inEnd) || (m_Config.separator != *ioPosition))
+            {
+                return false;
+            }
+            ++ioPosition;
+        }
+    }
+    return ioPosition == inEnd;
+}
+
+void CCSVDataSource::_skipHeader()
+{
+    const char* data = m_File.data();
+    const char* lineEnd = data ? static_cast<const char*>(memchr(data, '\n', m_File.size())) : nullptr;
+    m_Offset = lineEnd ? static_cast<size_t>(lineEnd - data) + 1 : m_File.size();
+}
+
+// ==========================================================================
+// class CIDXDataSource - public
+// ==========================================================================
+auto CIDXDataSource::open(const char* inInputsPath, const char* inTargetsPath, const Config& inConfig) -> Error
+{
+    if (!m_InputsFile.open(inInputsPath) || !m_TargetsFile.open(inTargetsPath))
+    {
+        m_InputsFile.close();
+        return Error::io;
+    }
+
+    Values inputs;
+    Values targets;
+    if (!_parseHeader(m_InputsFile, inputs) || !_parseHeader(m_TargetsFile, targets)
+     || (inputs.nrOfSamples != targets.nrOfSamples))
+    {
+        m_InputsFile.close();
+        m_TargetsFile.close();
+        return Error::format;
+    }
+
+    if ((0 != inConfig.nrOfClasses) && (1 != targets.valuesPerSample))
+    {
+        m_InputsFile.close();
+        m_TargetsFile.close();
+        return Error::param;
+    }
+
+    m_Inputs = inputs;
+    m_Targets = targets;
+    m_Config = inConfig;
+    m_NextSample = 0;
+    return Error::ok;
+}
+
+unsigned int CIDXDataSource::nrOfInputs() const
+{
+    return m_Inputs.valuesPerSample;
+}
+
+unsigned int CIDXDataSource::nrOfTargets() const
+{
+    return (0 != m_Config.nrOfClasses) ? m_Config.nrOfClasses : m_Targets.valuesPerSample;
+}
+
+unsigned int CIDXDataSource::read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples)
+{
+    const unsigned int nrOfInputs = this->nrOfInputs();
+    const unsigned int nrOfTargets = this->nrOfTargets();
+
+    unsigned int nrOfSamples = 0;
+    while ((nrOfSamples < inMaxNrOfSamples) && (m_NextSample < m_Inputs.nrOfSamples))
+    {
+        const unsigned char* inputs = reinterpret_cast<const unsigned char*>(m_Inputs.data)
+            + size_t(m_NextSample) * nrOfInputs * m_Inputs.bytesPerValue;
+        float* sampleInputs = outInputs + nrOfSamples * nrOfInputs;
+        if (0x08 == m_Inputs.type)
+        {
+            // The common case of images
+            for (unsigned int i = 0; i < nrOfInputs; ++i)
+            {
+                sampleInputs[i] = static_cast<float>(inputs[i]) * m_Config.inputScale + m_Config.inputOffset;
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < nrOfInputs; ++i)
+            {
+                sampleInputs[i] = _idxValue(inputs + i * m_Inputs.bytesPerValue, m_Inputs.type) * m_Config.inputScale + m_Config.inputOffset;
+            }
+        }
+
+        const unsigned char* targets = reinterpret_cast<const unsigned char*>(m_Targets.data)
+            + size_t(m_NextSample) * m_Targets.valuesPerSample * m_Targets.bytesPerValue;
+        float* sampleTargets = outTargets + nrOfSamples * nrOfTargets;
+        if (0 != m_Config.nrOfClasses)
+        {
+            if (!_encodeClass(_idxValue(targets, m_Targets.type), m_Config.nrOfClasses, sampleTargets))
+            {
+                std::fill(sampleTargets, sampleTargets + nrOfTargets, 0.f); // Unknown class
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < nrOfTargets; ++i)
+            {
+                sampleTargets[i] = _idxValue(targets + i * m_Targets.bytesPerValue, m_Targets.type);
+            }
+        }
+
+        ++m_NextSample;
+        ++nrOfSamples;
+    }
+
+    m_InputsFile.release(static_cast<size_t>(m_Inputs.data - m_InputsFile.data()) + size_t(m_NextSample) * nrOfInputs * m_Inputs.bytesPerValue);
+    return nrOfSamples;
+}
+
+void CIDXDataSource::rewind()
+{
+    m_NextSample = 0;
+}
+
+unsigned int CIDXDataSource::nrOfSamples() const
+{
+    return m_Inputs.nrOfSamples;
+}
+
+// ==========================================================================
+// class CIDXDataSource - private
+// ==========================================================================
+bool CIDXDataSource::_parseHeader(const utils::CMappedFile& inFile, Values& outValues)
+{
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(inFile.data());
+    const size_t size = inFile.size();
+
+    // Magic: 0, 0, type, number of dimensions
+    if ((size < 4) || (0 != data[0]) || (0 != data[1]) || (0 == _idxSizeOfType(data[2])) || (0 == data[3]))
+    {
+        return false;
+    }
+
+    const unsigned int nrOfDimensions = data[3];
+    const size_t headerSize = 4 + 4 * size_t(nrOfDimensions);
+    if (size < headerSize)
+    {
+        return false;
+    }
+
+    std::uint64_t valuesPerSample = 1;
+    std::uint64_t nrOfSamples = 0;
+    for (unsigned int dimension = 0; dimension < nrOfDimensions; ++dimension)
+    {
+        const unsigned char* dimensionSize = data + 4 + 4 * dimension;
+        const std::uint64_t thisSize = (std::uint64_t(dimensionSize[0]) << 24) | (std::uint64_t(dimensionSize[1]) << 16)
+                                     | (std::uint64_t(dimensionSize[2]) << 8) | dimensionSize[3];
+        if (0 == dimension)
+        {
+            nrOfSamples = thisSize;
+        }
+        else
+        {
+            valuesPerSample *= thisSize;
+        }
+    }
+
+    const unsigned int bytesPerValue = _idxSizeOfType(data[2]);
+    if ((0 == valuesPerSample) || (valuesPerSample > 0xFFFFFFFFu)
+     || ((size - headerSize) / bytesPerValue / valuesPerSample < nrOfSamples))
+    {
+        return false;
+    }
+
+    outValues.data = inFile.data() + headerSize;
+    outValues.type = data[2];
+    outValues.nrOfSamples = static_cast<unsigned int>(nrOfSamples);
+    outValues.valuesPerSample = static_cast<unsigned int>(valuesPerSample);
+    outValues.bytesPerValue = bytesPerValue;
+    return true;
+}
+
+// ==========================================================================
+// class CRawDataSource - public
+// ==========================================================================
+auto CRawDataSource::open(const char* inPath, const Config& inConfig) -> Error
+{
+    if (0 == inConfig.nrOfInputs)
+    {
+        return Error::param;
+    }
+
+    if (!m_File.open(inPath))
+    {
+        return Error::io;
+    }
+
+    m_Config = inConfig;
+    if (0 != m_File.size() % (size_t(_valuesPerSample()) * sizeof(float)))
+    {
+        m_File.close();
+        return Error::format;
+    }
+
+    m_NextSample = 0;
+    return Error::ok;
+}
+
+unsigned int CRawDataSource::nrOfInputs() const
+{
+    return m_Config.nrOfInputs;
+}
+
+unsigned int CRawDataSource::nrOfTargets() const
+{
+    return (0 != m_Config.nrOfClasses) ? m_Config.nrOfClasses : m_Config.nrOfTargets;
+}
+
+unsigned int CRawDataSource::read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples)
+{
+    const unsigned int nrOfInputs = this->nrOfInputs();
+    const unsigned int nrOfTargets = this->nrOfTargets();
+    const unsigned int valuesPerSample = _valuesPerSample();
+    const bool isScaled = (1.f != m_Config.inputScale) || (0.f != m_Config.inputOffset);
+
+    const unsigned long long nrOfAvailableSamples = nrOfSamples() - m_NextSample;
+    const unsigned int nrOfSamples = (nrOfAvailableSamples < inMaxNrOfSamples)
+                                   ? static_cast<unsigned int>(nrOfAvailableSamples) : inMaxNrOfSamples;
+    for (unsigned int sampleIndex = 0; sampleIndex < nrOfSamples; ++sampleIndex)
+    {
+        // The mapping is page aligned, so are the floats.
+        const float* sample = reinterpret_cast<const float*>(m_File.data()) + (m_NextSample + sampleIndex) * valuesPerSample;
+        float* sampleInputs = outInputs + sampleIndex * nrOfInputs;
+        if (isScaled)
+        {
+            for (unsigned int i = 0; i < nrOfInputs; ++i)
+            {
+                sampleInputs[i] = sample[i] * m_Config.inputScale + m_Config.inputOffset;
+            }
+        }
+        else
+        {
+            memcpy(sampleInputs, sample, nrOfInputs * sizeof(float));
+        }
+
+        float* sampleTargets = outTargets + sampleIndex * nrOfTargets;
+        if (0 != m_Config.nrOfClasses)
+        {
+            if (!_encodeClass(sample[nrOfInputs], m_Config.nrOfClasses, sampleTargets))
+            {
+                std::fill(sampleTargets, sampleTargets + nrOfTargets, 0.f); // Unknown class
+            }
+        }
+        else if (0 != nrOfTargets)
+        {
+            memcpy(sampleTargets, sample + nrOfInputs, nrOfTargets * sizeof(float));
+        }
+    }
+
+    m_NextSample += nrOfSamples;
+    m_File.release(static_cast<size_t>(m_NextSample * valuesPerSample * sizeof(float)));
+    return nrOfSamples;
+}
+
+void CRawDataSource::rewind()
+{
+    m_NextSample = 0;
+}
+
+unsigned long long CRawDataSource::nrOfSamples() const
+{
+    return m_File.size() / (size_t(_valuesPerSample()) * sizeof(float));
+}
+
+// ==========================================================================
+// class CRawDataSource - private
+// ==========================================================================
+unsigned int CRawDataSource::_valuesPerSample() const
+{
+    return m_Config.nrOfInputs + ((0 != m_Config.nrOfClasses) ? 1 : m_Config.nrOfTargets);
+}
+
+} // namespace kilib
@@ -0,0 +1,96 @@
+/*
+ * @file UT_CBatchLoader.cpp
+ * @brief Unittest for CBatchLoader
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "kilib/include/CBatchLoader.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cstdint>
+
+namespace {
+/*!
+ * @brief Generates the samples i = 0 ... n-1 with the inputs {i, -i} and
+ * the target {2i}.
+ */
+class CCountingSource final : public kilib::IDataSource
+{
+public:
+    explicit CCountingSource(unsigned int inNrOfSamples)
+    : m_NrOfSamples(inNrOfSamples)
+    {}
+
+    virtual unsigned int nrOfInputs() const override {return 2;}
+    virtual unsigned int nrOfTargets() const override {return 1;}
+
+    virtual unsigned int read(float* outInputs, float* outTargets, unsigned int inMaxNrOfSamples) override
+    {
+        unsigned int nrOfSamples = 0;
+        for (; (nrOfSamples < inMaxNrOfSamples) && (m_NextSample < m_NrOfSamples); ++nrOfSamples, ++m_NextSample)
+        {
+            outInputs[2 * nrOfSamples] = static_cast<float>(m_NextSample);
+            outInputs[2 * nrOfSamples + 1] = -static_cast<float>(m_NextSample);
+            outTargets[nrOfSamples] = 2.f * m_NextSample;
+        }
+        return nrOfSamples;
+    }
+
+    virtual void rewind() override {m_NextSample = 0;}
+
+private:
+    const unsigned int m_NrOfSamples;
+    unsigned int m_NextSample = 0;
+};
+} // namespace
+
+TSUNIT_TEST(kilib_CBatchLoader, deliversAllSamplesInOrderByAlignedBatches)
+{
+    CCountingSource source(1003);
+    kilib::CBatchLoader loader(source, 10);
+
+    for (unsigned int epoch = 0; epoch < 2; ++epoch)
+    {
+        kilib::CBatchLoader::Batch batch;
+        unsigned int nextSample = 0;
+        unsigned int nrOfBatches = 0;
+        bool inOrder = true;
+        bool isAligned = true;
+        while (loader.nextBatch(batch))
+        {
+            isAligned = isAligned && (0 == reinterpret_cast<std::uintptr_t>(batch.inputs) % kilib::CBatchLoader::kAlignment)
+                                  && (0 == reinterpret_cast<std::uintptr_t>(batch.targets) % kilib::CBatchLoader::kAlignment);
+            for (unsigned int i = 0; i < batch.nrOfSamples; ++i, ++nextSample)
+            {
+                inOrder = inOrder && (static_cast<float>(nextSample) == batch.inputs[2 * i])
+                                  && (-static_cast<float>(nextSample) == batch.inputs[2 * i + 1])
+                                  && (2.f * nextSample == batch.targets[i]);
+            }
+            ++nrOfBatches;
+        }
+        UT_EXPECT_TRUE(inOrder);
+        UT_EXPECT_TRUE(isAligned);
+        UT_EXPECT_EQ(1003, nextSample);
+        UT_EXPECT_EQ(101, nrOfBatches);
+        UT_EXPECT_EQ(0, batch.nrOfSamples);
+
+        // The end stays the end until rewind().
+        UT_EXPECT_FALSE(loader.nextBatch(batch));
+        loader.rewind();
+    }
+}
+
+TSUNIT_TEST(kilib_CBatchLoader, rewindWithinAnEpochRestarts)
+{
+    CCountingSource source(100);
+    kilib::CBatchLoader loader(source, 8);
+
+    kilib::CBatchLoader::Batch batch;
+    UT_EXPECT_TRUE(loader.nextBatch(batch));
+    UT_EXPECT_TRUE(loader.nextBatch(batch));
+    UT_EXPECT_EQ(8.f, batch.inputs[0]);
+
+    loader.rewind();
+    UT_EXPECT_TRUE(loader.nextBatch(batch));
+    UT_EXPECT_EQ(0.f, batch.inputs[0]);
+    UT_EXPECT_EQ(8, batch.nrOfSamples);
+}
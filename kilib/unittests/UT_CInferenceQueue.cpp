@@ -0,0 +1,124 @@
+/*
+ * @file UT_CInferenceQueue.cpp
+ * @brief Unittest for CInferenceQueue
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "kilib/include/CInferenceQueue.hpp"
+#include "kilib/include/Activation.hpp"
+#include "utils/include/CMath.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+TSUNIT_TEST(kilib_CInferenceQueue, requestsOfManyThreadsAreBatched)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    net.init({6, 16, 4}, reLU, softmax, math);
+
+    constexpr unsigned int kNrOfThreads = 4;
+    constexpr unsigned int kNrOfRequestsPerThread = 200;
+    constexpr unsigned int kNrOfRequests = kNrOfThreads * kNrOfRequestsPerThread;
+
+    // The expected results by the synchronous propagation
+    std::vector<float> inputs(kNrOfRequests * 6);
+    std::vector<float> expected(kNrOfRequests * 4);
+    for (unsigned int requestIndex = 0; requestIndex < kNrOfRequests; ++requestIndex)
+    {
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            inputs[requestIndex * 6 + i] = utils::CMath::randF32(0.f, 1.f);
+            (*net.inputLayer()->neuronOutputVector())[i] = inputs[requestIndex * 6 + i];
+        }
+        net.forwardPropagation([&](unsigned int index, float value)->void{
+            expected[requestIndex * 4 + index] = value;
+        });
+    }
+
+    kilib::CInferenceQueue::Config config;
+    config.maxBatchSize = 16;
+    config.maxLatency = std::chrono::microseconds(2000);
+    kilib::CInferenceQueue queue(net, config);
+    UT_EXPECT_FALSE(queue.isStarted());
+    UT_EXPECT_FALSE(queue.submit(&inputs[0]).valid());
+    UT_EXPECT_TRUE(queue.start());
+    UT_EXPECT_TRUE(queue.isStarted());
+    UT_EXPECT_FALSE(queue.start());
+
+    std::vector<float> results(kNrOfRequests * 4);
+    std::atomic<unsigned int> nrOfCompletions{0};
+    std::atomic<unsigned int> nrOfRejects{0};
+    std::vector<std::thread> clients;
+    for (unsigned int threadIndex = 0; threadIndex < kNrOfThreads; ++threadIndex)
+    {
+        clients.emplace_back([&, threadIndex](){
+            for (unsigned int i = 0; i < kNrOfRequestsPerThread; ++i)
+            {
+                const unsigned int requestIndex = threadIndex * kNrOfRequestsPerThread + i;
+                const bool submitted = queue.submit(&inputs[requestIndex * 6], [&, requestIndex](const float* inOutputs){
+                    std::copy(inOutputs, inOutputs + 4, &results[requestIndex * 4]);
+                    ++nrOfCompletions;
+                });
+                nrOfRejects += submitted ? 0 : 1;
+            }
+        });
+    }
+
+    for (std::thread& thisClient : clients)
+    {
+        thisClient.join();
+    }
+
+    // A future request
+    std::future<std::vector<float>> future = queue.submit(&inputs[0]);
+    UT_EXPECT_TRUE(future.valid());
+    const std::vector<float> futureResult = future.get();
+    UT_EXPECT_EQ(4, futureResult.size());
+    for (unsigned int index = 0; index < 4; ++index)
+    {
+        UT_EXPECT_EQ(expected[index], futureResult[index]);
+    }
+
+    // Stopping completes all pending requests.
+    queue.stop();
+    UT_EXPECT_FALSE(queue.isStarted());
+    UT_EXPECT_EQ(0, nrOfRejects);
+    UT_EXPECT_EQ(kNrOfRequests, nrOfCompletions);
+    UT_EXPECT_TRUE(expected == results);
+
+    const kilib::CInferenceQueue::Statistics statistics = queue.statistics();
+    UT_EXPECT_EQ(kNrOfRequests + 1, statistics.nrOfRequests);
+    UT_EXPECT_TRUE(statistics.nrOfBatches >= (kNrOfRequests + 1) / config.maxBatchSize);
+    UT_EXPECT_TRUE(statistics.nrOfBatches <= kNrOfRequests + 1);
+}
+
+TSUNIT_TEST(kilib_CInferenceQueue, failedBatchesAreCompletedWithoutOutputs)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    kilib::CNeuronalNet net;
+    net.init({3, 4, 2}, reLU, reLU, math);
+
+    kilib::CInferenceQueue queue(net);
+    UT_EXPECT_TRUE(queue.start());
+
+    // Break the network while the worker is idle.
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::zeroNeuronsInLayer, net.init({3, 0}, reLU, reLU, math));
+
+    const float inputs[3] = {0.1f, 0.2f, 0.3f};
+    std::promise<const float*> outputs;
+    UT_EXPECT_TRUE(queue.submit(inputs, [&](const float* inOutputs){outputs.set_value(inOutputs);}));
+    UT_EXPECT_EQ(nullptr, outputs.get_future().get());
+
+    std::future<std::vector<float>> future = queue.submit(inputs);
+    UT_EXPECT_TRUE(future.valid());
+    UT_EXPECT_TRUE(future.get().empty());
+    queue.stop();
+}
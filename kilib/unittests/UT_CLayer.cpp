@@ -5,12 +5,18 @@
  */
 #include "kilib/include/CLayer.hpp"
 #include "kilib/include/Activation.hpp"
+#include "kilib/include/CNeuronalNet.hpp"
 
 #include "utils/include/CMath.hpp"
 #include "utils/include/CBLASMathDriver.hpp"
+#include "utils/include/CClassicMathDriver.hpp"
+#include "utils/include/CRandom.hpp"
 
 #include "tsunit/TSUnit.hpp"
 #include "tsunit/TSUnitTestAddOns.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 static kilib::CActivationNull nullActivation;
 
@@ -1034,3 +1040,401 @@ TSUNIT_TEST(kilib_CLayer_ComplexTests, complexNetwork)
     }
 
 }
+
+// ==========================================================================
+// Profiling tests
+// ==========================================================================
+TSUNIT_TEST(kilib_CLayer_ProfilingTests, profileCountsCallsFlopsAndBytesPerPhase)
+{
+    utils::CMath math;
+
+    kilib::CLayer layer[2];
+    layer[0].init(3, nullActivation, math, nullptr);
+    layer[1].init(2, nullActivation, math, &layer[0]);
+
+    layer[1].forwardPropagation(true);
+    layer[1].forwardPropagation(true);
+
+    const kilib::CLayer::Profile& profile = layer[1].profile();
+    if (kilib::kProfilingEnabled)
+    {
+        // The input Layer does not weight anything, but activates.
+        UT_EXPECT_EQ(0, layer[0].profile().dotProduct.calls);
+        UT_EXPECT_EQ(2, layer[0].profile().activation.calls);
+
+        UT_EXPECT_EQ(2, profile.dotProduct.calls);
+        UT_EXPECT_EQ(2 * (2 * 2 * (3 + 1)), profile.dotProduct.flops);
+        UT_EXPECT_EQ(2 * sizeof(float) * ((2 + 1) * (3 + 1) + 2), profile.dotProduct.bytes);
+
+        UT_EXPECT_EQ(2, profile.activation.calls);
+        UT_EXPECT_EQ(2 * 2, profile.activation.flops);
+        UT_EXPECT_EQ(2 * sizeof(float) * 2 * 2, profile.activation.bytes);
+    }
+    else
+    {
+        UT_EXPECT_EQ(0, profile.dotProduct.calls);
+        UT_EXPECT_EQ(0, profile.activation.calls);
+    }
+
+    layer[1].resetProfile();
+    UT_EXPECT_EQ(0, layer[1].profile().dotProduct.calls);
+    UT_EXPECT_EQ(0, layer[1].profile().dotProduct.flops);
+    UT_EXPECT_EQ(0, layer[1].profile().dotProduct.bytes);
+    UT_EXPECT_EQ(0, layer[1].profile().dotProduct.nanoSeconds);
+    UT_EXPECT_EQ(0, layer[1].profile().activation.calls);
+}
+
+// ==========================================================================
+// Sparse weightnings
+// ==========================================================================
+TSUNIT_TEST(kilib_CLayer_SparseTests, sparseFormatsYieldTheSameResultAsDense)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    constexpr unsigned int kNrOfInputs = 37;
+    constexpr unsigned int kNrOfNeurons = 9;
+
+    kilib::CLayer layer[2];
+    layer[0].init(kNrOfInputs, nullActivation, math, nullptr);
+    layer[1].init(kNrOfNeurons, reLU, math, &layer[0]);
+    for (unsigned int i = 0; i < kNrOfInputs; ++i)
+    {
+        (*layer[0].neuronOutputVector())[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        *layer[1].biasForNeuron(n) = 0.1f * n;
+    }
+
+    const unsigned int nrOfZeros = layer[1].pruneWeightnings(0.8f);
+    UT_EXPECT_EQ(static_cast<unsigned int>(0.8f * kNrOfInputs * kNrOfNeurons), nrOfZeros);
+    UT_EXPECT_TRUE(layer[1].weightningSparsity() >= 0.79f);
+
+    float expected[kNrOfNeurons];
+    float expectedWeightnings[kNrOfNeurons][kNrOfInputs + 1];
+    layer[1].forwardPropagation(false);
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        expected[n] = (*layer[1].neuronOutputVector())[n];
+        UT_EXPECT_TRUE(layer[1].weightningsOfNeuron(n, expectedWeightnings[n]));
+    }
+    const size_t denseSize = layer[1].weightningMemorySize();
+    UT_EXPECT_EQ(sizeof(float) * kNrOfNeurons * (kNrOfInputs + 1), denseSize);
+
+    for (const kilib::CLayer::WeightFormat weightFormat : {kilib::CLayer::WeightFormat::csr, kilib::CLayer::WeightFormat::blockSparse})
+    {
+        UT_EXPECT_TRUE(layer[1].setWeightFormat(weightFormat));
+        UT_EXPECT_TRUE(weightFormat == layer[1].weightFormat());
+        UT_EXPECT_TRUE(layer[1].weightningMemorySize() < denseSize);
+        UT_EXPECT_EQ(nullptr, static_cast<const kilib::CLayer&>(layer[1]).weightningVectorForNeuronAtIndex(0));
+        UT_EXPECT_TRUE(std::fabs(layer[1].weightningSparsity() - float(nrOfZeros) / (kNrOfInputs * kNrOfNeurons)) < 1e-6f);
+
+        layer[1].forwardPropagation(false);
+        for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+        {
+            UT_EXPECT_EQ(expected[n], (*layer[1].neuronOutputVector())[n]);
+
+            float weightnings[kNrOfInputs + 1];
+            UT_EXPECT_TRUE(layer[1].weightningsOfNeuron(n, weightnings));
+            UT_EXPECT_EQ(0, memcmp(expectedWeightnings[n], weightnings, sizeof(weightnings)));
+        }
+
+        // A mutable access converts back to dense
+        UT_EXPECT_NE(nullptr, layer[1].biasForNeuron(0));
+        UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense == layer[1].weightFormat());
+        UT_EXPECT_EQ(denseSize, layer[1].weightningMemorySize());
+    }
+
+    // The input layer has no weightnings
+    UT_EXPECT_FALSE(layer[0].setWeightFormat(kilib::CLayer::WeightFormat::csr));
+}
+
+TSUNIT_TEST(kilib_CLayer_SparseTests, panelsYieldTheSameResultAsDense)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    // Neither the neurons nor the batch fill the panels and tiles completely.
+    constexpr unsigned int kNrOfInputs = 37;
+    constexpr unsigned int kNrOfNeurons = 19;
+    constexpr unsigned int kBatchSize = 7;
+
+    kilib::CLayer layer[2];
+    layer[0].init(kNrOfInputs, nullActivation, math, nullptr);
+    layer[1].init(kNrOfNeurons, reLU, math, &layer[0]);
+    for (unsigned int i = 0; i < kNrOfInputs; ++i)
+    {
+        (*layer[0].neuronOutputVector())[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+
+    float inputs[kBatchSize][kNrOfInputs + 1];
+    for (unsigned int sampleIndex = 0; sampleIndex < kBatchSize; ++sampleIndex)
+    {
+        for (unsigned int i = 0; i < kNrOfInputs; ++i)
+        {
+            inputs[sampleIndex][i] = utils::CMath::randF32(-1.f, 1.f);
+        }
+        inputs[sampleIndex][kNrOfInputs] = 1.f;
+    }
+
+    float expected[kNrOfNeurons];
+    float expectedBatch[kBatchSize][kNrOfNeurons + 1];
+    float expectedWeightnings[kNrOfNeurons][kNrOfInputs + 1];
+    layer[1].forwardPropagation(false);
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        expected[n] = (*layer[1].neuronOutputVector())[n];
+        UT_EXPECT_TRUE(layer[1].weightningsOfNeuron(n, expectedWeightnings[n]));
+    }
+    UT_EXPECT_TRUE(layer[1].propagateBatch(&inputs[0][0], kBatchSize, &expectedBatch[0][0]));
+    const size_t denseSize = layer[1].weightningMemorySize();
+
+    UT_EXPECT_TRUE(layer[1].setWeightFormat(kilib::CLayer::WeightFormat::panels));
+    UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::panels == layer[1].weightFormat());
+    UT_EXPECT_EQ(sizeof(float) * 24 * (kNrOfInputs + 1), layer[1].weightningMemorySize());
+    UT_EXPECT_EQ(nullptr, static_cast<const kilib::CLayer&>(layer[1]).weightningVectorForNeuronAtIndex(0));
+
+    layer[1].forwardPropagation(false);
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        UT_EXPECT_EQ(expected[n], (*layer[1].neuronOutputVector())[n]);
+
+        float weightnings[kNrOfInputs + 1];
+        UT_EXPECT_TRUE(layer[1].weightningsOfNeuron(n, weightnings));
+        UT_EXPECT_EQ(0, memcmp(expectedWeightnings[n], weightnings, sizeof(weightnings)));
+    }
+
+    float outputs[kBatchSize][kNrOfNeurons + 1] = {};
+    UT_EXPECT_TRUE(layer[1].propagateBatch(&inputs[0][0], kBatchSize, &outputs[0][0]));
+    UT_EXPECT_EQ(0, memcmp(expectedBatch, outputs, sizeof(outputs)));
+
+    // A mutable access converts back to dense
+    UT_EXPECT_NE(nullptr, layer[1].biasForNeuron(0));
+    UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense == layer[1].weightFormat());
+    UT_EXPECT_EQ(denseSize, layer[1].weightningMemorySize());
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        UT_EXPECT_EQ(0, memcmp(expectedWeightnings[n], **layer[1].weightningVectorForNeuronAtIndex(n), sizeof(expectedWeightnings[n])));
+    }
+}
+
+// ==========================================================================
+// Selective propagation
+// ==========================================================================
+TSUNIT_TEST(kilib_CLayer_SelectiveTests, selectedNeuronsAndTopKMatchTheFullPropagation)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    constexpr unsigned int kNrOfInputs = 37;
+    constexpr unsigned int kNrOfNeurons = 19;
+    constexpr unsigned int kK = 4;
+    const unsigned int selected[] = {18, 3, 9, 8, 0, 9};
+    constexpr unsigned int kNrOfSelected = sizeof(selected) / sizeof(selected[0]);
+
+    kilib::CLayer layer[2];
+    layer[0].init(kNrOfInputs, nullActivation, math, nullptr);
+    layer[1].init(kNrOfNeurons, tanhActivation, math, &layer[0]);
+    for (unsigned int i = 0; i < kNrOfInputs; ++i)
+    {
+        (*layer[0].neuronOutputVector())[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+    layer[1].pruneWeightnings(0.5f);
+
+    for (const kilib::CLayer::WeightFormat weightFormat : {kilib::CLayer::WeightFormat::dense,
+        kilib::CLayer::WeightFormat::csr, kilib::CLayer::WeightFormat::blockSparse, kilib::CLayer::WeightFormat::panels})
+    {
+        UT_EXPECT_TRUE(layer[1].setWeightFormat(weightFormat));
+        const utils::CVectorF32& expected = *layer[1].forwardPropagation(false);
+
+        float values[kNrOfSelected];
+        UT_EXPECT_TRUE(layer[1].propagateNeurons(selected, kNrOfSelected, values));
+        for (unsigned int i = 0; i < kNrOfSelected; ++i)
+        {
+            UT_EXPECT_EQ(expected[selected[i]], values[i]);
+        }
+
+        unsigned int expectedOrder[kNrOfNeurons];
+        for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+        {
+            expectedOrder[n] = n;
+        }
+        std::stable_sort(expectedOrder, expectedOrder + kNrOfNeurons, [&](unsigned int inA, unsigned int inB) {
+            return expected[inA] > expected[inB];
+        });
+
+        unsigned int indices[kK];
+        UT_EXPECT_TRUE(layer[1].propagateTopK(kK, indices, values));
+        for (unsigned int i = 0; i < kK; ++i)
+        {
+            UT_EXPECT_EQ(expectedOrder[i], indices[i]);
+            UT_EXPECT_EQ(expected[expectedOrder[i]], values[i]);
+        }
+
+        UT_EXPECT_TRUE(layer[1].propagateTopK(1, indices, nullptr));
+        UT_EXPECT_EQ(expectedOrder[0], indices[0]);
+    }
+
+    const unsigned int outOfRange = kNrOfNeurons;
+    float value = 0.f;
+    unsigned int index = 0;
+    UT_EXPECT_FALSE(layer[1].propagateNeurons(&outOfRange, 1, &value));
+    UT_EXPECT_FALSE(layer[1].propagateTopK(0, &index, &value));
+    UT_EXPECT_FALSE(layer[1].propagateTopK(kNrOfNeurons + 1, &index, &value));
+    UT_EXPECT_FALSE(layer[0].propagateTopK(1, &index, &value));
+}
+
+// ==========================================================================
+// Math drivers
+// ==========================================================================
+TSUNIT_TEST(kilib_CLayer_DriverTests, injectedDriversAreUsedInsteadOfTheInlinedOne)
+{
+    class SpyDriver : public utils::CMath::IMathDriver
+    {
+    public:
+        virtual float calcDotF32(const utils::CVectorF32& inVectorA, const utils::CVectorF32& inVectorB, float offset) const override
+        {
+            ++m_calcDotF32Called;
+            return m_Driver.calcDotF32(inVectorA, inVectorB, offset);
+        }
+
+        virtual float sumUpF32(const utils::CVectorF32& inVector) const override
+        {
+            return m_Driver.sumUpF32(inVector);
+        }
+
+        virtual float sumUpF32(const utils::CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const override
+        {
+            return m_Driver.sumUpF32(inVector, inIndexOfFirstElement, inNrOfElements);
+        }
+
+        mutable unsigned int m_calcDotF32Called = 0;
+
+    private:
+        utils::CClassicMathDriver m_Driver;
+    }; // class SpyDriver
+
+    constexpr unsigned int kNrOfInputs = 4;
+    constexpr unsigned int kNrOfNeurons = 3;
+
+    SpyDriver spyDriver;
+    utils::CMath spyMath(spyDriver);
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    kilib::CLayer layer[2];
+    kilib::CLayer spyLayer[2];
+    layer[0].init(kNrOfInputs, nullActivation, math, nullptr);
+    layer[1].init(kNrOfNeurons, tanhActivation, math, &layer[0]);
+    spyLayer[0].init(kNrOfInputs, nullActivation, spyMath, nullptr);
+    spyLayer[1].init(kNrOfNeurons, tanhActivation, spyMath, &spyLayer[0]);
+
+    for (unsigned int i = 0; i < kNrOfInputs; ++i)
+    {
+        (*layer[0].neuronOutputVector())[i] = (*spyLayer[0].neuronOutputVector())[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        memcpy(**spyLayer[1].weightningVectorForNeuronAtIndex(n), **layer[1].weightningVectorForNeuronAtIndex(n), (kNrOfInputs + 1) * sizeof(float));
+    }
+
+    layer[1].forwardPropagation(false);
+    spyLayer[1].forwardPropagation(false);
+    UT_EXPECT_EQ(kNrOfNeurons, spyDriver.m_calcDotF32Called);
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        UT_EXPECT_EQ((*layer[1].neuronOutputVector())[n], (*spyLayer[1].neuronOutputVector())[n]);
+    }
+}
+
+// ==========================================================================
+// Weightning initialization
+// ==========================================================================
+TSUNIT_TEST(kilib_CLayer_InitTests, randomizedWeightningsFollowTheirDistribution)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    constexpr unsigned int kNrOfInputs = 200;
+    constexpr unsigned int kNrOfNeurons = 100;
+
+    kilib::CLayer layer[2];
+    layer[0].init(kNrOfInputs, nullActivation, math, nullptr);
+    layer[1].init(kNrOfNeurons, reLU, math, &layer[0]);
+
+    const utils::CRandom random(1234, 1);
+    UT_EXPECT_FALSE(layer[0].randomizeWeightnings(kilib::CLayer::WeightInit::he, random));
+
+    // Xavier: Uniform within +/- sqrt(6 / (200 + 100)) = 0.1414
+    UT_EXPECT_TRUE(layer[1].randomizeWeightnings(kilib::CLayer::WeightInit::xavier, random));
+    float maxMagnitude = 0.f;
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        for (unsigned int i = 0; i < kNrOfInputs; ++i)
+        {
+            maxMagnitude = std::fmax(maxMagnitude, std::fabs(*layer[1].weightningAtIndexForNeuron(n, i)));
+        }
+        UT_EXPECT_EQ(0.f, *layer[1].biasForNeuron(n));
+    }
+    UT_EXPECT_TRUE(maxMagnitude <= std::sqrt(6.f / (kNrOfInputs + kNrOfNeurons)));
+    UT_EXPECT_TRUE(maxMagnitude > 0.9f * std::sqrt(6.f / (kNrOfInputs + kNrOfNeurons)));
+
+    // He: Normal with a deviation of sqrt(2 / 200) = 0.1
+    UT_EXPECT_TRUE(layer[1].randomizeWeightnings(kilib::CLayer::WeightInit::he, random));
+    double squareSum = 0.;
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        for (unsigned int i = 0; i < kNrOfInputs; ++i)
+        {
+            const float value = *layer[1].weightningAtIndexForNeuron(n, i);
+            squareSum += value * value;
+        }
+    }
+    UT_EXPECT_TRUE(std::fabs(std::sqrt(squareSum / (kNrOfInputs * kNrOfNeurons)) - 0.1) < 0.005);
+
+    // Ranges yield the same weightnings as the whole layer.
+    kilib::CLayer rangeLayer[2];
+    rangeLayer[0].init(kNrOfInputs, nullActivation, math, nullptr);
+    rangeLayer[1].init(kNrOfNeurons, reLU, math, &rangeLayer[0], false);
+    UT_EXPECT_TRUE(rangeLayer[1].randomizeWeightnings(kilib::CLayer::WeightInit::he, random, 40, 60));
+    UT_EXPECT_TRUE(rangeLayer[1].randomizeWeightnings(kilib::CLayer::WeightInit::he, random, 0, 40));
+    UT_EXPECT_FALSE(rangeLayer[1].randomizeWeightnings(kilib::CLayer::WeightInit::he, random, 90, 11));
+    for (unsigned int n = 0; n < kNrOfNeurons; ++n)
+    {
+        UT_EXPECT_EQ(0, memcmp(**layer[1].weightningVectorForNeuronAtIndex(n), **rangeLayer[1].weightningVectorForNeuronAtIndex(n),
+                               (kNrOfInputs + 1) * sizeof(float)));
+    }
+}
+
+TSUNIT_TEST(kilib_CLayer_InitTests, randomizedInitDependsOnTheLayerIndexOnly)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    kilib::CLayer layer[3];
+    layer[0].init(5, nullActivation, math, nullptr);
+    layer[1].init(4, reLU, math, &layer[0]);
+    layer[2].init(3, reLU, math, &layer[1]);
+
+    // Layers created later on don't see another stream.
+    kilib::CLayer laterLayer[3];
+    laterLayer[0].init(5, nullActivation, math, nullptr);
+    laterLayer[1].init(4, reLU, math, &laterLayer[0]);
+    laterLayer[2].init(3, reLU, math, &laterLayer[1]);
+
+    // The same weightnings as the default weight init of a net.
+    kilib::CNeuronalNet net;
+    net.init({5, 4, 3}, reLU, reLU, math);
+
+    for (unsigned int layerIndex = 1; layerIndex < 3; ++layerIndex)
+    {
+        const size_t rowSize = (layer[layerIndex - 1].nrOfNeurons() + 1) * sizeof(float);
+        for (unsigned int n = 0; n < layer[layerIndex].nrOfNeurons(); ++n)
+        {
+            const float* weightnings = **layer[layerIndex].weightningVectorForNeuronAtIndex(n);
+            UT_EXPECT_EQ(0, memcmp(weightnings, **laterLayer[layerIndex].weightningVectorForNeuronAtIndex(n), rowSize));
+            UT_EXPECT_EQ(0, memcmp(weightnings, **net.layer(layerIndex)->weightningVectorForNeuronAtIndex(n), rowSize));
+        }
+    }
+}
@@ -4,9 +4,789 @@
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
 #include "kilib/include/CNeuronalNet.hpp"
+#include "kilib/include/Activation.hpp"
+#include "utils/include/CMath.hpp"
+#include "utils/include/CTrace.hpp"
 #include "tsunit/TSUnit.hpp"
 #include "tsunit/TSUnitTestAddOns.hpp"
+#include "tsunit/TSUnitAllocations.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
 
 TSUNIT_TEST(kilib_CNeuronalNet, T1)
 {
 }
+
+TSUNIT_TEST(kilib_CNeuronalNet, totalProfileSumsUpAllLayers)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    kilib::CNeuronalNet net;
+    net.init({3, 4, 2}, reLU, reLU, math);
+
+    net.forwardPropagation([](unsigned int, float)->void{});
+
+    const kilib::CLayer::Profile total = net.totalProfile();
+    if (kilib::kProfilingEnabled)
+    {
+        UT_EXPECT_EQ(2, total.dotProduct.calls);
+        UT_EXPECT_EQ(2 * 4 * (3 + 1) + 2 * 2 * (4 + 1), total.dotProduct.flops);
+        UT_EXPECT_EQ(3, total.activation.calls);
+        UT_EXPECT_EQ(3 + 4 + 2, total.activation.flops);
+    }
+
+    std::FILE* file = tmpfile();
+    UT_EXPECT_NE(nullptr, file);
+    if (file)
+    {
+        net.dumpProfile(file);
+        rewind(file);
+
+        // The header, the disabled notice and two rows per layer and for the total.
+        char line[256];
+        unsigned int nrOfLines = 0;
+        unsigned int nrOfRows = 0;
+        while (fgets(line, sizeof(line), file))
+        {
+            ++nrOfLines;
+            char layerName[16];
+            unsigned int nrOfNeurons = 0;
+            char phaseName[16];
+            unsigned long long calls = 0;
+            unsigned long long flops = 0;
+            if (5 == sscanf(line, "%15s | %u | %15s | %llu | %llu", layerName, &nrOfNeurons, phaseName, &calls, &flops))
+            {
+                const kilib::CLayer::Profile& profile = (0 == strcmp(layerName, "total"))
+                    ? total : net.layer(nrOfRows / 2)->profile();
+                const kilib::PhaseCounters& expected = (0 == strcmp(phaseName, "dot"))
+                    ? profile.dotProduct : profile.activation;
+                UT_EXPECT_EQ(expected.calls, calls);
+                UT_EXPECT_EQ(expected.flops, flops);
+                ++nrOfRows;
+            }
+        }
+        UT_EXPECT_EQ(2 * (3 + 1), nrOfRows);
+        UT_EXPECT_EQ(1 + (kilib::kProfilingEnabled ? 0 : 1) + nrOfRows, nrOfLines);
+        fclose(file);
+    }
+
+    net.resetProfile();
+    UT_EXPECT_EQ(0, net.totalProfile().dotProduct.calls);
+    UT_EXPECT_EQ(0, net.totalProfile().activation.calls);
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, forwardPropagationEmitsTraceEvents)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    kilib::CNeuronalNet net;
+    net.init({3, 4, 2}, reLU, reLU, math);
+
+    utils::CTrace::clear();
+    utils::CTrace::enable(utils::CTrace::kNet | utils::CTrace::kLayer);
+    net.forwardPropagation([](unsigned int, float)->void{});
+    utils::CTrace::enable(utils::CTrace::kNone);
+
+    std::FILE* file = tmpfile();
+    UT_EXPECT_NE(nullptr, file);
+    if (file)
+    {
+        const unsigned int nrOfEvents = utils::CTrace::writeChromeTrace(file);
+#if defined(UTILS_ENABLE_TRACING)
+        // One event for the net and one for each of its layers.
+        UT_EXPECT_EQ(1 + 3, nrOfEvents);
+#else
+        UT_EXPECT_EQ(0, nrOfEvents);
+#endif
+        fclose(file);
+    }
+    utils::CTrace::clear();
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, saveAndLoadRestoresTheNet)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::notInited, net.save("UT_CNeuronalNet.tmln"));
+    net.init({3, 5, 4, 2}, tanhActivation, softmax, math);
+
+    char path[] = "/tmp/UT_CNeuronalNet_XXXXXX";
+    const int fd = mkstemp(path);
+    UT_EXPECT_TRUE(fd >= 0);
+    close(fd);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.save(path));
+
+    kilib::CNeuronalNet loadedNet;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, loadedNet.load(path, math));
+    UT_EXPECT_EQ(net.nrOfLayers(), loadedNet.nrOfLayers());
+    UT_EXPECT_EQ(std::string("tanh"), loadedNet.hiddenLayerActivation()->name());
+    UT_EXPECT_EQ(std::string("softmax"), loadedNet.outputActivation()->name());
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        (*net.inputLayer()->neuronOutputVector())[i] = 0.25f * i - 0.3f;
+        (*loadedNet.inputLayer()->neuronOutputVector())[i] = 0.25f * i - 0.3f;
+    }
+
+    float expected[2] = {};
+    net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+    unsigned int nrOfValues = 0;
+    loadedNet.forwardPropagation([&](unsigned int index, float value)->void{
+        UT_EXPECT_EQ(expected[index], value);
+        ++nrOfValues;
+    });
+    UT_EXPECT_EQ(2, nrOfValues);
+
+    // A truncated file must be rejected.
+    UT_EXPECT_EQ(0, truncate(path, 20));
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::format, loadedNet.load(path, math));
+    UT_EXPECT_EQ(0, loadedNet.nrOfLayers());
+
+    unlink(path);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::io, loadedNet.load(path, math));
+}
+
+/*!
+ * @brief Writes the header of a network file (see CNeuronalNet::save()) of a
+ * given topology followed by \p inNrOfWeightnings weightnings.
+ */
+static void _writeNetFile(const char* inPath, const std::vector<std::uint32_t>& inTopology, size_t inNrOfWeightnings)
+{
+    std::FILE* file = fopen(inPath, "wb");
+    if (file)
+    {
+        const std::uint32_t header[2] = {1, static_cast<std::uint32_t>(inTopology.size())};
+        char names[2][32] = {"tanh", "sigmoid"};
+        const std::vector<float> weightnings(inNrOfWeightnings, 0.5f);
+        fwrite("TMLN", 4, 1, file);
+        fwrite(header, sizeof(header), 1, file);
+        fwrite(inTopology.data(), sizeof(std::uint32_t), inTopology.size(), file);
+        fwrite(names, sizeof(names), 1, file);
+        fwrite(weightnings.data(), sizeof(float), weightnings.size(), file);
+        fclose(file);
+    }
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, loadRejectsTruncatedAndOversizedFiles)
+{
+    utils::CMath math;
+    kilib::CNeuronalNet net;
+
+    char path[] = "/tmp/UT_CNeuronalNet_XXXXXX";
+    const int fd = mkstemp(path);
+    UT_EXPECT_TRUE(fd >= 0);
+    close(fd);
+
+    // A 3-4-2 net has 4 * (3 + 1) + 2 * (4 + 1) = 26 weightnings and biases.
+    _writeNetFile(path, {3, 4, 2}, 26);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.load(path, math));
+    UT_EXPECT_EQ(3, net.nrOfLayers());
+
+    _writeNetFile(path, {3, 4, 2}, 25);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::format, net.load(path, math));
+    UT_EXPECT_EQ(0, net.nrOfLayers());
+
+    _writeNetFile(path, {3, 4, 2}, 27);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::format, net.load(path, math));
+
+    // Neither must the counts overflow nor must a huge net be allocated.
+    _writeNetFile(path, {3, 0xFFFFFFFFu, 2}, 26);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::format, net.load(path, math));
+    _writeNetFile(path, {0x1000000u, 0x1000000u, 0x1000000u}, 26);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::format, net.load(path, math));
+    UT_EXPECT_EQ(0, net.nrOfLayers());
+
+    unlink(path);
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, executionPlanAllowsPartialPropagation)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSigmoid sigmoid;
+
+    kilib::CNeuronalNet net;
+    UT_EXPECT_EQ(0, net.nrOfExecutionSteps());
+    net.init({4, 6, 5, 3}, reLU, sigmoid, math);
+    UT_EXPECT_EQ(4, net.nrOfExecutionSteps());
+
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        (*net.inputLayer()->neuronOutputVector())[i] = 0.5f - 0.2f * i;
+    }
+
+    float expected[3] = {};
+    net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+
+    // Change a weightning of layer 2: Only the layers 2 and 3 are affected.
+    *net.weightningForNeuronInLayer(2, 1, 3) += 0.75f;
+    float partial[3] = {};
+    net.forwardPropagationFromLayer(2, [&](unsigned int index, float value)->void{partial[index] = value;});
+
+    float full[3] = {};
+    net.forwardPropagation([&](unsigned int index, float value)->void{full[index] = value;});
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        UT_EXPECT_EQ(full[i], partial[i]);
+    }
+
+    // Executing every step by its own yields the same as a full propagation
+    *net.weightningForNeuronInLayer(2, 1, 3) -= 0.75f;
+    for (unsigned int stepIndex = 0; stepIndex < net.nrOfExecutionSteps(); ++stepIndex)
+    {
+        UT_EXPECT_TRUE(net.executeStep(stepIndex));
+    }
+    UT_EXPECT_FALSE(net.executeStep(net.nrOfExecutionSteps()));
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        UT_EXPECT_EQ(expected[i], (*net.outputLayer()->neuronOutputVector())[i]);
+    }
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, incrementalPropagationFollowsPartialInputChanges)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSoftmax softmax;
+
+    constexpr unsigned int kNrOfInputs = 200;
+
+    kilib::CNeuronalNet net;
+    kilib::CNeuronalNet incrementalNet;
+    incrementalNet.setIncrementalPropagation(true);
+    net.init({kNrOfInputs, 16, 8, 4}, reLU, softmax, math);
+    incrementalNet.init({kNrOfInputs, 16, 8, 4}, reLU, softmax, math);
+    UT_EXPECT_TRUE(incrementalNet.isIncrementalPropagation());
+    UT_EXPECT_TRUE(incrementalNet.layer(1)->isIncrementalPropagation());
+
+    // Both nets shall use the same weightnings.
+    for (unsigned int layerIndex = 1; layerIndex < net.nrOfLayers(); ++layerIndex)
+    {
+        for (unsigned int neuronIndex = 0; neuronIndex < net.neuronsInLayer(layerIndex); ++neuronIndex)
+        {
+            *incrementalNet.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex) =
+                *net.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+        }
+    }
+
+    utils::CVectorF32& input = *net.inputLayer()->neuronOutputVector();
+    utils::CVectorF32& incrementalInput = *incrementalNet.inputLayer()->neuronOutputVector();
+    for (unsigned int i = 0; i < kNrOfInputs; ++i)
+    {
+        input[i] = incrementalInput[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+
+    for (unsigned int pass = 0; pass < 50; ++pass)
+    {
+        // Change a few inputs only
+        for (unsigned int i = 0; i < 5; ++i)
+        {
+            const unsigned int inputIndex = (pass * 37 + i * 11) % kNrOfInputs;
+            input[inputIndex] = incrementalInput[inputIndex] = utils::CMath::randF32(-1.f, 1.f);
+        }
+
+        float expected[4] = {};
+        net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+        incrementalNet.forwardPropagation([&](unsigned int index, float value)->void{
+            UT_EXPECT_TRUE(std::fabs(expected[index] - value) <= 1e-4f * (1.f + std::fabs(expected[index])));
+        });
+    }
+
+    // Without any change no layer but the input layer does any work.
+    incrementalNet.resetProfile();
+    incrementalNet.forwardPropagation([](unsigned int, float)->void{});
+    UT_EXPECT_EQ(0, incrementalNet.totalProfile().dotProduct.calls);
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, sharedBuffersYieldTheSameResultWithLessMemory)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    net.init({4, 32, 16, 32, 8, 2}, tanhActivation, softmax, math);
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::MemoryMode::perLayerBuffers == net.memoryMode());
+    UT_EXPECT_EQ(sizeof(float) * (5 + 33 + 17 + 33 + 9 + 3), net.activationMemorySize());
+
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        (*net.inputLayer()->neuronOutputVector())[i] = 0.3f * i - 0.5f;
+    }
+
+    float expected[2] = {};
+    net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+
+    // The layers 1, 3, 5 and 2, 4 share a buffer each.
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.setMemoryMode(kilib::CNeuronalNet::MemoryMode::sharedBuffers));
+    UT_EXPECT_EQ(sizeof(float) * (5 + 33 + 17), net.activationMemorySize());
+    UT_EXPECT_EQ(**net.layer(1)->neuronOutputVector(), **net.layer(3)->neuronOutputVector());
+    UT_EXPECT_EQ(**net.layer(2)->neuronOutputVector(), **net.layer(4)->neuronOutputVector());
+
+    unsigned int nrOfValues = 0;
+    net.forwardPropagation([&](unsigned int index, float value)->void{
+        UT_EXPECT_EQ(expected[index], value);
+        ++nrOfValues;
+    });
+    UT_EXPECT_EQ(2, nrOfValues);
+
+    // Partial propagations fall back to a full one.
+    net.forwardPropagationFromLayer(4, [&](unsigned int index, float value)->void{
+        UT_EXPECT_EQ(expected[index], value);
+    });
+
+    // The mode is kept by a new initialization
+    net.init({4, 32, 16, 32, 8, 2}, tanhActivation, softmax, math);
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::MemoryMode::sharedBuffers == net.memoryMode());
+    UT_EXPECT_EQ(sizeof(float) * (5 + 33 + 17), net.activationMemorySize());
+
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.setMemoryMode(kilib::CNeuronalNet::MemoryMode::perLayerBuffers));
+    UT_EXPECT_EQ(sizeof(float) * (5 + 33 + 17 + 33 + 9 + 3), net.activationMemorySize());
+    UT_EXPECT_NE(**net.layer(1)->neuronOutputVector(), **net.layer(3)->neuronOutputVector());
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, boundInputsAreUsedWithoutCopy)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    float outputs[3] = {};
+    float inputs[4 + 1] = {};
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::notInited == net.bindInputs(inputs));
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::notInited == net.forwardPropagationInto(outputs, dimof(outputs)));
+
+    net.init({4, 16, 8, 3}, tanhActivation, softmax, math);
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        (*net.inputLayer()->neuronOutputVector())[i] = 0.3f * i - 0.5f;
+    }
+    float expected[3] = {};
+    net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+
+    // The network sets the 1.0 of the biases.
+    inputs[4] = 0.f;
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.bindInputs(inputs));
+    UT_EXPECT_EQ(inputs, **net.inputLayer()->neuronOutputVector());
+    UT_EXPECT_EQ(1.f, inputs[4]);
+
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        inputs[i] = 0.3f * i - 0.5f;
+    }
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationInto(outputs, dimof(outputs)));
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        UT_EXPECT_EQ(expected[i], outputs[i]);
+    }
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::param == net.forwardPropagationInto(nullptr, dimof(outputs)));
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::param == net.forwardPropagationInto(outputs, dimof(outputs) - 1));
+
+    // Changing the bound inputs changes the result, even with shared buffers.
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.setMemoryMode(kilib::CNeuronalNet::MemoryMode::sharedBuffers));
+    UT_EXPECT_EQ(inputs, **net.inputLayer()->neuronOutputVector());
+    inputs[0] = 0.7f;
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationInto(outputs, dimof(outputs)));
+    UT_EXPECT_TRUE(expected[0] != outputs[0]);
+
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.bindInputs(nullptr));
+    UT_EXPECT_NE(inputs, **net.inputLayer()->neuronOutputVector());
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, selectedOutputsAndTopKMatchTheFullPropagation)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    // With and without an output activation that needs all output neurons.
+    for (const kilib::CLayer::IActivation* outputActivation : {static_cast<const kilib::CLayer::IActivation*>(&tanhActivation),
+                                                               static_cast<const kilib::CLayer::IActivation*>(&softmax)})
+    {
+        kilib::CNeuronalNet net;
+        unsigned int indices[3] = {};
+        float values[3] = {};
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::notInited == net.forwardPropagationSelected(indices, 3, values));
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::notInited == net.forwardPropagationTopK(3, indices, values));
+
+        net.init({6, 16, 20}, tanhActivation, *outputActivation, math);
+        net.packWeightnings();
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            (*net.inputLayer()->neuronOutputVector())[i] = 0.2f * i - 0.5f;
+        }
+
+        float expected[20] = {};
+        net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+        const unsigned int expectedArgMax = static_cast<unsigned int>(std::max_element(expected, expected + 20) - expected);
+
+        // Change the output vector in order to see that it is not used.
+        (*net.outputLayer()->neuronOutputVector())[expectedArgMax] = -1.f;
+
+        const unsigned int selected[3] = {19, 0, expectedArgMax};
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationSelected(selected, 3, values));
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            UT_EXPECT_EQ(expected[selected[i]], values[i]);
+        }
+
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationTopK(3, indices, values));
+        UT_EXPECT_EQ(expectedArgMax, indices[0]);
+        UT_EXPECT_EQ(expected[expectedArgMax], values[0]);
+        UT_EXPECT_TRUE((values[0] >= values[1]) && (values[1] >= values[2]));
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            UT_EXPECT_EQ(expected[indices[i]], values[i]);
+        }
+
+        const unsigned int outOfRange = 20;
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::param == net.forwardPropagationSelected(&outOfRange, 1, values));
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::param == net.forwardPropagationTopK(21, indices, values));
+        UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::param == net.forwardPropagationTopK(1, nullptr, values));
+    }
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, steadyStatePropagationDoesNotAllocate)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    net.init({6, 24, 16, 10}, tanhActivation, softmax, math);
+    net.packWeightnings();
+
+    constexpr unsigned int kBatchSize = 4;
+    float inputs[kBatchSize * 6];
+    float outputs[kBatchSize * 10] = {};
+    for (float& input : inputs)
+    {
+        input = utils::CMath::randF32(-1.f, 1.f);
+    }
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        (*net.inputLayer()->neuronOutputVector())[i] = inputs[i];
+    }
+    unsigned int indices[3] = {};
+    float values[3] = {};
+    const unsigned int selected[2] = {9, 2};
+    float sum = 0.f;
+    const auto visitor = [&](unsigned int, float value)->void{sum += value;};
+
+    // The first pass may allocate its scratch buffers.
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationInto(outputs, dimof(outputs)));
+    net.forwardPropagation(visitor);
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationBatch(inputs, kBatchSize, outputs));
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationSelected(selected, 2, values));
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.forwardPropagationTopK(3, indices, values));
+
+    UT_EXPECT_NO_ALLOC {
+        net.forwardPropagationInto(outputs, dimof(outputs));
+        net.forwardPropagation(visitor);
+        net.forwardPropagationBatch(inputs, kBatchSize, outputs);
+        net.forwardPropagationSelected(selected, 2, values);
+        net.forwardPropagationTopK(3, indices, values);
+    }
+
+    // The same with caller owned inputs
+    float boundInputs[6 + 1] = {};
+    memcpy(boundInputs, inputs + 6, 6 * sizeof(float));
+    UT_EXPECT_TRUE(kilib::CNeuronalNet::Error::ok == net.bindInputs(boundInputs));
+    net.forwardPropagationInto(outputs, dimof(outputs));
+    UT_EXPECT_NO_ALLOC {
+        memcpy(boundInputs, inputs + 12, 6 * sizeof(float));
+        net.forwardPropagationInto(outputs, dimof(outputs));
+    }
+    UT_EXPECT_TRUE(sum > 0.f);
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, prunedNetIsStoredSparse)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSigmoid sigmoid;
+
+    kilib::CNeuronalNet net;
+    net.init({64, 32, 16, 4}, reLU, sigmoid, math);
+    const size_t denseSize = net.weightningMemorySize();
+
+    for (unsigned int i = 0; i < 64; ++i)
+    {
+        (*net.inputLayer()->neuronOutputVector())[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+
+    net.pruneByMagnitude(0.9f);
+    float expected[4] = {};
+    net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+
+    net.selectWeightFormats();
+    for (unsigned int layerIndex = 1; layerIndex < net.nrOfLayers(); ++layerIndex)
+    {
+        UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense != net.layer(layerIndex)->weightFormat());
+    }
+    UT_EXPECT_TRUE(net.weightningMemorySize() < denseSize / 3);
+
+    net.forwardPropagation([&](unsigned int index, float value)->void{
+        UT_EXPECT_EQ(expected[index], value);
+    });
+
+    // Dense again if the threshold is not reached
+    net.selectWeightFormats(0.95f);
+    UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense == net.layer(1)->weightFormat());
+    UT_EXPECT_EQ(denseSize, net.weightningMemorySize());
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, batchPropagationYieldsTheSameResultAsSingleSamples)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    net.init({5, 12, 7, 3}, tanhActivation, softmax, math);
+
+    constexpr unsigned int kBatchSize = 6;
+    float inputs[kBatchSize][5];
+    float outputs[kBatchSize][3] = {};
+    for (unsigned int sampleIndex = 0; sampleIndex < kBatchSize; ++sampleIndex)
+    {
+        for (unsigned int i = 0; i < 5; ++i)
+        {
+            inputs[sampleIndex][i] = utils::CMath::randF32(-1.f, 1.f);
+        }
+    }
+
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.forwardPropagationBatch(&inputs[0][0], kBatchSize, &outputs[0][0]));
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::param, net.forwardPropagationBatch(&inputs[0][0], 0, &outputs[0][0]));
+
+    for (unsigned int sampleIndex = 0; sampleIndex < kBatchSize; ++sampleIndex)
+    {
+        for (unsigned int i = 0; i < 5; ++i)
+        {
+            (*net.inputLayer()->neuronOutputVector())[i] = inputs[sampleIndex][i];
+        }
+        net.forwardPropagation([&](unsigned int index, float value)->void{
+            UT_EXPECT_EQ(value, outputs[sampleIndex][index]);
+        });
+    }
+
+    kilib::CNeuronalNet uninitedNet;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::notInited, uninitedNet.forwardPropagationBatch(&inputs[0][0], kBatchSize, &outputs[0][0]));
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, packedWeightningsYieldTheSameResult)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    net.init({23, 17, 9, 3}, tanhActivation, softmax, math);
+
+    constexpr unsigned int kBatchSize = 5;
+    float inputs[kBatchSize][23];
+    for (unsigned int sampleIndex = 0; sampleIndex < kBatchSize; ++sampleIndex)
+    {
+        for (unsigned int i = 0; i < 23; ++i)
+        {
+            inputs[sampleIndex][i] = utils::CMath::randF32(-1.f, 1.f);
+        }
+    }
+    float expected[kBatchSize][3] = {};
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.forwardPropagationBatch(&inputs[0][0], kBatchSize, &expected[0][0]));
+
+    net.packWeightnings();
+    for (unsigned int layerIndex = 1; layerIndex < net.nrOfLayers(); ++layerIndex)
+    {
+        UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::panels == net.layer(layerIndex)->weightFormat());
+    }
+
+    float outputs[kBatchSize][3] = {};
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.forwardPropagationBatch(&inputs[0][0], kBatchSize, &outputs[0][0]));
+    UT_EXPECT_EQ(0, memcmp(expected, outputs, sizeof(outputs)));
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, weightInitIsReproducibleForASeed)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSoftmax softmax;
+
+    // The first hidden layer is split into several chunks.
+    const std::vector<unsigned int> topology = {700, 300, 10};
+    kilib::CNeuronalNet nets[3];
+    nets[0].setWeightInit(kilib::CLayer::WeightInit::he, 99);
+    nets[1].setWeightInit(kilib::CLayer::WeightInit::he, 99);
+    nets[2].setWeightInit(kilib::CLayer::WeightInit::he, 100);
+    for (kilib::CNeuronalNet& net : nets)
+    {
+        UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.init(topology, reLU, softmax, math));
+    }
+    UT_EXPECT_TRUE(kilib::CLayer::WeightInit::he == nets[0].weightInit());
+    UT_EXPECT_EQ(99, nets[0].weightInitSeed());
+
+    for (unsigned int layerIndex = 1; layerIndex < topology.size(); ++layerIndex)
+    {
+        const unsigned int rowSize = topology[layerIndex - 1] + 1;
+        for (unsigned int n = 0; n < topology[layerIndex]; ++n)
+        {
+            const float* weightnings[3];
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                weightnings[i] = **nets[i].layer(layerIndex)->weightningVectorForNeuronAtIndex(n);
+            }
+            UT_EXPECT_EQ(0, memcmp(weightnings[0], weightnings[1], rowSize * sizeof(float)));
+            UT_EXPECT_NE(0, memcmp(weightnings[0], weightnings[2], rowSize * sizeof(float)));
+        }
+    }
+
+    // The same as a layer randomized on its own.
+    kilib::CLayer layer[2];
+    layer[0].init(topology[0], reLU, math);
+    layer[1].init(topology[1], reLU, math, &layer[0]);
+    layer[1].randomizeWeightnings(kilib::CLayer::WeightInit::he, utils::CRandom(99, 1));
+    UT_EXPECT_EQ(0, memcmp(**layer[1].weightningVectorForNeuronAtIndex(299),
+                           **nets[0].layer(1)->weightningVectorForNeuronAtIndex(299), (topology[0] + 1) * sizeof(float)));
+}
+
+/*!
+ * @brief Propagates a few random samples through \p inNet.
+ * @param inInputScale Scales the inputs if not nullptr.
+ * @param inInputShift Shifts the inputs if not nullptr.
+ */
+static std::vector<float> _propagateSamples(kilib::CNeuronalNet& inNet, const std::vector<float>& inSamples,
+                                            const float* inInputScale = nullptr, const float* inInputShift = nullptr)
+{
+    const unsigned int nrOfInputs = inNet.neuronsInLayer(0);
+    std::vector<float> outputs;
+    for (size_t first = 0; first < inSamples.size(); first += nrOfInputs)
+    {
+        for (unsigned int i = 0; i < nrOfInputs; ++i)
+        {
+            const float scale = inInputScale ? inInputScale[i] : 1.f;
+            const float shift = inInputShift ? inInputShift[i] : 0.f;
+            (*inNet.inputLayer()->neuronOutputVector())[i] = inSamples[first + i] * scale + shift;
+        }
+        inNet.forwardPropagation([&](unsigned int, float value)->void{outputs.push_back(value);});
+    }
+    return outputs;
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, optimizeCollapsesLinearLayersIfCheaper)
+{
+    utils::CMath math;
+    kilib::CActivationNull nullActivation;
+    kilib::CActivationTanh tanhActivation;
+
+    std::vector<float> samples(10 * 6);
+    for (float& value : samples)
+    {
+        value = utils::CMath::randF32(-1.f, 1.f);
+    }
+
+    kilib::CNeuronalNet net;
+    net.setWeightInit(kilib::CLayer::WeightInit::xavier);
+    net.init({6, 20, 20, 3}, nullActivation, tanhActivation, math);
+    const std::vector<float> expected = _propagateSamples(net, samples);
+
+    kilib::CNeuronalNet::OptimizeStats stats;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.optimize(nullptr, nullptr, &stats));
+    UT_EXPECT_EQ(2, stats.collapsedLayers);
+    UT_EXPECT_EQ(0, stats.droppedNeurons);
+    UT_EXPECT_FALSE(stats.foldedInputNormalization);
+    UT_EXPECT_EQ(2, net.nrOfLayers());
+    UT_EXPECT_EQ(3, net.neuronsInLayer(1));
+    UT_EXPECT_EQ(&tanhActivation, net.outputActivation());
+
+    const std::vector<float> outputs = _propagateSamples(net, samples);
+    UT_EXPECT_EQ(expected.size(), outputs.size());
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        UT_EXPECT_TRUE(std::fabs(expected[i] - outputs[i]) < 1e-5f);
+    }
+
+    // A bottleneck is cheaper than its product.
+    kilib::CNeuronalNet bottleneckNet;
+    bottleneckNet.init({50, 4, 50}, nullActivation, tanhActivation, math);
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, bottleneckNet.optimize(nullptr, nullptr, &stats));
+    UT_EXPECT_EQ(0, stats.collapsedLayers);
+    UT_EXPECT_EQ(3, bottleneckNet.nrOfLayers());
+
+    kilib::CNeuronalNet uninitedNet;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::notInited, uninitedNet.optimize());
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, optimizeFoldsTheInputNormalizationAndDropsUnusedNeurons)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSigmoid sigmoid;
+
+    std::vector<float> samples(10 * 5);
+    for (float& value : samples)
+    {
+        value = utils::CMath::randF32(0.f, 255.f);
+    }
+    const float scale[5] = {1.f / 255.f, 2.f / 255.f, 0.5f, 1.f / 128.f, 1.f};
+    const float shift[5] = {-0.5f, -1.f, 0.f, 0.25f, -3.f};
+
+    kilib::CNeuronalNet net;
+    net.setWeightInit(kilib::CLayer::WeightInit::he);
+    net.init({5, 8, 3}, reLU, sigmoid, math);
+    for (unsigned int n = 0; n < 3; ++n)
+    {
+        // Neither neuron 2 nor neuron 5 of the hidden layer feeds the output.
+        *net.layer(2)->weightningAtIndexForNeuron(n, 2) = 0.f;
+        *net.layer(2)->weightningAtIndexForNeuron(n, 5) = 0.f;
+    }
+    const std::vector<float> expected = _propagateSamples(net, samples, scale, shift);
+
+    kilib::CNeuronalNet::OptimizeStats stats;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.optimize(scale, shift, &stats));
+    UT_EXPECT_TRUE(stats.foldedInputNormalization);
+    UT_EXPECT_EQ(0, stats.collapsedLayers);
+    UT_EXPECT_EQ(2, stats.droppedNeurons);
+    UT_EXPECT_EQ(6, net.neuronsInLayer(1));
+
+    // The raw inputs are fed in now.
+    const std::vector<float> outputs = _propagateSamples(net, samples);
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        UT_EXPECT_TRUE(std::fabs(expected[i] - outputs[i]) < 1e-5f);
+    }
+}
+
+TSUNIT_TEST(kilib_CNeuronalNet, optimizeKeepsANetOfJustTheInputLayer)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    kilib::CNeuronalNet net;
+    net.init({3}, tanhActivation, tanhActivation, math);
+    UT_EXPECT_EQ(1, net.nrOfLayers());
+
+    const float scale[3] = {2.f, 2.f, 2.f};
+    const float shift[3] = {1.f, 1.f, 1.f};
+    kilib::CNeuronalNet::OptimizeStats stats;
+    stats.collapsedLayers = 7;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.optimize(scale, shift, &stats));
+    UT_EXPECT_EQ(0, stats.collapsedLayers);
+    UT_EXPECT_EQ(0, stats.droppedNeurons);
+    UT_EXPECT_FALSE(stats.foldedInputNormalization);
+    UT_EXPECT_EQ(1, net.nrOfLayers());
+    UT_EXPECT_EQ(3, net.neuronsInLayer(0));
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.optimize());
+}
@@ -0,0 +1,102 @@
+/*
+ * @file UT_CStaticNeuronalNet.cpp
+ * @brief Unittest for CStaticNeuronalNet
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "kilib/include/CStaticNeuronalNet.hpp"
+#include "kilib/include/Activation.hpp"
+#include "utils/include/CMath.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+
+TSUNIT_TEST(kilib_CStaticNeuronalNet, dimensionsAreKnownAtCompileTime)
+{
+    using Net = kilib::CStaticNeuronalNet<kilib::CActivationReLU, kilib::CActivationNull, 3, 10, 16, 8>;
+    static_assert(4 == Net::kNrOfLayers, "");
+    static_assert(3 == Net::kNrOfInputs, "");
+    static_assert(8 == Net::kNrOfOutputs, "");
+
+    Net net;
+    UT_EXPECT_EQ(3, net.layerView(0).nrOfNeurons);
+    UT_EXPECT_EQ(nullptr, net.layerView(0).weightnings);
+    UT_EXPECT_EQ(16, net.layerView(2).nrOfNeurons);
+    UT_EXPECT_EQ(10, net.layerView(2).nrOfWeightnings);
+    UT_EXPECT_EQ(nullptr, net.layerView(4).output);
+
+    UT_EXPECT_EQ(nullptr, net.weightningForNeuronInLayer(0, 0, 0));
+    UT_EXPECT_EQ(nullptr, net.weightningForNeuronInLayer(1, 10, 0));
+    UT_EXPECT_EQ(nullptr, net.weightningForNeuronInLayer(1, 0, 3));
+    UT_EXPECT_NE(nullptr, net.weightningForNeuronInLayer(1, 9, 2));
+    UT_EXPECT_NE(nullptr, net.biasForNeuronInLayer(3, 7));
+}
+
+TSUNIT_TEST(kilib_CStaticNeuronalNet, simpleNet)
+{
+    kilib::CStaticNeuronalNet<kilib::CActivationNull, kilib::CActivationNull, 3, 2> net;
+
+    net.inputVector()[0] = 1.2f;
+    net.inputVector()[1] = 2.4f;
+    net.inputVector()[2] = 4.6f;
+
+    *net.weightningForNeuronInLayer(1, 0, 0) = 4.5f;
+    *net.weightningForNeuronInLayer(1, 0, 1) = 3.2f;
+    *net.weightningForNeuronInLayer(1, 0, 2) = 2.1f;
+    *net.biasForNeuronInLayer(1, 0) = 1.8f;
+
+    *net.weightningForNeuronInLayer(1, 1, 0) = 14.5f;
+    *net.weightningForNeuronInLayer(1, 1, 1) = 13.2f;
+    *net.weightningForNeuronInLayer(1, 1, 2) = 12.1f;
+    *net.biasForNeuronInLayer(1, 1) = 11.8f;
+
+    const float* result = net.forwardPropagation();
+
+    constexpr float expected_dot_neron0 = 1.2f *  4.5f + 2.4f *  3.2f + 4.6f *  2.1f +  1.8f;
+    constexpr float expected_dot_neron1 = 1.2f * 14.5f + 2.4f * 13.2f + 4.6f * 12.1f + 11.8f;
+
+    UT_EXPECT_EQ(expected_dot_neron0, result[0]);
+    UT_EXPECT_EQ(expected_dot_neron1, result[1]);
+}
+
+TSUNIT_TEST(kilib_CStaticNeuronalNet, matchesTheDynamicNet)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet dynamicNet;
+    dynamicNet.init({4, 10, 12, 6}, reLU, softmax, math);
+
+    kilib::CStaticNeuronalNet<kilib::CActivationReLU, kilib::CActivationSoftmax, 4, 10, 12, 6> staticNet;
+    UT_EXPECT_TRUE(staticNet.assign(dynamicNet));
+
+    const float kInput[4] = {0.3f, 0.9f, 0.1f, 0.7f};
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        (*dynamicNet.inputLayer()->neuronOutputVector())[i] = kInput[i];
+        staticNet.inputVector()[i] = kInput[i];
+    }
+
+    const float* staticResult = staticNet.forwardPropagation();
+    unsigned int nrOfOutputs = 0;
+    dynamicNet.forwardPropagation([&](unsigned int index, float value)->void{
+        UT_EXPECT_EQ(value, staticResult[index]);
+        ++nrOfOutputs;
+    });
+    UT_EXPECT_EQ(6, nrOfOutputs);
+}
+
+TSUNIT_TEST(kilib_CStaticNeuronalNet, assignRejectsADifferentTopology)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+
+    kilib::CNeuronalNet dynamicNet;
+    dynamicNet.init({4, 10, 6}, reLU, reLU, math);
+
+    kilib::CStaticNeuronalNet<kilib::CActivationReLU, kilib::CActivationReLU, 4, 11, 6> staticNet;
+    UT_EXPECT_FALSE(staticNet.assign(dynamicNet));
+    UT_EXPECT_EQ(0.f, *staticNet.weightningForNeuronInLayer(1, 0, 0));
+
+    kilib::CStaticNeuronalNet<kilib::CActivationReLU, kilib::CActivationReLU, 4, 10> shorterNet;
+    UT_EXPECT_FALSE(shorterNet.assign(dynamicNet));
+}
@@ -0,0 +1,431 @@
+/*
+ * @file UT_CTrainer.cpp
+ * @brief Unittest for CTrainer
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "kilib/include/CTrainer.hpp"
+#include "kilib/include/Activation.hpp"
+#include "utils/include/CMath.hpp"
+#include "utils/include/CTrace.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include "tsunit/TSUnitAllocations.hpp"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static float _loss(kilib::CNeuronalNet& inNet, const float* inInputs, const float* inTargets, unsigned int inNrOfSamples)
+{
+    const unsigned int nrOfInputs = inNet.neuronsInLayer(0);
+    const unsigned int nrOfOutputs = inNet.neuronsInLayer(inNet.nrOfLayers() - 1);
+
+    double loss = 0.;
+    for (unsigned int sampleIndex = 0; sampleIndex < inNrOfSamples; ++sampleIndex)
+    {
+        for (unsigned int i = 0; i < nrOfInputs; ++i)
+        {
+            (*inNet.inputLayer()->neuronOutputVector())[i] = inInputs[sampleIndex * nrOfInputs + i];
+        }
+        inNet.forwardPropagation([&](unsigned int index, float value)->void{
+            const double error = value - inTargets[sampleIndex * nrOfOutputs + index];
+            loss += 0.5 * error * error;
+        });
+    }
+    return static_cast<float>(loss);
+}
+
+static void _copyWeightnings(const kilib::CNeuronalNet& inSource, kilib::CNeuronalNet& outDestination)
+{
+    for (unsigned int layerIndex = 1; layerIndex < inSource.nrOfLayers(); ++layerIndex)
+    {
+        for (unsigned int neuronIndex = 0; neuronIndex < inSource.neuronsInLayer(layerIndex); ++neuronIndex)
+        {
+            *outDestination.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex) =
+                *inSource.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+        }
+    }
+}
+
+static void _expectGradientsMatchFiniteDifferences(kilib::CNeuronalNet& inNet, const float* inInputs, const float* inTargets, unsigned int inNrOfSamples)
+{
+    kilib::CTrainer::Config config;
+    config.nrOfThreads = 2;
+    config.learningRate = 0.f; // Just calculate the gradients
+    kilib::CTrainer trainer(inNet, config);
+    UT_EXPECT_TRUE(nullptr == trainer.gradients());
+    UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainBatch(inInputs, inTargets, inNrOfSamples));
+    const float* gradients = trainer.gradients();
+    UT_EXPECT_TRUE(nullptr != gradients);
+
+    constexpr float kEpsilon = 1e-2f;
+    size_t parameterIndex = 0;
+    for (unsigned int layerIndex = 1; layerIndex < inNet.nrOfLayers(); ++layerIndex)
+    {
+        for (unsigned int neuronIndex = 0; neuronIndex < inNet.neuronsInLayer(layerIndex); ++neuronIndex)
+        {
+            utils::CVectorF32& weightnings = *inNet.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+            for (unsigned int i = 0; i < weightnings.size(); ++i, ++parameterIndex)
+            {
+                const float value = weightnings[i];
+                weightnings[i] = value + kEpsilon;
+                const float upperLoss = _loss(inNet, inInputs, inTargets, inNrOfSamples);
+                weightnings[i] = value - kEpsilon;
+                const float lowerLoss = _loss(inNet, inInputs, inTargets, inNrOfSamples);
+                weightnings[i] = value;
+
+                const float expected = (upperLoss - lowerLoss) / (2.f * kEpsilon);
+                UT_EXPECT_TRUE(std::fabs(expected - gradients[parameterIndex]) <= 1e-3f + 1e-2f * std::fabs(expected));
+            }
+        }
+    }
+    UT_EXPECT_EQ(trainer.nrOfParameters(), parameterIndex);
+}
+
+TSUNIT_TEST(kilib_CTrainer, gradientsMatchFiniteDifferences)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSigmoid sigmoid;
+
+    kilib::CNeuronalNet net;
+    net.init({3, 4, 2}, tanhActivation, sigmoid, math);
+
+    const float inputs[3 * 3] = {0.1f, -0.4f, 0.7f,   0.9f, 0.2f, -0.3f,   -0.5f, 0.6f, 0.0f};
+    const float targets[3 * 2] = {-0.2f, -0.7f,   -0.9f, -0.1f,   -0.4f, -0.5f};
+    _expectGradientsMatchFiniteDifferences(net, inputs, targets, 3);
+}
+
+TSUNIT_TEST(kilib_CTrainer, gradientsOfTheSoftmaxMatchFiniteDifferences)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    kilib::CActivationSoftmax softmax;
+
+    kilib::CNeuronalNet net;
+    net.init({2, 3, 3}, reLU, softmax, math);
+
+    // Positive weightnings and inputs keep the integral part of the softmax
+    // away from 0.
+    for (unsigned int layerIndex = 1; layerIndex < net.nrOfLayers(); ++layerIndex)
+    {
+        for (unsigned int neuronIndex = 0; neuronIndex < net.neuronsInLayer(layerIndex); ++neuronIndex)
+        {
+            utils::CVectorF32& weightnings = *net.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+            for (unsigned int i = 0; i < weightnings.size(); ++i)
+            {
+                weightnings[i] = 0.2f + 0.1f * ((neuronIndex + 2 * i + layerIndex) % 5);
+            }
+        }
+    }
+
+    const float inputs[2 * 2] = {0.3f, 0.8f,   0.9f, 0.1f};
+    const float targets[2 * 3] = {1.f, 0.f, 0.f,   0.f, 0.f, 1.f};
+    _expectGradientsMatchFiniteDifferences(net, inputs, targets, 2);
+}
+
+TSUNIT_TEST(kilib_CTrainer, trainingReducesTheLossDeterministically)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    constexpr unsigned int kNrOfSamples = 256;
+    std::vector<float> inputs(kNrOfSamples * 2);
+    std::vector<float> targets(kNrOfSamples);
+    for (unsigned int sampleIndex = 0; sampleIndex < kNrOfSamples; ++sampleIndex)
+    {
+        const float x = utils::CMath::randF32(-1.f, 1.f);
+        const float y = utils::CMath::randF32(-1.f, 1.f);
+        inputs[2 * sampleIndex] = x;
+        inputs[2 * sampleIndex + 1] = y;
+        targets[sampleIndex] = 0.8f * x * y;
+    }
+
+    kilib::CNeuronalNet nets[3];
+    for (kilib::CNeuronalNet& thisNet : nets)
+    {
+        thisNet.init({2, 16, 1}, tanhActivation, tanhActivation, math);
+    }
+    _copyWeightnings(nets[0], nets[1]);
+    _copyWeightnings(nets[0], nets[2]);
+
+    kilib::CTrainer::Config config;
+    config.nrOfThreads = 3;
+    config.batchSize = 16;
+    config.learningRate = 0.2f;
+    config.seed = 42;
+    kilib::CTrainer trainer0(nets[0], config);
+    kilib::CTrainer trainer1(nets[1], config);
+    config.nrOfThreads = 1;
+    kilib::CTrainer singleThreadedTrainer(nets[2], config);
+    UT_EXPECT_EQ(3, trainer0.nrOfThreads());
+
+    const float initialLoss = _loss(nets[0], inputs.data(), targets.data(), kNrOfSamples) / kNrOfSamples;
+    float loss[3] = {};
+    for (unsigned int epoch = 0; epoch < 100; ++epoch)
+    {
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer0.trainEpoch(inputs.data(), targets.data(), kNrOfSamples, &loss[0]));
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer1.trainEpoch(inputs.data(), targets.data(), kNrOfSamples, &loss[1]));
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, singleThreadedTrainer.trainEpoch(inputs.data(), targets.data(), kNrOfSamples, &loss[2]));
+    }
+    const float finalLoss = _loss(nets[0], inputs.data(), targets.data(), kNrOfSamples) / kNrOfSamples;
+    UT_EXPECT_TRUE(finalLoss < 0.25f * initialLoss);
+
+    // The same seed and number of threads yields the same weightnings. Any
+    // other number of threads just differs by rounding.
+    UT_EXPECT_EQ(loss[0], loss[1]);
+    UT_EXPECT_TRUE(std::fabs(loss[0] - loss[2]) <= 1e-3f * initialLoss);
+    bool areEqual = true;
+    for (unsigned int layerIndex = 1; layerIndex < nets[0].nrOfLayers(); ++layerIndex)
+    {
+        for (unsigned int neuronIndex = 0; neuronIndex < nets[0].neuronsInLayer(layerIndex); ++neuronIndex)
+        {
+            const utils::CVectorF32& weightnings0 = *nets[0].layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+            const utils::CVectorF32& weightnings1 = *nets[1].layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+            for (unsigned int i = 0; i < weightnings0.size(); ++i)
+            {
+                areEqual = areEqual && (weightnings0[i] == weightnings1[i]);
+            }
+        }
+    }
+    UT_EXPECT_TRUE(areEqual);
+}
+
+TSUNIT_TEST(kilib_CTrainer, steadyStateTrainingDoesNotAllocate)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    constexpr unsigned int kNrOfSamples = 32;
+    float inputs[kNrOfSamples * 3];
+    float targets[kNrOfSamples * 2];
+    for (float& input : inputs)
+    {
+        input = utils::CMath::randF32(-1.f, 1.f);
+    }
+    for (float& target : targets)
+    {
+        target = utils::CMath::randF32(-0.5f, 0.5f);
+    }
+
+    for (unsigned int nrOfThreads : {1u, 2u})
+    {
+        kilib::CNeuronalNet net;
+        net.init({3, 12, 2}, tanhActivation, tanhActivation, math);
+
+        kilib::CTrainer::Config config;
+        config.nrOfThreads = nrOfThreads;
+        config.batchSize = 8;
+        kilib::CTrainer trainer(net, config);
+
+        // The first steps allocate the gradients and the optimizer state.
+        float loss = 0.f;
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainBatch(inputs, targets, 8, &loss));
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainEpoch(inputs, targets, kNrOfSamples, &loss));
+
+        UT_EXPECT_NO_ALLOC {
+            trainer.trainBatch(inputs, targets, 8, &loss);
+            trainer.trainEpoch(inputs, targets, kNrOfSamples, &loss);
+        }
+    }
+}
+
+TSUNIT_TEST(kilib_CTrainer, workersEmitTaskTraceEvents)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    kilib::CNeuronalNet net;
+    net.init({2, 4, 1}, tanhActivation, tanhActivation, math);
+    const float inputs[6 * 2] = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, -0.1f, -0.2f, -0.3f, -0.4f, -0.5f, -0.6f};
+    const float targets[6] = {0.1f, 0.2f, 0.3f, -0.1f, -0.2f, -0.3f};
+
+    kilib::CTrainer::Config config;
+    config.nrOfThreads = 3;
+    kilib::CTrainer trainer(net, config);
+
+    utils::CTrace::clear();
+    utils::CTrace::enable(utils::CTrace::kTask);
+    UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainBatch(inputs, targets, 6));
+    utils::CTrace::enable(utils::CTrace::kNone);
+
+    std::FILE* file = tmpfile();
+    UT_EXPECT_NE(nullptr, file);
+    if (file)
+    {
+        const unsigned int nrOfEvents = utils::CTrace::writeChromeTrace(file);
+#if defined(UTILS_ENABLE_TRACING)
+        // The shards and the reduction of every worker.
+        UT_EXPECT_EQ(2 * 3, nrOfEvents);
+#else
+        UT_EXPECT_EQ(0, nrOfEvents);
+#endif
+        fclose(file);
+    }
+    utils::CTrace::clear();
+}
+
+static std::vector<float> _parameters(const kilib::CNeuronalNet& inNet)
+{
+    std::vector<float> parameters;
+    for (unsigned int layerIndex = 1; layerIndex < inNet.nrOfLayers(); ++layerIndex)
+    {
+        for (unsigned int neuronIndex = 0; neuronIndex < inNet.neuronsInLayer(layerIndex); ++neuronIndex)
+        {
+            const utils::CVectorF32& weightnings = *inNet.layer(layerIndex)->weightningVectorForNeuronAtIndex(neuronIndex);
+            parameters.insert(parameters.end(), *weightnings, *weightnings + weightnings.size());
+        }
+    }
+    return parameters;
+}
+
+TSUNIT_TEST(kilib_CTrainer, optimizersFollowTheirUpdateRules)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    const float inputs[3 * 2] = {0.5f, -1.f,   0.25f, 0.75f,   -0.5f, 0.1f};
+    const float targets[3 * 2] = {0.2f, -0.3f,   0.f, 0.5f,   -0.4f, 0.1f};
+
+    kilib::CNeuronalNet nets[2];
+    nets[0].init({2, 4, 2}, tanhActivation, tanhActivation, math);
+    nets[1].init({2, 4, 2}, tanhActivation, tanhActivation, math);
+    _copyWeightnings(nets[0], nets[1]);
+
+    kilib::CTrainer::Config config;
+    config.nrOfThreads = 2;
+    config.learningRate = 0.1f;
+    config.optimizer = kilib::CTrainer::Optimizer::momentum;
+    config.momentum = 0.5f;
+    kilib::CTrainer momentumTrainer(nets[0], config);
+    config.optimizer = kilib::CTrainer::Optimizer::adam;
+    kilib::CTrainer adamTrainer(nets[1], config);
+    UT_EXPECT_EQ(0, adamTrainer.optimizerStateSize());
+
+    const size_t nrOfParameters = _parameters(nets[0]).size();
+    std::vector<float> velocities(nrOfParameters, 0.f);
+    std::vector<float> firstMoments(nrOfParameters, 0.f);
+    std::vector<float> secondMoments(nrOfParameters, 0.f);
+    bool isMomentumOk = true;
+    bool isAdamOk = true;
+    for (unsigned int step = 1; step <= 3; ++step)
+    {
+        const std::vector<float> momentumParameters = _parameters(nets[0]);
+        const std::vector<float> adamParameters = _parameters(nets[1]);
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, momentumTrainer.trainBatch(inputs, targets, 3));
+        UT_EXPECT_EQ(kilib::CTrainer::Error::ok, adamTrainer.trainBatch(inputs, targets, 3));
+        const std::vector<float> updatedMomentumParameters = _parameters(nets[0]);
+        const std::vector<float> updatedAdamParameters = _parameters(nets[1]);
+
+        const float adamStepSize = config.learningRate * std::sqrt(1.f - std::pow(config.beta2, float(step)))
+                                                        / (1.f - std::pow(config.beta1, float(step)));
+        for (size_t i = 0; i < nrOfParameters; ++i)
+        {
+            const float momentumGradient = momentumTrainer.gradients()[i] / 3.f;
+            velocities[i] = config.momentum * velocities[i] + momentumGradient;
+            const float expectedMomentumParameter = momentumParameters[i] - config.learningRate * velocities[i];
+            isMomentumOk = isMomentumOk && (std::fabs(expectedMomentumParameter - updatedMomentumParameters[i]) <= 1e-6f);
+
+            const float adamGradient = adamTrainer.gradients()[i] / 3.f;
+            firstMoments[i] = config.beta1 * firstMoments[i] + (1.f - config.beta1) * adamGradient;
+            secondMoments[i] = config.beta2 * secondMoments[i] + (1.f - config.beta2) * adamGradient * adamGradient;
+            const float expectedAdamParameter = adamParameters[i]
+                - adamStepSize * firstMoments[i] / (std::sqrt(secondMoments[i]) + config.epsilon);
+            isAdamOk = isAdamOk && (std::fabs(expectedAdamParameter - updatedAdamParameters[i]) <= 1e-5f);
+        }
+    }
+    UT_EXPECT_TRUE(isMomentumOk);
+    UT_EXPECT_TRUE(isAdamOk);
+
+    // The state is allocated once by training begins.
+    UT_EXPECT_EQ(nrOfParameters * sizeof(float), momentumTrainer.optimizerStateSize());
+    UT_EXPECT_EQ(2 * nrOfParameters * sizeof(float), adamTrainer.optimizerStateSize());
+}
+
+TSUNIT_TEST(kilib_CTrainer, optimizersReduceTheLoss)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+
+    constexpr unsigned int kNrOfSamples = 256;
+    std::vector<float> inputs(kNrOfSamples * 2);
+    std::vector<float> targets(kNrOfSamples);
+    for (unsigned int sampleIndex = 0; sampleIndex < kNrOfSamples; ++sampleIndex)
+    {
+        const float x = utils::CMath::randF32(-1.f, 1.f);
+        const float y = utils::CMath::randF32(-1.f, 1.f);
+        inputs[2 * sampleIndex] = x;
+        inputs[2 * sampleIndex + 1] = y;
+        targets[sampleIndex] = 0.8f * x * y;
+    }
+
+    const kilib::CTrainer::Optimizer kOptimizers[] = {kilib::CTrainer::Optimizer::momentum, kilib::CTrainer::Optimizer::adam};
+    for (const kilib::CTrainer::Optimizer thisOptimizer : kOptimizers)
+    {
+        kilib::CNeuronalNet net;
+        net.init({2, 16, 1}, tanhActivation, tanhActivation, math);
+
+        kilib::CTrainer::Config config;
+        config.nrOfThreads = 2;
+        config.batchSize = 16;
+        config.learningRate = (kilib::CTrainer::Optimizer::adam == thisOptimizer) ? 0.01f : 0.05f;
+        config.optimizer = thisOptimizer;
+        kilib::CTrainer trainer(net, config);
+
+        const float initialLoss = _loss(net, inputs.data(), targets.data(), kNrOfSamples) / kNrOfSamples;
+        for (unsigned int epoch = 0; epoch < 50; ++epoch)
+        {
+            UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainEpoch(inputs.data(), targets.data(), kNrOfSamples));
+        }
+        const float finalLoss = _loss(net, inputs.data(), targets.data(), kNrOfSamples) / kNrOfSamples;
+        UT_EXPECT_TRUE(finalLoss < 0.25f * initialLoss);
+    }
+}
+
+TSUNIT_TEST(kilib_CTrainer, rejectsInvalidParameters)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    const float values[4] = {};
+
+    kilib::CNeuronalNet uninitedNet;
+    kilib::CTrainer uninitedTrainer(uninitedNet);
+    UT_EXPECT_EQ(kilib::CTrainer::Error::notInited, uninitedTrainer.trainBatch(values, values, 1));
+
+    kilib::CNeuronalNet net;
+    net.init({2, 2}, reLU, reLU, math);
+    kilib::CTrainer trainer(net);
+    UT_EXPECT_EQ(kilib::CTrainer::Error::param, trainer.trainBatch(nullptr, values, 1));
+    UT_EXPECT_EQ(kilib::CTrainer::Error::param, trainer.trainBatch(values, values, 0));
+    UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainBatch(values, values, 1));
+
+    kilib::CTrainer::Config config;
+    config.optimizer = kilib::CTrainer::Optimizer::momentum;
+    config.momentum = 1.f;
+    kilib::CTrainer momentumTrainer(net, config);
+    UT_EXPECT_EQ(kilib::CTrainer::Error::param, momentumTrainer.trainBatch(values, values, 1));
+
+    config.optimizer = kilib::CTrainer::Optimizer::adam;
+    config.epsilon = 0.f;
+    kilib::CTrainer adamTrainer(net, config);
+    UT_EXPECT_EQ(kilib::CTrainer::Error::param, adamTrainer.trainEpoch(values, values, 1));
+}
+
+TSUNIT_TEST(kilib_CTrainer, convertsTheLayersToDenseOnceAtTheFirstBatch)
+{
+    utils::CMath math;
+    kilib::CActivationReLU reLU;
+    const float values[4] = {};
+
+    kilib::CNeuronalNet net;
+    net.init({2, 2}, reLU, reLU, math);
+    net.packWeightnings();
+    UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense != net.outputLayer()->weightFormat());
+
+    kilib::CTrainer trainer(net);
+    UT_EXPECT_EQ(kilib::CTrainer::Error::ok, trainer.trainBatch(values, values, 1));
+    UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense == net.outputLayer()->weightFormat());
+
+    // Later on the trainer refuses to unpack the weightnings silently.
+    net.packWeightnings();
+    UT_EXPECT_EQ(kilib::CTrainer::Error::weightFormat, trainer.trainBatch(values, values, 1));
+    UT_EXPECT_TRUE(kilib::CLayer::WeightFormat::dense != net.outputLayer()->weightFormat());
+}
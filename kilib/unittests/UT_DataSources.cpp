@@ -0,0 +1,203 @@
+/*
+ * @file UT_DataSources.cpp
+ * @brief Unittest for the data sources (CCSVDataSource, CIDXDataSource)
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "kilib/include/DataSources.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static std::string _writeTemporaryFile(const void* inData, size_t inSize)
+{
+    char path[] = "/tmp/UT_DataSources_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0)
+    {
+        const ssize_t written = write(fd, inData, inSize);
+        (void)written;
+        close(fd);
+    }
+    return path;
+}
+
+TSUNIT_TEST(kilib_DataSources, csvSourceParsesValuesAndSkipsMalformedLines)
+{
+    const std::string csv =
+        "x,y,label\n"
+        "1.5, -2 ,3\r\n"
+        "\n"
+        "1e-2,+0.25,1\n"
+        "7,8\n"               // Too less columns
+        "1,2,9\n"             // No class
+        "0.000123456789,-1.5E+3,0";
+    const std::string path = _writeTemporaryFile(csv.data(), csv.size());
+
+    kilib::CCSVDataSource source;
+    kilib::CCSVDataSource::Config config;
+    config.nrOfInputs = 2;
+    config.nrOfClasses = 4;
+    config.hasHeader = true;
+    config.inputScale = 2.f;
+    UT_EXPECT_EQ(kilib::CCSVDataSource::Error::io, source.open("/tmp/UT_DataSources_does_not_exist", config));
+    UT_EXPECT_EQ(kilib::CCSVDataSource::Error::ok, source.open(path.c_str(), config));
+    UT_EXPECT_EQ(2, source.nrOfInputs());
+    UT_EXPECT_EQ(4, source.nrOfTargets());
+
+    float inputs[4 * 3] = {};
+    float targets[4 * 4] = {};
+    UT_EXPECT_EQ(2, source.read(inputs, targets, 2));
+    UT_EXPECT_EQ(3.f, inputs[0]);
+    UT_EXPECT_EQ(-4.f, inputs[1]);
+    UT_EXPECT_EQ(2.f * 1e-2f, inputs[2]);
+    UT_EXPECT_EQ(0.5f, inputs[3]);
+    const float expectedTargets[2 * 4] = {0.f, 0.f, 0.f, 1.f,   0.f, 1.f, 0.f, 0.f};
+    for (unsigned int i = 0; i < 2 * 4; ++i)
+    {
+        UT_EXPECT_EQ(expectedTargets[i], targets[i]);
+    }
+
+    UT_EXPECT_EQ(1, source.read(inputs, targets, 4));
+    UT_EXPECT_EQ(2.f * 0.000123456789f, inputs[0]);
+    UT_EXPECT_EQ(-3000.f, inputs[1]);
+    UT_EXPECT_EQ(1.f, targets[0]);
+    UT_EXPECT_EQ(2, source.nrOfSkippedLines());
+    UT_EXPECT_EQ(0, source.read(inputs, targets, 4));
+
+    source.rewind();
+    UT_EXPECT_EQ(3, source.read(inputs, targets, 4));
+    UT_EXPECT_EQ(3.f, inputs[0]);
+
+    // Plain target columns in front of the inputs
+    config.nrOfClasses = 0;
+    config.nrOfTargets = 1;
+    config.nrOfInputs = 2;
+    config.targetsFirst = true;
+    config.inputScale = 1.f;
+    UT_EXPECT_EQ(kilib::CCSVDataSource::Error::ok, source.open(path.c_str(), config));
+    UT_EXPECT_EQ(4, source.read(inputs, targets, 4));
+    UT_EXPECT_EQ(1.5f, targets[0]);
+    UT_EXPECT_EQ(-2.f, inputs[0]);
+    UT_EXPECT_EQ(3.f, inputs[1]);
+    UT_EXPECT_EQ(1, source.nrOfSkippedLines());
+
+    // Inputs only
+    config.nrOfTargets = 0;
+    config.nrOfInputs = 3;
+    UT_EXPECT_EQ(kilib::CCSVDataSource::Error::ok, source.open(path.c_str(), config));
+    UT_EXPECT_EQ(0, source.nrOfTargets());
+    UT_EXPECT_EQ(4, source.read(inputs, nullptr, 4));
+    UT_EXPECT_EQ(1.5f, inputs[0]);
+    UT_EXPECT_EQ(3.f, inputs[2]);
+
+    unlink(path.c_str());
+}
+
+TSUNIT_TEST(kilib_DataSources, idxSourceReadsImagesAndLabels)
+{
+    // 3 images of 2x2 unsigned bytes and their labels
+    const unsigned char images[] = {
+        0, 0, 0x08, 3,   0, 0, 0, 3,   0, 0, 0, 2,   0, 0, 0, 2,
+        0, 51, 102, 255,
+        255, 0, 0, 0,
+        1, 2, 3, 4
+    };
+    const unsigned char labels[] = {
+        0, 0, 0x08, 1,   0, 0, 0, 3,
+        2, 0, 1
+    };
+    const std::string imagesPath = _writeTemporaryFile(images, sizeof(images));
+    const std::string labelsPath = _writeTemporaryFile(labels, sizeof(labels));
+    const std::string truncatedPath = _writeTemporaryFile(images, sizeof(images) - 1);
+
+    kilib::CIDXDataSource source;
+    kilib::CIDXDataSource::Config config;
+    config.nrOfClasses = 3;
+    config.inputScale = 1.f / 255.f;
+    UT_EXPECT_EQ(kilib::CIDXDataSource::Error::format, source.open(truncatedPath.c_str(), labelsPath.c_str(), config));
+    UT_EXPECT_EQ(kilib::CIDXDataSource::Error::param, source.open(labelsPath.c_str(), imagesPath.c_str(), config));
+    UT_EXPECT_EQ(kilib::CIDXDataSource::Error::ok, source.open(imagesPath.c_str(), labelsPath.c_str(), config));
+    UT_EXPECT_EQ(3, source.nrOfSamples());
+    UT_EXPECT_EQ(4, source.nrOfInputs());
+    UT_EXPECT_EQ(3, source.nrOfTargets());
+
+    float inputs[3 * 4] = {};
+    float targets[3 * 3] = {};
+    UT_EXPECT_EQ(2, source.read(inputs, targets, 2));
+    UT_EXPECT_EQ(0.f, inputs[0]);
+    UT_EXPECT_TRUE(std::fabs(0.2f - inputs[1]) <= 1e-6f);
+    UT_EXPECT_EQ(1.f, inputs[3]);
+    UT_EXPECT_EQ(1.f, inputs[4]);
+    UT_EXPECT_EQ(1.f, targets[2]);
+    UT_EXPECT_EQ(0.f, targets[0] + targets[1]);
+    UT_EXPECT_EQ(1.f, targets[3]);
+
+    UT_EXPECT_EQ(1, source.read(inputs, targets, 2));
+    UT_EXPECT_TRUE(std::fabs(4.f / 255.f - inputs[3]) <= 1e-6f);
+    UT_EXPECT_EQ(1.f, targets[1]);
+    UT_EXPECT_EQ(0, source.read(inputs, targets, 2));
+
+    // The labels as they are
+    config.nrOfClasses = 0;
+    UT_EXPECT_EQ(kilib::CIDXDataSource::Error::ok, source.open(imagesPath.c_str(), labelsPath.c_str(), config));
+    UT_EXPECT_EQ(1, source.nrOfTargets());
+    UT_EXPECT_EQ(3, source.read(inputs, targets, 3));
+    UT_EXPECT_EQ(2.f, targets[0]);
+    UT_EXPECT_EQ(0.f, targets[1]);
+    UT_EXPECT_EQ(1.f, targets[2]);
+
+    unlink(imagesPath.c_str());
+    unlink(labelsPath.c_str());
+    unlink(truncatedPath.c_str());
+}
+
+TSUNIT_TEST(kilib_DataSources, rawSourceReadsFloatRows)
+{
+    // 3 samples of 2 inputs and a class label
+    const float values[] = {
+        1.f, 2.f, 1.f,
+        3.f, 4.f, 0.f,
+        5.f, 6.f, 7.f
+    };
+    const std::string path = _writeTemporaryFile(values, sizeof(values));
+
+    kilib::CRawDataSource source;
+    kilib::CRawDataSource::Config config;
+    UT_EXPECT_EQ(kilib::CRawDataSource::Error::param, source.open(path.c_str(), config));
+    config.nrOfInputs = 2;
+    UT_EXPECT_EQ(kilib::CRawDataSource::Error::format, source.open(path.c_str(), config));
+
+    config.nrOfClasses = 2;
+    config.inputOffset = -1.f;
+    UT_EXPECT_EQ(kilib::CRawDataSource::Error::ok, source.open(path.c_str(), config));
+    UT_EXPECT_EQ(3, source.nrOfSamples());
+    UT_EXPECT_EQ(2, source.nrOfTargets());
+
+    float inputs[3 * 2] = {};
+    float targets[3 * 2] = {};
+    UT_EXPECT_EQ(2, source.read(inputs, targets, 2));
+    UT_EXPECT_EQ(0.f, inputs[0]);
+    UT_EXPECT_EQ(3.f, inputs[3]);
+    UT_EXPECT_EQ(1.f, targets[1]);
+    UT_EXPECT_EQ(1.f, targets[2]);
+    UT_EXPECT_EQ(1, source.read(inputs, targets, 2));
+    UT_EXPECT_EQ(5.f, inputs[1]);
+    UT_EXPECT_EQ(0.f, targets[0] + targets[1]); // Unknown class
+    UT_EXPECT_EQ(0, source.read(inputs, targets, 2));
+
+    // Inputs only
+    config.nrOfClasses = 0;
+    config.nrOfInputs = 3;
+    config.inputOffset = 0.f;
+    UT_EXPECT_EQ(kilib::CRawDataSource::Error::ok, source.open(path.c_str(), config));
+    UT_EXPECT_EQ(0, source.nrOfTargets());
+    UT_EXPECT_EQ(3, source.read(inputs, nullptr, 3));
+    UT_EXPECT_EQ(7.f, inputs[8]);
+
+    unlink(path.c_str());
+}
@@ -1,44 +1,291 @@
+/* ==========================================================================
+ * @(#)File: main.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
 #include "kilib/include/CNeuronalNet.hpp"
+#include "kilib/include/DataSources.hpp"
 #include "utils/include/CMath.hpp"
-
-#include <vector>
-#include <array>
-
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstdio>
-#include <cstdint>
 #include <cstring>
-#include <cassert>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include <libgen.h>
+#include <strings.h>
+#include <unistd.h>
+
+// ==========================================================================
+// Local Types
+// ==========================================================================
+using Clock = std::chrono::steady_clock;
+
+/*!
+ * @brief A batch on its way through the pipeline. The slots are reused in
+ * a ring, so the memory is bounded by the number of slots regardless of
+ * the size of the input file.
+ */
+struct Slot
+{
+    enum struct State
+    {
+        free,   // Owned by the reader
+        read,   // Waits for a worker
+        scored  // Waits for the writer
+    };
+
+    State state = State::free;
+    unsigned int nrOfSamples = 0;
+    std::vector<float> inputs;
+    std::vector<float> outputs;
+
+    /// @brief The encoded outputs as they are written to the output file.
+    std::vector<char> bytes;
+    size_t nrOfBytes = 0;
+};
+
+/*!
+ * @brief A worker owns a copy of the network, since a network must not
+ * propagate concurrently.
+ */
+struct Worker
+{
+    utils::CMath math;
+    kilib::CNeuronalNet net;
+    std::thread thread;
+    double busySeconds = 0.;
+};
+
+struct Options
+{
+    const char* modelPath = nullptr;
+    const char* inputPath = nullptr;
+    const char* outputPath = nullptr;
+    unsigned int nrOfThreads = 0;
+    unsigned int batchSize = 1024;
+    bool hasHeader = false;
+    char separator = ',';
+};
+
+/*!
+ * @brief The state shared by the reader (the main thread), the workers
+ * and the writer. All members are guarded by #mutex. Once #isFailed is set
+ * all of them stop, so no batch is written after a failed one.
+ */
+struct Pipeline
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<Slot> slots;
+    unsigned long long nrOfReadBatches = 0;
+    unsigned long long nrOfTakenBatches = 0;
+    bool isEndOfInput = false;
+    bool isFailed = false;
+};
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+static double _secondsSince(Clock::time_point inStart)
+{
+    return std::chrono::duration<double>(Clock::now() - inStart).count();
+}
+
+static bool _isCSVFile(const char* inPath)
+{
+    const size_t length = strlen(inPath);
+    return (length >= 4) && (0 == strcasecmp(inPath + length - 4, ".csv"));
+}
+
+/*!
+ * @brief Encodes the outputs of a scored batch, either as text lines or as
+ * raw float32 values.
+ */
+static void _encodeOutputs(Slot& ioSlot, unsigned int inNrOfOutputs, bool inAsText, char inSeparator)
+{
+    const size_t nrOfValues = size_t(ioSlot.nrOfSamples) * inNrOfOutputs;
+    if (!inAsText)
+    {
+        ioSlot.nrOfBytes = nrOfValues * sizeof(float);
+        ioSlot.bytes.resize(ioSlot.nrOfBytes);
+        memcpy(ioSlot.bytes.data(), ioSlot.outputs.data(), ioSlot.nrOfBytes);
+        return;
+    }
 
-// Poor mans unittest ;-)
-#if defined(__arm__)
-    #define UT_ASSERT(a) do {if (!(a)){asm("bkpt");}}while(0)
-#else
-    #define UT_ASSERT(a) do {assert(a);}while(0)
-#endif
+    // "%.9g" needs at most 16 characters, plus the separator.
+    constexpr size_t kMaxCharactersPerValue = 17;
+    ioSlot.bytes.resize(nrOfValues * kMaxCharactersPerValue + 1);
+    char* position = ioSlot.bytes.data();
+    for (size_t i = 0; i < nrOfValues; ++i)
+    {
+        position += snprintf(position, kMaxCharactersPerValue, "%.9g", ioSlot.outputs[i]);
+        *position++ = (inNrOfOutputs - 1 == i % inNrOfOutputs) ? '\n' : inSeparator;
+    }
+    ioSlot.nrOfBytes = static_cast<size_t>(position - ioSlot.bytes.data());
+}
 
-#define UT_EXPECT_TRUE(a)  do{UT_ASSERT(a);}while(0)
-#define UT_EXPECT_FALSE(a) do{UT_ASSERT(!(a));}while(0)
-#define UT_EXPECT_EQ(a,b)  do{UT_ASSERT((a)==(b));}while(0)
-#define UT_EXPECT_NE(a,b)  do{UT_ASSERT((a)!=(b));}while(0)
+static void _scoreBatches(Pipeline& ioPipeline, Worker& ioWorker, bool inAsText, char inSeparator)
+{
+    const unsigned int nrOfOutputs = ioWorker.net.neuronsInLayer(ioWorker.net.nrOfLayers() - 1);
+    for (;;)
+    {
+        Slot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(ioPipeline.mutex);
+            ioPipeline.changed.wait(lock, [&]() {
+                return (ioPipeline.nrOfTakenBatches < ioPipeline.nrOfReadBatches)
+                    || ioPipeline.isEndOfInput || ioPipeline.isFailed;
+            });
+            if (ioPipeline.isFailed || (ioPipeline.nrOfTakenBatches == ioPipeline.nrOfReadBatches))
+            {
+                return; // The end of the input or a failure
+            }
+            slot = &ioPipeline.slots[ioPipeline.nrOfTakenBatches++ % ioPipeline.slots.size()];
+        }
 
-#define dimof(x) (sizeof(x) / sizeof(*(x)))
+        const Clock::time_point start = Clock::now();
+        slot->outputs.resize(size_t(slot->nrOfSamples) * nrOfOutputs);
+        const bool isOk = kilib::CNeuronalNet::Error::ok
+            == ioWorker.net.forwardPropagationBatch(slot->inputs.data(), slot->nrOfSamples, slot->outputs.data());
+        if (isOk)
+        {
+            _encodeOutputs(*slot, nrOfOutputs, inAsText, inSeparator);
+        }
+        ioWorker.busySeconds += _secondsSince(start);
 
-// Our network shall consist of 3 Layers (from left to right):
+        {
+            // A failed batch stays unscored, so its slot is never written.
+            std::lock_guard<std::mutex> lock(ioPipeline.mutex);
+            if (isOk)
+            {
+                slot->state = Slot::State::scored;
+            }
+            ioPipeline.isFailed = ioPipeline.isFailed || !isOk;
+        }
+        ioPipeline.changed.notify_all();
+    }
+}
 
-static float reLU(float inValue)
+/*!
+ * @brief Writes the scored batches in the order of the input.
+ */
+static void _writeBatches(Pipeline& ioPipeline, std::FILE* inFile, double& outBusySeconds)
 {
-    return fmaxf(0.f, inValue);
+    for (unsigned long long batchIndex = 0;; ++batchIndex)
+    {
+        Slot& slot = ioPipeline.slots[batchIndex % ioPipeline.slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(ioPipeline.mutex);
+            ioPipeline.changed.wait(lock, [&]() {
+                return (Slot::State::scored == slot.state) || ioPipeline.isFailed
+                    || (ioPipeline.isEndOfInput && (batchIndex == ioPipeline.nrOfReadBatches));
+            });
+            if (ioPipeline.isFailed || (Slot::State::scored != slot.state))
+            {
+                return;
+            }
+        }
+
+        const Clock::time_point start = Clock::now();
+        const bool isWritten = slot.nrOfBytes == fwrite(slot.bytes.data(), 1, slot.nrOfBytes, inFile);
+        outBusySeconds += _secondsSince(start);
+
+        {
+            std::lock_guard<std::mutex> lock(ioPipeline.mutex);
+            slot.state = Slot::State::free;
+            ioPipeline.isFailed = ioPipeline.isFailed || !isWritten;
+        }
+        ioPipeline.changed.notify_all();
+    }
 }
 
-static float sigmoid(float inValue)
+static void usage(const char* prgName)
 {
-    return 1.f / (1.f + expf(-inValue));
+    printf("Usage of %s:\n", prgName);
+    printf("    %s [-t <threads>] [-b <batch size>] [-H] [-s <separator>] <model_file> <input_file> <output_file>\n", prgName);
+    printf("Scores every sample of <input_file> by a neuronal net that has been stored\n"
+           "by kilib::CNeuronalNet::save() and writes the outputs to <output_file>\n"
+           "('-' for stdout) in the order of the input.\n"
+           "\n"
+           "Files named *.csv are text files of comma separated values, one sample per\n"
+           "line. Any other file consists of raw float32 values. The input is streamed,\n"
+           "so the memory needed does not depend on its size.\n"
+           "\n"
+           "    -t <threads>     The number of inference threads (default: all cores)\n"
+           "    -b <batch size>  The number of samples per batch (default: 1024)\n"
+           "    -H               The input CSV file starts with a header line\n"
+           "    -s <separator>   The separator of the CSV files (default: ',')\n");
 }
 
-static float output(float inValue)
+static bool _parseOptions(int argc, char* argv[], Options& outOptions)
 {
-    return 1.f / (1.f + expf(-inValue));
+    int option;
+    while (-1 != (option = getopt(argc, argv, "t:b:Hs:")))
+    {
+        switch (option)
+        {
+            case 't': outOptions.nrOfThreads = static_cast<unsigned int>(atoi(optarg)); break;
+            case 'b': outOptions.batchSize = static_cast<unsigned int>(atoi(optarg)); break;
+            case 'H': outOptions.hasHeader = true; break;
+            case 's': outOptions.separator = optarg[0]; break;
+            default: return false;
+        }
+    }
+
+    if ((argc - optind != 3) || (0 == outOptions.batchSize) || ('\0' == outOptions.separator))
+    {
+        return false;
+    }
+    outOptions.modelPath = argv[optind];
+    outOptions.inputPath = argv[optind + 1];
+    outOptions.outputPath = argv[optind + 2];
+    return true;
 }
 
 /* ========================================================================== *
@@ -46,57 +293,151 @@ static float output(float inValue)
  * ========================================================================== */
 int main(int argc, char* argv[])
 {
+    const char* prgName = basename(argv[0]);
+    Options options;
+    if (!_parseOptions(argc, argv, options))
     {
+        printf("*** Error using '%s': Invalid Parameters!\n\n", prgName);
+        usage(prgName);
+        return EXIT_FAILURE;
+    }
 
-        utils::CMath math;
+    const Clock::time_point startOfRun = Clock::now();
+    const unsigned int nrOfThreads = (0 != options.nrOfThreads)
+                                   ? options.nrOfThreads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (unsigned int i = 0; i < nrOfThreads; ++i)
+    {
+        std::unique_ptr<Worker> worker(new(std::nothrow) Worker);
+        // Scoring only: Simplify the network and pack the weightnings for the blocked kernels.
+        if (!worker || (kilib::CNeuronalNet::Error::ok != worker->net.load(options.modelPath, worker->math))
+                    || (kilib::CNeuronalNet::Error::ok != worker->net.optimize()))
+        {
+            fprintf(stderr, "*** Error using '%s': Unable to load the model '%s'!\n", prgName, options.modelPath);
+            return EXIT_FAILURE;
+        }
+        worker->net.packWeightnings();
+        workers.push_back(std::move(worker));
+    }
+    const kilib::CNeuronalNet& net = workers.front()->net;
+    const unsigned int nrOfInputs = net.neuronsInLayer(0);
 
-        kilib::CNeuronalNet neuronalNet;
+    kilib::CCSVDataSource csvSource;
+    kilib::CRawDataSource rawSource;
+    kilib::IDataSource* source = nullptr;
+    if (_isCSVFile(options.inputPath))
+    {
+        kilib::CCSVDataSource::Config config;
+        config.nrOfInputs = nrOfInputs;
+        config.nrOfTargets = 0;
+        config.separator = options.separator;
+        config.hasHeader = options.hasHeader;
+        source = (kilib::CCSVDataSource::Error::ok == csvSource.open(options.inputPath, config)) ? &csvSource : nullptr;
+    }
+    else
+    {
+        kilib::CRawDataSource::Config config;
+        config.nrOfInputs = nrOfInputs;
+        source = (kilib::CRawDataSource::Error::ok == rawSource.open(options.inputPath, config)) ? &rawSource : nullptr;
+    }
+    if (nullptr == source)
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to read %u inputs per sample from '%s'!\n", prgName, nrOfInputs, options.inputPath);
+        return EXIT_FAILURE;
+    }
 
+    const bool isStdout = (0 == strcmp("-", options.outputPath));
+    std::FILE* outFile = isStdout ? stdout : fopen(options.outputPath, "wb");
+    if (nullptr == outFile)
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to create '%s'!\n", prgName, options.outputPath);
+        return EXIT_FAILURE;
+    }
 
-        neuronalNet.init({
-                 3 // - An input Layer with 3 Neurons
-              , 10  // - A first hidden layer with 16 Neurons
-              , 16  // - A second hidden layer with 16 Neurons
-              , 8  // - An output layer with 8 Neurons
-        },
-            reLU,
-            output,
-            math
-        );
+    // Two batches per worker keep the workers busy while the reader and the
+    // writer are at work.
+    Pipeline pipeline;
+    pipeline.slots.resize(2 * nrOfThreads + 2);
+    for (Slot& slot : pipeline.slots)
+    {
+        slot.inputs.resize(size_t(options.batchSize) * nrOfInputs);
+    }
 
-        // Train the Network
+    const bool asText = _isCSVFile(options.outputPath);
+    for (std::unique_ptr<Worker>& worker : workers)
+    {
+        Worker* thisWorker = worker.get();
+        thisWorker->thread = std::thread([&pipeline, thisWorker, asText, &options]() {
+            _scoreBatches(pipeline, *thisWorker, asText, options.separator);
+        });
+    }
+    double writeSeconds = 0.;
+    std::thread writer([&]() {_writeBatches(pipeline, outFile, writeSeconds);});
 
-        // Step 1 Generate Input Data (a Bitwise rpräsentation of the Training data)
-        kilib::CLayer* inputLayer = neuronalNet.inputLayer();
-        const kilib::CLayer* outputLayer = neuronalNet.outputLayer();
-        if (inputLayer && outputLayer)
+    // The main thread is the reader.
+    double readSeconds = 0.;
+    unsigned long long nrOfSamples = 0;
+    for (unsigned long long batchIndex = 0;; ++batchIndex)
+    {
+        Slot& slot = pipeline.slots[batchIndex % pipeline.slots.size()];
         {
-            utils::CVectorF32* outputVector = inputLayer->neuronOutputVector();
-            assert(outputVector);
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            pipeline.changed.wait(lock, [&]() {return (Slot::State::free == slot.state) || pipeline.isFailed;});
+            if (pipeline.isFailed)
+            {
+                break; // No need to read the rest of the input.
+            }
+        }
+
+        const Clock::time_point start = Clock::now();
+        slot.nrOfSamples = source->read(slot.inputs.data(), nullptr, options.batchSize);
+        readSeconds += _secondsSince(start);
+        nrOfSamples += slot.nrOfSamples;
 
-            const std::array<uint8_t, 8> kTrainingData = {0,1,2,3,4,5,6,7};
-            for (const uint8_t trainingInput : kTrainingData)
+        {
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            if (0 == slot.nrOfSamples)
             {
-                (*outputVector)[0] = (trainingInput & 0b001 ? 1 : 0);
-                (*outputVector)[1] = (trainingInput & 0b010 ? 1 : 0);
-                (*outputVector)[2] = (trainingInput & 0b100 ? 1 : 0);
-
-
-                for (unsigned int epochCnt = 0; epochCnt < 1; ++epochCnt)
-                {
-                    const bool gradientKnown = (0 != epochCnt);
-                    // Calculate the Cost
-                    neuronalNet.forwardPropagation([&](unsigned int index, float value)->void{
-                        printf("Epoch %d: v[%d] = %.2f\n", epochCnt+1, index, value);
-                    });
-
-                    // Change the weight
-                    {
-                    }
-                } // for (unsigned int epochCnt = 0; epochCnt < 100; ++epochCnt)
+                pipeline.isEndOfInput = true;
             }
+            else
+            {
+                slot.state = Slot::State::read;
+                ++pipeline.nrOfReadBatches;
+            }
+        }
+        pipeline.changed.notify_all();
+        if (0 == slot.nrOfSamples)
+        {
+            break;
         }
     }
 
+    double scoreSeconds = 0.;
+    for (std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->thread.join();
+        scoreSeconds += worker->busySeconds;
+    }
+    writer.join();
+
+    const bool isWritten = (0 == (isStdout ? fflush(outFile) : fclose(outFile)));
+    const double totalSeconds = _secondsSince(startOfRun);
+    if (pipeline.isFailed || !isWritten)
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to score '%s' into '%s'!\n", prgName, options.inputPath, options.outputPath);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "%s: Scored %llu rows in %.3f s (%.0f rows/s) by %u threads.\n",
+            prgName, nrOfSamples, totalSeconds, nrOfSamples / std::max(totalSeconds, 1e-9), nrOfThreads);
+    if (&csvSource == source)
+    {
+        fprintf(stderr, "    skipped lines : %llu\n", csvSource.nrOfSkippedLines());
+    }
+    fprintf(stderr, "    read          : %8.3f s\n"
+                    "    score         : %8.3f s (summed up over all threads)\n"
+                    "    write         : %8.3f s\n",
+            readSeconds, scoreSeconds, writeSeconds);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,419 @@
+/* ==========================================================================
+ * @(#)File: tools/InferenceServer/InferenceServer.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "Protocol.hpp"
+#include "kilib/include/CNeuronalNet.hpp"
+#include "utils/include/CMath.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/epoll.h>
+
+// ==========================================================================
+// Local Types
+// ==========================================================================
+/*!
+ * @brief A client connection. Both buffers consist of floats, so the
+ * payloads of the frames can be used in place: The inputs are propagated
+ * right from the receive buffer and the outputs are written right into the
+ * send buffer.
+ */
+struct Connection
+{
+    int fd = -1;
+
+    std::vector<float> receiveBuffer;
+    size_t receivedBytes = 0;
+
+    std::vector<float> sendBuffer;
+    size_t bytesToSend = 0;
+    size_t sentBytes = 0;
+
+    std::uint32_t events = EPOLLIN; ///< The events registered at the epoll instance
+};
+
+/*!
+ * A connection is not read any longer while it has this many bytes to send.
+ * So a client that pipelines requests but does not read the responses can't
+ * grow the send buffer without limit.
+ */
+static constexpr size_t kMaxBytesToSend = 1 << 20;
+
+static volatile std::sig_atomic_t sTerminate = 0;
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+static void _onSignal(int)
+{
+    sTerminate = 1;
+}
+
+static bool _setNonBlocking(int inFd)
+{
+    const int flags = fcntl(inFd, F_GETFL, 0);
+    return (flags >= 0) && (0 == fcntl(inFd, F_SETFL, flags | O_NONBLOCK));
+}
+
+static char* _bytes(std::vector<float>& inBuffer)
+{
+    return reinterpret_cast<char*>(inBuffer.data());
+}
+
+/*!
+ * @brief Appends a frame of \p inPayloadSize bytes to the send buffer.
+ * @return The payload of the frame to be filled in by the caller.
+ */
+static char* _appendFrame(Connection& ioConnection, size_t inPayloadSize)
+{
+    const size_t frameSize = protocol::kHeaderSize + inPayloadSize;
+    const size_t requiredBytes = ioConnection.bytesToSend + frameSize;
+    if (requiredBytes > ioConnection.sendBuffer.size() * sizeof(float))
+    {
+        ioConnection.sendBuffer.resize(2 * (requiredBytes + sizeof(float) - 1) / sizeof(float));
+    }
+
+    char* frame = _bytes(ioConnection.sendBuffer) + ioConnection.bytesToSend;
+    const protocol::FrameLength length = static_cast<protocol::FrameLength>(inPayloadSize);
+    memcpy(frame, &length, sizeof(length));
+    ioConnection.bytesToSend += frameSize;
+    return frame + protocol::kHeaderSize;
+}
+
+/*!
+ * @brief Answers all complete requests of the receive buffer.
+ * @return false if a request is malformed or could not be answered.
+ */
+static bool _processRequests(Connection& ioConnection, kilib::CNeuronalNet& inNet)
+{
+    const protocol::FrameLength nrOfInputs = inNet.neuronsInLayer(0);
+    const protocol::FrameLength nrOfOutputs = inNet.neuronsInLayer(inNet.nrOfLayers() - 1);
+
+    char* buffer = _bytes(ioConnection.receiveBuffer);
+    size_t offset = 0;
+    while (ioConnection.receivedBytes - offset >= protocol::kHeaderSize)
+    {
+        protocol::FrameLength payloadSize = 0;
+        memcpy(&payloadSize, buffer + offset, sizeof(payloadSize));
+        if ((0 != payloadSize) && (nrOfInputs * sizeof(float) != payloadSize))
+        {
+            return false;
+        }
+
+        if (ioConnection.receivedBytes - offset - protocol::kHeaderSize < payloadSize)
+        {
+            break; // Incomplete frame
+        }
+
+        if (0 == payloadSize)
+        {
+            const protocol::FrameLength info[2] = {nrOfInputs, nrOfOutputs};
+            memcpy(_appendFrame(ioConnection, sizeof(info)), info, sizeof(info));
+        }
+        else
+        {
+            // Both payloads are float aligned since every frame is a multiple of floats.
+            float* outputs = reinterpret_cast<float*>(_appendFrame(ioConnection, nrOfOutputs * sizeof(float)));
+            const float* inputs = reinterpret_cast<const float*>(buffer + offset + protocol::kHeaderSize);
+            if (kilib::CNeuronalNet::Error::ok != inNet.forwardPropagationBatch(inputs, 1, outputs))
+            {
+                return false;
+            }
+        }
+        offset += protocol::kHeaderSize + payloadSize;
+    }
+
+    // Keep an incomplete frame for the next read.
+    if (0 != offset)
+    {
+        memmove(buffer, buffer + offset, ioConnection.receivedBytes - offset);
+        ioConnection.receivedBytes -= offset;
+    }
+    return true;
+}
+
+/*!
+ * @brief Sends as much of the send buffer as the socket takes.
+ * @return false if the connection is broken.
+ */
+static bool _send(Connection& ioConnection)
+{
+    while (ioConnection.sentBytes < ioConnection.bytesToSend)
+    {
+        const ssize_t rc = send(ioConnection.fd, _bytes(ioConnection.sendBuffer) + ioConnection.sentBytes,
+                                ioConnection.bytesToSend - ioConnection.sentBytes, MSG_NOSIGNAL);
+        if (rc < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return (EAGAIN == errno) || (EWOULDBLOCK == errno);
+        }
+        ioConnection.sentBytes += static_cast<size_t>(rc);
+    }
+
+    ioConnection.sentBytes = 0;
+    ioConnection.bytesToSend = 0;
+    return true;
+}
+
+/*!
+ * @brief Reads all available data and answers the complete requests. Stops
+ * reading as soon as kMaxBytesToSend are waiting to be sent.
+ * @return false if the connection is closed or broken.
+ */
+static bool _receive(Connection& ioConnection, kilib::CNeuronalNet& inNet)
+{
+    while (ioConnection.bytesToSend < kMaxBytesToSend)
+    {
+        const size_t capacity = ioConnection.receiveBuffer.size() * sizeof(float);
+        const ssize_t rc = recv(ioConnection.fd, _bytes(ioConnection.receiveBuffer) + ioConnection.receivedBytes,
+                                capacity - ioConnection.receivedBytes, 0);
+        if (0 == rc)
+        {
+            return false; // Closed by the peer
+        }
+
+        if (rc < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return (EAGAIN == errno) || (EWOULDBLOCK == errno);
+        }
+
+        ioConnection.receivedBytes += static_cast<size_t>(rc);
+        if (!_processRequests(ioConnection, inNet))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * @brief Waits for the socket to become writable while there is something to
+ * send and pauses the reading while the send buffer is full.
+ * @return false if the events could not be changed.
+ */
+static bool _updateEvents(int inEpollFd, Connection& ioConnection)
+{
+    const bool waitForInput = (ioConnection.bytesToSend < kMaxBytesToSend);
+    const bool waitForOutput = (0 != ioConnection.bytesToSend);
+    const std::uint32_t events = (waitForInput ? EPOLLIN : 0u) | (waitForOutput ? EPOLLOUT : 0u);
+    if (events == ioConnection.events)
+    {
+        return true;
+    }
+
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = &ioConnection;
+    ioConnection.events = events;
+    return 0 == epoll_ctl(inEpollFd, EPOLL_CTL_MOD, ioConnection.fd, &event);
+}
+
+static void _closeConnection(int inEpollFd, Connection* inConnection)
+{
+    epoll_ctl(inEpollFd, EPOLL_CTL_DEL, inConnection->fd, nullptr);
+    close(inConnection->fd);
+    delete inConnection;
+}
+
+static void _acceptConnections(int inEpollFd, int inListenFd, size_t inReceiveBufferSize)
+{
+    for (;;)
+    {
+        const int fd = accept(inListenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            return; // EAGAIN: No more pending connections
+        }
+
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Fails harmlessly for Unix sockets
+
+        Connection* connection = new(std::nothrow) Connection;
+        if ((nullptr == connection) || !_setNonBlocking(fd))
+        {
+            delete connection;
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->receiveBuffer.resize(inReceiveBufferSize);
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (0 != epoll_ctl(inEpollFd, EPOLL_CTL_ADD, fd, &event))
+        {
+            close(fd);
+            delete connection;
+        }
+    }
+}
+
+static void usage(const char* prgName)
+{
+    printf("Usage of %s:\n", prgName);
+    printf("    %s <model_file> <address>\n", prgName);
+    printf("Serves a neuronal net that has been stored by kilib::CNeuronalNet::save().\n"
+           "<address> is either 'unix:<path>' or 'tcp:<host>:<port>'.\n"
+           "\n"
+           "Every request and response is a frame of a uint32 payload length followed\n"
+           "by the payload. An inference request carries the input values as float32\n"
+           "and is answered by the output values as float32. An empty request is\n"
+           "answered by the number of inputs and outputs as uint32. Connections are\n"
+           "kept alive until the client closes them.\n");
+}
+
+/* ========================================================================== *
+ * Main entry
+ * ========================================================================== */
+int main(int argc, char* argv[])
+{
+    const char* prgName = basename(argv[0]);
+    if (argc < 3)
+    {
+        printf("*** Error using '%s': Parameter Missing!\n\n", prgName);
+        usage(prgName);
+        return EXIT_FAILURE;
+    }
+
+    const char* modelPath = argv[1];
+    const char* address = argv[2];
+
+    utils::CMath math;
+    kilib::CNeuronalNet net;
+    // Scoring only: Simplify the network and pack the weightnings for the blocked kernels.
+    if ((kilib::CNeuronalNet::Error::ok != net.load(modelPath, math))
+     || (kilib::CNeuronalNet::Error::ok != net.optimize()))
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to load the model '%s'!\n", prgName, modelPath);
+        return EXIT_FAILURE;
+    }
+    net.packWeightnings();
+
+    const int listenFd = protocol::openSocket(address, true);
+    const int epollFd = epoll_create1(0);
+    if ((listenFd < 0) || (epollFd < 0) || !_setNonBlocking(listenFd))
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to listen at '%s' (%s)!\n", prgName, address, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    epoll_event listenEvent = {};
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = nullptr; // Marks the listening socket
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent);
+
+    // No SA_RESTART: A signal interrupts epoll_wait().
+    struct sigaction action = {};
+    action.sa_handler = _onSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // The receive buffer takes a bunch of pipelined requests at once.
+    constexpr size_t kRequestsPerRead = 64;
+    const size_t receiveBufferSize = kRequestsPerRead * (net.neuronsInLayer(0) + 1);
+
+    fprintf(stderr, "%s: Serving '%s' (%u inputs, %u outputs) at '%s'\n", prgName, modelPath,
+            net.neuronsInLayer(0), net.neuronsInLayer(net.nrOfLayers() - 1), address);
+
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    while (!sTerminate)
+    {
+        const int nrOfEvents = epoll_wait(epollFd, events, kMaxEvents, -1);
+        if (nrOfEvents < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            fprintf(stderr, "*** Error using '%s': epoll_wait() failed (%s)!\n", prgName, strerror(errno));
+            break;
+        }
+
+        for (int eventIndex = 0; eventIndex < nrOfEvents; ++eventIndex)
+        {
+            Connection* connection = static_cast<Connection*>(events[eventIndex].data.ptr);
+            if (nullptr == connection)
+            {
+                _acceptConnections(epollFd, listenFd, receiveBufferSize);
+                continue;
+            }
+
+            bool alive = 0 == (events[eventIndex].events & EPOLLERR);
+            if (alive && (events[eventIndex].events & (EPOLLIN | EPOLLHUP)))
+            {
+                alive = _receive(*connection, net);
+            }
+            if (alive)
+            {
+                alive = _send(*connection) && _updateEvents(epollFd, *connection);
+            }
+            if (!alive)
+            {
+                _closeConnection(epollFd, connection);
+            }
+        }
+    }
+
+    close(listenFd);
+    close(epollFd);
+    protocol::removeSocketFile(address);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+/* ==========================================================================
+ * @(#)File: tools/InferenceServer/LoadGenerator.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "Protocol.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <libgen.h>
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+static bool _sendAll(int inFd, const void* inData, size_t inSize)
+{
+    const char* data = static_cast<const char*>(inData);
+    while (inSize > 0)
+    {
+        const ssize_t rc = send(inFd, data, inSize, MSG_NOSIGNAL);
+        if (rc <= 0)
+        {
+            if ((rc < 0) && (EINTR == errno))
+            {
+                continue;
+            }
+            return false;
+        }
+        data += rc;
+        inSize -= static_cast<size_t>(rc);
+    }
+    return true;
+}
+
+static bool _receiveAll(int inFd, void* outData, size_t inSize)
+{
+    char* data = static_cast<char*>(outData);
+    while (inSize > 0)
+    {
+        const ssize_t rc = recv(inFd, data, inSize, 0);
+        if (rc <= 0)
+        {
+            if ((rc < 0) && (EINTR == errno))
+            {
+                continue;
+            }
+            return false;
+        }
+        data += rc;
+        inSize -= static_cast<size_t>(rc);
+    }
+    return true;
+}
+
+/*!
+ * @brief Receives a response frame.
+ * @return false if the connection broke or the payload is not \p inPayloadSize bytes.
+ */
+static bool _receiveFrame(int inFd, void* outPayload, size_t inPayloadSize)
+{
+    protocol::FrameLength length = 0;
+    return _receiveAll(inFd, &length, sizeof(length))
+        && (inPayloadSize == length)
+        && _receiveAll(inFd, outPayload, inPayloadSize);
+}
+
+/*!
+ * @brief Sends \p inNrOfRequests inference requests one after the other over
+ * a single (kept alive) connection and records the latency of each.
+ * @return false on any error.
+ */
+static bool _runClient(const char* inAddress, unsigned int inClientIndex, unsigned int inNrOfRequests,
+                       std::vector<std::chrono::nanoseconds>& outLatencies)
+{
+    const int fd = protocol::openSocket(inAddress, false);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // Ask for the shape of the net.
+    const protocol::FrameLength infoRequest = 0;
+    protocol::FrameLength info[2] = {};
+    bool success = _sendAll(fd, &infoRequest, sizeof(infoRequest)) && _receiveFrame(fd, info, sizeof(info));
+
+    const unsigned int nrOfInputs = info[0];
+    const unsigned int nrOfOutputs = info[1];
+
+    // The request frame is prepared once: header followed by the inputs.
+    std::vector<float> request(1 + nrOfInputs);
+    const protocol::FrameLength payloadSize = static_cast<protocol::FrameLength>(nrOfInputs * sizeof(float));
+    memcpy(request.data(), &payloadSize, sizeof(payloadSize));
+    for (unsigned int i = 0; i < nrOfInputs; ++i)
+    {
+        request[1 + i] = static_cast<float>((inClientIndex + i) % 17) / 17.f - 0.5f;
+    }
+    std::vector<float> response(nrOfOutputs);
+
+    outLatencies.reserve(inNrOfRequests);
+    for (unsigned int requestIndex = 0; success && (requestIndex < inNrOfRequests); ++requestIndex)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        success = _sendAll(fd, request.data(), request.size() * sizeof(float))
+               && _receiveFrame(fd, response.data(), nrOfOutputs * sizeof(float));
+        outLatencies.push_back(std::chrono::steady_clock::now() - start);
+    }
+
+    close(fd);
+    return success;
+}
+
+static double _percentileUS(const std::vector<std::chrono::nanoseconds>& inSortedLatencies, double inPercentile)
+{
+    const size_t index = std::min(inSortedLatencies.size() - 1,
+        static_cast<size_t>(inPercentile / 100. * static_cast<double>(inSortedLatencies.size())));
+    return static_cast<double>(inSortedLatencies[index].count()) / 1000.;
+}
+
+static void usage(const char* prgName)
+{
+    printf("Usage of %s:\n", prgName);
+    printf("    %s <address> [<nr_of_connections> [<nr_of_requests_per_connection>]]\n", prgName);
+    printf("Generates load for an InferenceServer at <address> ('unix:<path>' or\n"
+           "'tcp:<host>:<port>'). Every connection is served by its own thread that\n"
+           "sends its requests one after the other over the kept alive connection.\n"
+           "Reports the throughput and the latency percentiles. The defaults are\n"
+           "4 connections and 10000 requests each.\n");
+}
+
+/* ========================================================================== *
+ * Main entry
+ * ========================================================================== */
+int main(int argc, char* argv[])
+{
+    const char* prgName = basename(argv[0]);
+    if (argc < 2)
+    {
+        printf("*** Error using '%s': Parameter Missing!\n\n", prgName);
+        usage(prgName);
+        return EXIT_FAILURE;
+    }
+
+    const char* address = argv[1];
+    const unsigned int nrOfConnections = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : 4;
+    const unsigned int nrOfRequests = (argc > 3) ? static_cast<unsigned int>(atoi(argv[3])) : 10000;
+    if ((0 == nrOfConnections) || (0 == nrOfRequests))
+    {
+        printf("*** Error using '%s': Invalid Parameter!\n\n", prgName);
+        usage(prgName);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<std::chrono::nanoseconds>> latencies(nrOfConnections);
+    std::atomic<unsigned int> nrOfFailedClients{0};
+    std::vector<std::thread> clients;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int clientIndex = 0; clientIndex < nrOfConnections; ++clientIndex)
+    {
+        clients.emplace_back([&, clientIndex](){
+            if (!_runClient(address, clientIndex, nrOfRequests, latencies[clientIndex]))
+            {
+                ++nrOfFailedClients;
+            }
+        });
+    }
+    for (std::thread& thisClient : clients)
+    {
+        thisClient.join();
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    if (0 != nrOfFailedClients)
+    {
+        fprintf(stderr, "*** Error using '%s': %u of %u connections to '%s' failed!\n",
+                prgName, static_cast<unsigned int>(nrOfFailedClients), nrOfConnections, address);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::chrono::nanoseconds> allLatencies;
+    allLatencies.reserve(static_cast<size_t>(nrOfConnections) * nrOfRequests);
+    for (const std::vector<std::chrono::nanoseconds>& thisLatencies : latencies)
+    {
+        allLatencies.insert(allLatencies.end(), thisLatencies.begin(), thisLatencies.end());
+    }
+    std::sort(allLatencies.begin(), allLatencies.end());
+
+    printf("Connections : %u\n", nrOfConnections);
+    printf("Requests    : %zu in %.3f s\n", allLatencies.size(), duration.count());
+    printf("Throughput  : %.0f requests/s\n", static_cast<double>(allLatencies.size()) / duration.count());
+    printf("Latency [us]: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           _percentileUS(allLatencies, 50.), _percentileUS(allLatencies, 90.),
+           _percentileUS(allLatencies, 99.), _percentileUS(allLatencies, 99.9),
+           _percentileUS(allLatencies, 100.));
+    return EXIT_SUCCESS;
+}
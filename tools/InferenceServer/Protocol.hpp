@@ -0,0 +1,221 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: tools/InferenceServer/Protocol.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*!
+ * @brief The wire protocol of the InferenceServer.
+ *
+ * Every message is a frame of a uint32 length (the number of payload bytes)
+ * followed by the payload. All values are in the hosts native byte order
+ * since server and clients run on the same machine.
+ *
+ * Requests:
+ * - Inference: The neuronsInLayer(0) input values as float32.
+ * - Info: An empty payload.
+ *
+ * Responses (in the order of the requests, a connection may be kept alive
+ * for any number of requests):
+ * - Inference: The output values as float32.
+ * - Info: The number of inputs and the number of outputs as uint32.
+ *
+ * A request of any other size closes the connection.
+ */
+namespace protocol {
+
+using FrameLength = std::uint32_t;
+
+static constexpr size_t kHeaderSize = sizeof(FrameLength);
+
+/*!
+ * @brief Removes a stale Unix Domain socket file. Any other kind of file at
+ * \p inPath is kept.
+ * @return true if there is no file at \p inPath (anymore), false otherwise
+ * (errno is set to EADDRINUSE).
+ */
+inline bool _removeStaleSocketFile(const char* inPath)
+{
+    struct stat status;
+    if ((0 == lstat(inPath, &status)) && !(S_ISSOCK(status.st_mode) && (0 == unlink(inPath))))
+    {
+        errno = EADDRINUSE;
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * @brief Opens a socket for an address
+ * - "unix:<path>" for an Unix Domain socket. A listening socket replaces a
+ *   stale socket file at <path>, but fails by EADDRINUSE for any other file.
+ * - "tcp:<host>:<port>" for a TCP socket
+ *
+ * @param inAddress The address.
+ * @param inListen true to bind and listen (server), false to connect (client).
+ * @return The file descriptor or -1 on failure (errno is set).
+ */
+inline int openSocket(const char* inAddress, bool inListen)
+{
+    if (0 == strncmp(inAddress, "unix:", 5))
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        const char* path = inAddress + 5;
+        if (strlen(path) >= sizeof(address.sun_path))
+        {
+            return -1;
+        }
+        strcpy(address.sun_path, path);
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0)
+        {
+            int rc = -1;
+            if (inListen)
+            {
+                rc = _removeStaleSocketFile(path) ? 0 : -1;
+                rc = (0 == rc) ? bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) : rc;
+                rc = (0 == rc) ? listen(fd, SOMAXCONN) : rc;
+            }
+            else
+            {
+                rc = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            }
+
+            if (0 != rc)
+            {
+                const int error = errno;
+                close(fd);
+                errno = error;
+                return -1;
+            }
+        }
+        return fd;
+    }
+
+    if (0 == strncmp(inAddress, "tcp:", 4))
+    {
+        const std::string hostAndPort(inAddress + 4);
+        const size_t colon = hostAndPort.rfind(':');
+        if (std::string::npos == colon)
+        {
+            return -1;
+        }
+        const std::string host = hostAndPort.substr(0, colon);
+        const std::string port = hostAndPort.substr(colon + 1);
+
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = inListen ? AI_PASSIVE : 0;
+        addrinfo* addresses = nullptr;
+        if (0 != getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses))
+        {
+            return -1;
+        }
+
+        int fd = -1;
+        for (const addrinfo* thisAddress = addresses; thisAddress && (fd < 0); thisAddress = thisAddress->ai_next)
+        {
+            fd = socket(thisAddress->ai_family, thisAddress->ai_socktype, thisAddress->ai_protocol);
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            // Small frames must not wait for Nagle's algorithm.
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            int rc = -1;
+            if (inListen)
+            {
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                rc = bind(fd, thisAddress->ai_addr, thisAddress->ai_addrlen);
+                rc = (0 == rc) ? listen(fd, SOMAXCONN) : rc;
+            }
+            else
+            {
+                rc = connect(fd, thisAddress->ai_addr, thisAddress->ai_addrlen);
+            }
+
+            if (0 != rc)
+            {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+        return fd;
+    }
+    return -1;
+}
+
+/*!
+ * @brief Removes the socket file of an Unix Domain socket address. Nothing
+ * happens for other addresses or if the file is no socket.
+ */
+inline void removeSocketFile(const char* inAddress)
+{
+    if (0 == strncmp(inAddress, "unix:", 5))
+    {
+        _removeStaleSocketFile(inAddress + 5);
+    }
+}
+
+} // namespace protocol
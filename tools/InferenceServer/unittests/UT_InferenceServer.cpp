@@ -0,0 +1,177 @@
+/*
+ * @file UT_InferenceServer.cpp
+ * @brief Smoke test of the InferenceServer and the InferenceLoadGenerator at
+ * a local Unix Domain socket
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "kilib/include/Activation.hpp"
+#include "kilib/include/CNeuronalNet.hpp"
+#include "tools/InferenceServer/Protocol.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include "utils/include/CMath.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*!
+ * @brief Starts a program.
+ * @param inArgs The program path and its arguments, terminated by nullptr.
+ * @param inIsQuiet true to discard the programs stdout.
+ * @return The process id or -1 on failure.
+ */
+static pid_t _spawn(const char* const inArgs[], bool inIsQuiet)
+{
+    const pid_t pid = fork();
+    if (0 == pid)
+    {
+        if (inIsQuiet)
+        {
+            const int nullFd = open("/dev/null", O_WRONLY);
+            dup2(nullFd, STDOUT_FILENO);
+        }
+        execv(inArgs[0], const_cast<char* const*>(inArgs));
+        _exit(127);
+    }
+    return pid;
+}
+
+/*!
+ * @brief Waits until a process has exited.
+ * @return The exit code or -1 if the process did not exit normally.
+ */
+static int _waitForExit(pid_t inPid)
+{
+    int status = 0;
+    if ((inPid < 0) || (waitpid(inPid, &status, 0) != inPid) || !WIFEXITED(status))
+    {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+/*!
+ * @brief Connects to the server at \p inAddress and retries for a while
+ * since the server needs some time to start listening.
+ */
+static int _connect(const char* inAddress)
+{
+    int fd = -1;
+    for (unsigned int attempt = 0; (fd < 0) && (attempt < 200); ++attempt)
+    {
+        fd = protocol::openSocket(inAddress, false);
+        if (fd < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        }
+    }
+    return fd;
+}
+
+/*!
+ * @brief Sends a request frame and receives the response frame.
+ * @return false if the connection broke or the response is not \p inResponseSize bytes.
+ */
+static bool _exchange(int inFd, const void* inRequest, protocol::FrameLength inRequestSize,
+                      void* outResponse, protocol::FrameLength inResponseSize)
+{
+    protocol::FrameLength length = 0;
+    return (sizeof(inRequestSize) == send(inFd, &inRequestSize, sizeof(inRequestSize), MSG_NOSIGNAL))
+        && (static_cast<ssize_t>(inRequestSize) == send(inFd, inRequest, inRequestSize, MSG_NOSIGNAL))
+        && (sizeof(length) == recv(inFd, &length, sizeof(length), MSG_WAITALL))
+        && (inResponseSize == length)
+        && (static_cast<ssize_t>(inResponseSize) == recv(inFd, outResponse, inResponseSize, MSG_WAITALL));
+}
+
+TSUNIT_TEST(tools_InferenceServer, serverAnswersTheRequestsOfTheLoadGenerator)
+{
+    utils::CMath math;
+    kilib::CActivationTanh tanhActivation;
+    kilib::CActivationSigmoid sigmoid;
+
+    kilib::CNeuronalNet net;
+    net.init({5, 7, 3}, tanhActivation, sigmoid, math);
+
+    char directory[] = "/tmp/UT_InferenceServer_XXXXXX";
+    UT_EXPECT_TRUE(nullptr != mkdtemp(directory));
+    const std::string modelPath = std::string(directory) + "/model.net";
+    const std::string socketPath = std::string(directory) + "/server.sock";
+    const std::string address = "unix:" + socketPath;
+    UT_EXPECT_EQ(kilib::CNeuronalNet::Error::ok, net.save(modelPath.c_str()));
+
+    const char* const serverArgs[] = {INFERENCE_SERVER_PATH, modelPath.c_str(), address.c_str(), nullptr};
+    const pid_t serverPid = _spawn(serverArgs, true);
+    UT_EXPECT_TRUE(serverPid > 0);
+
+    const int fd = _connect(address.c_str());
+    UT_EXPECT_TRUE(fd >= 0);
+    if (fd >= 0)
+    {
+        protocol::FrameLength info[2] = {};
+        UT_EXPECT_TRUE(_exchange(fd, nullptr, 0, info, sizeof(info)));
+        UT_EXPECT_EQ(5, info[0]);
+        UT_EXPECT_EQ(3, info[1]);
+
+        float inputs[5] = {};
+        for (unsigned int i = 0; i < dimof(inputs); ++i)
+        {
+            inputs[i] = 0.2f * i - 0.4f;
+            (*net.inputLayer()->neuronOutputVector())[i] = inputs[i];
+        }
+        float expected[3] = {};
+        net.forwardPropagation([&](unsigned int index, float value)->void{expected[index] = value;});
+
+        float outputs[3] = {};
+        UT_EXPECT_TRUE(_exchange(fd, inputs, sizeof(inputs), outputs, sizeof(outputs)));
+        for (unsigned int i = 0; i < dimof(outputs); ++i)
+        {
+            UT_EXPECT_TRUE(std::fabs(expected[i] - outputs[i]) < 1e-5f);
+        }
+        close(fd);
+    }
+
+    const char* const loadGeneratorArgs[] = {INFERENCE_LOAD_GENERATOR_PATH, address.c_str(), "2", "100", nullptr};
+    UT_EXPECT_EQ(EXIT_SUCCESS, _waitForExit(_spawn(loadGeneratorArgs, true)));
+
+    // The server terminates on SIGTERM and removes its socket file.
+    UT_EXPECT_EQ(0, kill(serverPid, SIGTERM));
+    UT_EXPECT_EQ(EXIT_SUCCESS, _waitForExit(serverPid));
+    UT_EXPECT_NE(0, access(socketPath.c_str(), F_OK));
+
+    unlink(modelPath.c_str());
+    rmdir(directory);
+}
+
+TSUNIT_TEST(tools_InferenceServer, listeningKeepsOtherFilesAtTheSocketPath)
+{
+    char path[] = "/tmp/UT_InferenceServer_XXXXXX";
+    const int fileFd = mkstemp(path);
+    UT_EXPECT_TRUE(fileFd >= 0);
+    close(fileFd);
+
+    const std::string address = std::string("unix:") + path;
+    errno = 0;
+    UT_EXPECT_EQ(-1, protocol::openSocket(address.c_str(), true));
+    UT_EXPECT_EQ(EADDRINUSE, errno);
+    protocol::removeSocketFile(address.c_str());
+    UT_EXPECT_EQ(0, access(path, F_OK));
+
+    // A stale socket file however is replaced.
+    unlink(path);
+    int listenFd = protocol::openSocket(address.c_str(), true);
+    UT_EXPECT_TRUE(listenFd >= 0);
+    close(listenFd);
+    listenFd = protocol::openSocket(address.c_str(), true);
+    UT_EXPECT_TRUE(listenFd >= 0);
+    close(listenFd);
+    protocol::removeSocketFile(address.c_str());
+    UT_EXPECT_NE(0, access(path, F_OK));
+}
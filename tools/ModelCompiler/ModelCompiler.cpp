@@ -0,0 +1,280 @@
+/* ==========================================================================
+ * @(#)File: tools/ModelCompiler/ModelCompiler.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "kilib/include/CNeuronalNet.hpp"
+#include "utils/include/CMath.hpp"
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <libgen.h>
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+/*!
+ * @brief Emits the C++ expression of an activation applied to the variable
+ * named \c x. The expressions mirror the built in activations of kilib
+ * (learning rate 0, as CLayer::forwardPropagation() uses it) so that the
+ * generated code yields bit identical results.
+ *
+ * @return The expression or nullptr if the activation is unknown.
+ */
+static const char* _activationExpression(const char* inActivationName)
+{
+    static const struct
+    {
+        const char* name;
+        const char* expression;
+    } kExpressions[] = {
+        {"null",      "x"},
+        {"reLU",      "std::fmax(0.f, x)"},
+        {"leakyReLU", "(x >= 0) ? x : x * 0.f"},
+        {"sigmoid",   "_sigmoid(x) - 1.f"},
+        {"tanh",      "2.f * _sigmoid(2.f * x) - 1.f"},
+        {"softmax",   "(0.f != integral) ? x / integral : 0.f"},
+    };
+
+    for (const auto& thisExpression : kExpressions)
+    {
+        if (0 == strcmp(thisExpression.name, inActivationName))
+        {
+            return thisExpression.expression;
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * @brief The number of floats a row of weightnings occupies in the emitted
+ * tables. The rows are padded by 0 to a multiple of 8 floats, so that every
+ * row of an alignas(32) table starts aligned to 32 bytes.
+ */
+static unsigned int _paddedRowSize(unsigned int inRowSize)
+{
+    return (inRowSize + 7) & ~7u;
+}
+
+static void _emitLayerTable(std::FILE* inFile, const kilib::CLayer& inLayer, unsigned int inLayerIndex)
+{
+    const unsigned int nrOfNeurons = inLayer.nrOfNeurons();
+    const unsigned int rowSize = inLayer.nrOfWeightnings() + 1;
+
+    fprintf(inFile, "\n// Layer %u: %u neurons, %u weightnings + bias each (rows padded by 0)\n", inLayerIndex, nrOfNeurons, rowSize - 1);
+    fprintf(inFile, "alignas(32) static const float kWeightningsL%u[%u][%u] = {\n", inLayerIndex, nrOfNeurons, _paddedRowSize(rowSize));
+    for (unsigned int neuronIndex = 0; neuronIndex < nrOfNeurons; ++neuronIndex)
+    {
+        const utils::CVectorF32& weightnings = *inLayer.weightningVectorForNeuronAtIndex(neuronIndex);
+        fprintf(inFile, "    {");
+        for (unsigned int i = 0; i < rowSize; ++i)
+        {
+            // 9 significant digits are sufficient to reproduce any float exactly.
+            fprintf(inFile, "%s%#.9gf", (0 == i) ? "" : ", ", weightnings[i]);
+        }
+        fprintf(inFile, "},\n");
+    }
+    fprintf(inFile, "};\n");
+}
+
+static void _emitLayerPropagation(std::FILE* inFile, const kilib::CLayer& inLayer, unsigned int inLayerIndex, const char* inActivationName)
+{
+    const unsigned int nrOfNeurons = inLayer.nrOfNeurons();
+    const unsigned int rowSize = inLayer.nrOfWeightnings() + 1;
+
+    fprintf(inFile, "\n    // Layer %u (%s)\n", inLayerIndex, inActivationName);
+    fprintf(inFile, "    float layer%u[%u + 1];\n", inLayerIndex, nrOfNeurons);
+    fprintf(inFile, "    for (unsigned int n = 0; n < %u; ++n)\n", nrOfNeurons);
+    fprintf(inFile, "    {\n");
+    fprintf(inFile, "        float res = 0.f;\n");
+    fprintf(inFile, "        for (unsigned int i = 0; i < %u; ++i)\n", rowSize);
+    fprintf(inFile, "        {\n");
+    fprintf(inFile, "            res += kWeightningsL%u[n][i] * layer%u[i];\n", inLayerIndex, inLayerIndex - 1);
+    fprintf(inFile, "        }\n");
+    fprintf(inFile, "        layer%u[n] = res;\n", inLayerIndex);
+    fprintf(inFile, "    }\n");
+    fprintf(inFile, "    layer%u[%u] = 1.f;\n", inLayerIndex, nrOfNeurons);
+
+    if (0 != strcmp("null", inActivationName))
+    {
+        const bool needsIntegralPart = (0 == strcmp("softmax", inActivationName));
+        if (needsIntegralPart)
+        {
+            fprintf(inFile, "    {\n");
+            fprintf(inFile, "        float integral = 0.f;\n");
+            fprintf(inFile, "        for (unsigned int n = 0; n < %u; ++n)\n", nrOfNeurons);
+            fprintf(inFile, "        {\n");
+            fprintf(inFile, "            integral += layer%u[n];\n", inLayerIndex);
+            fprintf(inFile, "        }\n");
+        }
+        else
+        {
+            fprintf(inFile, "    {\n");
+        }
+        fprintf(inFile, "        for (unsigned int n = 0; n < %u; ++n)\n", nrOfNeurons);
+        fprintf(inFile, "        {\n");
+        fprintf(inFile, "            const float x = layer%u[n];\n", inLayerIndex);
+        fprintf(inFile, "            layer%u[n] = %s;\n", inLayerIndex, _activationExpression(inActivationName));
+        fprintf(inFile, "        }\n");
+        fprintf(inFile, "    }\n");
+    }
+}
+
+static bool _emitCode(std::FILE* inFile, const kilib::CNeuronalNet& inNet, const char* inModelPath, const char* inFunctionName)
+{
+    const char* hiddenName = inNet.hiddenLayerActivation()->name();
+    const char* outputName = inNet.outputActivation()->name();
+    if (!_activationExpression(hiddenName) || !_activationExpression(outputName))
+    {
+        return false;
+    }
+
+    const unsigned int nrOfLayers = inNet.nrOfLayers();
+    const unsigned int nrOfInputs = inNet.neuronsInLayer(0);
+    const unsigned int nrOfOutputs = inNet.neuronsInLayer(nrOfLayers - 1);
+
+    fprintf(inFile, "// ==========================================================================\n");
+    fprintf(inFile, "// Generated by ModelCompiler from '%s' - Do not edit!\n", inModelPath);
+    fprintf(inFile, "//\n");
+    fprintf(inFile, "// void %s(const float* inInput, float* outOutput);\n", inFunctionName);
+    fprintf(inFile, "//     inInput:   %u values\n", nrOfInputs);
+    fprintf(inFile, "//     outOutput: %u values\n", nrOfOutputs);
+    fprintf(inFile, "// ==========================================================================\n");
+    fprintf(inFile, "#include <cmath>\n");
+    fprintf(inFile, "\n");
+    fprintf(inFile, "namespace {\n");
+    fprintf(inFile, "inline float _sigmoid(float inValue)\n");
+    fprintf(inFile, "{\n");
+    fprintf(inFile, "    return 1.f / (1.f + expf(-inValue));\n");
+    fprintf(inFile, "}\n");
+
+    for (unsigned int layerIndex = 1; layerIndex < nrOfLayers; ++layerIndex)
+    {
+        _emitLayerTable(inFile, *inNet.layer(layerIndex), layerIndex);
+    }
+    fprintf(inFile, "} // namespace\n");
+
+    fprintf(inFile, "\n");
+    fprintf(inFile, "void %s(const float* inInput, float* outOutput)\n", inFunctionName);
+    fprintf(inFile, "{\n");
+    fprintf(inFile, "    // Layer 0 (input)\n");
+    fprintf(inFile, "    float layer0[%u + 1];\n", nrOfInputs);
+    fprintf(inFile, "    for (unsigned int n = 0; n < %u; ++n)\n", nrOfInputs);
+    fprintf(inFile, "    {\n");
+    fprintf(inFile, "        layer0[n] = inInput[n];\n");
+    fprintf(inFile, "    }\n");
+    fprintf(inFile, "    layer0[%u] = 1.f;\n", nrOfInputs);
+
+    for (unsigned int layerIndex = 1; layerIndex < nrOfLayers; ++layerIndex)
+    {
+        const bool isOutputLayer = (nrOfLayers - 1 == layerIndex);
+        _emitLayerPropagation(inFile, *inNet.layer(layerIndex), layerIndex, isOutputLayer ? outputName : hiddenName);
+    }
+
+    fprintf(inFile, "\n");
+    fprintf(inFile, "    for (unsigned int n = 0; n < %u; ++n)\n", nrOfOutputs);
+    fprintf(inFile, "    {\n");
+    fprintf(inFile, "        outOutput[n] = layer%u[n];\n", nrOfLayers - 1);
+    fprintf(inFile, "    }\n");
+    fprintf(inFile, "}\n");
+    return true;
+}
+
+static void usage(const char* prgName)
+{
+    printf("Usage of %s:\n", prgName);
+    printf("    %s <model_file> <function_name> [<output_file>]\n", prgName);
+    printf("Translates a neuronal net that has been stored by kilib::CNeuronalNet::save()\n"
+           "into a dependency free C++ source file. This file contains the weightnings as\n"
+           "constant tables and a function\n"
+           "\n"
+           "    void <function_name>(const float* inInput, float* outOutput);\n"
+           "\n"
+           "that performs the forward propagation of the net. If <output_file> is omitted\n"
+           "the code will be written to stdout.\n");
+}
+
+/* ========================================================================== *
+ * Main entry
+ * ========================================================================== */
+int main(int argc, char* argv[])
+{
+    const char* prgName = basename(argv[0]);
+    if (argc < 3)
+    {
+        printf("*** Error using '%s': Parameter Missing!\n\n", prgName);
+        usage(prgName);
+        return EXIT_FAILURE;
+    }
+
+    const char* modelPath = argv[1];
+    const char* functionName = argv[2];
+
+    utils::CMath math;
+    kilib::CNeuronalNet net;
+    if (kilib::CNeuronalNet::Error::ok != net.load(modelPath, math))
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to load the model '%s'!\n", prgName, modelPath);
+        return EXIT_FAILURE;
+    }
+
+    std::FILE* outFile = (argc > 3) ? fopen(argv[3], "w") : stdout;
+    if (nullptr == outFile)
+    {
+        fprintf(stderr, "*** Error using '%s': Unable to create '%s'!\n", prgName, argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    const bool success = _emitCode(outFile, net, modelPath, functionName);
+    if (stdout != outFile)
+    {
+        fclose(outFile);
+    }
+
+    if (!success)
+    {
+        fprintf(stderr, "*** Error using '%s': The model uses an unsupported activation!\n", prgName);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
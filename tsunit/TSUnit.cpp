@@ -165,6 +165,7 @@ public:
 
 ILogger* pLogger = nullptr;
 const TestListEntry* pCurrentEntry;
+TestHooks testHooks = {nullptr, nullptr};
 
 // class TestCaseRegistrar - public
 void TestCaseRegistrar::push(const TestListEntry& inEntry)
@@ -181,6 +182,10 @@ static void _runTests()
         _totalStatistics.incRunTestsCnt();
         const auto oldFailCnt = _totalStatistics.assertionsFailedCnt();
         pLogger->issueTestRun(entry);
+        if (testHooks.beforeTest)
+        {
+            testHooks.beforeTest();
+        }
         entry.testFunct();
         if (oldFailCnt == _totalStatistics.assertionsFailedCnt())
         {
@@ -191,6 +196,10 @@ static void _runTests()
             _totalStatistics.incFailedTestsCnt();
             pLogger->reportFailed();
         }
+        if (testHooks.afterTest)
+        {
+            testHooks.afterTest();
+        }
     }
 }
 } // namespace tsunit
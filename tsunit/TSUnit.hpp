@@ -238,6 +238,17 @@ public:
 extern ILogger* pLogger;
 extern const TestListEntry* pCurrentEntry;
 
+/*
+ * Optional hooks that are called around every test (e.g. by the allocation
+ * counting, see TSUnitAllocations.hpp). Unused hooks are nullptr.
+ */
+struct TestHooks {
+    void(*beforeTest)(void);
+    void(*afterTest)(void);
+};
+
+extern TestHooks testHooks;
+
 #define UT_EXPECT_TRUE(arg) do{\
   tsunit::totalStatistics().incAssertionsCnt();\
   if ( ! (arg) ) {\
@@ -0,0 +1,250 @@
+/* ==========================================================================
+ * @(#)File: TSUnitAllocations.cpp
+ * Created: 2026-10-18
+ * --------------------------------------------------------------------------
+ *  (c)1982-2024 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * ========================================================================== */
+#include "tsunit/TSUnitAllocations.hpp"
+#include "tsunit/TSUnit.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace tsunit {
+
+static std::atomic<std::uint64_t> _allocations(0);
+static std::atomic<std::uint64_t> _deallocations(0);
+static std::atomic<std::uint64_t> _allocatedBytes(0);
+
+// The counters at the start of the running test.
+static AllocationCounters _testStart;
+
+static void* _allocate(std::size_t inSize)
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    _allocatedBytes.fetch_add(inSize, std::memory_order_relaxed);
+    return malloc(inSize ? inSize : 1);
+}
+
+#if defined(__cpp_aligned_new)
+static void* _allocateAligned(std::size_t inSize, std::align_val_t inAlignment)
+{
+    // aligned_alloc() expects the size to be a multiple of the alignment.
+    const std::size_t alignment = static_cast<std::size_t>(inAlignment);
+    const std::size_t size = ((inSize ? inSize : 1) + alignment - 1) / alignment * alignment;
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    _allocatedBytes.fetch_add(inSize, std::memory_order_relaxed);
+    return aligned_alloc(alignment, size);
+}
+#endif
+
+static void _deallocate(void* inPtr)
+{
+    if (inPtr)
+    {
+        _deallocations.fetch_add(1, std::memory_order_relaxed);
+        free(inPtr);
+    }
+}
+
+static void _beforeTest()
+{
+    _testStart = allocationCounters();
+}
+
+static void _afterTest()
+{
+    const AllocationCounters counters = allocationCounters();
+    if (pLogger)
+    {
+        pLogger->log("    %llu allocations (%llu bytes), %llu deallocations\n"
+            , static_cast<unsigned long long>(counters.allocations - _testStart.allocations)
+            , static_cast<unsigned long long>(counters.allocatedBytes - _testStart.allocatedBytes)
+            , static_cast<unsigned long long>(counters.deallocations - _testStart.deallocations));
+    }
+}
+
+// Installs the hooks of the test runner as soon as this is linked.
+static const bool _hooksInstalled = [](){
+    testHooks.beforeTest = _beforeTest;
+    testHooks.afterTest = _afterTest;
+    return true;
+}();
+
+AllocationCounters allocationCounters()
+{
+    AllocationCounters counters;
+    counters.allocations = _allocations.load(std::memory_order_relaxed);
+    counters.deallocations = _deallocations.load(std::memory_order_relaxed);
+    counters.allocatedBytes = _allocatedBytes.load(std::memory_order_relaxed);
+    return counters;
+}
+
+// class CNoAllocationScope - public
+CNoAllocationScope::CNoAllocationScope(int inLine)
+: m_Start(allocationCounters())
+, m_Line(inLine)
+{
+}
+
+void CNoAllocationScope::check()
+{
+    const AllocationCounters counters = allocationCounters();
+    m_Checked = true;
+
+    totalStatistics().incAssertionsCnt();
+    if (counters.allocations != m_Start.allocations)
+    {
+        totalStatistics().incAssertionFailedCnt();
+        if (pLogger)
+        {
+            pLogger->reportFailed();
+            pLogger->log(ESC_COLOR_RED "*** %llu unexpected allocations (%llu bytes) in %s::%s @line %d" ESC_COLOR_RESET "\n"
+                , static_cast<unsigned long long>(counters.allocations - m_Start.allocations)
+                , static_cast<unsigned long long>(counters.allocatedBytes - m_Start.allocatedBytes)
+                , pCurrentEntry->groupName
+                , pCurrentEntry->testCaseName, m_Line);
+        }
+    }
+}
+} // namespace tsunit
+
+// ==========================================================================
+// The replacements of the global operator new and delete
+// ==========================================================================
+void* operator new(std::size_t inSize)
+{
+    void* ptr = tsunit::_allocate(inSize);
+    if (nullptr == ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t inSize)
+{
+    return ::operator new(inSize);
+}
+
+void* operator new(std::size_t inSize, const std::nothrow_t&) noexcept
+{
+    return tsunit::_allocate(inSize);
+}
+
+void* operator new[](std::size_t inSize, const std::nothrow_t&) noexcept
+{
+    return tsunit::_allocate(inSize);
+}
+
+void operator delete(void* inPtr) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete[](void* inPtr) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete(void* inPtr, std::size_t) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete[](void* inPtr, std::size_t) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete(void* inPtr, const std::nothrow_t&) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete[](void* inPtr, const std::nothrow_t&) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+#if defined(__cpp_aligned_new)
+// The over-aligned forms. They are counted like the others.
+void* operator new(std::size_t inSize, std::align_val_t inAlignment)
+{
+    void* ptr = tsunit::_allocateAligned(inSize, inAlignment);
+    if (nullptr == ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t inSize, std::align_val_t inAlignment)
+{
+    return ::operator new(inSize, inAlignment);
+}
+
+void* operator new(std::size_t inSize, std::align_val_t inAlignment, const std::nothrow_t&) noexcept
+{
+    return tsunit::_allocateAligned(inSize, inAlignment);
+}
+
+void* operator new[](std::size_t inSize, std::align_val_t inAlignment, const std::nothrow_t&) noexcept
+{
+    return tsunit::_allocateAligned(inSize, inAlignment);
+}
+
+void operator delete(void* inPtr, std::align_val_t) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete[](void* inPtr, std::align_val_t) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete(void* inPtr, std::size_t, std::align_val_t) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete[](void* inPtr, std::size_t, std::align_val_t) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete(void* inPtr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+
+void operator delete[](void* inPtr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    tsunit::_deallocate(inPtr);
+}
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: TSUnitAllocations.hpp
+ * Created: 2026-10-18
+ * --------------------------------------------------------------------------
+ *  (c)1982-2024 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * ========================================================================== */
+#include <cstdint>
+
+// Opt-in counting of the heap allocations.
+//
+// Link the object library "tsunit_allocations" into a test in order to
+// replace the global operator new and delete by counting ones (all forms,
+// including the over-aligned ones of C++17):
+//
+//     target_link_libraries(UT_X PRIVATE tsunit_allocations)
+//
+// The allocations of every test are reported in the test log then and
+// UT_EXPECT_NO_ALLOC turns allocations within a scope into a failure.
+
+namespace tsunit {
+
+/*!
+ * The number of allocations and deallocations by the global operator new and
+ * delete of all threads since the start of the program.
+ */
+struct AllocationCounters {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t allocatedBytes = 0;
+};
+
+/*!
+ * Returns the current counters.
+ * \return The counters of all threads.
+ */
+AllocationCounters allocationCounters();
+
+/*!
+ * Counts the allocations between its construction and check(). This is the
+ * implementation of UT_EXPECT_NO_ALLOC.
+ */
+class CNoAllocationScope
+{
+public:
+    CNoAllocationScope(int inLine);
+
+    /*!
+     * Asks if the scope has been entered the first time.
+     * \return true until check() has been called.
+     */
+    bool isFirstPass() const {return !m_Checked;}
+
+    /*!
+     * Counts an assertion that fails if there have been allocations since
+     * the construction. The number of allocations and bytes are logged then.
+     */
+    void check();
+
+private:
+    AllocationCounters m_Start;
+    int m_Line = 0;
+    bool m_Checked = false;
+}; // class CNoAllocationScope
+
+/*
+ * Expects the following statement (or block) not to allocate any heap
+ * memory, in any thread:
+ *
+ *     UT_EXPECT_NO_ALLOC {
+ *         net.forwardPropagationInto(outputs, dimof(outputs));
+ *     }
+ */
+#define UT_EXPECT_NO_ALLOC \
+    for (tsunit::CNoAllocationScope _utNoAllocationScope(__LINE__);\
+         _utNoAllocationScope.isFirstPass();\
+         _utNoAllocationScope.check())
+
+} // namespace tsunit
@@ -42,10 +42,17 @@
  *
  * ========================================================================== */
 #include "CMath.hpp"
+#include "MathKernels.hpp"
 #include <stdlib.h>
 
 namespace utils {
-class CClassicMathDriver : public CMath::IMathDriver
+/*!
+ * @brief The default driver of CMath. It calculates by plain loops.
+ *
+ * The class is final and defines its methods inline. So CBasicMath<CClassicMathDriver>
+ * calls them directly and the compiler is able to inline them into the callers loops.
+ */
+class CClassicMathDriver final : public IMathDriver
 {
 public:
     CClassicMathDriver() = default;
@@ -55,4 +62,35 @@ public:
     virtual float sumUpF32(const CVectorF32& inVector) const override;
     virtual float sumUpF32(const CVectorF32& inVector, unsigned int offset, unsigned int inNrOfElements) const override;
 }; // class CClassicMathDriver
+
+// ==========================================================================
+// class CClassicMathDriver : public IMathDriver
+// ==========================================================================
+inline float CClassicMathDriver::calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset) const
+{
+    float res = 0;
+    assert(inVectorA.size() == inVectorB.size());
+    if (inVectorA.size() == inVectorB.size())
+    {
+        res = kernels::calcDotF32(*inVectorA, *inVectorB, inVectorA.size(), offset);
+    }
+    return res;
+}
+
+inline float CClassicMathDriver::sumUpF32(const CVectorF32& inVector) const
+{
+    return kernels::sumUpF32(*inVector, inVector.size());
+}
+
+inline float CClassicMathDriver::sumUpF32(const CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const
+{
+    float sum = 0.f;
+
+    const unsigned int endIndex = std::min<unsigned int>(inIndexOfFirstElement + inNrOfElements, static_cast<unsigned int>(inVector.size()));
+    if (inIndexOfFirstElement < endIndex)
+    {
+        sum = kernels::sumUpF32(*inVector + inIndexOfFirstElement, endIndex - inIndexOfFirstElement);
+    }
+    return sum;
+}
 } // namespace utils
@@ -0,0 +1,164 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: utils/include/CMPSCQueue.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include <atomic>
+
+namespace utils {
+/*!
+ * @brief A lock free, unbounded queue for multiple producers and a single
+ * consumer (after Dmitry Vyukov's intrusive MPSC queue).
+ *
+ * The queue is intrusive: An element needs to derive from
+ * CMPSCQueue<T>::Node. So pushing and popping never allocates. The queue does
+ * not own its elements.
+ *
+ * - push() may be called by any thread and is wait free.
+ * - pop() and isEmpty() must only be called by one (the consumer) thread.
+ *
+ * @code
+ * struct Request : utils::CMPSCQueue<Request>::Node { int value; };
+ * utils::CMPSCQueue<Request> queue;
+ * queue.push(&request); // Any thread
+ * Request* next = queue.pop(); // Consumer thread
+ * @endcode
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+template <typename T>
+class CMPSCQueue
+{
+public:
+    /// @brief The link of an element. Every element of the queue needs to derive from this.
+    struct Node
+    {
+        std::atomic<Node*> m_NextInQueue{nullptr};
+    };
+
+    CMPSCQueue()
+    : m_Head(&m_Stub)
+    , m_Tail(&m_Stub)
+    {}
+
+    // This class is not ought to be copied or assigned!
+    CMPSCQueue(const CMPSCQueue&) = delete;
+    CMPSCQueue& operator= (const CMPSCQueue&) = delete;
+
+    /*!
+     * @brief Appends an element to the queue. This may be called by any thread.
+     * @param inElement The element to append. It must not be part of a queue already.
+     */
+    void push(T* inElement)
+    {
+        _push(static_cast<Node*>(inElement));
+    }
+
+    /*!
+     * @brief Removes the oldest element from the queue. Only the consumer
+     * thread may call this.
+     *
+     * @return The oldest element or nullptr if the queue is empty. Since a
+     * producer may be just about to link its element this may return nullptr
+     * even though a push() has already begun.
+     */
+    T* pop()
+    {
+        Node* tail = m_Tail;
+        Node* next = tail->m_NextInQueue.load(std::memory_order_acquire);
+        if (&m_Stub == tail)
+        {
+            if (nullptr == next)
+            {
+                return nullptr;
+            }
+            m_Tail = next;
+            tail = next;
+            next = next->m_NextInQueue.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            m_Tail = next;
+            return static_cast<T*>(tail);
+        }
+
+        if (tail != m_Head.load(std::memory_order_acquire))
+        {
+            // A producer has not yet linked its element.
+            return nullptr;
+        }
+
+        // tail is the last element. Put the stub behind it in order to be
+        // able to unlink tail.
+        _push(&m_Stub);
+        next = tail->m_NextInQueue.load(std::memory_order_acquire);
+        if (next)
+        {
+            m_Tail = next;
+            return static_cast<T*>(tail);
+        }
+        return nullptr;
+    }
+
+    /*!
+     * @brief Asks if the queue is empty. Only the consumer thread may call this.
+     * @return true if there is no element (whose push() has begun) in the queue.
+     */
+    bool isEmpty() const
+    {
+        return (&m_Stub == m_Tail) && (&m_Stub == m_Head.load(std::memory_order_seq_cst));
+    }
+
+private:
+    void _push(Node* inNode)
+    {
+        inNode->m_NextInQueue.store(nullptr, std::memory_order_relaxed);
+        Node* previous = m_Head.exchange(inNode, std::memory_order_seq_cst);
+        previous->m_NextInQueue.store(inNode, std::memory_order_release);
+    }
+
+private:
+    std::atomic<Node*> m_Head; ///< The most recent pushed node (producers side)
+    Node* m_Tail;              ///< The oldest node (consumers side)
+    Node m_Stub;
+}; // class CMPSCQueue
+} // namespace utils
@@ -0,0 +1,106 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: utils/include/CMappedFile.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include <cstddef>
+
+namespace utils {
+/*!
+ * @brief A file that is mapped read only into the address space.
+ *
+ * The pages are read on demand by the operating system, so even a file that
+ * exceeds the RAM can be processed. The mapping is announced to be read
+ * sequentially, and pages that are no longer needed can be dropped by
+ * release().
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CMappedFile
+{
+public:
+    CMappedFile() = default;
+    ~CMappedFile();
+
+    // This class is not ought to be copied or assigned!
+    CMappedFile(const CMappedFile&) = delete;
+    CMappedFile& operator= (const CMappedFile&) = delete;
+
+    /*!
+     * @brief Maps a file. A previously mapped file is closed before.
+     * @param inPath The path of the file.
+     * @return false if the file could not be opened or mapped.
+     */
+    bool open(const char* inPath);
+
+    /*!
+     * @brief Unmaps the file. Nothing happens if no file is mapped.
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /*!
+     * @brief The contents of the file.
+     * @return The first byte or nullptr if the file is empty or not open.
+     */
+    const char* data() const;
+
+    /*!
+     * @brief The size of the file in bytes.
+     */
+    size_t size() const;
+
+    /*!
+     * @brief Tells the operating system that the bytes in front of
+     * \p inOffset are not needed any more. So their pages can be dropped
+     * from the memory. They are read again if they are accessed later on.
+     * @param inOffset The offset of the first byte that is still needed.
+     */
+    void release(size_t inOffset);
+
+private:
+    int m_FileDescriptor = -1;
+    const char* m_Data = nullptr;
+    size_t m_Size = 0;
+    size_t m_ReleasedSize = 0; ///< The bytes already released (page aligned)
+}; // class CMappedFile
+} // namespace utils
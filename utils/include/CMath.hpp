@@ -43,100 +43,172 @@
  * ========================================================================== */
 
 #include "CVector.hpp"
+#include "CTrace.hpp"
 #include <cstdlib>
 #include <algorithm>
 
 namespace utils {
 /*!
- * @brief A Mathematical library that uses "drivers" for its realization.
- *
- * The Purpose of a custom driver is to allow the CMath object use spicialized (optimized)
- * algorithms or to give tests a change to implementa a spy for mathematial functions that are
- * covered by CMath.
+ * @brief Interface for a driver that is used by CMath
  *
  * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
  */
-class CMath
+class IMathDriver
 {
 public:
+    IMathDriver() = default;
+    virtual ~IMathDriver() = default;
+
     /*!
-     * @brief Interface for a driver that is used by CMath
+     * @brief Implementation for a dot product calcualtions of two Vectors.
+     *
+     * This Implementation has to realize the calculation of \f$OutVector = inVectorA \cdot inVectorB + offset\f$
      *
-     * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+     * @param inVectorA The left hand side Vector to perform the calculation.
+     * @param inVectorB The right hand side Vector to perform the calculation.
+     * @param offset A custom ofset for the dot product calcualtion. It is assumed that this is zero if not used.
+     * @return The result \f$f(inVector) = inVectorA \cdot inVectorB + offset\f$
      */
-    class IMathDriver
-    {
-    public:
-        IMathDriver() = default;
-        virtual ~IMathDriver() = default;
-
-        /*!
-         * @brief Implementation for a dot product calcualtions of two Vectors.
-         *
-         * This Implementation has to realize the calculation of \f$OutVector = inVectorA \cdot inVectorB + offset\f$
-         *
-         * @param inVectorA The left hand side Vector to perform the calculation.
-         * @param inVectorB The right hand side Vector to perform the calculation.
-         * @param offset A custom ofset for the dot product calcualtion. It is assumed that this is zero if not used.
-         * @return The result \f$f(inVector) = inVectorA \cdot inVectorB + offset\f$
-         */
-        virtual float calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset) const = 0;
-        
-        /*!
-         * @brief Interface for a Method that is supposed to perform an integration of all components of a given
-         * vector and return this result.
-         *
-         * @param inVector The vector whose components are subject of integration
-         * @return The result \f$f(inVector) = \Sum{inVector}_{0}^{inNrOfElements}\f$
-         *
-         * @see sumUpF32(const CVectorF32&, unsigned int, unsigned int) const
-         */
-        virtual float sumUpF32(const CVectorF32& inVector) const = 0;
-
-        /*!
-         * @brief Interface for a Method that is supposed to perform an integration of a specific range of components of a given
-         * vector and return this result.
-         *
-         * @warning The caller of thsi method expects that the implementation will clamp the index to valid ranges of the vector.
-         * This means that if the offset (plus nrOfElements) would exceed the vectors elements then the implementation
-         * must take care to adjust (clmap) the boundaries to valid range in order to respect the vectors range of elements!
-         *
-         * @param inVector The vector whose components are subject of integration
-         * @param inIndexOfFirstElement The 0 based index of the first element of \p inVector to integrate to.
-         * @param inNrOfElements The number of elements of the vector \p inVector starting at index
-         *   \p inIndexOfFirstElement to intgerate to.
-         * @return The result \f$f(inVector, offset, inNrOfElements) = \Sum{inVector}_{offset}^{inNrOfElements}\f$
-         *
-         * @see sumUpF32(const CVectorF32&) const
-         */
-        virtual float sumUpF32(const CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const = 0;
-    };
+    virtual float calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset) const = 0;
+    
+    /*!
+     * @brief Interface for a Method that is supposed to perform an integration of all components of a given
+     * vector and return this result.
+     *
+     * @param inVector The vector whose components are subject of integration
+     * @return The result \f$f(inVector) = \Sum{inVector}_{0}^{inNrOfElements}\f$
+     *
+     * @see sumUpF32(const CVectorF32&, unsigned int, unsigned int) const
+     */
+    virtual float sumUpF32(const CVectorF32& inVector) const = 0;
 
     /*!
-     * @brief Creates an CMath object with a default implementation of a IMathDriver that performs the
-     * desired operations by using the CPU.
+     * @brief Interface for a Method that is supposed to perform an integration of a specific range of components of a given
+     * vector and return this result.
      *
-     * Custom Implementations may use #CMath(const IMathDriver&) and hand over optimized drivers that
-     * for example may utilize SIMD or other target specific mathematical accellearations.
+     * @warning The caller of thsi method expects that the implementation will clamp the index to valid ranges of the vector.
+     * This means that if the offset (plus nrOfElements) would exceed the vectors elements then the implementation
+     * must take care to adjust (clmap) the boundaries to valid range in order to respect the vectors range of elements!
      *
-     * @see CMath(const IMathDriver&)
+     * @param inVector The vector whose components are subject of integration
+     * @param inIndexOfFirstElement The 0 based index of the first element of \p inVector to integrate to.
+     * @param inNrOfElements The number of elements of the vector \p inVector starting at index
+     *   \p inIndexOfFirstElement to intgerate to.
+     * @return The result \f$f(inVector, offset, inNrOfElements) = \Sum{inVector}_{offset}^{inNrOfElements}\f$
+     *
+     * @see sumUpF32(const CVectorF32&) const
      */
-    CMath();
+    virtual float sumUpF32(const CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const = 0;
 
-    
     /*!
-     * @brief Creates an CMath object with a customized implementation of a IMathDriver that performs the
-     * desired operations by using the drivers implementation strategy. (see IDriver for details)
+     * @brief Implementation for a dot product of a sparse vector and a dense vector.
      *
-     * @param inDriver The driver that will be used to perform optimized calcualtions of this object.
+     * The sparse vector is given by its non zero values and their (ascending) indices
+     * in respect of \p inDenseVector. The default implementation uses the plain
+     * kernel (see utils::kernels::calcSparseDotF32()).
+     *
+     * @param inValues The non zero values of the sparse vector.
+     * @param inIndices The index of each value. Every index has to be less than
+     *     \p inDenseVector.size().
+     * @param inNrOfNonZeros The number of elements of \p inValues and \p inIndices.
+     * @param inDenseVector The dense vector.
+     * @param offset A custom ofset for the dot product calcualtion.
+     * @return The dot product of both vectors plus \p offset.
      */
-    CMath(const IMathDriver& inDriver)
+    virtual float calcSparseDotF32(const float* inValues, const unsigned int* inIndices, size_t inNrOfNonZeros,
+        const CVectorF32& inDenseVector, float offset) const;
+
+    /*!
+     * @brief Implementation for a dot product of a block sparse vector and a dense vector.
+     *
+     * The sparse vector consists of blocks of \p inBlockSize consecutive values.
+     * The default implementation uses the plain kernel (see
+     * utils::kernels::calcBlockSparseDotF32()).
+     *
+     * @param inBlockValues The values of all blocks (block after block).
+     * @param inBlockIndices The index of the first element of each block.
+     *     Every block has to fit into \p inDenseVector.
+     * @param inNrOfBlocks The number of blocks.
+     * @param inBlockSize The number of values of every block.
+     * @param inDenseVector The dense vector.
+     * @param offset A custom ofset for the dot product calcualtion.
+     * @return The dot product of both vectors plus \p offset.
+     */
+    virtual float calcBlockSparseDotF32(const float* inBlockValues, const unsigned int* inBlockIndices, size_t inNrOfBlocks,
+        unsigned int inBlockSize, const CVectorF32& inDenseVector, float offset) const;
+
+    /*!
+     * @brief Implementation for the product of a matrix in panel layout and a vector.
+     *
+     * The default implementation uses the plain kernel (see
+     * utils::kernels::calcPanelGemvF32()).
+     *
+     * @param inPanels The matrix packed by utils::kernels::packPanelsF32().
+     * @param inNrOfRows The number of rows of the matrix.
+     * @param inNrOfColumns The number of columns of the matrix.
+     * @param inVector The \p inNrOfColumns values to multiply by.
+     * @param outVector Receives the \p inNrOfRows results.
+     */
+    virtual void calcPanelGemvF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+        const float* inVector, float* outVector) const;
+
+    /*!
+     * @brief Implementation for the product of a matrix in panel layout and
+     * a batch of vectors.
+     *
+     * The default implementation uses the cache blocked kernel (see
+     * utils::kernels::calcPanelGemmF32()).
+     *
+     * @param inPanels The matrix packed by utils::kernels::packPanelsF32().
+     * @param inNrOfRows The number of rows of the matrix.
+     * @param inNrOfColumns The number of columns of the matrix.
+     * @param inSamples \p inNrOfSamples rows of (at least) \p inNrOfColumns values.
+     * @param inNrOfSamples The number of samples.
+     * @param inSampleStride The distance of the samples within \p inSamples (in floats).
+     * @param outResults Receives \p inNrOfSamples rows of \p inNrOfRows results.
+     * @param inResultStride The distance of the results of the samples (in floats).
+     */
+    virtual void calcPanelGemmF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+        const float* inSamples, size_t inNrOfSamples, size_t inSampleStride,
+        float* outResults, size_t inResultStride) const;
+}; // class IMathDriver
+
+/*!
+ * @brief The operations of CMath for a driver of the type \p TDriver.
+ *
+ * CMath uses IMathDriver, so every operation is a virtual call. A driver class
+ * that is `final` and defines its methods inline (like CClassicMathDriver)
+ * may be used as \p TDriver instead: The compiler is then able to inline the
+ * operations into the loops of the caller. \p TDriver does not need to be
+ * derived from IMathDriver. It just has to provide the methods that are
+ * actually used.
+ *
+ * @tparam TDriver The type of the driver.
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+template <typename TDriver>
+class CBasicMath
+{
+public:
+    /*!
+     * @brief Creates an object that uses the driver \p inDriver.
+     * @param inDriver The driver. It has to outlive this object.
+     */
+    explicit CBasicMath(const TDriver& inDriver)
     : m_Driver(inDriver)
     {}
 
-    ~CMath() = default;
+    ~CBasicMath() = default;
+
+    /*!
+     * @brief Asks for the driver of this object.
+     * @return The driver as given to the constructor.
+     */
+    const TDriver& driver() const
+    {
+        return m_Driver;
+    }
 
-    
     /*!
      * @brief Implementation for a dot product calcualtions of two Vectors.
      *
@@ -149,6 +221,7 @@ public:
      */
     float calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset = 0.f) const
     {
+        UTILS_TRACE_SCOPE(traceScope, "calcDotF32", CTrace::kDriver, static_cast<std::int64_t>(inVectorA.size()));
         return m_Driver.calcDotF32(inVectorA, inVectorB, offset);
     }
 
@@ -163,6 +236,7 @@ public:
      */
     float sumUpVector(const CVectorF32& inVector) const
     {
+        UTILS_TRACE_SCOPE(traceScope, "sumUpF32", CTrace::kDriver, static_cast<std::int64_t>(inVector.size()));
         return m_Driver.sumUpF32(inVector);
     }
 
@@ -179,11 +253,105 @@ public:
      */
     float sumUpVector(const CVectorF32& inVector, unsigned int offset, unsigned int inNrOfElements) const
     {
+        UTILS_TRACE_SCOPE(traceScope, "sumUpF32", CTrace::kDriver, inNrOfElements);
         return m_Driver.sumUpF32(inVector, offset, inNrOfElements);
     }
-    static float randF32(float inMin, float inMax);
+
+    /*!
+     * @brief Perform a dot product of a sparse and a dense vector.
+     * @see IMathDriver::calcSparseDotF32()
+     */
+    float calcSparseDotF32(const float* inValues, const unsigned int* inIndices, size_t inNrOfNonZeros,
+        const CVectorF32& inDenseVector, float offset = 0.f) const
+    {
+        UTILS_TRACE_SCOPE(traceScope, "calcSparseDotF32", CTrace::kDriver, static_cast<std::int64_t>(inNrOfNonZeros));
+        return m_Driver.calcSparseDotF32(inValues, inIndices, inNrOfNonZeros, inDenseVector, offset);
+    }
+
+    /*!
+     * @brief Perform a dot product of a block sparse and a dense vector.
+     * @see IMathDriver::calcBlockSparseDotF32()
+     */
+    float calcBlockSparseDotF32(const float* inBlockValues, const unsigned int* inBlockIndices, size_t inNrOfBlocks,
+        unsigned int inBlockSize, const CVectorF32& inDenseVector, float offset = 0.f) const
+    {
+        UTILS_TRACE_SCOPE(traceScope, "calcBlockSparseDotF32", CTrace::kDriver, static_cast<std::int64_t>(inNrOfBlocks * inBlockSize));
+        return m_Driver.calcBlockSparseDotF32(inBlockValues, inBlockIndices, inNrOfBlocks, inBlockSize, inDenseVector, offset);
+    }
+
+    /*!
+     * @brief Multiply a matrix in panel layout by a vector.
+     * @see IMathDriver::calcPanelGemvF32()
+     */
+    void calcPanelGemvF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+        const float* inVector, float* outVector) const
+    {
+        UTILS_TRACE_SCOPE(traceScope, "calcPanelGemvF32", CTrace::kDriver, static_cast<std::int64_t>(inNrOfRows * inNrOfColumns));
+        m_Driver.calcPanelGemvF32(inPanels, inNrOfRows, inNrOfColumns, inVector, outVector);
+    }
+
+    /*!
+     * @brief Multiply a matrix in panel layout by a batch of vectors.
+     * @see IMathDriver::calcPanelGemmF32()
+     */
+    void calcPanelGemmF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+        const float* inSamples, size_t inNrOfSamples, size_t inSampleStride,
+        float* outResults, size_t inResultStride) const
+    {
+        UTILS_TRACE_SCOPE(traceScope, "calcPanelGemmF32", CTrace::kDriver, static_cast<std::int64_t>(inNrOfRows * inNrOfColumns * inNrOfSamples));
+        m_Driver.calcPanelGemmF32(inPanels, inNrOfRows, inNrOfColumns, inSamples, inNrOfSamples, inSampleStride, outResults, inResultStride);
+    }
 
 private:
-    const IMathDriver& m_Driver;
+    const TDriver& m_Driver;
+}; // class CBasicMath
+
+/*!
+ * @brief A Mathematical library that uses "drivers" for its realization.
+ *
+ * The Purpose of a custom driver is to allow the CMath object use spicialized (optimized)
+ * algorithms or to give tests a change to implementa a spy for mathematial functions that are
+ * covered by CMath.
+ *
+ * @see CBasicMath for a variant whose driver is selected at compile time.
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CMath : public CBasicMath<IMathDriver>
+{
+public:
+    /// @brief The interface of the drivers (see utils::IMathDriver).
+    using IMathDriver = utils::IMathDriver;
+
+    /*!
+     * @brief Creates an CMath object with a default implementation of a IMathDriver that performs the
+     * desired operations by using the CPU.
+     *
+     * Custom Implementations may use #CMath(const IMathDriver&) and hand over optimized drivers that
+     * for example may utilize SIMD or other target specific mathematical accellearations.
+     *
+     * @see CMath(const IMathDriver&)
+     */
+    CMath();
+
+    
+    /*!
+     * @brief Creates an CMath object with a customized implementation of a IMathDriver that performs the
+     * desired operations by using the drivers implementation strategy. (see IDriver for details)
+     *
+     * @param inDriver The driver that will be used to perform optimized calcualtions of this object.
+     */
+    CMath(const IMathDriver& inDriver)
+    : CBasicMath<IMathDriver>(inDriver)
+    {}
+
+    /*!
+     * @brief Returns a random number. Every thread uses a generator of its
+     * own (see CRandom), so this is thread safe.
+     *
+     * @param inMin The lower bound (inclusive).
+     * @param inMax The upper bound (exclusive).
+     * @return A number uniformly distributed in [\p inMin ... \p inMax).
+     */
+    static float randF32(float inMin, float inMax);
 }; // class CMath
 } // namespace utils
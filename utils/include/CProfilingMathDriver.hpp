@@ -0,0 +1,190 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: utils/include/CProfilingMathDriver.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include "CMath.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace utils {
+/*!
+ * @brief A "decorating" driver that forwards every call to another driver and
+ * collects statistics about these calls:
+ *
+ *  - The number of calls per method
+ *  - The cumulated time spent per method
+ *  - A histogram of the vector lengths per method
+ *
+ * Every thread counts into its own block of counters, which it looks up
+ * without a lock for the last few drivers it used. So the overhead of a
+ * call is two clock readings and some uncontended increments. The mutex is
+ * only taken when a thread uses a driver the first time, or again after it
+ * has used more than eight other drivers since.
+ * The statistics are summed up across all threads upon #statistics().
+ *
+ * Usage:
+ * @code
+ * utils::CClassicMathDriver classicDriver;
+ * utils::CProfilingMathDriver profilingDriver(classicDriver);
+ * utils::CMath math(profilingDriver);
+ * ...
+ * profilingDriver.report(stdout);
+ * @endcode
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CProfilingMathDriver : public CMath::IMathDriver
+{
+public:
+    /// @brief The methods of CMath::IMathDriver that are going to be profiled.
+    enum Method
+    {
+        kCalcDotF32,
+        kSumUpF32,
+        kSumUpF32Range,
+        kCalcSparseDotF32,
+        kCalcBlockSparseDotF32,
+        kCalcPanelGemvF32,
+        kCalcPanelGemmF32,
+        kNrOfMethods
+    };
+
+    /*!
+     * @brief The number of histogram buckets. The bucket \p i counts the calls
+     * for vectors whose length \p n is \f$2^{i-1} \le n < 2^i\f$ (bucket 0
+     * counts empty vectors).
+     * @see lengthOfBucket()
+     */
+    static constexpr unsigned int kNrOfLengthBuckets = 33;
+
+    /// @brief The statistics collected for a certain method.
+    struct MethodStatistics
+    {
+        std::uint64_t calls = 0;
+        std::uint64_t nanoSeconds = 0;
+        std::uint64_t elements = 0; ///< Sum of the lengths of all calls
+        std::uint64_t lengthHistogram[kNrOfLengthBuckets] = {0};
+    };
+
+    /*!
+     * @brief Creates a profiling driver that decorates another one.
+     * @param inDriver The driver that performs the actual calculations.
+     * It needs to outlive this object.
+     */
+    CProfilingMathDriver(const CMath::IMathDriver& inDriver);
+    virtual ~CProfilingMathDriver();
+
+    CProfilingMathDriver(const CProfilingMathDriver&) = delete;
+    CProfilingMathDriver& operator= (const CProfilingMathDriver&) = delete;
+
+    virtual float calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset) const override;
+    virtual float sumUpF32(const CVectorF32& inVector) const override;
+    virtual float sumUpF32(const CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const override;
+    virtual float calcSparseDotF32(const float* inValues, const unsigned int* inIndices, size_t inNrOfNonZeros,
+        const CVectorF32& inDenseVector, float offset) const override;
+    virtual float calcBlockSparseDotF32(const float* inBlockValues, const unsigned int* inBlockIndices, size_t inNrOfBlocks,
+        unsigned int inBlockSize, const CVectorF32& inDenseVector, float offset) const override;
+    virtual void calcPanelGemvF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+        const float* inVector, float* outVector) const override;
+    virtual void calcPanelGemmF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+        const float* inSamples, size_t inNrOfSamples, size_t inSampleStride,
+        float* outResults, size_t inResultStride) const override;
+
+    /*!
+     * @brief Returns the statistics of a method summed up over all threads.
+     * @param inMethod The method to ask for.
+     * @return The statistics of \p inMethod.
+     */
+    MethodStatistics statistics(Method inMethod) const;
+
+    /*!
+     * @brief Resets the statistics of all methods.
+     * @note Calls that are running concurrently may or may not be counted.
+     */
+    void reset();
+
+    /*!
+     * @brief Writes the statistics of all methods as a table (including their
+     * non empty histogram buckets).
+     * @param inFile The file to write to.
+     */
+    void report(std::FILE* inFile) const;
+
+    /*!
+     * @brief Returns the name of a method.
+     * @param inMethod The method to ask for.
+     * @return The printable name of \p inMethod.
+     */
+    static const char* methodName(Method inMethod);
+
+    /*!
+     * @brief Returns the histogram bucket a given vector length is counted in.
+     * @param inLength The length of a vector.
+     * @return The index of the bucket [0 ... kNrOfLengthBuckets-1].
+     */
+    static unsigned int bucketOfLength(std::uint64_t inLength);
+
+    /*!
+     * @brief Returns the smallest vector length that is counted in a given bucket.
+     * @param inBucket The index of the bucket [0 ... kNrOfLengthBuckets-1].
+     * @return The smallest length of \p inBucket.
+     */
+    static std::uint64_t lengthOfBucket(unsigned int inBucket);
+
+private:
+    struct ThreadCounters;
+
+    ThreadCounters* _threadCounters() const;
+    void _count(Method inMethod, std::uint64_t inLength, std::uint64_t inNanoSeconds) const;
+
+private:
+    const CMath::IMathDriver& m_Driver;
+    const std::uint64_t m_InstanceId;
+
+    mutable std::mutex m_Mutex;
+    mutable std::vector<std::unique_ptr<ThreadCounters>> m_ThreadCounters;
+}; // class CProfilingMathDriver
+} // namespace utils
@@ -0,0 +1,147 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: utils/include/CRandom.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+/*!
+ * @brief A counter based random number generator (Philox4x32-10).
+ *
+ * Every random number is a pure function of the seed, the stream and its
+ * position within the stream. So any range of a stream can be generated
+ * independently of the others, e.g. by several threads in parallel, and the
+ * result is the same for a seed no matter how the work was split. Different
+ * streams of the same seed are independent sequences.
+ *
+ * The fill methods are const and thus may be called by several threads at
+ * once. The sequential methods (nextU32(), nextF32()) keep a position and are
+ * meant for a single thread.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CRandom
+{
+public:
+    /// @brief The seed that is used if none is given.
+    static constexpr std::uint64_t kDefaultSeed = 0x5DEECE66Dull;
+
+    /*!
+     * @brief Creates a generator.
+     * @param inSeed The seed (the key of the generator).
+     * @param inStream The stream of the seed to generate.
+     */
+    explicit CRandom(std::uint64_t inSeed = kDefaultSeed, std::uint64_t inStream = 0);
+
+    std::uint64_t seed() const;
+    std::uint64_t stream() const;
+
+    /*!
+     * @brief The position of the next number that nextU32() or nextF32()
+     * returns.
+     */
+    std::uint64_t position() const;
+
+    /*!
+     * @brief Sets the position of the next number that nextU32() or
+     * nextF32() returns.
+     */
+    void seek(std::uint64_t inPosition);
+
+    /*!
+     * @brief Returns the number at position() and advances the position.
+     * @return A number of 32 uniformly distributed bits.
+     */
+    std::uint32_t nextU32();
+
+    /*!
+     * @brief Like nextU32(), but scaled to a float.
+     * @param inMin The lower bound (inclusive).
+     * @param inMax The upper bound (exclusive).
+     * @return A number uniformly distributed in [\p inMin ... \p inMax).
+     */
+    float nextF32(float inMin, float inMax);
+
+    /*!
+     * @brief Generates the numbers at the positions \p inPosition ...
+     * \p inPosition + \p inNrOfValues - 1 in a uniform distribution.
+     *
+     * @param inPosition The position of the first number within the stream.
+     * @param outValues Receives the numbers.
+     * @param inNrOfValues The number of values to generate.
+     * @param inMin The lower bound (inclusive).
+     * @param inMax The upper bound (exclusive).
+     */
+    void fillUniformF32(std::uint64_t inPosition, float* outValues, std::size_t inNrOfValues,
+        float inMin, float inMax) const;
+
+    /*!
+     * @brief Generates the numbers at the positions \p inPosition ...
+     * \p inPosition + \p inNrOfValues - 1 in a normal distribution.
+     *
+     * The numbers at the positions 2k and 2k+1 are derived from the uniform
+     * numbers of the same positions (Box-Muller transform).
+     *
+     * @param inPosition The position of the first number within the stream.
+     * @param outValues Receives the numbers.
+     * @param inNrOfValues The number of values to generate.
+     * @param inMean The mean of the distribution.
+     * @param inStdDeviation The standard deviation of the distribution.
+     */
+    void fillNormalF32(std::uint64_t inPosition, float* outValues, std::size_t inNrOfValues,
+        float inMean, float inStdDeviation) const;
+
+private:
+    void _fillU32(std::uint64_t inPosition, std::uint32_t* outValues, std::size_t inNrOfValues) const;
+
+private:
+    std::uint64_t m_Seed;
+    std::uint64_t m_Stream;
+    std::uint64_t m_Position = 0;
+
+    // The block of nextU32() (4 numbers starting at a position that is a
+    // multiple of 4)
+    std::uint64_t m_BlockPosition = ~0ull;
+    std::uint32_t m_Block[4] = {};
+}; // class CRandom
+} // namespace utils
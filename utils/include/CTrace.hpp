@@ -0,0 +1,216 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: utils/include/CTrace.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace utils {
+/*!
+ * @brief A light weight tracer that records scoped events (e.g. a layers
+ * forward propagation or a math driver kernel) and writes them as
+ * *Chrome Trace Event* JSON which may be inspected by \p chrome://tracing or
+ * <a href="https://ui.perfetto.dev">Perfetto</a>.
+ *
+ * Every thread records its events into its own ring buffer of
+ * #kEventsPerThread entries. Recording does neither lock nor allocate
+ * (besides the very first event of a thread which registers its buffer).
+ * If a ring buffer overflows then the oldest events of that thread get lost.
+ *
+ * Tracing has to be enabled at runtime for a set of categories by #enable().
+ * The instrumentation itself (see #UTILS_TRACE_SCOPE) is only compiled in
+ * if \p UTILS_ENABLE_TRACING is defined.
+ *
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+class CTrace
+{
+public:
+    /*!
+     * @brief The categories events may be recorded for. They may be or'ed.
+     *
+     * kDriver records an event per call of a math kernel (e.g. per dot
+     * product), which fills a ring buffer within a single propagation of a
+     * mid sized net. So it is not part of kAll and has to be enabled
+     * explicitly, e.g. kAll | kDriver.
+     */
+    enum Category : std::uint32_t
+    {
+        kNone    = 0,
+        kNet     = 1u << 0, ///< Network wide operations (CNeuronalNet)
+        kLayer   = 1u << 1, ///< Per layer operations (CLayer)
+        kDriver  = 1u << 2, ///< Math driver kernels (CMath), one event per call
+        kTask    = 1u << 3, ///< Tasks that run on worker threads
+        kAll     = 0xffffffffu & ~kDriver ///< All categories but kDriver
+    };
+
+    /// @brief The number of events each threads ring buffer is able to keep.
+    static constexpr unsigned int kEventsPerThread = 1u << 14;
+
+    /*!
+     * @brief The number of exited threads whose events are kept until they
+     * are written. The buffer of an exited thread is released once its
+     * events have been written or cleared, or if newer threads exceed this
+     * number.
+     */
+    static constexpr unsigned int kMaxExitedThreads = 64;
+
+    /// @brief A single completed event.
+    struct Event
+    {
+        const char*   name;      ///< Static string (will not be copied!)
+        std::uint32_t category;  ///< One of Category
+        std::int64_t  arg;       ///< Event specific argument (e.g. nr of neurons)
+        std::uint64_t startNs;   ///< Start relative to #nowNs()'s epoch
+        std::uint64_t durationNs;
+    };
+
+    /*!
+     * @brief Enables the tracing for a given set of categories.
+     * @param inCategories The or'ed mask of Category values to record.
+     *     Pass kNone to disable tracing at all.
+     */
+    static void enable(std::uint32_t inCategories);
+
+    /*!
+     * @brief Ask if events of a certain category are going to be recorded.
+     * @param inCategory The category to ask for.
+     * @return true if events of this category are recorded.
+     */
+    static bool isEnabled(std::uint32_t inCategory)
+    {
+        return 0 != (s_EnabledCategories.load(std::memory_order_relaxed) & inCategory);
+    }
+
+    /*!
+     * @brief Records a completed event in the calling threads ring buffer.
+     * @param inName A static string that names the event.
+     * @param inCategory The events category.
+     * @param inArg An event specific argument.
+     * @param inStartNs The start time as returned by #nowNs()
+     * @param inEndNs The end time as returned by #nowNs()
+     */
+    static void record(const char* inName, std::uint32_t inCategory, std::int64_t inArg,
+                       std::uint64_t inStartNs, std::uint64_t inEndNs);
+
+    /*!
+     * @brief Writes all events recorded so far as Chrome Trace JSON.
+     * Afterwards the events of exited threads are dropped.
+     * @note Events that are overwritten by their thread while being written
+     * are skipped. For a complete trace call this when the traced work has
+     * been finished.
+     * @param inFile The file to write to.
+     * @return The number of events written.
+     */
+    static unsigned int writeChromeTrace(std::FILE* inFile);
+
+    /*!
+     * @brief Convenience for writeChromeTrace(std::FILE*) that writes a file.
+     * @param inPath The path of the file to create.
+     * @return true upon success, false if the file could not be written.
+     */
+    static bool writeChromeTrace(const char* inPath);
+
+    /*!
+     * @brief Drops all events recorded so far together with the buffers of
+     * exited threads.
+     */
+    static void clear();
+
+    /*!
+     * @brief The monotonic time in nanoseconds that is used for the events.
+     */
+    static std::uint64_t nowNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /*!
+     * @brief Records its own life time as an event (if the category is enabled).
+     * Please use this by means of #UTILS_TRACE_SCOPE.
+     */
+    class CScope
+    {
+    public:
+        CScope(const char* inName, std::uint32_t inCategory, std::int64_t inArg = 0)
+        : m_Name(CTrace::isEnabled(inCategory) ? inName : nullptr)
+        , m_Category(inCategory)
+        , m_Arg(inArg)
+        , m_StartNs(m_Name ? CTrace::nowNs() : 0)
+        {}
+
+        ~CScope()
+        {
+            if (m_Name)
+            {
+                CTrace::record(m_Name, m_Category, m_Arg, m_StartNs, CTrace::nowNs());
+            }
+        }
+
+        CScope(const CScope&) = delete;
+        CScope& operator= (const CScope&) = delete;
+
+    private:
+        const char* const m_Name;
+        const std::uint32_t m_Category;
+        const std::int64_t m_Arg;
+        const std::uint64_t m_StartNs;
+    }; // class CScope
+
+private:
+    static std::atomic<std::uint32_t> s_EnabledCategories;
+}; // class CTrace
+} // namespace utils
+
+/*!
+ * @brief Traces the remainder of the enclosing scope as an event.
+ * This expands to nothing unless \p UTILS_ENABLE_TRACING is defined.
+ */
+#if defined(UTILS_ENABLE_TRACING)
+    #define UTILS_TRACE_SCOPE(scopeName, eventName, category, arg) \
+        utils::CTrace::CScope scopeName((eventName), (category), (arg))
+#else
+    #define UTILS_TRACE_SCOPE(scopeName, eventName, category, arg) do{}while(0)
+#endif
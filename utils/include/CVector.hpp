@@ -41,18 +41,36 @@
  *   this program under different conditions or license agreements.
  *
  * ========================================================================== */
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
 #include <cfloat>
+#include <cmath>
 #include <memory.h>
 #include <functional>
+#include <new>
 
 namespace utils {
-template <typename T>
+/*!
+ * @brief A vector of a fixed number of elements (that may be changed by
+ * resize()).
+ *
+ * Up to \p NR_OF_INLINE_ELEMENTS elements are stored inside of the vector
+ * object itself (small buffer), so tiny vectors don't allocate at all. The
+ * default is a cache line worth of elements. Larger vectors use the heap.
+ * Either way operator*() provides the elements as a plain array.
+ *
+ * @tparam T The type of the elements.
+ * @tparam NR_OF_INLINE_ELEMENTS The capacity of the small buffer.
+ */
+template <typename T, size_t NR_OF_INLINE_ELEMENTS = 64 / sizeof(T)>
 class CVector
 {
 public:
+    /// @brief The number of elements stored without allocation.
+    static constexpr size_t kNrOfInlineElements = NR_OF_INLINE_ELEMENTS;
+
     CVector() : CVector(0){}
 
 
@@ -66,11 +84,32 @@ public:
      */
     CVector(size_t inNrOfElements)
     : m_NrOfElements(inNrOfElements)
-    , m_Elements(new(std::nothrow) T[inNrOfElements])
+    , m_Capacity((inNrOfElements > kNrOfInlineElements) ? inNrOfElements : kNrOfInlineElements)
+    , m_Elements((inNrOfElements > kNrOfInlineElements) ? new(std::nothrow) T[inNrOfElements] : m_InlineElements)
     {
         assert(m_Elements);
     }
 
+    /*!
+     * @brief Create a Vector that uses external storage instead of allocating
+     * its own. The Vector does **not** take the ownership of this storage.
+     *
+     * This allows several vectors to share a common buffer (e.g. for reusing
+     * the activation buffers of a neuronal net).
+     *
+     * @param inExternalElements The storage of at least \p inNrOfElements
+     *     elements. This needs to outlive this vector.
+     * @param inNrOfElements The number of elements of the vector.
+     */
+    CVector(T* inExternalElements, size_t inNrOfElements)
+    : m_NrOfElements(inNrOfElements)
+    , m_Capacity(inNrOfElements)
+    , m_Elements(inExternalElements)
+    , m_OwnsElements(false)
+    {
+        assert(m_Elements || (0 == inNrOfElements));
+    }
+
     /*!
      * @brief Create a copy of another Vector as a new vector.
      * @param inVector The vector to create a copy from.
@@ -86,16 +125,18 @@ public:
      * @param inMoveVector The vector to move to this.
      */
     CVector(CVector&& inMoveVector)
-    : m_NrOfElements(inMoveVector.m_NrOfElements)
-    , m_Elements(inMoveVector.m_Elements)
     {
-        inMoveVector.m_NrOfElements = 0;
-        inMoveVector.m_Elements = nullptr;
+        _takeOver(inMoveVector);
     }
 
     /*!
      * @brief Assign another Vector as this vector by applying copy semantic.
      * This Vector becomes the dimension among of its values of the other vector.
+     *
+     * The storage of this vector is reused as long as its #capacity()
+     * suffices. So assigning vectors of varying sizes allocates only if a
+     * vector exceeds all previous ones.
+     *
      * @param inRHSVector The vector to copy from.
      * @return This Vector after assign the elements of \p inRHSVector
      */
@@ -103,14 +144,17 @@ public:
     {
         if (this != &inRHSVector)
         {
-            if (inRHSVector.m_NrOfElements > m_NrOfElements)
+            if (inRHSVector.m_NrOfElements > m_Capacity)
             {
-                delete [] m_Elements;
-                m_Elements = new(std::nothrow) T[inRHSVector.m_NrOfElements];
-                assert(m_Elements);
+                const bool success = _reallocate(inRHSVector.m_NrOfElements, false);
+                assert(success);
+                (void)success;
             }
             m_NrOfElements = inRHSVector.m_NrOfElements;
-            memcpy(&m_Elements[0], &inRHSVector.m_Elements[0], sizeof(float) * m_NrOfElements);
+            if (m_NrOfElements > 0)
+            {
+                memcpy(&m_Elements[0], &inRHSVector.m_Elements[0], sizeof(T) * m_NrOfElements);
+            }
         }
         return *this;
     }
@@ -125,11 +169,8 @@ public:
     {
         if (this != &inRHSMoveVector)
         {
-            m_NrOfElements = inRHSMoveVector.m_NrOfElements;
-            m_Elements = inRHSMoveVector.m_Elements ;
-
-            inRHSMoveVector.m_NrOfElements = 0;
-            inRHSMoveVector.m_Elements = nullptr;
+            _releaseElements();
+            _takeOver(inRHSMoveVector);
         }
         return *this;
     }
@@ -139,9 +180,10 @@ public:
      */
     ~CVector()
     {
-        delete [] m_Elements;
+        _releaseElements();
         m_Elements = nullptr;
         m_NrOfElements = 0;
+        m_Capacity = 0;
     }
 
     /*!
@@ -194,6 +236,53 @@ public:
         return m_NrOfElements;
     }
 
+    /*!
+     * @brief Return the number of components this vector is able to hold
+     * without allocating.
+     * @return The number of components of the storage (at least #size()).
+     * @see reserve()
+     */
+    size_t capacity() const
+    {
+        return m_Capacity;
+    }
+
+    /*!
+     * @brief Ensures a storage of at least \p inCapacity components. The
+     * components and the size of this vector are kept.
+     *
+     * @param inCapacity The number of components to provide storage for.
+     * @return false if the storage could not be allocated. This vector is
+     *     unchanged then.
+     * @see capacity()
+     */
+    bool reserve(size_t inCapacity)
+    {
+        return (inCapacity <= m_Capacity) || _reallocate(inCapacity, true);
+    }
+
+    /*!
+     * @brief Changes the number of components of this vector. The storage
+     * is never shrunk, it grows only if \p inNrOfElements exceeds the
+     * #capacity(). So shrinking and growing a vector again does not allocate.
+     *
+     * @note Just like the constructor this does **not** initialize the
+     * components that are added.
+     *
+     * @param inNrOfElements The new number of components.
+     * @return false if the storage could not be allocated. This vector is
+     *     unchanged then.
+     */
+    bool resize(size_t inNrOfElements)
+    {
+        if (!reserve(inNrOfElements))
+        {
+            return false;
+        }
+        m_NrOfElements = inNrOfElements;
+        return true;
+    }
+
     /// @brief A mutable visitor function that is used by #for_each(const MutableVisitor&)
     using MutableVisitor = std::function<void(T&)>;
 
@@ -242,10 +331,47 @@ public:
         }
     }
 
+    /*!
+     * @brief The number of independent accumulators of the reductions.
+     *
+     * The reductions (e.g. max(), sum()) process the elements in rows of
+     * kNrOfLanes elements and keep one accumulator per column. This breaks
+     * the dependency of every step on the previous one, so the compiler is
+     * able to vectorize the loops.
+     */
+    static constexpr size_t kNrOfLanes = 8;
+
+    /*!
+     * @brief The number of elements up to which Summation::pairwise sums up
+     * directly (by the lanes).
+     */
+    static constexpr size_t kPairwiseBlockSize = 256;
+
+    /*!
+     * @brief Selects how sum(), average() and lengthSqu() accumulate.
+     */
+    enum struct Summation
+    {
+        /*!
+         * kNrOfLanes accumulators (default). The rounding error grows
+         * linearly with the number of elements.
+         */
+        lanes,
+
+        /*!
+         * Sums up both halves recursively, blocks of kPairwiseBlockSize
+         * elements by the lanes. The rounding error grows with the
+         * logarithm of the number of elements only. Use this for long
+         * vectors.
+         */
+        pairwise
+    };
+
     /*!
      * @brief Return the greatest element of this vector.
      * @return The greates element of this vector.
      * @see min() const
+     * @see argMax() const
      * @see average() const
      */
     T max() const
@@ -253,14 +379,7 @@ public:
         T maxValue;
         if (m_NrOfElements > 0)
         {
-            maxValue = m_Elements[0];
-            for (unsigned int i=1; i < m_NrOfElements; ++i)
-            {
-                if (m_Elements[i] > maxValue)
-                {
-                    maxValue = m_Elements[i];
-                }
-            }
+            maxValue = _reduce([](const T& inA, const T& inB) {return (inB > inA) ? inB : inA;});
         }
         return maxValue;
     }
@@ -269,6 +388,7 @@ public:
      * @brief Return the smallest element of this vector.
      * @return The greates smallest of this vector.
      * @see max() const
+     * @see argMin() const
      * @see average() const
      */
     T min() const
@@ -276,36 +396,100 @@ public:
         T minValue;
         if (m_NrOfElements > 0)
         {
-            minValue = m_Elements[0];
-            for (unsigned int i=1; i < m_NrOfElements; ++i)
+            minValue = _reduce([](const T& inA, const T& inB) {return (inB < inA) ? inB : inA;});
+        }
+        return minValue;
+    }
+
+    /*!
+     * @brief Return the index of the greatest element of this vector.
+     * @return The index of the greatest element (the first one if there are
+     *     several) or #size() if this vector is empty.
+     * @see max() const
+     */
+    size_t argMax() const
+    {
+        return _indexOfExtremum([](const T& inA, const T& inB) {return inA > inB;});
+    }
+
+    /*!
+     * @brief Return the index of the smallest element of this vector.
+     * @return The index of the smallest element (the first one if there are
+     *     several) or #size() if this vector is empty.
+     * @see min() const
+     */
+    size_t argMin() const
+    {
+        return _indexOfExtremum([](const T& inA, const T& inB) {return inA < inB;});
+    }
+
+    /*!
+     * @brief Determines the indices of the \p inK greatest elements of this
+     * vector by a partial sort: A heap of the \p inK best candidates is
+     * maintained in \p outIndices, so there is no further storage needed.
+     *
+     * @param inK The number of elements to determine.
+     * @param outIndices Receives the indices of the min(\p inK, #size())
+     *     greatest elements ordered by descending values. Equal values are
+     *     ordered by their indices.
+     * @return The number of indices written to \p outIndices.
+     * @see argMax() const
+     */
+    size_t topK(size_t inK, size_t* outIndices) const
+    {
+        const T* elements = m_Elements;
+        const auto isBetter = [elements](size_t inA, size_t inB) {
+            return (elements[inA] > elements[inB]) || ((elements[inA] == elements[inB]) && (inA < inB));
+        };
+
+        const size_t k = (inK < m_NrOfElements) ? inK : m_NrOfElements;
+        if (k > 0)
+        {
+            // The worst candidate is on top of the heap.
+            for (size_t i = 0; i < k; ++i)
+            {
+                outIndices[i] = i;
+            }
+            std::make_heap(outIndices, outIndices + k, isBetter);
+            for (size_t i = k; i < m_NrOfElements; ++i)
             {
-                if (m_Elements[i] < minValue)
+                if (isBetter(i, outIndices[0]))
                 {
-                    minValue = m_Elements[i];
+                    std::pop_heap(outIndices, outIndices + k, isBetter);
+                    outIndices[k - 1] = i;
+                    std::push_heap(outIndices, outIndices + k, isBetter);
                 }
             }
+            std::sort_heap(outIndices, outIndices + k, isBetter);
         }
-        return minValue;
+        return k;
+    }
+
+    /*!
+     * @brief Return the sum of this vectors components.
+     * @param inSummation How to accumulate.
+     * @return The sum of this vectors components (0 if this vector is empty).
+     * @see average() const
+     */
+    T sum(Summation inSummation = Summation::lanes) const
+    {
+        return _sum(inSummation, [](const T& inValue) {return inValue;});
     }
 
     /*!
      * @brief Return the average value of this vectors components.
+     * @param inSummation How to accumulate.
      * @return The average value of this vectors components.
      * @see min() const
      * @see max() const
      */
-    T average() const
+    T average(Summation inSummation = Summation::lanes) const
     {
         T retValue;
         assert (m_NrOfElements > 0);
         if (m_NrOfElements > 0)
         {
-            T sum = 0;
-            for (unsigned int i=0; i < m_NrOfElements; ++i)
-            {
-                sum += m_Elements[i];
-            }
-            retValue = sum / m_NrOfElements;
+            retValue = sum(inSummation) / m_NrOfElements;
         }
         return retValue;
     }
@@ -325,23 +509,14 @@ public:
 
     /*!
      * @brief Calculate the vectors **square** length.
+     * @param inSummation How to accumulate.
      * @return The **square** of the vectors length.
      * @see length() const
      */
-    T lengthSqu() const
+    T lengthSqu(Summation inSummation = Summation::lanes) const
     {
-        T retValue = 0;
         assert (m_NrOfElements > 0);
-        if (m_NrOfElements > 0)
-        {
-            T sum = 0;
-            for (unsigned int i=0; i < m_NrOfElements; ++i)
-            {
-                sum += m_Elements[i] * m_Elements[i];
-            }
-            retValue = sum;
-        }
-        return retValue;
+        return _sum(inSummation, [](const T& inValue) {return inValue * inValue;});
     }
 
     /*!
@@ -350,7 +525,7 @@ public:
      * @param inScale The scale to appy to every vector component.
      * @return This Vector after performing the discussed action.
      */
-    CVector<T>& operator*=(const T& inScale)
+    CVector& operator*=(const T& inScale)
     {
         for (unsigned int i=0; i < m_NrOfElements; ++i)
         {
@@ -366,7 +541,7 @@ public:
      * @param inRHSVector The other vector that is add to this vector.
      * @return This Vector after performing the discussed action.
      */
-    CVector<T>& operator+=(const CVector<T>& inRHSVector)
+    CVector& operator+=(const CVector& inRHSVector)
     {
         assert(inRHSVector.size() == this->size());
         if (inRHSVector.size() == this->size())
@@ -379,9 +554,240 @@ public:
         return *this;
     }
 
+    /*!
+     * @brief Asks if this vector has allocated its storage by its own.
+     * @return false if this vector uses an external storage.
+     * @see CVector(T*, size_t)
+     */
+    bool ownsElements() const
+    {
+        return m_OwnsElements;
+    }
+
+private:
+    /*!
+     * @brief Replaces the storage by an own one of \p inCapacity components.
+     * @param inCapacity The number of components of the new storage.
+     * @param inKeepElements true to copy the components into the new storage.
+     * @return false if the storage could not be allocated.
+     */
+    bool _reallocate(size_t inCapacity, bool inKeepElements)
+    {
+        T* elements = new(std::nothrow) T[inCapacity];
+        if (nullptr == elements)
+        {
+            return false;
+        }
+
+        if (inKeepElements && (m_NrOfElements > 0))
+        {
+            memcpy(elements, m_Elements, sizeof(T) * m_NrOfElements);
+        }
+        _releaseElements();
+        m_Elements = elements;
+        m_Capacity = inCapacity;
+        m_OwnsElements = true;
+        return true;
+    }
+
+    /*!
+     * @brief Frees the storage if it has been allocated by this vector.
+     */
+    void _releaseElements()
+    {
+        if (m_OwnsElements && (m_Elements != m_InlineElements))
+        {
+            delete [] m_Elements;
+        }
+    }
+
+    /*!
+     * @brief Takes over the elements of another vector, which is empty
+     * afterwards. Elements in its small buffer need to be copied.
+     */
+    void _takeOver(CVector& ioVector)
+    {
+        m_NrOfElements = ioVector.m_NrOfElements;
+        m_Capacity = ioVector.m_Capacity;
+        m_OwnsElements = ioVector.m_OwnsElements;
+        if (ioVector.m_Elements == ioVector.m_InlineElements)
+        {
+            memcpy(m_InlineElements, ioVector.m_InlineElements, sizeof(T) * m_NrOfElements);
+            m_Elements = m_InlineElements;
+        }
+        else
+        {
+            m_Elements = ioVector.m_Elements;
+        }
+
+        ioVector.m_NrOfElements = 0;
+        ioVector.m_Capacity = 0;
+        ioVector.m_Elements = nullptr;
+    }
+
+    /*!
+     * @brief Combines all elements by \p inCombine (the vector must not be
+     * empty). Each lane combines every kNrOfLanes'th element, then the lanes
+     * and the remaining elements are combined.
+     */
+    template <typename TCombine>
+    T _reduce(TCombine inCombine) const
+    {
+        const T* elements = m_Elements;
+        T lanes[kNrOfLanes];
+        for (size_t l = 0; l < kNrOfLanes; ++l)
+        {
+            lanes[l] = elements[0];
+        }
+
+        const size_t nrOfLaneElements = m_NrOfElements / kNrOfLanes * kNrOfLanes;
+        size_t i = 0;
+        for (; i < nrOfLaneElements; i += kNrOfLanes)
+        {
+            for (size_t l = 0; l < kNrOfLanes; ++l)
+            {
+                lanes[l] = inCombine(lanes[l], elements[i + l]);
+            }
+        }
+
+        T result = lanes[0];
+        for (size_t l = 1; l < kNrOfLanes; ++l)
+        {
+            result = inCombine(result, lanes[l]);
+        }
+        for (; i < m_NrOfElements; ++i)
+        {
+            result = inCombine(result, elements[i]);
+        }
+        return result;
+    }
+
+    /*!
+     * @brief Like _reduce() but keeps the index of the element for which
+     * \p inIsBetter holds against all others (the first one of equals).
+     */
+    template <typename TIsBetter>
+    size_t _indexOfExtremum(TIsBetter inIsBetter) const
+    {
+        const T* elements = m_Elements;
+        if (m_NrOfElements < kNrOfLanes)
+        {
+            size_t bestIndex = 0;
+            for (size_t i = 1; i < m_NrOfElements; ++i)
+            {
+                if (inIsBetter(elements[i], elements[bestIndex]))
+                {
+                    bestIndex = i;
+                }
+            }
+            return (m_NrOfElements > 0) ? bestIndex : m_NrOfElements;
+        }
+
+        T values[kNrOfLanes];
+        size_t indices[kNrOfLanes];
+        for (size_t l = 0; l < kNrOfLanes; ++l)
+        {
+            values[l] = elements[l];
+            indices[l] = l;
+        }
+
+        const size_t nrOfLaneElements = m_NrOfElements / kNrOfLanes * kNrOfLanes;
+        size_t i = kNrOfLanes;
+        for (; i < nrOfLaneElements; i += kNrOfLanes)
+        {
+            for (size_t l = 0; l < kNrOfLanes; ++l)
+            {
+                const bool isBetter = inIsBetter(elements[i + l], values[l]);
+                values[l] = isBetter ? elements[i + l] : values[l];
+                indices[l] = isBetter ? i + l : indices[l];
+            }
+        }
+
+        size_t bestLane = 0;
+        for (size_t l = 1; l < kNrOfLanes; ++l)
+        {
+            if (inIsBetter(values[l], values[bestLane])
+                || (!inIsBetter(values[bestLane], values[l]) && (indices[l] < indices[bestLane])))
+            {
+                bestLane = l;
+            }
+        }
+
+        size_t bestIndex = indices[bestLane];
+        for (; i < m_NrOfElements; ++i)
+        {
+            if (inIsBetter(elements[i], elements[bestIndex]))
+            {
+                bestIndex = i;
+            }
+        }
+        return bestIndex;
+    }
+
+    /*!
+     * @brief Sums up \p inTransform of every element.
+     */
+    template <typename TTransform>
+    T _sum(Summation inSummation, TTransform inTransform) const
+    {
+        return (Summation::pairwise == inSummation)
+            ? _sumPairwise(m_Elements, m_NrOfElements, inTransform)
+            : _sumLanes(m_Elements, m_NrOfElements, inTransform);
+    }
+
+    template <typename TTransform>
+    static T _sumLanes(const T* inElements, size_t inNrOfElements, TTransform inTransform)
+    {
+        T lanes[kNrOfLanes] = {};
+        const size_t nrOfLaneElements = inNrOfElements / kNrOfLanes * kNrOfLanes;
+        size_t i = 0;
+        for (; i < nrOfLaneElements; i += kNrOfLanes)
+        {
+            for (size_t l = 0; l < kNrOfLanes; ++l)
+            {
+                lanes[l] += inTransform(inElements[i + l]);
+            }
+        }
+
+        // Add up the lanes pairwise as well.
+        for (size_t width = kNrOfLanes / 2; width > 0; width /= 2)
+        {
+            for (size_t l = 0; l < width; ++l)
+            {
+                lanes[l] += lanes[l + width];
+            }
+        }
+
+        T sum = lanes[0];
+        for (; i < inNrOfElements; ++i)
+        {
+            sum += inTransform(inElements[i]);
+        }
+        return sum;
+    }
+
+    template <typename TTransform>
+    static T _sumPairwise(const T* inElements, size_t inNrOfElements, TTransform inTransform)
+    {
+        if (inNrOfElements <= kPairwiseBlockSize)
+        {
+            return _sumLanes(inElements, inNrOfElements, inTransform);
+        }
+
+        // Split at a multiple of the lanes, so only the last block has a tail.
+        const size_t half = (inNrOfElements / 2 + kNrOfLanes - 1) / kNrOfLanes * kNrOfLanes;
+        return _sumPairwise(inElements, half, inTransform)
+             + _sumPairwise(inElements + half, inNrOfElements - half, inTransform);
+    }
+
 private:
     size_t m_NrOfElements = 0;
+    size_t m_Capacity = 0;
     T* m_Elements = nullptr;
+    bool m_OwnsElements = true;
+
+    // The small buffer (see NR_OF_INLINE_ELEMENTS)
+    T m_InlineElements[(NR_OF_INLINE_ELEMENTS > 0) ? NR_OF_INLINE_ELEMENTS : 1];
 }; // struct CVector
 
 /*!
@@ -394,18 +800,18 @@ private:
  * @param inRHSVector The right hand side Vector to add.
  * @return the resulting vector that is \p inLHSVector + \p inRHSVector
  */
-template<typename T>
-CVector<T> operator+(const CVector<T>& inLHSVector, const CVector<T>& inRHSVector)
+template<typename T, size_t N>
+CVector<T, N> operator+(const CVector<T, N>& inLHSVector, const CVector<T, N>& inRHSVector)
 {
     assert (inLHSVector.size() == inRHSVector.size());
     if (inLHSVector.size() == inRHSVector.size())
     {
-        CVector<T> resV(inLHSVector);
+        CVector<T, N> resV(inLHSVector);
         return resV+=(inRHSVector);
     }
     else
     {
-        return CVector<T>(0);
+        return CVector<T, N>(0);
     }
 }
 
@@ -419,13 +825,13 @@ CVector<T> operator+(const CVector<T>& inLHSVector, const CVector<T>& inRHSVecto
  * @param inRHSVector The right hand side Vector to add.
  * @return the resulting vector that is \p inLHSVector + \p inRHSVector
  */
-template<typename T>
-CVector<T> operator-(const CVector<T>& inLHSVector, const CVector<T>& inRHSVector)
+template<typename T, size_t N>
+CVector<T, N> operator-(const CVector<T, N>& inLHSVector, const CVector<T, N>& inRHSVector)
 {
     assert (inLHSVector.size() == inRHSVector.size());
     if (inLHSVector.size() == inRHSVector.size())
     {
-        CVector<T> resV(inLHSVector);
+        CVector<T, N> resV(inLHSVector);
         for (unsigned int i=0; i < inLHSVector.size(); ++i)
         {
             inLHSVector[i] -= inRHSVector[i];
@@ -434,7 +840,7 @@ CVector<T> operator-(const CVector<T>& inLHSVector, const CVector<T>& inRHSVecto
     }
     else
     {
-        return CVector<T>(0);
+        return CVector<T, N>(0);
     }
 }
 
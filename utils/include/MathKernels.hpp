@@ -0,0 +1,331 @@
+#pragma once
+/* ==========================================================================
+ * @(#)File: utils/include/MathKernels.hpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+#include <cmath>
+#include <cstddef>
+
+namespace utils {
+/*!
+ * @brief The plain mathematical kernels that operate on raw float arrays.
+ *
+ * They are shared by CClassicMathDriver (with lengths known at runtime) and
+ * by the compile time specialized code (e.g. kilib::CStaticNeuronalNet) that
+ * uses the variants whose length is a template parameter. Since those loops
+ * have a constant trip count the compiler is able to fully unroll them.
+ *
+ * Both variants accumulate in the same order. So they yield bit identical
+ * results for the same input.
+ */
+namespace kernels {
+/*!
+ * @brief Calculates \f$offset + \sum_{i=0}^{inNrOfElements-1} inA_i \cdot inB_i\f$
+ * @param inA The left hand side vector.
+ * @param inB The right hand side vector.
+ * @param inNrOfElements The number of elements of both vectors.
+ * @param offset The initial value of the sum.
+ * @return The dot product of both vectors plus \p offset.
+ */
+inline float calcDotF32(const float* inA, const float* inB, std::size_t inNrOfElements, float offset)
+{
+    float res = offset;
+    for (std::size_t i = 0; i < inNrOfElements; ++i)
+    {
+        res += inA[i] * inB[i];
+    }
+    return res;
+}
+
+/*!
+ * @brief Compile time sized variant of calcDotF32(const float*, const float*, std::size_t, float)
+ */
+template <std::size_t NR_OF_ELEMENTS>
+inline float calcDotF32(const float* inA, const float* inB, float offset)
+{
+    float res = offset;
+    for (std::size_t i = 0; i < NR_OF_ELEMENTS; ++i)
+    {
+        res += inA[i] * inB[i];
+    }
+    return res;
+}
+
+/*!
+ * @brief Calculates \f$\sum_{i=0}^{inNrOfElements-1} inVector_i\f$
+ * @param inVector The vector to sum up.
+ * @param inNrOfElements The number of elements to sum up.
+ * @return The sum of the first \p inNrOfElements elements of \p inVector.
+ */
+inline float sumUpF32(const float* inVector, std::size_t inNrOfElements)
+{
+    float sum = 0.f;
+    for (std::size_t i = 0; i < inNrOfElements; ++i)
+    {
+        sum += inVector[i];
+    }
+    return sum;
+}
+
+/*!
+ * @brief Compile time sized variant of sumUpF32(const float*, std::size_t)
+ */
+template <std::size_t NR_OF_ELEMENTS>
+inline float sumUpF32(const float* inVector)
+{
+    float sum = 0.f;
+    for (std::size_t i = 0; i < NR_OF_ELEMENTS; ++i)
+    {
+        sum += inVector[i];
+    }
+    return sum;
+}
+
+/*!
+ * @brief Calculates the dot product of a sparse vector (given by its non zero
+ * values and their indices) and a dense vector:
+ * \f$offset + \sum_{k=0}^{inNrOfNonZeros-1} inValues_k \cdot inDense_{inIndices_k}\f$
+ *
+ * @param inValues The non zero values of the sparse vector.
+ * @param inIndices The (ascending) index of each of \p inValues.
+ * @param inNrOfNonZeros The number of elements of \p inValues and \p inIndices.
+ * @param inDense The dense vector.
+ * @param offset The initial value of the sum.
+ * @return The dot product of both vectors plus \p offset.
+ */
+inline float calcSparseDotF32(const float* inValues, const unsigned int* inIndices, std::size_t inNrOfNonZeros,
+    const float* inDense, float offset)
+{
+    float res = offset;
+    for (std::size_t k = 0; k < inNrOfNonZeros; ++k)
+    {
+        res += inValues[k] * inDense[inIndices[k]];
+    }
+    return res;
+}
+
+/*!
+ * @brief Calculates the dot product of a block sparse vector and a dense
+ * vector. The sparse vector consists of \p inNrOfBlocks blocks of
+ * \p inBlockSize consecutive values each. Block \p b starts at index
+ * \p inBlockIndices[b] of the dense vector.
+ *
+ * @param inBlockValues The values of all blocks (block after block).
+ * @param inBlockIndices The (ascending) index of the first element of each block.
+ * @param inNrOfBlocks The number of blocks.
+ * @param inBlockSize The number of values of every block.
+ * @param inDense The dense vector.
+ * @param offset The initial value of the sum.
+ * @return The dot product of both vectors plus \p offset.
+ */
+inline float calcBlockSparseDotF32(const float* inBlockValues, const unsigned int* inBlockIndices, std::size_t inNrOfBlocks,
+    unsigned int inBlockSize, const float* inDense, float offset)
+{
+    float res = offset;
+    for (std::size_t b = 0; b < inNrOfBlocks; ++b)
+    {
+        const float* values = inBlockValues + b * inBlockSize;
+        const float* dense = inDense + inBlockIndices[b];
+        for (unsigned int i = 0; i < inBlockSize; ++i)
+        {
+            res += values[i] * dense[i];
+        }
+    }
+    return res;
+}
+
+/*!
+ * @brief The update step of the plain gradient descent:
+ * \f$w_i \leftarrow w_i - inStepSize \cdot g_i\f$
+ *
+ * The update kernels below process every element independently by a single
+ * pass over contiguous arrays, so the compiler is able to vectorize them.
+ *
+ * @param ioWeights The weightnings to update.
+ * @param inGradients The gradient of each weightning.
+ * @param inNrOfElements The number of elements of all arrays.
+ * @param inStepSize The factor of the gradients.
+ */
+inline void stepSGDF32(float* ioWeights, const float* inGradients, std::size_t inNrOfElements, float inStepSize)
+{
+    for (std::size_t i = 0; i < inNrOfElements; ++i)
+    {
+        ioWeights[i] -= inStepSize * inGradients[i];
+    }
+}
+
+/*!
+ * @brief The update step of the gradient descent with momentum:
+ * \f$v_i \leftarrow inMomentum \cdot v_i + inGradientScale \cdot g_i\f$,
+ * \f$w_i \leftarrow w_i - inLearningRate \cdot v_i\f$
+ *
+ * @param ioWeights The weightnings to update.
+ * @param ioVelocities The velocity of each weightning.
+ * @param inGradients The gradient of each weightning.
+ * @param inNrOfElements The number of elements of all arrays.
+ * @param inGradientScale The factor of the gradients (e.g. 1 / batch size).
+ * @param inLearningRate The factor of the velocities.
+ * @param inMomentum The decay of the velocities.
+ */
+inline void stepMomentumF32(float* ioWeights, float* ioVelocities, const float* inGradients, std::size_t inNrOfElements,
+    float inGradientScale, float inLearningRate, float inMomentum)
+{
+    for (std::size_t i = 0; i < inNrOfElements; ++i)
+    {
+        const float velocity = inMomentum * ioVelocities[i] + inGradientScale * inGradients[i];
+        ioVelocities[i] = velocity;
+        ioWeights[i] -= inLearningRate * velocity;
+    }
+}
+
+/*!
+ * @brief The update step of Adam:
+ * \f$m_i \leftarrow \beta_1 m_i + (1 - \beta_1) g_i\f$,
+ * \f$v_i \leftarrow \beta_2 v_i + (1 - \beta_2) g_i^2\f$,
+ * \f$w_i \leftarrow w_i - inStepSize \cdot \frac{m_i}{\sqrt{v_i} + \epsilon}\f$
+ * with \f$g_i = inGradientScale \cdot inGradients_i\f$.
+ *
+ * @param ioWeights The weightnings to update.
+ * @param ioFirstMoments The first moment of each weightning.
+ * @param ioSecondMoments The second moment of each weightning.
+ * @param inGradients The gradient of each weightning.
+ * @param inNrOfElements The number of elements of all arrays.
+ * @param inGradientScale The factor of the gradients (e.g. 1 / batch size).
+ * @param inStepSize The learning rate including the bias correction of
+ *     the moments.
+ * @param inBeta1 The decay \f$\beta_1\f$ of the first moments.
+ * @param inBeta2 The decay \f$\beta_2\f$ of the second moments.
+ * @param inEpsilon The \f$\epsilon\f$ that prevents a division by 0.
+ */
+inline void stepAdamF32(float* ioWeights, float* ioFirstMoments, float* ioSecondMoments, const float* inGradients,
+    std::size_t inNrOfElements, float inGradientScale, float inStepSize, float inBeta1, float inBeta2, float inEpsilon)
+{
+    for (std::size_t i = 0; i < inNrOfElements; ++i)
+    {
+        const float gradient = inGradientScale * inGradients[i];
+        const float firstMoment = inBeta1 * ioFirstMoments[i] + (1.f - inBeta1) * gradient;
+        const float secondMoment = inBeta2 * ioSecondMoments[i] + (1.f - inBeta2) * gradient * gradient;
+        ioFirstMoments[i] = firstMoment;
+        ioSecondMoments[i] = secondMoment;
+        ioWeights[i] -= inStepSize * firstMoment / (std::sqrt(secondMoment) + inEpsilon);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Panel matrices (see utils/src/MathKernels.cpp)
+// --------------------------------------------------------------------------
+/*!
+ * @brief The number of rows of a matrix that are interleaved into a panel.
+ *
+ * A matrix of \p R rows and \p C columns is stored as \f$\lceil R / kPanelSize \rceil\f$
+ * panels. Panel \p p holds the rows \f$p \cdot kPanelSize\f$ ... \f$(p+1) \cdot kPanelSize - 1\f$
+ * column by column: Element (r, c) is at index \f$c \cdot kPanelSize + r \bmod kPanelSize\f$
+ * of its panel. The rows that exceed the matrix are 0. So the kernels read the
+ * weightnings of a panel strictly sequential and calculate kPanelSize rows at once.
+ */
+constexpr std::size_t kPanelSize = 8;
+
+/*!
+ * @brief The number of floats needed to store a matrix as panels.
+ * @param inNrOfRows The number of rows of the matrix.
+ * @param inNrOfColumns The number of columns of the matrix.
+ */
+inline std::size_t panelMatrixSize(std::size_t inNrOfRows, std::size_t inNrOfColumns)
+{
+    return (inNrOfRows + kPanelSize - 1) / kPanelSize * kPanelSize * inNrOfColumns;
+}
+
+/*!
+ * @brief Packs the rows of a matrix into panels.
+ * @param inRows \p inNrOfRows pointers to the \p inNrOfColumns values of each row.
+ * @param inNrOfRows The number of rows.
+ * @param inNrOfColumns The number of columns.
+ * @param outPanels Receives panelMatrixSize() floats.
+ */
+void packPanelsF32(const float* const* inRows, std::size_t inNrOfRows, std::size_t inNrOfColumns, float* outPanels);
+
+/*!
+ * @brief Copies a single row out of a panel matrix.
+ * @param inPanels The panel matrix (see packPanelsF32()).
+ * @param inNrOfColumns The number of columns.
+ * @param inRowIndex The index of the row.
+ * @param outRow Receives the \p inNrOfColumns values of the row.
+ */
+void unpackPanelRowF32(const float* inPanels, std::size_t inNrOfColumns, std::size_t inRowIndex, float* outRow);
+
+/*!
+ * @brief Multiplies a panel matrix by a vector: \f$out_r = \sum_{c} M_{r,c} \cdot inVector_c\f$
+ *
+ * Every row is summed up in the order of its columns, so the results are
+ * identical to calcDotF32() of each row and \p inVector (offset 0).
+ *
+ * @param inPanels The panel matrix (see packPanelsF32()).
+ * @param inNrOfRows The number of rows.
+ * @param inNrOfColumns The number of columns.
+ * @param inVector The \p inNrOfColumns values to multiply by.
+ * @param outVector Receives the \p inNrOfRows results.
+ */
+void calcPanelGemvF32(const float* inPanels, std::size_t inNrOfRows, std::size_t inNrOfColumns,
+    const float* inVector, float* outVector);
+
+/*!
+ * @brief Multiplies a panel matrix by a batch of vectors:
+ * \f$out_{s,r} = \sum_{c} M_{r,c} \cdot in_{s,c}\f$ for every sample \p s.
+ *
+ * The calculation is blocked for the caches: A slice of the columns of a panel
+ * stays in the L1 cache while it is applied to a block of samples that stays in
+ * the L2 cache. A register tile calculates a whole panel for several samples at
+ * once. The results are identical to calcPanelGemvF32() of every sample.
+ *
+ * @param inPanels The panel matrix (see packPanelsF32()).
+ * @param inNrOfRows The number of rows.
+ * @param inNrOfColumns The number of columns.
+ * @param inSamples The samples: \p inNrOfSamples rows of (at least) \p inNrOfColumns values.
+ * @param inNrOfSamples The number of samples.
+ * @param inSampleStride The distance of the samples within \p inSamples (in floats).
+ * @param outResults Receives \p inNrOfSamples rows of \p inNrOfRows results.
+ * @param inResultStride The distance of the results of the samples (in floats).
+ */
+void calcPanelGemmF32(const float* inPanels, std::size_t inNrOfRows, std::size_t inNrOfColumns,
+    const float* inSamples, std::size_t inNrOfSamples, std::size_t inSampleStride,
+    float* outResults, std::size_t inResultStride);
+} // namespace kernels
+} // namespace utils
@@ -1,5 +1,5 @@
 /* ==========================================================================
- * @(#)File: utils/src/CClassicMathDriver.cpp.cpp
+ * @(#)File: utils/src/CMappedFile.cpp
  * --------------------------------------------------------------------------
  *  (c)1982-2025 Tangerine-Software
  *
@@ -40,62 +40,105 @@
  *   this program under different conditions or license agreements.
  *
  * ========================================================================== */
-// ==========================================================================
-// Includes
-// ==========================================================================
-#include "utils/include/CClassicMathDriver.hpp"
+#include "utils/include/CMappedFile.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+namespace utils {
 // ==========================================================================
-// Macros
+// class CMappedFile - public
 // ==========================================================================
+CMappedFile::~CMappedFile()
+{
+    close();
+}
 
-// ==========================================================================
-// Typedefs
-// ==========================================================================
+bool CMappedFile::open(const char* inPath)
+{
+    close();
 
-// ==========================================================================
-// Local Functions
-// ==========================================================================
+    const int fd = ::open(inPath, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
 
-namespace utils {
-// ==========================================================================
-// class CClassicMathDriver : public CMath::IMathDriver
-// ==========================================================================
-float CClassicMathDriver::calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset) const
-{
-    float res = 0;
-    assert(inVectorA.size() == inVectorB.size());
-    if (inVectorA.size() == inVectorB.size())
+    struct stat fileStat;
+    if (0 != fstat(fd, &fileStat))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(fileStat.st_size);
+    if (0 != size)
     {
-        res = offset;
-        for (size_t i=0; i < inVectorA.size(); ++i)
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data)
         {
-            res += inVectorA[i] * inVectorB[i];
+            ::close(fd);
+            return false;
         }
+        madvise(data, size, MADV_SEQUENTIAL);
+        m_Data = static_cast<const char*>(data);
     }
-    return res;
+
+    m_FileDescriptor = fd;
+    m_Size = size;
+    m_ReleasedSize = 0;
+    return true;
 }
 
-float CClassicMathDriver::sumUpF32(const CVectorF32& inVector) const
+void CMappedFile::close()
 {
-    float sum = 0.f;
-    for (unsigned int i=0; i != inVector.size(); ++i)
+    if (m_Data)
     {
-        sum += inVector[i];
+        munmap(const_cast<char*>(m_Data), m_Size);
+        m_Data = nullptr;
     }
-    return sum;
+
+    if (m_FileDescriptor >= 0)
+    {
+        ::close(m_FileDescriptor);
+        m_FileDescriptor = -1;
+    }
+    m_Size = 0;
+    m_ReleasedSize = 0;
 }
 
-float CClassicMathDriver::sumUpF32(const CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const
+bool CMappedFile::isOpen() const
 {
-    float sum = 0.f;
+    return m_FileDescriptor >= 0;
+}
 
-    inNrOfElements = std::min<unsigned int>(inIndexOfFirstElement + inNrOfElements, static_cast<unsigned int>(inVector.size()));
-    for (unsigned int i = inIndexOfFirstElement; i != inNrOfElements; ++i)
+const char* CMappedFile::data() const
+{
+    return m_Data;
+}
+
+size_t CMappedFile::size() const
+{
+    return m_Size;
+}
+
+void CMappedFile::release(size_t inOffset)
+{
+    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    // Only whole pages may be released.
+    const size_t releaseSize = (inOffset < m_Size ? inOffset : m_Size) / kPageSize * kPageSize;
+    if (releaseSize < m_ReleasedSize)
+    {
+        // The reader restarted in front of the released pages.
+        m_ReleasedSize = releaseSize;
+    }
+    else if (m_Data && (releaseSize > m_ReleasedSize))
     {
-        sum += inVector[i];
+        madvise(const_cast<char*>(m_Data) + m_ReleasedSize, releaseSize - m_ReleasedSize, MADV_DONTNEED);
+        m_ReleasedSize = releaseSize;
     }
-    return sum;
 }
 
 } // namespace utils
@@ -45,6 +45,9 @@
 // ==========================================================================
 #include "utils/include/CMath.hpp"
 #include "utils/include/CClassicMathDriver.hpp"
+#include "utils/include/MathKernels.hpp"
+#include "utils/include/CRandom.hpp"
+#include <atomic>
 
 // ==========================================================================
 // Macros
@@ -58,11 +61,6 @@
 // Local Functions
 // ==========================================================================
 
-static float _randF32()
-{
-    return float(rand()) / RAND_MAX;
-}
-
 namespace utils {
 
 static CClassicMathDriver classicMathDriver;
@@ -71,11 +69,45 @@ static CClassicMathDriver classicMathDriver;
 // class CMath - public, static
 // ==========================================================================
 CMath::CMath()
-: m_Driver(classicMathDriver)
+: CBasicMath<IMathDriver>(classicMathDriver)
 {}
 
 float CMath::randF32(float inMin, float inMax)
 {
-    return inMin + ((inMax - inMin) * _randF32());
+    // Every thread draws from a stream of its own. The seed differs from
+    // CRandom::kDefaultSeed, so these streams never equal the ones of the
+    // weightning init.
+    static constexpr std::uint64_t kSeed = ~CRandom::kDefaultSeed;
+    static std::atomic<std::uint64_t> nextStream(0);
+    thread_local CRandom random(kSeed, nextStream++);
+    return random.nextF32(inMin, inMax);
+}
+
+// ==========================================================================
+// class IMathDriver - default implementations
+// ==========================================================================
+float IMathDriver::calcSparseDotF32(const float* inValues, const unsigned int* inIndices, size_t inNrOfNonZeros,
+    const CVectorF32& inDenseVector, float offset) const
+{
+    return kernels::calcSparseDotF32(inValues, inIndices, inNrOfNonZeros, *inDenseVector, offset);
+}
+
+float IMathDriver::calcBlockSparseDotF32(const float* inBlockValues, const unsigned int* inBlockIndices, size_t inNrOfBlocks,
+    unsigned int inBlockSize, const CVectorF32& inDenseVector, float offset) const
+{
+    return kernels::calcBlockSparseDotF32(inBlockValues, inBlockIndices, inNrOfBlocks, inBlockSize, *inDenseVector, offset);
+}
+
+void IMathDriver::calcPanelGemvF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+    const float* inVector, float* outVector) const
+{
+    kernels::calcPanelGemvF32(inPanels, inNrOfRows, inNrOfColumns, inVector, outVector);
+}
+
+void IMathDriver::calcPanelGemmF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+    const float* inSamples, size_t inNrOfSamples, size_t inSampleStride,
+    float* outResults, size_t inResultStride) const
+{
+    kernels::calcPanelGemmF32(inPanels, inNrOfRows, inNrOfColumns, inSamples, inNrOfSamples, inSampleStride, outResults, inResultStride);
 }
 } // namespace utils
@@ -0,0 +1,340 @@
+/* ==========================================================================
+ * @(#)File: utils/src/CProfilingMathDriver.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "utils/include/CProfilingMathDriver.hpp"
+#include <cassert>
+#include <chrono>
+#include <new>
+#include <thread>
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+static std::uint64_t _nowNs()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static std::uint64_t _nextInstanceId()
+{
+    static std::atomic<std::uint64_t> instanceId{0};
+    return ++instanceId;
+}
+
+namespace utils {
+/*!
+ * @brief The counters of a single thread. Only the owning thread counts, so
+ * the (relaxed) atomics do not contend. The padding keeps the blocks of
+ * different threads off each others cache lines.
+ */
+struct CProfilingMathDriver::ThreadCounters
+{
+    explicit ThreadCounters(std::thread::id inOwner)
+    : owner(inOwner)
+    {}
+
+    const std::thread::id owner;
+
+    struct Counters
+    {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> nanoSeconds{0};
+        std::atomic<std::uint64_t> elements{0};
+        std::atomic<std::uint64_t> lengthHistogram[kNrOfLengthBuckets];
+
+        Counters()
+        {
+            for (std::atomic<std::uint64_t>& bucket : lengthHistogram)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    Counters methods[kNrOfMethods];
+    char padding[64];
+};
+
+static void _add(std::atomic<std::uint64_t>& inCounter, std::uint64_t inValue)
+{
+    // An atomic RMW, so that a concurrent reset() is not overwritten.
+    inCounter.fetch_add(inValue, std::memory_order_relaxed);
+}
+
+// ==========================================================================
+// class CProfilingMathDriver : public CMath::IMathDriver
+// ==========================================================================
+CProfilingMathDriver::CProfilingMathDriver(const CMath::IMathDriver& inDriver)
+: m_Driver(inDriver)
+, m_InstanceId(_nextInstanceId())
+{}
+
+CProfilingMathDriver::~CProfilingMathDriver() = default;
+
+float CProfilingMathDriver::calcDotF32(const CVectorF32& inVectorA, const CVectorF32& inVectorB, float offset) const
+{
+    const std::uint64_t start = _nowNs();
+    const float res = m_Driver.calcDotF32(inVectorA, inVectorB, offset);
+    _count(kCalcDotF32, inVectorA.size(), _nowNs() - start);
+    return res;
+}
+
+float CProfilingMathDriver::sumUpF32(const CVectorF32& inVector) const
+{
+    const std::uint64_t start = _nowNs();
+    const float res = m_Driver.sumUpF32(inVector);
+    _count(kSumUpF32, inVector.size(), _nowNs() - start);
+    return res;
+}
+
+float CProfilingMathDriver::sumUpF32(const CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const
+{
+    const std::uint64_t start = _nowNs();
+    const float res = m_Driver.sumUpF32(inVector, inIndexOfFirstElement, inNrOfElements);
+    _count(kSumUpF32Range, inNrOfElements, _nowNs() - start);
+    return res;
+}
+
+float CProfilingMathDriver::calcSparseDotF32(const float* inValues, const unsigned int* inIndices, size_t inNrOfNonZeros,
+    const CVectorF32& inDenseVector, float offset) const
+{
+    const std::uint64_t start = _nowNs();
+    const float res = m_Driver.calcSparseDotF32(inValues, inIndices, inNrOfNonZeros, inDenseVector, offset);
+    _count(kCalcSparseDotF32, inNrOfNonZeros, _nowNs() - start);
+    return res;
+}
+
+float CProfilingMathDriver::calcBlockSparseDotF32(const float* inBlockValues, const unsigned int* inBlockIndices, size_t inNrOfBlocks,
+    unsigned int inBlockSize, const CVectorF32& inDenseVector, float offset) const
+{
+    const std::uint64_t start = _nowNs();
+    const float res = m_Driver.calcBlockSparseDotF32(inBlockValues, inBlockIndices, inNrOfBlocks, inBlockSize, inDenseVector, offset);
+    _count(kCalcBlockSparseDotF32, inNrOfBlocks * inBlockSize, _nowNs() - start);
+    return res;
+}
+
+void CProfilingMathDriver::calcPanelGemvF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+    const float* inVector, float* outVector) const
+{
+    const std::uint64_t start = _nowNs();
+    m_Driver.calcPanelGemvF32(inPanels, inNrOfRows, inNrOfColumns, inVector, outVector);
+    _count(kCalcPanelGemvF32, inNrOfRows * inNrOfColumns, _nowNs() - start);
+}
+
+void CProfilingMathDriver::calcPanelGemmF32(const float* inPanels, size_t inNrOfRows, size_t inNrOfColumns,
+    const float* inSamples, size_t inNrOfSamples, size_t inSampleStride,
+    float* outResults, size_t inResultStride) const
+{
+    const std::uint64_t start = _nowNs();
+    m_Driver.calcPanelGemmF32(inPanels, inNrOfRows, inNrOfColumns, inSamples, inNrOfSamples, inSampleStride, outResults, inResultStride);
+    _count(kCalcPanelGemmF32, inNrOfRows * inNrOfColumns * inNrOfSamples, _nowNs() - start);
+}
+
+auto CProfilingMathDriver::statistics(Method inMethod) const -> MethodStatistics
+{
+    MethodStatistics stats;
+    if (inMethod < kNrOfMethods)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const std::unique_ptr<ThreadCounters>& thisThread : m_ThreadCounters)
+        {
+            const ThreadCounters::Counters& counters = thisThread->methods[inMethod];
+            stats.calls += counters.calls.load(std::memory_order_relaxed);
+            stats.nanoSeconds += counters.nanoSeconds.load(std::memory_order_relaxed);
+            stats.elements += counters.elements.load(std::memory_order_relaxed);
+            for (unsigned int i = 0; i < kNrOfLengthBuckets; ++i)
+            {
+                stats.lengthHistogram[i] += counters.lengthHistogram[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return stats;
+}
+
+void CProfilingMathDriver::reset()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (std::unique_ptr<ThreadCounters>& thisThread : m_ThreadCounters)
+    {
+        for (ThreadCounters::Counters& counters : thisThread->methods)
+        {
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.nanoSeconds.store(0, std::memory_order_relaxed);
+            counters.elements.store(0, std::memory_order_relaxed);
+            for (std::atomic<std::uint64_t>& bucket : counters.lengthHistogram)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void CProfilingMathDriver::report(std::FILE* inFile) const
+{
+    fprintf(inFile, "%-21s | %12s | %14s | %10s | %12s\n",
+        "Method", "Calls", "Elements", "Time [us]", "ns/call");
+    for (unsigned int m = 0; m < kNrOfMethods; ++m)
+    {
+        const MethodStatistics stats = statistics(static_cast<Method>(m));
+        fprintf(inFile, "%-21s | %12llu | %14llu | %10.1f | %12.1f\n",
+            methodName(static_cast<Method>(m)),
+            static_cast<unsigned long long>(stats.calls),
+            static_cast<unsigned long long>(stats.elements),
+            stats.nanoSeconds / 1e3,
+            stats.calls ? double(stats.nanoSeconds) / stats.calls : 0.);
+
+        for (unsigned int i = 0; i < kNrOfLengthBuckets; ++i)
+        {
+            if (stats.lengthHistogram[i])
+            {
+                fprintf(inFile, "%-21s   length %10llu..%-10llu: %llu\n", "",
+                    static_cast<unsigned long long>(lengthOfBucket(i)),
+                    static_cast<unsigned long long>(i ? 2 * lengthOfBucket(i) - 1 : 0),
+                    static_cast<unsigned long long>(stats.lengthHistogram[i]));
+            }
+        }
+    }
+}
+
+const char* CProfilingMathDriver::methodName(Method inMethod)
+{
+    switch (inMethod)
+    {
+        case kCalcDotF32:            return "calcDotF32";
+        case kSumUpF32:              return "sumUpF32";
+        case kSumUpF32Range:         return "sumUpF32Range";
+        case kCalcSparseDotF32:      return "calcSparseDotF32";
+        case kCalcBlockSparseDotF32: return "calcBlockSparseDotF32";
+        case kCalcPanelGemvF32:      return "calcPanelGemvF32";
+        case kCalcPanelGemmF32:      return "calcPanelGemmF32";
+        default:                     return "?";
+    }
+}
+
+unsigned int CProfilingMathDriver::bucketOfLength(std::uint64_t inLength)
+{
+    unsigned int bucket = 0;
+    for (; inLength && (bucket < kNrOfLengthBuckets - 1); inLength >>= 1)
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::uint64_t CProfilingMathDriver::lengthOfBucket(unsigned int inBucket)
+{
+    return inBucket ? (std::uint64_t(1) << (inBucket - 1)) : 0;
+}
+
+// ==========================================================================
+// class CProfilingMathDriver - private
+// ==========================================================================
+auto CProfilingMathDriver::_threadCounters() const -> ThreadCounters*
+{
+    // Every thread caches the counters of the drivers it used last, so a
+    // thread that alternates between a few drivers (e.g. nested ones) does
+    // not lock. The instance id (rather than the address) makes sure that a
+    // new driver never picks up the counters of a destroyed one.
+    struct CacheEntry
+    {
+        std::uint64_t instanceId;
+        ThreadCounters* counters;
+    };
+    constexpr unsigned int kCacheSize = 8;
+    thread_local CacheEntry tlsCache[kCacheSize] = {};
+    thread_local unsigned int tlsNextEntry = 0;
+    for (const CacheEntry& thisEntry : tlsCache)
+    {
+        if (thisEntry.instanceId == m_InstanceId)
+        {
+            return thisEntry.counters;
+        }
+    }
+
+    const std::thread::id thisThread = std::this_thread::get_id();
+    ThreadCounters* counters = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const std::unique_ptr<ThreadCounters>& thisCounters : m_ThreadCounters)
+        {
+            if (thisCounters->owner == thisThread)
+            {
+                counters = thisCounters.get();
+                break;
+            }
+        }
+
+        if (nullptr == counters)
+        {
+            counters = new(std::nothrow) ThreadCounters(thisThread);
+            assert(counters);
+            if (nullptr == counters)
+            {
+                return nullptr;
+            }
+            m_ThreadCounters.emplace_back(counters);
+        }
+    }
+
+    // The oldest entry makes room.
+    tlsCache[tlsNextEntry] = {m_InstanceId, counters};
+    tlsNextEntry = (tlsNextEntry + 1) % kCacheSize;
+    return counters;
+}
+
+void CProfilingMathDriver::_count(Method inMethod, std::uint64_t inLength, std::uint64_t inNanoSeconds) const
+{
+    ThreadCounters* threadCounters = _threadCounters();
+    if (threadCounters)
+    {
+        ThreadCounters::Counters& counters = threadCounters->methods[inMethod];
+        _add(counters.calls, 1);
+        _add(counters.nanoSeconds, inNanoSeconds);
+        _add(counters.elements, inLength);
+        _add(counters.lengthHistogram[bucketOfLength(inLength)], 1);
+    }
+}
+} // namespace utils
@@ -0,0 +1,246 @@
+/* ==========================================================================
+ * @(#)File: utils/src/CRandom.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "utils/include/CRandom.hpp"
+#include <algorithm>
+#include <cmath>
+
+// ==========================================================================
+// Local Constants
+// ==========================================================================
+/// @brief The multipliers and key increments of Philox4x32 (see Salmon et al.,
+/// "Parallel random numbers: as easy as 1, 2, 3", SC'11).
+static constexpr std::uint32_t kPhiloxM0 = 0xD2511F53u;
+static constexpr std::uint32_t kPhiloxM1 = 0xCD9E8D57u;
+static constexpr std::uint32_t kPhiloxW0 = 0x9E3779B9u;
+static constexpr std::uint32_t kPhiloxW1 = 0xBB67AE85u;
+static constexpr unsigned int kPhiloxRounds = 10;
+
+/// @brief The numbers that are converted at once by the fill methods (even for fillNormalF32()).
+static constexpr std::size_t kChunkSize = 256;
+
+/// @brief 2^-24: Scales the upper 24 bits of a number to [0 ... 1).
+static constexpr float kUnitScale = 1.f / 16777216.f;
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+/*!
+ * @brief Calculates a single block of Philox4x32-10.
+ * @param inCounter The 128 bit counter.
+ * @param inKey The 64 bit key.
+ * @param outBlock Receives the 4 numbers.
+ */
+static inline void _philoxBlock(const std::uint32_t inCounter[4], const std::uint32_t inKey[2], std::uint32_t* outBlock)
+{
+    std::uint32_t c0 = inCounter[0];
+    std::uint32_t c1 = inCounter[1];
+    std::uint32_t c2 = inCounter[2];
+    std::uint32_t c3 = inCounter[3];
+    std::uint32_t k0 = inKey[0];
+    std::uint32_t k1 = inKey[1];
+
+    for (unsigned int round = 0; round < kPhiloxRounds; ++round)
+    {
+        const std::uint64_t product0 = std::uint64_t(kPhiloxM0) * c0;
+        const std::uint64_t product1 = std::uint64_t(kPhiloxM1) * c2;
+        c0 = std::uint32_t(product1 >> 32) ^ c1 ^ k0;
+        c1 = std::uint32_t(product1);
+        c2 = std::uint32_t(product0 >> 32) ^ c3 ^ k1;
+        c3 = std::uint32_t(product0);
+        k0 += kPhiloxW0;
+        k1 += kPhiloxW1;
+    }
+
+    outBlock[0] = c0;
+    outBlock[1] = c1;
+    outBlock[2] = c2;
+    outBlock[3] = c3;
+}
+
+namespace utils {
+// ==========================================================================
+// class CRandom - public
+// ==========================================================================
+CRandom::CRandom(std::uint64_t inSeed, std::uint64_t inStream)
+: m_Seed(inSeed)
+, m_Stream(inStream)
+{}
+
+std::uint64_t CRandom::seed() const
+{
+    return m_Seed;
+}
+
+std::uint64_t CRandom::stream() const
+{
+    return m_Stream;
+}
+
+std::uint64_t CRandom::position() const
+{
+    return m_Position;
+}
+
+void CRandom::seek(std::uint64_t inPosition)
+{
+    m_Position = inPosition;
+}
+
+std::uint32_t CRandom::nextU32()
+{
+    const std::uint64_t blockPosition = m_Position & ~3ull;
+    if (blockPosition != m_BlockPosition)
+    {
+        _fillU32(blockPosition, m_Block, 4);
+        m_BlockPosition = blockPosition;
+    }
+    return m_Block[m_Position++ & 3];
+}
+
+float CRandom::nextF32(float inMin, float inMax)
+{
+    return inMin + (inMax - inMin) * (float(nextU32() >> 8) * kUnitScale);
+}
+
+void CRandom::fillUniformF32(std::uint64_t inPosition, float* outValues, std::size_t inNrOfValues,
+    float inMin, float inMax) const
+{
+    const float scale = (inMax - inMin) * kUnitScale;
+    std::uint32_t bits[kChunkSize];
+    for (std::size_t first = 0; first < inNrOfValues; first += kChunkSize)
+    {
+        const std::size_t nrOfValues = std::min(kChunkSize, inNrOfValues - first);
+        _fillU32(inPosition + first, bits, nrOfValues);
+        for (std::size_t i = 0; i < nrOfValues; ++i)
+        {
+            outValues[first + i] = inMin + float(bits[i] >> 8) * scale;
+        }
+    }
+}
+
+void CRandom::fillNormalF32(std::uint64_t inPosition, float* outValues, std::size_t inNrOfValues,
+    float inMean, float inStdDeviation) const
+{
+    static constexpr float kTwoPi = 6.28318530717958647692f;
+
+    std::uint32_t bits[kChunkSize];
+    std::uint64_t position = inPosition;
+    const std::uint64_t endPosition = inPosition + inNrOfValues;
+    while (position < endPosition)
+    {
+        // Whole pairs only. So the pair of the first and the last number is complete.
+        const std::uint64_t firstPosition = position & ~1ull;
+        const std::uint64_t lastPosition = std::min<std::uint64_t>(firstPosition + kChunkSize, (endPosition + 1) & ~1ull);
+        _fillU32(firstPosition, bits, lastPosition - firstPosition);
+
+        for (std::uint64_t pairPosition = firstPosition; pairPosition < lastPosition; pairPosition += 2)
+        {
+            const std::uint32_t* pair = bits + (pairPosition - firstPosition);
+            const float u1 = float((pair[0] >> 8) + 1) * kUnitScale; // (0 ... 1]
+            const float u2 = float(pair[1] >> 8) * kUnitScale;
+            const float radius = inStdDeviation * std::sqrt(-2.f * std::log(u1));
+
+            if ((pairPosition >= inPosition) && (pairPosition < endPosition))
+            {
+                outValues[pairPosition - inPosition] = inMean + radius * std::cos(kTwoPi * u2);
+            }
+            if (pairPosition + 1 < endPosition)
+            {
+                outValues[pairPosition + 1 - inPosition] = inMean + radius * std::sin(kTwoPi * u2);
+            }
+        }
+        position = lastPosition;
+    }
+}
+
+// ==========================================================================
+// class CRandom - private
+// ==========================================================================
+void CRandom::_fillU32(std::uint64_t inPosition, std::uint32_t* outValues, std::size_t inNrOfValues) const
+{
+    const std::uint32_t key[2] = {std::uint32_t(m_Seed), std::uint32_t(m_Seed >> 32)};
+    std::uint32_t counter[4] = {0, 0, std::uint32_t(m_Stream), std::uint32_t(m_Stream >> 32)};
+
+    std::uint64_t block = inPosition / 4;
+    std::size_t index = 0;
+
+    // A partial block at the beginning
+    const unsigned int skip = static_cast<unsigned int>(inPosition % 4);
+    if ((0 != skip) && (inNrOfValues > 0))
+    {
+        std::uint32_t values[4];
+        counter[0] = std::uint32_t(block);
+        counter[1] = std::uint32_t(block >> 32);
+        _philoxBlock(counter, key, values);
+        for (unsigned int i = skip; (i < 4) && (index < inNrOfValues); ++i)
+        {
+            outValues[index++] = values[i];
+        }
+        ++block;
+    }
+
+    // The whole blocks do not depend on each other.
+    for (; index + 4 <= inNrOfValues; index += 4, ++block)
+    {
+        counter[0] = std::uint32_t(block);
+        counter[1] = std::uint32_t(block >> 32);
+        _philoxBlock(counter, key, outValues + index);
+    }
+
+    // A partial block at the end
+    if (index < inNrOfValues)
+    {
+        std::uint32_t values[4];
+        counter[0] = std::uint32_t(block);
+        counter[1] = std::uint32_t(block >> 32);
+        _philoxBlock(counter, key, values);
+        for (unsigned int i = 0; index < inNrOfValues; ++i)
+        {
+            outValues[index++] = values[i];
+        }
+    }
+}
+} // namespace utils
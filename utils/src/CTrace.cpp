@@ -0,0 +1,262 @@
+/* ==========================================================================
+ * @(#)File: utils/src/CTrace.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "utils/include/CTrace.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// ==========================================================================
+// Typedefs
+// ==========================================================================
+namespace {
+/*!
+ * @brief The ring buffer of a single thread. Only the owning thread writes
+ * to it. The readers (writeChromeTrace(), clear()) synchronize by #head.
+ */
+struct ThreadBuffer
+{
+    static constexpr std::uint64_t kMask = utils::CTrace::kEventsPerThread - 1;
+    static_assert(0 == (utils::CTrace::kEventsPerThread & kMask), "kEventsPerThread must be a power of 2");
+
+    unsigned int threadIndex = 0;
+    std::atomic<std::uint64_t> head{0};  ///< Total nr of events ever written
+    std::atomic<std::uint64_t> begun{0}; ///< Total nr of events whose writing has begun
+    std::atomic<std::uint64_t> first{0}; ///< Index of the first event since clear()
+    std::atomic<bool> hasExited{false};  ///< The owning thread has exited
+    utils::CTrace::Event events[utils::CTrace::kEventsPerThread];
+};
+
+using ThreadBufferPtr = std::shared_ptr<ThreadBuffer>;
+
+/*!
+ * @brief The reference of a thread to its buffer. It marks the buffer once
+ * the thread exits, so that the buffer may be reclaimed.
+ */
+struct ThreadBufferOwner
+{
+    ThreadBufferPtr buffer;
+
+    ~ThreadBufferOwner()
+    {
+        if (buffer)
+        {
+            buffer->hasExited.store(true, std::memory_order_release);
+        }
+    }
+};
+} // namespace
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+static std::mutex& _registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<ThreadBufferPtr>& _registry()
+{
+    static std::vector<ThreadBufferPtr> registry;
+    return registry;
+}
+
+static const std::uint64_t s_EpochNs = utils::CTrace::nowNs();
+
+/*!
+ * @brief Drops the buffers of exited threads whose events have been written
+ * or cleared. Of the exited threads with pending events only the newest
+ * CTrace::kMaxExitedThreads are kept. The registry mutex must be held.
+ * @param inAreEventsFlushed true if all events have just been written.
+ */
+static void _reclaimBuffers(bool inAreEventsFlushed)
+{
+    std::vector<ThreadBufferPtr>& registry = _registry();
+    unsigned int nrOfExitedThreads = 0;
+    for (size_t i = registry.size(); i-- > 0; )
+    {
+        ThreadBuffer& buffer = *registry[i];
+        if (buffer.hasExited.load(std::memory_order_acquire))
+        {
+            const bool isFlushed = inAreEventsFlushed
+                || (buffer.first.load(std::memory_order_relaxed) == buffer.head.load(std::memory_order_relaxed));
+            if (isFlushed || (++nrOfExitedThreads > utils::CTrace::kMaxExitedThreads))
+            {
+                registry.erase(registry.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Returns the ring buffer of the calling thread and registers a new
+ * one upon the first call of a thread. The registry keeps the buffer alive
+ * beyond the threads lifetime so that its events can still be written.
+ */
+static ThreadBuffer* _threadBuffer()
+{
+    static unsigned int nextThreadIndex = 0;
+    thread_local ThreadBufferOwner tlsOwner;
+    if (!tlsOwner.buffer)
+    {
+        ThreadBufferPtr newBuffer(new(std::nothrow) ThreadBuffer());
+        if (newBuffer)
+        {
+            std::lock_guard<std::mutex> lock(_registryMutex());
+            _reclaimBuffers(false);
+            newBuffer->threadIndex = nextThreadIndex++;
+            _registry().push_back(newBuffer);
+            tlsOwner.buffer = newBuffer;
+        }
+    }
+    return tlsOwner.buffer.get();
+}
+
+static const char* _categoryName(std::uint32_t inCategory)
+{
+    switch (inCategory)
+    {
+        case utils::CTrace::kNet:    return "net";
+        case utils::CTrace::kLayer:  return "layer";
+        case utils::CTrace::kDriver: return "driver";
+        case utils::CTrace::kTask:   return "task";
+        default:                     return "misc";
+    }
+}
+
+namespace utils {
+std::atomic<std::uint32_t> CTrace::s_EnabledCategories{CTrace::kNone};
+
+// ==========================================================================
+// class CTrace - public, static
+// ==========================================================================
+void CTrace::enable(std::uint32_t inCategories)
+{
+    s_EnabledCategories.store(inCategories, std::memory_order_relaxed);
+}
+
+void CTrace::record(const char* inName, std::uint32_t inCategory, std::int64_t inArg,
+                    std::uint64_t inStartNs, std::uint64_t inEndNs)
+{
+    ThreadBuffer* buffer = _threadBuffer();
+    if (buffer)
+    {
+        const std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        buffer->begun.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Event& event = buffer->events[head & ThreadBuffer::kMask];
+        event.name = inName;
+        event.category = inCategory;
+        event.arg = inArg;
+        event.startNs = inStartNs;
+        event.durationNs = inEndNs - inStartNs;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+}
+
+unsigned int CTrace::writeChromeTrace(std::FILE* inFile)
+{
+    unsigned int nrOfEvents = 0;
+
+    std::lock_guard<std::mutex> lock(_registryMutex());
+    fprintf(inFile, "{\"traceEvents\":[");
+    for (const ThreadBufferPtr& buffer : _registry())
+    {
+        const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const std::uint64_t oldest = head > kEventsPerThread ? head - kEventsPerThread : 0;
+        const std::uint64_t first = std::max(oldest, buffer->first.load(std::memory_order_relaxed));
+
+        for (std::uint64_t i = first; i < head; ++i)
+        {
+            const Event event = buffer->events[i & ThreadBuffer::kMask];
+
+            // Skip the event if its slot has been reused while copying it.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (buffer->begun.load(std::memory_order_relaxed) > i + kEventsPerThread)
+            {
+                continue;
+            }
+
+            fprintf(inFile,
+                "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"arg\":%lld}}",
+                nrOfEvents ? "," : "",
+                event.name, _categoryName(event.category), buffer->threadIndex,
+                (event.startNs - s_EpochNs) / 1e3, event.durationNs / 1e3,
+                static_cast<long long>(event.arg));
+            ++nrOfEvents;
+        }
+    }
+    fprintf(inFile, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    _reclaimBuffers(true);
+    return nrOfEvents;
+}
+
+bool CTrace::writeChromeTrace(const char* inPath)
+{
+    bool success = false;
+    std::FILE* file = fopen(inPath, "w");
+    if (file)
+    {
+        writeChromeTrace(file);
+        success = (0 == fclose(file));
+    }
+    return success;
+}
+
+void CTrace::clear()
+{
+    std::lock_guard<std::mutex> lock(_registryMutex());
+    for (const ThreadBufferPtr& buffer : _registry())
+    {
+        buffer->first.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+    _reclaimBuffers(true);
+}
+} // namespace utils
@@ -0,0 +1,219 @@
+/* ==========================================================================
+ * @(#)File: utils/src/MathKernels.cpp
+ * --------------------------------------------------------------------------
+ *  (c)1982-2025 Tangerine-Software
+ *
+ *       Hans-Peter Beständig
+ *       Kühbachstr. 8
+ *       81543 München
+ *       GERMANY
+ *
+ *       mailto:hdusel@tangerine-soft.de
+ *       http://hdusel.tangerine-soft.de
+ * --------------------------------------------------------------------------
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to
+ *
+ *       Free Software Foundation, Inc.
+ *       59 Temple Place - Suite 330
+ *       Boston, MA  02111-1307, USA
+ *
+ *   Notice, that ``free software'' addresses the fact that this program
+ *   is __distributed__ under the term of the GNU General Public License
+ *   and because of this, it can be redistributed and modified under the
+ *   conditions of this license, but the software remains __copyrighted__
+ *   by the author. Don't intermix this with the general meaning of
+ *   Public Domain software or such a derivated distribution label.
+ *
+ *   The author reserves the right to distribute following releases of
+ *   this program under different conditions or license agreements.
+ *
+ * ========================================================================== */
+// ==========================================================================
+// Includes
+// ==========================================================================
+#include "utils/include/MathKernels.hpp"
+#include <algorithm>
+#include <cstring>
+
+// ==========================================================================
+// Local Constants
+// ==========================================================================
+/// @brief The number of samples of a register tile.
+static constexpr std::size_t kTileSamples = 4;
+
+/// @brief The columns of a panel slice (8 KB) that stays in the L1 cache.
+static constexpr std::size_t kBlockColumns = 256;
+
+/// @brief The samples of a block (64 KB at most) that stays in the L2 cache.
+static constexpr std::size_t kBlockSamples = 64;
+
+// ==========================================================================
+// Local Functions
+// ==========================================================================
+/*!
+ * @brief The register tile: Calculates a panel slice for kTileSamples samples.
+ *
+ * @param inPanel The first column of the slice within the panel.
+ * @param inNrOfColumns The number of columns of the slice.
+ * @param inSamples The first column of the slice within the first sample.
+ * @param inSampleStride The distance of the samples.
+ * @param ioResults The first result of the panel within the first sample.
+ * @param inResultStride The distance of the results of the samples.
+ * @param inNrOfRows The number of valid rows of the panel.
+ * @param inIsFirstSlice false to continue the sums of the previous slices.
+ */
+static void _panelTile(const float* inPanel, std::size_t inNrOfColumns,
+    const float* inSamples, std::size_t inSampleStride,
+    float* ioResults, std::size_t inResultStride, std::size_t inNrOfRows, bool inIsFirstSlice)
+{
+    using utils::kernels::kPanelSize;
+
+    float sums[kTileSamples][kPanelSize] = {};
+    if (!inIsFirstSlice)
+    {
+        for (std::size_t s = 0; s < kTileSamples; ++s)
+        {
+            memcpy(sums[s], ioResults + s * inResultStride, inNrOfRows * sizeof(float));
+        }
+    }
+
+    const float* samples[kTileSamples];
+    for (std::size_t s = 0; s < kTileSamples; ++s)
+    {
+        samples[s] = inSamples + s * inSampleStride;
+    }
+
+    for (std::size_t c = 0; c < inNrOfColumns; ++c)
+    {
+        const float* column = inPanel + c * kPanelSize;
+        for (std::size_t s = 0; s < kTileSamples; ++s)
+        {
+            const float value = samples[s][c];
+            for (std::size_t r = 0; r < kPanelSize; ++r)
+            {
+                sums[s][r] += column[r] * value;
+            }
+        }
+    }
+
+    for (std::size_t s = 0; s < kTileSamples; ++s)
+    {
+        memcpy(ioResults + s * inResultStride, sums[s], inNrOfRows * sizeof(float));
+    }
+}
+
+/*!
+ * @brief Like _panelTile() for a single sample.
+ */
+static void _panelColumnSlice(const float* inPanel, std::size_t inNrOfColumns, const float* inSample,
+    float* ioResults, std::size_t inNrOfRows, bool inIsFirstSlice)
+{
+    using utils::kernels::kPanelSize;
+
+    float sums[kPanelSize] = {};
+    if (!inIsFirstSlice)
+    {
+        memcpy(sums, ioResults, inNrOfRows * sizeof(float));
+    }
+
+    for (std::size_t c = 0; c < inNrOfColumns; ++c)
+    {
+        const float* column = inPanel + c * kPanelSize;
+        const float value = inSample[c];
+        for (std::size_t r = 0; r < kPanelSize; ++r)
+        {
+            sums[r] += column[r] * value;
+        }
+    }
+    memcpy(ioResults, sums, inNrOfRows * sizeof(float));
+}
+
+namespace utils {
+namespace kernels {
+// ==========================================================================
+// Panel matrices
+// ==========================================================================
+void packPanelsF32(const float* const* inRows, std::size_t inNrOfRows, std::size_t inNrOfColumns, float* outPanels)
+{
+    const std::size_t nrOfPanels = (inNrOfRows + kPanelSize - 1) / kPanelSize;
+    for (std::size_t p = 0; p < nrOfPanels; ++p)
+    {
+        float* panel = outPanels + p * kPanelSize * inNrOfColumns;
+        for (std::size_t r = 0; r < kPanelSize; ++r)
+        {
+            const std::size_t rowIndex = p * kPanelSize + r;
+            for (std::size_t c = 0; c < inNrOfColumns; ++c)
+            {
+                panel[c * kPanelSize + r] = (rowIndex < inNrOfRows) ? inRows[rowIndex][c] : 0.f;
+            }
+        }
+    }
+}
+
+void unpackPanelRowF32(const float* inPanels, std::size_t inNrOfColumns, std::size_t inRowIndex, float* outRow)
+{
+    const float* panel = inPanels + inRowIndex / kPanelSize * kPanelSize * inNrOfColumns + inRowIndex % kPanelSize;
+    for (std::size_t c = 0; c < inNrOfColumns; ++c)
+    {
+        outRow[c] = panel[c * kPanelSize];
+    }
+}
+
+void calcPanelGemvF32(const float* inPanels, std::size_t inNrOfRows, std::size_t inNrOfColumns,
+    const float* inVector, float* outVector)
+{
+    // The weightnings are read just once. So there is nothing to block.
+    for (std::size_t firstRow = 0; firstRow < inNrOfRows; firstRow += kPanelSize)
+    {
+        _panelColumnSlice(inPanels + firstRow * inNrOfColumns, inNrOfColumns, inVector,
+                          outVector + firstRow, std::min(kPanelSize, inNrOfRows - firstRow), true);
+    }
+}
+
+void calcPanelGemmF32(const float* inPanels, std::size_t inNrOfRows, std::size_t inNrOfColumns,
+    const float* inSamples, std::size_t inNrOfSamples, std::size_t inSampleStride,
+    float* outResults, std::size_t inResultStride)
+{
+    for (std::size_t firstColumn = 0; firstColumn < inNrOfColumns; firstColumn += kBlockColumns)
+    {
+        const std::size_t nrOfColumns = std::min(kBlockColumns, inNrOfColumns - firstColumn);
+        const bool isFirstSlice = (0 == firstColumn);
+
+        for (std::size_t firstSample = 0; firstSample < inNrOfSamples; firstSample += kBlockSamples)
+        {
+            const std::size_t endSample = std::min(firstSample + kBlockSamples, inNrOfSamples);
+
+            for (std::size_t firstRow = 0; firstRow < inNrOfRows; firstRow += kPanelSize)
+            {
+                const float* slice = inPanels + firstRow * inNrOfColumns + firstColumn * kPanelSize;
+                const std::size_t nrOfRows = std::min(kPanelSize, inNrOfRows - firstRow);
+
+                std::size_t s = firstSample;
+                for (; s + kTileSamples <= endSample; s += kTileSamples)
+                {
+                    _panelTile(slice, nrOfColumns, inSamples + s * inSampleStride + firstColumn, inSampleStride,
+                               outResults + s * inResultStride + firstRow, inResultStride, nrOfRows, isFirstSlice);
+                }
+                for (; s < endSample; ++s)
+                {
+                    _panelColumnSlice(slice, nrOfColumns, inSamples + s * inSampleStride + firstColumn,
+                                      outResults + s * inResultStride + firstRow, nrOfRows, isFirstSlice);
+                }
+            }
+        }
+    }
+}
+} // namespace kernels
+} // namespace utils
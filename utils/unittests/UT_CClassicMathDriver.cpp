@@ -10,3 +10,23 @@
 TSUNIT_TEST(utils_CClassicMathDriver, T1)
 {
 }
+
+TSUNIT_TEST(utils_CClassicMathDriver, inlinedDriverYieldsTheSameResultsAsTheVirtualOne)
+{
+    utils::CVectorF32 v1(37);
+    utils::CVectorF32 v2(37);
+    for (unsigned int i = 0; i < v1.size(); ++i)
+    {
+        v1[i] = utils::CMath::randF32(-1.f, 1.f);
+        v2[i] = utils::CMath::randF32(-1.f, 1.f);
+    }
+
+    utils::CClassicMathDriver driver;
+    const utils::CMath math(driver);
+    const utils::CBasicMath<utils::CClassicMathDriver> inlineMath(driver);
+    UT_EXPECT_EQ(&driver, &inlineMath.driver());
+
+    UT_EXPECT_EQ(math.calcDotF32(v1, v2, 0.5f), inlineMath.calcDotF32(v1, v2, 0.5f));
+    UT_EXPECT_EQ(math.sumUpVector(v1), inlineMath.sumUpVector(v1));
+    UT_EXPECT_EQ(math.sumUpVector(v1, 30, 20), inlineMath.sumUpVector(v1, 30, 20));
+}
@@ -0,0 +1,99 @@
+/*
+ * @file utils/unittests/UT_CMPSCQueue.cpp
+ * @brief Unittest for CMPSCQueue
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "utils/include/CMPSCQueue.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <thread>
+#include <vector>
+
+namespace {
+struct Element : utils::CMPSCQueue<Element>::Node
+{
+    unsigned int producer = 0;
+    unsigned int sequence = 0;
+};
+} // namespace
+
+TSUNIT_TEST(utils_CMPSCQueue, popReturnsTheElementsInOrder)
+{
+    utils::CMPSCQueue<Element> queue;
+    UT_EXPECT_TRUE(queue.isEmpty());
+    UT_EXPECT_TRUE(nullptr == queue.pop());
+
+    Element elements[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        elements[i].sequence = i;
+        queue.push(&elements[i]);
+        UT_EXPECT_FALSE(queue.isEmpty());
+    }
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        UT_EXPECT_TRUE(&elements[i] == queue.pop());
+    }
+    UT_EXPECT_TRUE(queue.isEmpty());
+    UT_EXPECT_TRUE(nullptr == queue.pop());
+
+    // An element may be queued again once it has been popped.
+    queue.push(&elements[1]);
+    UT_EXPECT_TRUE(&elements[1] == queue.pop());
+    UT_EXPECT_TRUE(queue.isEmpty());
+}
+
+TSUNIT_TEST(utils_CMPSCQueue, multipleProducersKeepTheirOrder)
+{
+    constexpr unsigned int kNrOfProducers = 4;
+    constexpr unsigned int kNrOfElementsPerProducer = 20'000;
+
+    utils::CMPSCQueue<Element> queue;
+    std::vector<Element> elements(kNrOfProducers * kNrOfElementsPerProducer);
+
+    std::vector<std::thread> producers;
+    for (unsigned int producerIndex = 0; producerIndex < kNrOfProducers; ++producerIndex)
+    {
+        producers.emplace_back([&queue, &elements, producerIndex](){
+            for (unsigned int i = 0; i < kNrOfElementsPerProducer; ++i)
+            {
+                Element& element = elements[producerIndex * kNrOfElementsPerProducer + i];
+                element.producer = producerIndex;
+                element.sequence = i;
+                queue.push(&element);
+            }
+        });
+    }
+
+    unsigned int nextSequence[kNrOfProducers] = {};
+    unsigned int nrOfElements = 0;
+    bool inOrder = true;
+    while (nrOfElements < kNrOfProducers * kNrOfElementsPerProducer)
+    {
+        Element* element = queue.pop();
+        if (element)
+        {
+            inOrder = inOrder && (nextSequence[element->producer] == element->sequence);
+            nextSequence[element->producer] = element->sequence + 1;
+            ++nrOfElements;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    for (std::thread& thisProducer : producers)
+    {
+        thisProducer.join();
+    }
+
+    UT_EXPECT_TRUE(inOrder);
+    UT_EXPECT_TRUE(queue.isEmpty());
+    UT_EXPECT_TRUE(nullptr == queue.pop());
+    for (unsigned int producerIndex = 0; producerIndex < kNrOfProducers; ++producerIndex)
+    {
+        UT_EXPECT_EQ(kNrOfElementsPerProducer, nextSequence[producerIndex]);
+    }
+}
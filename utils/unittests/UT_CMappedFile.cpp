@@ -0,0 +1,52 @@
+/*
+ * @file utils/unittests/UT_CMappedFile.cpp
+ * @brief Unittest for CMappedFile
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "utils/include/CMappedFile.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+TSUNIT_TEST(utils_CMappedFile, mapsTheContentsOfAFile)
+{
+    std::vector<char> contents(3 * 4096 + 17);
+    for (size_t i = 0; i < contents.size(); ++i)
+    {
+        contents[i] = static_cast<char>(i * 7);
+    }
+
+    char path[] = "/tmp/UT_CMappedFile_XXXXXX";
+    const int fd = mkstemp(path);
+    UT_EXPECT_TRUE(fd >= 0);
+    UT_EXPECT_EQ(static_cast<ssize_t>(contents.size()), write(fd, contents.data(), contents.size()));
+    close(fd);
+
+    utils::CMappedFile file;
+    UT_EXPECT_FALSE(file.isOpen());
+    UT_EXPECT_FALSE(file.open("/tmp/UT_CMappedFile_does_not_exist"));
+    UT_EXPECT_TRUE(file.open(path));
+    UT_EXPECT_TRUE(file.isOpen());
+    UT_EXPECT_EQ(contents.size(), file.size());
+    UT_EXPECT_EQ(0, memcmp(contents.data(), file.data(), contents.size()));
+
+    // Released pages are read again on access.
+    file.release(2 * 4096 + 5);
+    UT_EXPECT_EQ(0, memcmp(contents.data(), file.data(), contents.size()));
+    file.release(0);
+
+    file.close();
+    UT_EXPECT_FALSE(file.isOpen());
+    UT_EXPECT_TRUE(nullptr == file.data());
+
+    // An empty file
+    truncate(path, 0);
+    UT_EXPECT_TRUE(file.open(path));
+    UT_EXPECT_EQ(0, file.size());
+    UT_EXPECT_TRUE(nullptr == file.data());
+
+    unlink(path);
+}
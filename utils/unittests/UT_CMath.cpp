@@ -29,7 +29,7 @@ uint64_t getCurrentTimeMS()
 // ==========================================================================
 TSUNIT_TEST(utils_CMath, TestRandomRange)
 {
-    constexpr size_t  kNumberOfSamples = 100ul;
+    constexpr size_t  kNumberOfSamples = 10'000ul;
 
     float maxValue = FLT_MIN;
     float minValue = FLT_MAX;
@@ -142,6 +142,11 @@ TSUNIT_TEST(utils_CMath_MathDriverTests, CustomDriver)
             return 0;
         }
 
+        virtual float sumUpF32(const utils::CVectorF32& inVector, unsigned int inIndexOfFirstElement, unsigned int inNrOfElements) const override
+        {
+            return 0;
+        }
+
         mutable unsigned int m_calcDotF32Called = 0;
     }; // class CustomDriver
 
@@ -157,3 +162,26 @@ TSUNIT_TEST(utils_CMath_MathDriverTests, CustomDriver)
     // So ask the spy...
     UT_EXPECT_EQ(1, customDriver.m_calcDotF32Called);
 }
+
+TSUNIT_TEST(utils_CMath_MathDriverTests, CompileTimeDriver)
+{
+    // A compile time driver just needs the methods that are actually used.
+    struct SpyDriver
+    {
+        float calcDotF32(const utils::CVectorF32& inVectorA, const utils::CVectorF32& inVectorB, float offset) const
+        {
+            ++m_calcDotF32Called;
+            return offset;
+        }
+
+        mutable unsigned int m_calcDotF32Called = 0;
+    }; // struct SpyDriver
+
+    SpyDriver spyDriver;
+    const utils::CBasicMath<SpyDriver> math(spyDriver);
+    utils::CVector<float> v1(5);
+    utils::CVector<float> v2(5);
+
+    UT_EXPECT_EQ(2.f, math.calcDotF32(v1, v2, 2.f));
+    UT_EXPECT_EQ(1, spyDriver.m_calcDotF32Called);
+}
@@ -0,0 +1,209 @@
+/*
+ * @file utils/unittests/UT_CProfilingMathDriver.cpp
+ * @brief Unittest for CProfilingMathDriver
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "utils/include/CProfilingMathDriver.hpp"
+#include "utils/include/CClassicMathDriver.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TSUNIT_TEST(utils_CProfilingMathDriver, forwardsToTheDecoratedDriver)
+{
+    utils::CClassicMathDriver classicDriver;
+    utils::CProfilingMathDriver profilingDriver(classicDriver);
+    utils::CMath math(profilingDriver);
+
+    utils::CVectorF32 v1(3);
+    utils::CVectorF32 v2(3);
+    v1[0] = 1.f; v1[1] = 2.f; v1[2] = 3.f;
+    v2[0] = 4.f; v2[1] = 5.f; v2[2] = 6.f;
+
+    UT_EXPECT_EQ(1.f * 4.f + 2.f * 5.f + 3.f * 6.f + 0.5f, math.calcDotF32(v1, v2, 0.5f));
+    UT_EXPECT_EQ(1.f + 2.f + 3.f, math.sumUpVector(v1));
+    UT_EXPECT_EQ(2.f + 3.f, math.sumUpVector(v1, 1, 2));
+
+    const float values[] = {2.f, -1.f};
+    const unsigned int indices[] = {0, 2};
+    UT_EXPECT_EQ(2.f * 4.f - 1.f * 6.f, math.calcSparseDotF32(values, indices, 2, v2));
+    UT_EXPECT_EQ(1, profilingDriver.statistics(utils::CProfilingMathDriver::kCalcSparseDotF32).calls);
+    UT_EXPECT_EQ(2, profilingDriver.statistics(utils::CProfilingMathDriver::kCalcSparseDotF32).elements);
+
+    const unsigned int blockIndices[] = {1};
+    UT_EXPECT_EQ(2.f * 5.f - 1.f * 6.f + 1.f, math.calcBlockSparseDotF32(values, blockIndices, 1, 2, v2, 1.f));
+    UT_EXPECT_EQ(1, profilingDriver.statistics(utils::CProfilingMathDriver::kCalcBlockSparseDotF32).calls);
+}
+
+TSUNIT_TEST(utils_CProfilingMathDriver, countsCallsAndVectorLengths)
+{
+    utils::CClassicMathDriver classicDriver;
+    utils::CProfilingMathDriver profilingDriver(classicDriver);
+    utils::CMath math(profilingDriver);
+
+    utils::CVectorF32 small(3);
+    utils::CVectorF32 large(100);
+    small.setAll(1.f);
+    large.setAll(1.f);
+
+    (void)math.calcDotF32(small, small);
+    (void)math.calcDotF32(small, small);
+    (void)math.calcDotF32(large, large);
+    (void)math.sumUpVector(large, 0, 16);
+
+    const utils::CProfilingMathDriver::MethodStatistics dotStats =
+        profilingDriver.statistics(utils::CProfilingMathDriver::kCalcDotF32);
+    UT_EXPECT_EQ(3, dotStats.calls);
+    UT_EXPECT_EQ(3 + 3 + 100, dotStats.elements);
+    UT_EXPECT_EQ(2, dotStats.lengthHistogram[utils::CProfilingMathDriver::bucketOfLength(3)]);
+    UT_EXPECT_EQ(1, dotStats.lengthHistogram[utils::CProfilingMathDriver::bucketOfLength(100)]);
+
+    UT_EXPECT_EQ(0, profilingDriver.statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+    UT_EXPECT_EQ(1, profilingDriver.statistics(utils::CProfilingMathDriver::kSumUpF32Range).calls);
+
+    std::FILE* file = tmpfile();
+    UT_EXPECT_NE(nullptr, file);
+    if (file)
+    {
+        profilingDriver.report(file);
+        rewind(file);
+
+        // The header, one row per method and one line per used length bucket.
+        char line[256];
+        unsigned int nrOfLines = 0;
+        unsigned int nrOfRows = 0;
+        unsigned int nrOfBuckets = 0;
+        while (fgets(line, sizeof(line), file))
+        {
+            ++nrOfLines;
+            char methodName[32];
+            unsigned long long calls = 0;
+            unsigned long long elements = 0;
+            unsigned long long minLength = 0;
+            unsigned long long maxLength = 0;
+            unsigned long long count = 0;
+            if (3 == sscanf(line, "%31s | %llu | %llu", methodName, &calls, &elements))
+            {
+                const utils::CProfilingMathDriver::Method method = static_cast<utils::CProfilingMathDriver::Method>(nrOfRows);
+                UT_EXPECT_EQ(0, strcmp(utils::CProfilingMathDriver::methodName(method), methodName));
+                UT_EXPECT_EQ(profilingDriver.statistics(method).calls, calls);
+                UT_EXPECT_EQ(profilingDriver.statistics(method).elements, elements);
+                ++nrOfRows;
+            }
+            else if (3 == sscanf(line, " length %llu..%llu : %llu", &minLength, &maxLength, &count))
+            {
+                const unsigned int bucket = utils::CProfilingMathDriver::bucketOfLength(minLength);
+                UT_EXPECT_EQ(bucket, utils::CProfilingMathDriver::bucketOfLength(maxLength));
+                UT_EXPECT_EQ(profilingDriver.statistics(static_cast<utils::CProfilingMathDriver::Method>(nrOfRows - 1))
+                             .lengthHistogram[bucket], count);
+                ++nrOfBuckets;
+            }
+        }
+        UT_EXPECT_EQ(utils::CProfilingMathDriver::kNrOfMethods, nrOfRows);
+        UT_EXPECT_EQ(2 + 1, nrOfBuckets);
+        UT_EXPECT_EQ(1 + nrOfRows + nrOfBuckets, nrOfLines);
+        fclose(file);
+    }
+
+    profilingDriver.reset();
+    UT_EXPECT_EQ(0, profilingDriver.statistics(utils::CProfilingMathDriver::kCalcDotF32).calls);
+    UT_EXPECT_EQ(0, profilingDriver.statistics(utils::CProfilingMathDriver::kCalcDotF32).elements);
+}
+
+TSUNIT_TEST(utils_CProfilingMathDriver, lengthBuckets)
+{
+    UT_EXPECT_EQ(0, utils::CProfilingMathDriver::bucketOfLength(0));
+    UT_EXPECT_EQ(1, utils::CProfilingMathDriver::bucketOfLength(1));
+    UT_EXPECT_EQ(2, utils::CProfilingMathDriver::bucketOfLength(2));
+    UT_EXPECT_EQ(2, utils::CProfilingMathDriver::bucketOfLength(3));
+    UT_EXPECT_EQ(3, utils::CProfilingMathDriver::bucketOfLength(4));
+    UT_EXPECT_EQ(utils::CProfilingMathDriver::kNrOfLengthBuckets - 1,
+                 utils::CProfilingMathDriver::bucketOfLength(UINT64_MAX));
+
+    UT_EXPECT_EQ(0, utils::CProfilingMathDriver::lengthOfBucket(0));
+    UT_EXPECT_EQ(1, utils::CProfilingMathDriver::lengthOfBucket(1));
+    UT_EXPECT_EQ(4, utils::CProfilingMathDriver::lengthOfBucket(3));
+}
+
+TSUNIT_TEST(utils_CProfilingMathDriver, sumsUpTheCountersOfAllThreads)
+{
+    utils::CClassicMathDriver classicDriver;
+    utils::CProfilingMathDriver profilingDriver(classicDriver);
+    utils::CMath math(profilingDriver);
+
+    constexpr unsigned int kNrOfThreads = 4;
+    constexpr unsigned int kCallsPerThread = 1000;
+
+    std::thread threads[kNrOfThreads];
+    for (std::thread& thisThread : threads)
+    {
+        thisThread = std::thread([&math](){
+            utils::CVectorF32 v(8);
+            v.setAll(1.f);
+            for (unsigned int i = 0; i < kCallsPerThread; ++i)
+            {
+                (void)math.sumUpVector(v);
+            }
+        });
+    }
+    for (std::thread& thisThread : threads)
+    {
+        thisThread.join();
+    }
+
+    UT_EXPECT_EQ(kNrOfThreads * kCallsPerThread,
+                 profilingDriver.statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+}
+
+TSUNIT_TEST(utils_CProfilingMathDriver, countsPerDriverWhenAThreadUsesSeveral)
+{
+    utils::CClassicMathDriver classicDriver;
+    utils::CProfilingMathDriver firstDriver(classicDriver);
+    utils::CProfilingMathDriver secondDriver(classicDriver);
+    utils::CProfilingMathDriver* profilingDrivers[2] = {&firstDriver, &secondDriver};
+
+    utils::CVectorF32 v(4);
+    v.setAll(1.f);
+    for (unsigned int i = 0; i < 10; ++i)
+    {
+        (void)profilingDrivers[i % 2]->sumUpF32(v);
+        (void)profilingDrivers[0]->sumUpF32(v);
+    }
+    UT_EXPECT_EQ(15, profilingDrivers[0]->statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+    UT_EXPECT_EQ(5, profilingDrivers[1]->statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+
+    profilingDrivers[0]->reset();
+    UT_EXPECT_EQ(0, profilingDrivers[0]->statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+    (void)profilingDrivers[0]->sumUpF32(v);
+    UT_EXPECT_EQ(1, profilingDrivers[0]->statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+
+    // A driver that replaces a destroyed one starts from scratch.
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        utils::CProfilingMathDriver temporaryDriver(classicDriver);
+        (void)temporaryDriver.sumUpF32(v);
+        UT_EXPECT_EQ(1, temporaryDriver.statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+    }
+
+    // More drivers than a thread caches still count correctly.
+    std::vector<std::unique_ptr<utils::CProfilingMathDriver>> manyDrivers;
+    for (unsigned int i = 0; i < 11; ++i)
+    {
+        manyDrivers.emplace_back(new utils::CProfilingMathDriver(classicDriver));
+    }
+    for (unsigned int round = 0; round < 3; ++round)
+    {
+        for (std::unique_ptr<utils::CProfilingMathDriver>& thisDriver : manyDrivers)
+        {
+            (void)thisDriver->sumUpF32(v);
+        }
+    }
+    for (std::unique_ptr<utils::CProfilingMathDriver>& thisDriver : manyDrivers)
+    {
+        UT_EXPECT_EQ(3, thisDriver->statistics(utils::CProfilingMathDriver::kSumUpF32).calls);
+    }
+}
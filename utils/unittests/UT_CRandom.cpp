@@ -0,0 +1,101 @@
+/*
+ * @file utils/unittests/UT_CRandom.cpp
+ * @brief Unittest for CRandom
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "utils/include/CRandom.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+TSUNIT_TEST(utils_CRandom, matchesTheKnownAnswerOfPhilox)
+{
+    // Philox4x32-10 of the counter 0 and the key 0 (Random123)
+    utils::CRandom random(0, 0);
+    UT_EXPECT_EQ(0x6627e8d5u, random.nextU32());
+    UT_EXPECT_EQ(0xe169c58du, random.nextU32());
+    UT_EXPECT_EQ(0xbc57ac4cu, random.nextU32());
+    UT_EXPECT_EQ(0x9b00dbd8u, random.nextU32());
+    UT_EXPECT_EQ(4, random.position());
+}
+
+TSUNIT_TEST(utils_CRandom, rangesDoNotDependOnTheSplit)
+{
+    constexpr std::size_t kNrOfValues = 603;
+    const utils::CRandom random(42, 7);
+
+    float all[kNrOfValues];
+    random.fillUniformF32(0, all, kNrOfValues, -2.f, 3.f);
+
+    // Any split (aligned to the blocks or not) yields the same numbers.
+    for (const std::size_t split : {1, 3, 4, 5, 50, 101, 257, 511})
+    {
+        float parts[kNrOfValues];
+        random.fillUniformF32(split, parts + split, kNrOfValues - split, -2.f, 3.f);
+        random.fillUniformF32(0, parts, split, -2.f, 3.f);
+        UT_EXPECT_EQ(0, memcmp(all, parts, sizeof(all)));
+    }
+
+    // So does the sequential access
+    utils::CRandom sequential(42, 7);
+    sequential.seek(17);
+    UT_EXPECT_EQ(all[17], sequential.nextF32(-2.f, 3.f));
+    UT_EXPECT_EQ(all[18], sequential.nextF32(-2.f, 3.f));
+
+    for (const std::size_t split : {1, 2, 3, 64})
+    {
+        float normal[kNrOfValues];
+        float parts[kNrOfValues];
+        random.fillNormalF32(0, normal, kNrOfValues, 0.f, 1.f);
+        random.fillNormalF32(split, parts + split, kNrOfValues - split, 0.f, 1.f);
+        random.fillNormalF32(0, parts, split, 0.f, 1.f);
+        UT_EXPECT_EQ(0, memcmp(normal, parts, sizeof(normal)));
+    }
+}
+
+TSUNIT_TEST(utils_CRandom, streamsAndSeedsDiffer)
+{
+    float values[3][16];
+    utils::CRandom(1, 0).fillUniformF32(0, values[0], 16, 0.f, 1.f);
+    utils::CRandom(1, 1).fillUniformF32(0, values[1], 16, 0.f, 1.f);
+    utils::CRandom(2, 0).fillUniformF32(0, values[2], 16, 0.f, 1.f);
+
+    UT_EXPECT_NE(0, memcmp(values[0], values[1], sizeof(values[0])));
+    UT_EXPECT_NE(0, memcmp(values[0], values[2], sizeof(values[0])));
+}
+
+TSUNIT_TEST(utils_CRandom, distributionsHaveTheirMoments)
+{
+    constexpr std::size_t kNrOfValues = 100'000;
+    std::vector<float> values(kNrOfValues);
+    const utils::CRandom random;
+
+    random.fillUniformF32(0, values.data(), kNrOfValues, -1.f, 3.f);
+    double sum = 0.;
+    float minValue = 3.f;
+    float maxValue = -1.f;
+    for (const float value : values)
+    {
+        sum += value;
+        minValue = std::fmin(minValue, value);
+        maxValue = std::fmax(maxValue, value);
+    }
+    UT_EXPECT_TRUE(minValue >= -1.f);
+    UT_EXPECT_TRUE(maxValue < 3.f);
+    UT_EXPECT_TRUE(std::fabs(sum / kNrOfValues - 1.) < 0.02);
+
+    random.fillNormalF32(0, values.data(), kNrOfValues, 2.f, 0.5f);
+    double squareSum = 0.;
+    sum = 0.;
+    for (const float value : values)
+    {
+        sum += value;
+        squareSum += value * value;
+    }
+    const double mean = sum / kNrOfValues;
+    const double deviation = std::sqrt(squareSum / kNrOfValues - mean * mean);
+    UT_EXPECT_TRUE(std::fabs(mean - 2.) < 0.01);
+    UT_EXPECT_TRUE(std::fabs(deviation - 0.5) < 0.01);
+}
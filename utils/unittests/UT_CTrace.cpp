@@ -0,0 +1,170 @@
+/*
+ * @file utils/unittests/UT_CTrace.cpp
+ * @brief Unittest for CTrace
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "utils/include/CTrace.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cstring>
+#include <string>
+#include <thread>
+
+static std::string _chromeTrace(unsigned int& outNrOfEvents)
+{
+    std::string json;
+    std::FILE* file = tmpfile();
+    UT_EXPECT_NE(nullptr, file);
+    if (file)
+    {
+        outNrOfEvents = utils::CTrace::writeChromeTrace(file);
+        rewind(file);
+        char buffer[256];
+        size_t nrOfBytes;
+        while ((nrOfBytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            json.append(buffer, nrOfBytes);
+        }
+        fclose(file);
+    }
+    return json;
+}
+
+TSUNIT_TEST(utils_CTrace, recordedEventsAreWrittenAsChromeTrace)
+{
+    utils::CTrace::clear();
+    utils::CTrace::record("firstEvent", utils::CTrace::kLayer, 42, 1000, 3000);
+    utils::CTrace::record("secondEvent", utils::CTrace::kDriver, 7, 2000, 2500);
+
+    unsigned int nrOfEvents = 0;
+    const std::string json = _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(2, nrOfEvents);
+    UT_EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+    UT_EXPECT_NE(std::string::npos, json.find("\"name\":\"firstEvent\",\"cat\":\"layer\",\"ph\":\"X\""));
+    UT_EXPECT_NE(std::string::npos, json.find("\"dur\":2.000,\"args\":{\"arg\":42}"));
+    UT_EXPECT_NE(std::string::npos, json.find("\"name\":\"secondEvent\",\"cat\":\"driver\""));
+
+    utils::CTrace::clear();
+    _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(0, nrOfEvents);
+}
+
+TSUNIT_TEST(utils_CTrace, scopeRecordsOnlyEnabledCategories)
+{
+    utils::CTrace::clear();
+    utils::CTrace::enable(utils::CTrace::kLayer);
+
+    {
+        utils::CTrace::CScope layerScope("layerScope", utils::CTrace::kLayer);
+        utils::CTrace::CScope driverScope("driverScope", utils::CTrace::kDriver);
+    }
+    utils::CTrace::enable(utils::CTrace::kNone);
+
+    unsigned int nrOfEvents = 0;
+    const std::string json = _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(1, nrOfEvents);
+    UT_EXPECT_NE(std::string::npos, json.find("layerScope"));
+    UT_EXPECT_EQ(std::string::npos, json.find("driverScope"));
+    utils::CTrace::clear();
+}
+
+TSUNIT_TEST(utils_CTrace, driverEventsAreNotPartOfAll)
+{
+    utils::CTrace::enable(utils::CTrace::kAll);
+    UT_EXPECT_TRUE(utils::CTrace::isEnabled(utils::CTrace::kNet));
+    UT_EXPECT_TRUE(utils::CTrace::isEnabled(utils::CTrace::kLayer));
+    UT_EXPECT_TRUE(utils::CTrace::isEnabled(utils::CTrace::kTask));
+    UT_EXPECT_FALSE(utils::CTrace::isEnabled(utils::CTrace::kDriver));
+
+    utils::CTrace::enable(utils::CTrace::kAll | utils::CTrace::kDriver);
+    UT_EXPECT_TRUE(utils::CTrace::isEnabled(utils::CTrace::kDriver));
+    utils::CTrace::enable(utils::CTrace::kNone);
+}
+
+TSUNIT_TEST(utils_CTrace, everyThreadGetsItsOwnTrack)
+{
+    utils::CTrace::clear();
+    std::thread worker([](){
+        utils::CTrace::record("workerEvent", utils::CTrace::kTask, 0, 10, 20);
+    });
+    worker.join();
+    utils::CTrace::record("mainEvent", utils::CTrace::kTask, 0, 10, 20);
+
+    unsigned int nrOfEvents = 0;
+    const std::string json = _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(2, nrOfEvents);
+
+    // The events must be written even though the worker is gone, but on different tracks.
+    const size_t workerPos = json.find("workerEvent");
+    const size_t mainPos = json.find("mainEvent");
+    UT_EXPECT_NE(std::string::npos, workerPos);
+    UT_EXPECT_NE(std::string::npos, mainPos);
+    if ((std::string::npos != workerPos) && (std::string::npos != mainPos))
+    {
+        const size_t workerTid = json.find("\"tid\":", workerPos);
+        const size_t mainTid = json.find("\"tid\":", mainPos);
+        UT_EXPECT_NE(json.substr(workerTid, 8), json.substr(mainTid, 8));
+    }
+    utils::CTrace::clear();
+}
+
+TSUNIT_TEST(utils_CTrace, ringBufferKeepsTheNewestEvents)
+{
+    utils::CTrace::clear();
+    for (unsigned int i = 0; i < utils::CTrace::kEventsPerThread + 10; ++i)
+    {
+        utils::CTrace::record("event", utils::CTrace::kTask, i, 0, 1);
+    }
+
+    unsigned int nrOfEvents = 0;
+    const std::string json = _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(utils::CTrace::kEventsPerThread, nrOfEvents);
+    UT_EXPECT_EQ(std::string::npos, json.find("{\"arg\":9}"));
+    UT_EXPECT_NE(std::string::npos, json.find("{\"arg\":10}"));
+    utils::CTrace::clear();
+}
+
+TSUNIT_TEST(utils_CTrace, exitedThreadsAreDroppedOnceWritten)
+{
+    utils::CTrace::clear();
+    std::thread worker([](){
+        utils::CTrace::record("workerEvent", utils::CTrace::kTask, 0, 10, 20);
+    });
+    worker.join();
+
+    unsigned int nrOfEvents = 0;
+    UT_EXPECT_NE(std::string::npos, _chromeTrace(nrOfEvents).find("workerEvent"));
+    UT_EXPECT_EQ(1, nrOfEvents);
+
+    // The worker has gone, so its buffer must not be written again.
+    utils::CTrace::record("mainEvent", utils::CTrace::kTask, 0, 10, 20);
+    const std::string json = _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(1, nrOfEvents);
+    UT_EXPECT_EQ(std::string::npos, json.find("workerEvent"));
+    utils::CTrace::clear();
+}
+
+TSUNIT_TEST(utils_CTrace, onlyTheNewestExitedThreadsAreKept)
+{
+    utils::CTrace::clear();
+    for (unsigned int i = 0; i < utils::CTrace::kMaxExitedThreads + 10; ++i)
+    {
+        std::thread worker([i](){
+            utils::CTrace::record("workerEvent", utils::CTrace::kTask, i, 10, 20);
+        });
+        worker.join();
+    }
+    // Registering the buffer of one more thread drops the oldest exited ones.
+    std::thread lastWorker([](){
+        utils::CTrace::record("lastEvent", utils::CTrace::kTask, 0, 10, 20);
+    });
+    lastWorker.join();
+
+    unsigned int nrOfEvents = 0;
+    const std::string json = _chromeTrace(nrOfEvents);
+    UT_EXPECT_EQ(utils::CTrace::kMaxExitedThreads + 1, nrOfEvents);
+    UT_EXPECT_EQ(std::string::npos, json.find("{\"arg\":9}"));
+    UT_EXPECT_NE(std::string::npos, json.find("{\"arg\":10}"));
+    UT_EXPECT_NE(std::string::npos, json.find("lastEvent"));
+    utils::CTrace::clear();
+}
@@ -6,6 +6,7 @@
 #include "utils/include/CVector.hpp"
 #include "tsunit/TSUnit.hpp"
 #include "tsunit/TSUnitTestAddOns.hpp"
+#include <cmath>
 
 TSUNIT_TEST(utils_CVector, TestIf_size_returnsTheConstructedSize)
 {
@@ -205,6 +206,103 @@ TSUNIT_TEST(utils_CVector, TestIf_length_returnsTheProperValue)
     UT_EXPECT_EQ((sqrtf(1*1 + 2*2 + 8*8 + 5*5 + 3*3)), v1.length());
 }
 
+TSUNIT_TEST(utils_CVector, TestIf_reductionsMatchAScalarLoopForAllLengths)
+{
+    // The lengths cover vectors shorter than the lanes and partial rows.
+    for (size_t nrOfElements = 1; nrOfElements < 4 * utils::CVectorF32::kNrOfLanes + 3; ++nrOfElements)
+    {
+        utils::CVector<int> v(nrOfElements);
+        for (size_t i = 0; i < nrOfElements; ++i)
+        {
+            v[i] = static_cast<int>((i * 7919) % 23) - 11;
+        }
+
+        int expectedMin = v[0], expectedMax = v[0], expectedSum = 0, expectedLengthSqu = 0;
+        size_t expectedArgMin = 0, expectedArgMax = 0;
+        for (size_t i = 0; i < nrOfElements; ++i)
+        {
+            if (v[i] < expectedMin) {expectedMin = v[i]; expectedArgMin = i;}
+            if (v[i] > expectedMax) {expectedMax = v[i]; expectedArgMax = i;}
+            expectedSum += v[i];
+            expectedLengthSqu += v[i] * v[i];
+        }
+
+        UT_EXPECT_EQ(expectedMin, v.min());
+        UT_EXPECT_EQ(expectedMax, v.max());
+        UT_EXPECT_EQ(expectedArgMin, v.argMin());
+        UT_EXPECT_EQ(expectedArgMax, v.argMax());
+        UT_EXPECT_EQ(expectedSum, v.sum());
+        UT_EXPECT_EQ(expectedSum, v.sum(utils::CVector<int>::Summation::pairwise));
+        UT_EXPECT_EQ(expectedLengthSqu, v.lengthSqu());
+    }
+
+    utils::CVector<int> empty(0);
+    UT_EXPECT_EQ(0, empty.argMax());
+    UT_EXPECT_EQ(0, empty.sum());
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_argMax_returnsTheFirstOfEqualValues)
+{
+    utils::CVectorF32 v(40);
+    v.setAll(1.f);
+    v[13] = v[29] = v[37] = 5.f;
+    v[22] = v[38] = -5.f;
+
+    UT_EXPECT_EQ(13, v.argMax());
+    UT_EXPECT_EQ(22, v.argMin());
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_topK_returnsTheIndicesOfTheGreatestValues)
+{
+    utils::CVectorF32 v(50);
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        v[i] = static_cast<float>((i * 37) % 11);
+    }
+
+    // The value 10 appears at the first four of these indices, 9 at the others.
+    size_t indices[7];
+    UT_EXPECT_EQ(7, v.topK(7, indices));
+    const size_t expected[7] = {8, 19, 30, 41, 5, 16, 27};
+    for (size_t i = 0; i < 7; ++i)
+    {
+        UT_EXPECT_EQ(expected[i], indices[i]);
+    }
+
+    // At most all elements
+    utils::CVectorF32 small(3);
+    small[0] = 1.f;
+    small[1] = 3.f;
+    small[2] = 2.f;
+    UT_EXPECT_EQ(3, small.topK(5, indices));
+    UT_EXPECT_EQ(1, indices[0]);
+    UT_EXPECT_EQ(2, indices[1]);
+    UT_EXPECT_EQ(0, indices[2]);
+    UT_EXPECT_EQ(0, small.topK(0, indices));
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_pairwiseSummation_isMoreAccurateForLongVectors)
+{
+    constexpr size_t kNrOfElements = 1u << 22;
+    utils::CVectorF32 v(kNrOfElements);
+    v.setAll(0.1f);
+
+    const double expected = 0.1 * kNrOfElements;
+    float naive = 0.f;
+    for (size_t i = 0; i < kNrOfElements; ++i)
+    {
+        naive += v[i];
+    }
+    const double naiveError = std::fabs(naive - expected);
+    const double lanesError = std::fabs(v.sum() - expected);
+    const double pairwiseError = std::fabs(v.sum(utils::CVectorF32::Summation::pairwise) - expected);
+
+    UT_EXPECT_TRUE(lanesError < naiveError);
+    UT_EXPECT_TRUE(pairwiseError < lanesError);
+    UT_EXPECT_TRUE(pairwiseError < 1e-5 * expected);
+    UT_EXPECT_TRUE(std::fabs(v.average(utils::CVectorF32::Summation::pairwise) - 0.1f) < 1e-6f);
+}
+
 // ==========================================================================
 // Vector intrinsic manipulation
 // ==========================================================================
@@ -351,3 +449,163 @@ TSUNIT_TEST(utils_CVector, TestIf_deferencingTheInternalStorageAsPointerToNonCon
     UT_EXPECT_EQ(+5 *   +30, v1[3]);
     UT_EXPECT_EQ(-3 * -2233, v1[4]);
 }
+
+// ==========================================================================
+// External storage
+// ==========================================================================
+TSUNIT_TEST(utils_CVector, TestIf_externalStorageIsUsedButNotOwned)
+{
+    float storage[4] = {1.f, 2.f, 3.f, 4.f};
+    {
+        utils::CVector<float> v1(storage, 3);
+        UT_EXPECT_EQ(3, v1.size());
+        UT_EXPECT_FALSE(v1.ownsElements());
+        UT_EXPECT_EQ(&storage[0], *v1);
+
+        v1[1] = 7.f;
+        UT_EXPECT_EQ(7.f, storage[1]);
+
+        // A copy gets its own storage.
+        utils::CVector<float> v2(v1);
+        UT_EXPECT_TRUE(v2.ownsElements());
+        UT_EXPECT_NE(&storage[0], *v2);
+        UT_EXPECT_EQ(7.f, v2[1]);
+    }
+
+    // The storage is still alive and untouched beyond the vector.
+    UT_EXPECT_EQ(4.f, storage[3]);
+}
+
+// ==========================================================================
+// Capacity
+// ==========================================================================
+TSUNIT_TEST(utils_CVector, TestIf_reserve_keepsTheElementsAndTheSize)
+{
+    utils::CVector<float> v(3);
+    v[0] = 1.f;
+    v[1] = 2.f;
+    v[2] = 3.f;
+    UT_EXPECT_EQ(utils::CVectorF32::kNrOfInlineElements, v.capacity());
+
+    UT_EXPECT_TRUE(v.reserve(100));
+    UT_EXPECT_EQ(3, v.size());
+    UT_EXPECT_EQ(100, v.capacity());
+    UT_EXPECT_EQ(2.f, v[1]);
+
+    // Less than the capacity is a no-op.
+    const float* elements = *v;
+    UT_EXPECT_TRUE(v.reserve(10));
+    UT_EXPECT_EQ(100, v.capacity());
+    UT_EXPECT_EQ(elements, *v);
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_resize_neverShrinksTheStorage)
+{
+    utils::CVector<float> v(64);
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        v[i] = static_cast<float>(i);
+    }
+    const float* elements = *v;
+
+    // Reshapes within the capacity reuse the storage.
+    for (const size_t nrOfElements : {1u, 17u, 64u, 0u, 33u})
+    {
+        UT_EXPECT_TRUE(v.resize(nrOfElements));
+        UT_EXPECT_EQ(nrOfElements, v.size());
+        UT_EXPECT_EQ(64, v.capacity());
+        UT_EXPECT_EQ(elements, *v);
+    }
+    UT_EXPECT_EQ(32.f, v[32]);
+
+    // Growing beyond keeps the elements.
+    UT_EXPECT_TRUE(v.resize(65));
+    UT_EXPECT_EQ(65, v.capacity());
+    UT_EXPECT_EQ(32.f, v[32]);
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_assignmentOperator_reusesTheStorage)
+{
+    utils::CVector<double> small(5);
+    utils::CVector<double> large(50);
+    small.setAll(1.0);
+    large.setAll(2.0);
+
+    utils::CVector<double> v(0);
+    v = large;
+    const double* elements = *v;
+    for (unsigned int pass = 0; pass < 10; ++pass)
+    {
+        v = (pass & 1) ? small : large;
+        UT_EXPECT_EQ(elements, *v);
+        UT_EXPECT_EQ(50, v.capacity());
+    }
+    UT_EXPECT_EQ(5, v.size());
+    UT_EXPECT_EQ(1.0, v[4]);
+
+    // A move takes over the storage and its capacity.
+    utils::CVector<double> moved(3);
+    moved = std::move(v);
+    UT_EXPECT_EQ(elements, *moved);
+    UT_EXPECT_EQ(50, moved.capacity());
+    UT_EXPECT_EQ(0, v.capacity());
+}
+
+// ==========================================================================
+// Small buffer
+// ==========================================================================
+static bool _isInsideOf(const void* inPointer, const void* inObject, size_t inObjectSize)
+{
+    const char* pointer = static_cast<const char*>(inPointer);
+    const char* object = static_cast<const char*>(inObject);
+    return (pointer >= object) && (pointer < object + inObjectSize);
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_smallVectors_useTheInlineStorage)
+{
+    UT_EXPECT_EQ(16, utils::CVectorF32::kNrOfInlineElements);
+
+    utils::CVectorF32 small(4);
+    UT_EXPECT_TRUE(_isInsideOf(*small, &small, sizeof(small)));
+    UT_EXPECT_TRUE(small.ownsElements());
+    UT_EXPECT_EQ(16, small.capacity());
+
+    utils::CVectorF32 large(17);
+    UT_EXPECT_FALSE(_isInsideOf(*large, &large, sizeof(large)));
+
+    // The capacity is configurable, 0 disables the small buffer.
+    utils::CVector<float, 0> heapOnly(4);
+    UT_EXPECT_FALSE(_isInsideOf(*heapOnly, &heapOnly, sizeof(heapOnly)));
+    UT_EXPECT_EQ(4, heapOnly.capacity());
+}
+
+TSUNIT_TEST(utils_CVector, TestIf_smallVectors_keepTheirElementsOnMoveAndGrowth)
+{
+    utils::CVectorF32 v1(3);
+    v1[0] = 1.f;
+    v1[1] = 2.f;
+    v1[2] = 3.f;
+
+    // A move copies the small buffer.
+    utils::CVectorF32 v2(std::move(v1));
+    UT_EXPECT_EQ(0, v1.size());
+    UT_EXPECT_TRUE(_isInsideOf(*v2, &v2, sizeof(v2)));
+    UT_EXPECT_EQ(2.f, v2[1]);
+
+    utils::CVectorF32 v3(20);
+    v3 = std::move(v2);
+    UT_EXPECT_EQ(3, v3.size());
+    UT_EXPECT_TRUE(_isInsideOf(*v3, &v3, sizeof(v3)));
+    UT_EXPECT_EQ(3.f, v3[2]);
+
+    // Growing beyond the small buffer moves to the heap.
+    UT_EXPECT_TRUE(v3.resize(40));
+    UT_EXPECT_FALSE(_isInsideOf(*v3, &v3, sizeof(v3)));
+    UT_EXPECT_EQ(40, v3.capacity());
+    UT_EXPECT_EQ(1.f, v3[0]);
+    UT_EXPECT_EQ(3.f, v3[2]);
+
+    // A vector that has been moved from may be assigned again.
+    const utils::CVectorF32 v4(v2 = v3);
+    UT_EXPECT_EQ(40, v4.size());
+}
@@ -0,0 +1,96 @@
+/*
+ * @file utils/unittests/UT_MathKernels.cpp
+ * @brief Unittest for MathKernels
+ * @author "Hans-Peter Beständig"<hdusel@tangerine-soft.de>
+ */
+#include "utils/include/MathKernels.hpp"
+#include "utils/include/CMath.hpp"
+#include "tsunit/TSUnit.hpp"
+#include "tsunit/TSUnitTestAddOns.hpp"
+#include <cstring>
+#include <vector>
+
+// ==========================================================================
+// Panel kernels
+// ==========================================================================
+TSUNIT_TEST(utils_MathKernels, packedPanelsRestoreTheRows)
+{
+    constexpr std::size_t kNrOfRows = 11;
+    constexpr std::size_t kNrOfColumns = 5;
+
+    float matrix[kNrOfRows][kNrOfColumns];
+    const float* rows[kNrOfRows];
+    for (std::size_t r = 0; r < kNrOfRows; ++r)
+    {
+        for (std::size_t c = 0; c < kNrOfColumns; ++c)
+        {
+            matrix[r][c] = float(r * kNrOfColumns + c);
+        }
+        rows[r] = matrix[r];
+    }
+
+    // 11 rows need two panels of 8 rows each.
+    UT_EXPECT_EQ(16 * kNrOfColumns, utils::kernels::panelMatrixSize(kNrOfRows, kNrOfColumns));
+    std::vector<float> panels(utils::kernels::panelMatrixSize(kNrOfRows, kNrOfColumns), -1.f);
+    utils::kernels::packPanelsF32(rows, kNrOfRows, kNrOfColumns, panels.data());
+
+    UT_EXPECT_EQ(matrix[0][1], panels[utils::kernels::kPanelSize]);
+    UT_EXPECT_EQ(0.f, panels.back()); // The padding rows are 0
+    for (std::size_t r = 0; r < kNrOfRows; ++r)
+    {
+        float row[kNrOfColumns];
+        utils::kernels::unpackPanelRowF32(panels.data(), kNrOfColumns, r, row);
+        UT_EXPECT_EQ(0, memcmp(matrix[r], row, sizeof(row)));
+    }
+}
+
+TSUNIT_TEST(utils_MathKernels, panelGemmMatchesGemvAndTheDotProduct)
+{
+    // Neither the rows fill the panels, nor the samples fill the tiles, and
+    // the columns exceed a single cache block.
+    constexpr std::size_t kNrOfRows = 13;
+    constexpr std::size_t kNrOfColumns = 301;
+    constexpr std::size_t kNrOfSamples = 71;
+    constexpr std::size_t kResultStride = kNrOfRows + 1;
+
+    std::vector<float> matrix(kNrOfRows * kNrOfColumns);
+    std::vector<const float*> rows(kNrOfRows);
+    for (std::size_t r = 0; r < kNrOfRows; ++r)
+    {
+        for (std::size_t c = 0; c < kNrOfColumns; ++c)
+        {
+            matrix[r * kNrOfColumns + c] = utils::CMath::randF32(-1.f, 1.f);
+        }
+        rows[r] = &matrix[r * kNrOfColumns];
+    }
+    std::vector<float> samples(kNrOfSamples * kNrOfColumns);
+    for (float& value : samples)
+    {
+        value = utils::CMath::randF32(-1.f, 1.f);
+    }
+
+    std::vector<float> panels(utils::kernels::panelMatrixSize(kNrOfRows, kNrOfColumns));
+    utils::kernels::packPanelsF32(rows.data(), kNrOfRows, kNrOfColumns, panels.data());
+
+    std::vector<float> results(kNrOfSamples * kResultStride, -1.f);
+    utils::kernels::calcPanelGemmF32(panels.data(), kNrOfRows, kNrOfColumns,
+        samples.data(), kNrOfSamples, kNrOfColumns, results.data(), kResultStride);
+
+    utils::CMath math;
+    for (std::size_t s = 0; s < kNrOfSamples; ++s)
+    {
+        const float* thisSample = &samples[s * kNrOfColumns];
+        float gemv[kNrOfRows];
+        utils::kernels::calcPanelGemvF32(panels.data(), kNrOfRows, kNrOfColumns, thisSample, gemv);
+
+        const utils::CVectorF32 sampleVector(const_cast<float*>(thisSample), kNrOfColumns);
+        for (std::size_t r = 0; r < kNrOfRows; ++r)
+        {
+            const utils::CVectorF32 rowVector(const_cast<float*>(rows[r]), kNrOfColumns);
+            UT_EXPECT_EQ(gemv[r], results[s * kResultStride + r]);
+            UT_EXPECT_EQ(math.calcDotF32(rowVector, sampleVector), gemv[r]);
+        }
+        // The stride is not touched.
+        UT_EXPECT_EQ(-1.f, results[s * kResultStride + kNrOfRows]);
+    }
+}